@@ -0,0 +1,135 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "../../Engine/Debugging/Logger.h"
+#include "../../Engine/Utility/String.h"
+
+struct BenchEntry
+{
+  const char* name;
+  void (*run)();
+};
+
+static const BenchEntry BENCHES[] =
+{
+  { "string", StringBench },
+  { "utf8", Utf8Bench },
+  { "wildcard", WildcardBench },
+  { "resourcecache", ResourceCacheBench },
+  { "streaming", StreamingBench },
+  { "pack", PackBench },
+  { "event", EventBench },
+  { "process", ProcessBench },
+  { "scheduler", SchedulerBench },
+  { "transform", TransformBench },
+  { "batchmath", BatchMathBench },
+  { "frustum", FrustumBench },
+  { "aabbtree", AabbTreeBench },
+  { "spatial", SpatialBench },
+  { "occlusion", OcclusionBench },
+  { "renderqueue", RenderQueueBench },
+  { "glstate", GLStateBench },
+  { "instancing", InstancingBench },
+  { "text", TextBench },
+  { "distancefield", DistanceFieldBench },
+  { "rasterizer", RasterizerBench },
+  { "bakedfont", BakedFontBench },
+};
+
+static const unsigned int NUM_BENCHES = sizeof(BENCHES) / sizeof(BENCHES[0]);
+
+volatile unsigned int g_bench_sink = 0;
+static unsigned int s_failures = 0;
+
+BenchTimer::BenchTimer()
+{
+  LARGE_INTEGER frequency;
+  QueryPerformanceFrequency(&frequency);
+  _ms_per_tick = 1000.0 / (double)frequency.QuadPart;
+  Start();
+}
+
+void BenchTimer::Start()
+{
+  QueryPerformanceCounter(&_start);
+}
+
+double BenchTimer::Milliseconds() const
+{
+  LARGE_INTEGER now;
+  QueryPerformanceCounter(&now);
+  return (now.QuadPart - _start.QuadPart) * _ms_per_tick;
+}
+
+const char* BenchFontPath()
+{
+  static const char* PATHS[] =
+  {
+    "../Engine/3rdParty/glm-0.9.3.4/doc/goodies/tenby-five.otf",
+    "../../../Source/Engine/3rdParty/glm-0.9.3.4/doc/goodies/tenby-five.otf"
+  };
+  for(unsigned int i = 0; i < sizeof(PATHS) / sizeof(PATHS[0]); ++i)
+  {
+    FILE* file = 0;
+    if(fopen_s(&file, PATHS[i], "rb") == 0 && file)
+    {
+      fclose(file);
+      return PATHS[i];
+    }
+  }
+  return 0;
+}
+
+void BenchCheck(bool passed, const char* what, const char* file, unsigned int line)
+{
+  if(passed)
+    return;
+  ++s_failures;
+  printf("  FAILED: %s (%s:%u)\n", what, file, line);
+}
+
+static bool Selected(const char* name, int argc, wchar_t* argv[])
+{
+  if(argc < 2)
+    return true;
+  for(int i = 1; i < argc; ++i)
+  {
+    if(_stricmp(ws2s(argv[i]).c_str(), name) == 0)
+      return true;
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Bench [name ...]
+//
+// Runs the named benches, or all of them, and returns non-zero if any of
+// their checks failed.
+//////////////////////////////////////////////////////////////////////////////
+int wmain(int argc, wchar_t* argv[])
+{
+  Logger::Init("logging.xml");
+
+  unsigned int ran = 0;
+  for(unsigned int i = 0; i < NUM_BENCHES; ++i)
+  {
+    if(!Selected(BENCHES[i].name, argc, argv))
+      continue;
+    printf("%s\n", BENCHES[i].name);
+    BENCHES[i].run();
+    ++ran;
+  }
+
+  if(ran == 0)
+  {
+    printf("usage: Bench [name ...]\n");
+    for(unsigned int i = 0; i < NUM_BENCHES; ++i)
+      printf("  %s\n", BENCHES[i].name);
+  }
+  else if(s_failures > 0)
+  {
+    printf("%u checks failed\n", s_failures);
+  }
+
+  Logger::Destroy();
+  return ran > 0 && s_failures == 0 ? 0 : 1;
+}
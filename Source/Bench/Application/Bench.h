@@ -0,0 +1,72 @@
+#pragma once
+//========================================================================
+// Bench.h : The benchmarks and tests the Bench tool runs
+//
+// Each bench builds its own data from a fixed seed, times the engine code
+// against the plainer or older way of doing the same thing, prints what it
+// measured, and checks the two agree.  Run it from a Release build, the
+// Debug numbers only show how slow the checked iterators are.  A failed
+// check makes the tool return non-zero, so it runs as a test as well.
+//========================================================================
+
+//a QueryPerformanceCounter stopwatch
+class BenchTimer
+{
+  LARGE_INTEGER _start;
+  double _ms_per_tick;
+
+public:
+  BenchTimer();
+  void Start();
+  double Milliseconds() const;    //since Start()
+};
+
+//xorshift, so every run and every machine gets the same data
+class BenchRandom
+{
+  unsigned int _state;
+
+public:
+  explicit BenchRandom(unsigned int seed) { _state = seed ? seed : 1; }
+  unsigned int Next()
+  {
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return _state;
+  }
+  float Range(float low, float high) { return low + (high - low) * (Next() >> 8) * (1.0f / 16777216.0f); }
+};
+
+//counts a failure and prints what failed
+void BenchCheck(bool passed, const char* what, const char* file, unsigned int line);
+#define BENCH_CHECK(x) BenchCheck((x), #x, __FILE__, __LINE__)
+
+//results nothing else reads are added in here so the optimizer cant throw the work away
+extern volatile unsigned int g_bench_sink;
+
+//the one font in the tree, found from the project directory or the executable's.  NULL if it isnt there.
+const char* BenchFontPath();
+
+void StringBench();
+void Utf8Bench();
+void WildcardBench();
+void ResourceCacheBench();
+void StreamingBench();
+void PackBench();
+void EventBench();
+void ProcessBench();
+void SchedulerBench();
+void TransformBench();
+void BatchMathBench();
+void FrustumBench();
+void AabbTreeBench();
+void SpatialBench();
+void OcclusionBench();
+void RenderQueueBench();
+void GLStateBench();
+void InstancingBench();
+void TextBench();
+void DistanceFieldBench();
+void RasterizerBench();
+void BakedFontBench();
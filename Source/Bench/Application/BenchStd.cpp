@@ -0,0 +1 @@
+#include "BenchStd.h"
\ No newline at end of file
@@ -0,0 +1 @@
+#include "../../Engine/EngineStd.h"
\ No newline at end of file
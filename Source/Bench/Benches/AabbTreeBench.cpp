@@ -0,0 +1,154 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include <math.h>
+#include "../../Engine/Actors/Actor.h"
+#include "../../Engine/Scene/AabbTree.h"
+
+const unsigned int NUM_BOXES = 20000;
+const unsigned int NUM_RAYS = 4096;
+const int GRID = 200;
+
+//////////////////////////////////////////////////////////////////////////////
+// The slab test in double, one axis at a time, with a ray parallel to an
+// axis tested by where its origin is.  Boxes and rays are on a whole
+// number grid, so the float version has no rounding to disagree with.
+//////////////////////////////////////////////////////////////////////////////
+static bool RayHitsBox(const AabbTreeRay& ray, const Aabb& box)
+{
+  double enter = 0.0, exit = ray.max_t;
+  for(int axis = 0; axis < 3; ++axis)
+  {
+    double origin = ray.origin[axis], direction = ray.direction[axis];
+    if(direction == 0.0)
+    {
+      if(origin < box.min[axis] || origin > box.max[axis])
+        return false;
+      continue;
+    }
+    double t0 = (box.min[axis] - origin) / direction;
+    double t1 = (box.max[axis] - origin) / direction;
+    enter = std::max(enter, std::min(t0, t1));
+    exit = std::min(exit, std::max(t0, t1));
+  }
+  return enter <= exit;
+}
+
+static glm::vec3 GridPoint(BenchRandom& random)
+{
+  return glm::vec3((float)(random.Next() % GRID), (float)(random.Next() % GRID), (float)(random.Next() % GRID));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Half the rays run along an axis and start on a box's face, the case
+// where the slab test multiplied 0 by an infinite inverse.  The rest go in
+// any direction, some with one or two components 0.
+//////////////////////////////////////////////////////////////////////////////
+static AabbTreeRay MakeRay(BenchRandom& random, const std::vector<Aabb>& boxes, unsigned int i)
+{
+  AabbTreeRay ray;
+  ray.max_t = (float)(random.Next() % GRID);
+  if(i % 2 == 0)
+  {
+    const Aabb& box = boxes[random.Next() % boxes.size()];
+    int axis = random.Next() % 3;
+    ray.origin = GridPoint(random);
+    ray.origin[(axis + 1) % 3] = random.Next() % 2 ? box.min[(axis + 1) % 3] : box.max[(axis + 1) % 3];
+    ray.direction = glm::vec3(0.0f);
+    ray.direction[axis] = random.Next() % 2 ? 1.0f : -1.0f;
+    return ray;
+  }
+  ray.origin = GridPoint(random);
+  for(int axis = 0; axis < 3; ++axis)
+    ray.direction[axis] = random.Next() % 3 == 0 ? 0.0f : (float)((int)(random.Next() % 5) - 2);
+  return ray;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Actors put themselves in the global tree with SetBounds(), move in it,
+// and are gone from it once destroyed.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckActors()
+{
+  AabbTree tree(0.1f, true);
+  BENCH_CHECK(AabbTree::Get() == &tree);
+  std::vector<ActorId> found;
+  {
+    Actor actor(7);
+    actor.SetBounds(Aabb(glm::vec3(0.0f), glm::vec3(1.0f)));
+    BENCH_CHECK(tree.NumProxies() == 1);
+    actor.SetBounds(Aabb(glm::vec3(10.0f), glm::vec3(11.0f)));
+    BENCH_CHECK(tree.NumProxies() == 1);
+    tree.QueryBox(Aabb(glm::vec3(9.0f), glm::vec3(12.0f)), found);
+    BENCH_CHECK(found.size() == 1 && found[0] == 7);
+    found.clear();
+    tree.QueryBox(Aabb(glm::vec3(-1.0f), glm::vec3(2.0f)), found);
+    BENCH_CHECK(found.empty());
+  }
+  BENCH_CHECK(tree.NumProxies() == 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Ray queries one at a time and batched, against testing every box.
+//////////////////////////////////////////////////////////////////////////////
+void AabbTreeBench()
+{
+  BenchRandom random(41);
+  AabbTree tree(0.0f);
+  std::vector<Aabb> boxes;
+  for(unsigned int i = 0; i < NUM_BOXES; ++i)
+  {
+    glm::vec3 min = GridPoint(random);
+    glm::vec3 size((float)(1 + random.Next() % 4), (float)(1 + random.Next() % 4), (float)(1 + random.Next() % 4));
+    boxes.push_back(Aabb(min, min + size));
+    tree.Insert(boxes.back(), i);
+  }
+  std::vector<AabbTreeRay> rays;
+  for(unsigned int i = 0; i < NUM_RAYS; ++i)
+    rays.push_back(MakeRay(random, boxes, i));
+
+  BenchTimer timer;
+  std::vector<std::vector<ActorId> > expected(NUM_RAYS);
+  for(unsigned int r = 0; r < NUM_RAYS; ++r)
+  {
+    for(unsigned int b = 0; b < NUM_BOXES; ++b)
+    {
+      if(RayHitsBox(rays[r], boxes[b]))
+        expected[r].push_back(b);
+    }
+  }
+  double brute_ms = timer.Milliseconds();
+
+  unsigned int wrong = 0, total_hits = 0;
+  std::vector<ActorId> found;
+  timer.Start();
+  for(unsigned int r = 0; r < NUM_RAYS; ++r)
+  {
+    found.clear();
+    tree.QueryRay(rays[r], found);
+    std::sort(found.begin(), found.end());
+    wrong += found != expected[r];
+    total_hits += (unsigned int)found.size();
+  }
+  double single_ms = timer.Milliseconds();
+  BENCH_CHECK(wrong == 0);
+
+  std::vector<AabbTreeHit> hits;
+  timer.Start();
+  tree.QueryRays(&rays[0], NUM_RAYS, hits);
+  double batch_ms = timer.Milliseconds();
+  std::vector<std::vector<ActorId> > batched(NUM_RAYS);
+  for(size_t i = 0; i < hits.size(); ++i)
+    batched[hits[i].query].push_back(hits[i].actor);
+  wrong = 0;
+  for(unsigned int r = 0; r < NUM_RAYS; ++r)
+  {
+    std::sort(batched[r].begin(), batched[r].end());
+    wrong += batched[r] != expected[r];
+  }
+  BENCH_CHECK(wrong == 0);
+
+  CheckActors();
+
+  printf("  %u boxes, %u rays, half along an axis from a box's face, %u hits\n", NUM_BOXES, NUM_RAYS, total_hits);
+  printf("  every box %.3f ms, QueryRay %.3f ms, QueryRays %.3f ms\n", brute_ms, single_ms, batch_ms);
+}
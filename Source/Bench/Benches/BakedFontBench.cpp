@@ -0,0 +1,229 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "../../Engine/Text/BakedFont.h"
+#include "../../Engine/Text/BakedFontBuilder.h"
+#include "../../Engine/Text/DistanceField.h"
+#include "../../Engine/Text/TextLayoutCache.h"
+#include "../../Engine/Utility/String.h"
+#include "../../Engine/Utility/Utf8.h"
+
+const unsigned int PIXEL_SIZE = 16;
+const unsigned int DISTANCE_FIELD_SIZE = 32;
+const unsigned int SPREAD = 4;
+const unsigned int STARTS = 20;
+static const wchar_t* BAKED_FILE = L"bench_font.bfnt";
+static const wchar_t* BAKED_DISTANCE_FILE = L"bench_font_distance.bfnt";
+
+//the first screen of a game, all characters that were baked
+static const char* SCREEN[] =
+{
+  "New Game", "Continue", "Load Game", "Options", "Video", "Audio", "Controls", "Credits", "Quit",
+  "Press any key to start", "Version 1.0.3 (build 2291)", "Copyright 2013"
+};
+const unsigned int NUM_SCREEN = sizeof(SCREEN) / sizeof(SCREEN[0]);
+
+//ASCII and Latin-1, the font has glyphs for some of them
+static std::string Characters()
+{
+  std::string text;
+  for(unsigned int c = 0x20; c < 0x100; ++c)
+  {
+    if(c < 0x80)
+    {
+      text += (char)c;
+    }
+    else if(c >= 0xa0)
+    {
+      text += (char)(0xc0 | (c >> 6));
+      text += (char)(0x80 | (c & 0x3f));
+    }
+  }
+  return text;
+}
+
+static bool SameBitmap(const GlyphBitmap& a, const GlyphBitmap& b)
+{
+  int width = a.pixels ? a.width : 0, height = a.pixels ? a.height : 0;
+  if(width != (b.pixels ? b.width : 0) || height != (b.pixels ? b.height : 0) ||
+     a.left != b.left || a.top != b.top || a.advance != b.advance)
+    return false;
+  for(int row = 0; row < height; ++row)
+  {
+    if(memcmp(a.pixels + row * a.pitch, b.pixels + row * b.pitch, width) != 0)
+      return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Every baked character, glyph, kerning pair and metric has to be what
+// FreeType gives for the font, and every character left out has to be
+// one the font doesnt have.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckPlain(const char* path, const BakedFont& baked, const std::string& text)
+{
+  FontCache fonts;
+  FontId font = fonts.AddFont(path);
+  std::vector<Utf32Char> characters(text.size());
+  size_t num_characters = 0;
+  Utf8ToUtf32(text.c_str(), text.size(), &characters[0], characters.size(), num_characters, true);
+
+  unsigned int wrong = 0;
+  std::vector<unsigned int> glyphs;
+  for(size_t i = 0; i < num_characters; ++i)
+  {
+    unsigned int glyph_index = fonts.GlyphIndex(font, characters[i]);
+    wrong += baked.GlyphIndex(characters[i]) != glyph_index;
+    if(glyph_index)
+      glyphs.push_back(glyph_index);
+  }
+  std::sort(glyphs.begin(), glyphs.end());
+  glyphs.erase(std::unique(glyphs.begin(), glyphs.end()), glyphs.end());
+  BENCH_CHECK(baked.NumGlyphs() == glyphs.size());
+
+  for(size_t i = 0; i < glyphs.size(); ++i)
+  {
+    GlyphBitmap expected, found;
+    BENCH_CHECK(fonts.Glyph(font, PIXEL_SIZE, glyphs[i], expected));
+    wrong += !baked.Glyph(glyphs[i], found) || !SameBitmap(expected, found);
+  }
+  unsigned int kerned = 0;
+  for(size_t left = 0; left < glyphs.size(); ++left)
+  {
+    for(size_t right = 0; right < glyphs.size(); ++right)
+    {
+      int amount = fonts.Kerning(font, PIXEL_SIZE, glyphs[left], glyphs[right]);
+      wrong += baked.Kerning(glyphs[left], glyphs[right]) != amount;
+      kerned += amount != 0;
+    }
+  }
+  FontMetrics expected, found;
+  BENCH_CHECK(fonts.Metrics(font, PIXEL_SIZE, expected));
+  baked.Metrics(found);
+  wrong += expected.ascender != found.ascender || expected.descender != found.descender || expected.line_height != found.line_height;
+  printf("  checked %u characters, %u glyphs and %u kerning pairs against FreeType\n",
+         (unsigned int)num_characters, (unsigned int)glyphs.size(), kerned);
+  BENCH_CHECK(wrong == 0);
+}
+
+//a distance field bake has to give the DistanceFieldGlyphs the glyphs they would have made
+static void CheckDistanceField(const char* path, const BakedFont& baked)
+{
+  FontCache fonts;
+  FontId font = fonts.AddFont(path);
+  DistanceFieldGlyphs made(fonts, DISTANCE_FIELD_SIZE, SPREAD);
+  FontCache baked_fonts;
+  FontId baked_font = baked_fonts.AddFont(path);
+  baked_fonts.AddBakedFont(baked_font, baked);
+  DistanceFieldGlyphs from_bake(baked_fonts, DISTANCE_FIELD_SIZE, SPREAD);
+  BENCH_CHECK(from_bake.Baked(baked_font) == &baked);
+
+  unsigned int wrong = 0;
+  for(unsigned int c = 0x20; c < 0x7f; ++c)
+  {
+    unsigned int glyph_index = fonts.GlyphIndex(font, c);
+    if(!glyph_index)
+      continue;
+    //copied, the next Glyph() call reuses the scratch
+    GlyphBitmap expected, found;
+    BENCH_CHECK(made.Glyph(font, glyph_index, expected));
+    std::vector<unsigned char> pixels(expected.pixels, expected.pixels + (expected.pixels ? expected.height * expected.pitch : 0));
+    expected.pixels = pixels.empty() ? 0 : &pixels[0];
+    wrong += !from_bake.Glyph(baked_font, glyph_index, found) || !SameBitmap(expected, found);
+  }
+  BENCH_CHECK(wrong == 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Everything a game does to put its first screen of text up, from a
+// FontCache that has only just been made.  With the bake attached the
+// font's file name is one that doesnt exist, so anything that reached
+// FreeType would fail.  Returns the vertices of every layout.
+//////////////////////////////////////////////////////////////////////////////
+static double FirstScreen(const char* path, const BakedFont* baked, std::vector<TextVertex>& vertices)
+{
+  BenchTimer timer;
+  FontCache fonts;
+  FontId font = fonts.AddFont(baked ? "no such font.ttf" : path);
+  if(baked)
+    fonts.AddBakedFont(font, *baked);
+  GlyphAtlas atlas(512, 512, 1);
+  TextLayoutCache layouts(fonts, atlas);
+  vertices.clear();
+  for(unsigned int i = 0; i < NUM_SCREEN; ++i)
+  {
+    const TextLayout* layout = layouts.Layout(font, PIXEL_SIZE, SCREEN[i], strlen(SCREEN[i]));
+    if(layout)
+      vertices.insert(vertices.end(), layout->vertices.begin(), layout->vertices.end());
+  }
+  return timer.Milliseconds();
+}
+
+static bool SameVertices(const std::vector<TextVertex>& a, const std::vector<TextVertex>& b)
+{
+  if(a.size() != b.size())
+    return false;
+  for(size_t i = 0; i < a.size(); ++i)
+  {
+    if(a[i].x != b[i].x || a[i].y != b[i].y || a[i].u != b[i].u || a[i].v != b[i].v)
+      return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Bakes the font in the tree for ASCII and Latin-1, plain and as distance
+// fields, checks the bakes against FreeType, and times putting up a first
+// screen of text from a cold FontCache with the font and with the bake
+// mapped in its place.
+//////////////////////////////////////////////////////////////////////////////
+void BakedFontBench()
+{
+  const char* path = BenchFontPath();
+  BENCH_CHECK(path != 0);
+  if(!path)
+    return;
+  std::string text = Characters();
+
+  BakedFontBuilder builder;
+  BENCH_CHECK(builder.SetFont(s2ws(path), PIXEL_SIZE));
+  builder.AddCharacters(text.c_str(), text.size());
+  BenchTimer timer;
+  BENCH_CHECK(builder.Build(BAKED_FILE));
+  double bake_ms = timer.Milliseconds();
+  const BakedFontBuilderStats& stats = builder.Stats();
+  printf("  baked %u characters, %u glyphs, %u kerning pairs, %ux%u atlas, %llu bytes, %.3f ms\n",
+         stats.characters, stats.glyphs, stats.kerning_pairs, stats.atlas_width, stats.atlas_height, stats.bytes, bake_ms);
+
+  BakedFontBuilder distance_builder;
+  BENCH_CHECK(distance_builder.SetFont(s2ws(path), DISTANCE_FIELD_SIZE));
+  distance_builder.SetDistanceField(SPREAD);
+  distance_builder.AddCharacters(text.c_str(), text.size());
+  BENCH_CHECK(distance_builder.Build(BAKED_DISTANCE_FILE));
+
+  {
+    BakedFont baked, distance_baked;
+    BENCH_CHECK(baked.Open(BAKED_FILE) && !baked.IsDistanceField());
+    BENCH_CHECK(distance_baked.Open(BAKED_DISTANCE_FILE) && distance_baked.IsDistanceField());
+    if(baked.IsOpen() && distance_baked.IsOpen())
+    {
+      CheckPlain(path, baked, text);
+      CheckDistanceField(path, distance_baked);
+
+      std::vector<TextVertex> expected, found;
+      double font_ms = 0.0, baked_ms = 0.0;
+      for(unsigned int i = 0; i < STARTS; ++i)
+      {
+        font_ms += FirstScreen(path, 0, expected);
+        timer.Start();
+        BakedFont cold;
+        cold.Open(BAKED_FILE);
+        baked_ms += timer.Milliseconds() + FirstScreen(path, &cold, found);
+      }
+      printf("  first screen of %u strings, from the font %.3f ms, from the bake %.3f ms\n", NUM_SCREEN, font_ms / STARTS, baked_ms / STARTS);
+      BENCH_CHECK(!expected.empty() && SameVertices(expected, found));
+    }
+  }
+  DeleteFileW(BAKED_FILE);
+  DeleteFileW(BAKED_DISTANCE_FILE);
+}
@@ -0,0 +1,123 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include <math.h>
+#include "../../Engine/Math/BatchMath.h"
+
+const unsigned int COUNT = 100000;
+const unsigned int REPEATS = 20;
+const float TOLERANCE = 1e-4f;
+
+static const char* PATH_NAMES[] = { "glm", "SSE", "AVX" };
+
+struct BatchData
+{
+  std::vector<glm::mat4> a, b, out;
+  std::vector<unsigned int> a_index;
+  std::vector<glm::vec3> points, points_out;
+  std::vector<glm::vec3> translation, scale;
+  std::vector<glm::quat> rotation;
+};
+
+//an affine matrix, the kind the kernels are used for
+static glm::mat4 RandomAffine(BenchRandom& random)
+{
+  glm::quat q(random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f));
+  glm::mat4 m = glm::mat4_cast(glm::normalize(q)) * random.Range(0.5f, 2.0f);
+  m[3] = glm::vec4(random.Range(-100.0f, 100.0f), random.Range(-100.0f, 100.0f), random.Range(-100.0f, 100.0f), 1.0f);
+  return m;
+}
+
+static void MakeData(BatchData& d)
+{
+  BenchRandom random(39);
+  for(unsigned int i = 0; i < COUNT; ++i)
+  {
+    d.a.push_back(RandomAffine(random));
+    d.b.push_back(RandomAffine(random));
+    d.a_index.push_back(random.Next() % COUNT);
+    d.points.push_back(glm::vec3(random.Range(-10.0f, 10.0f), random.Range(-10.0f, 10.0f), random.Range(-10.0f, 10.0f)));
+    d.translation.push_back(glm::vec3(random.Range(-10.0f, 10.0f), random.Range(-10.0f, 10.0f), random.Range(-10.0f, 10.0f)));
+    glm::quat q(random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f));
+    d.rotation.push_back(glm::normalize(q));
+    d.scale.push_back(glm::vec3(random.Range(0.5f, 1.5f), random.Range(0.5f, 1.5f), random.Range(0.5f, 1.5f)));
+  }
+  d.out.resize(COUNT);
+  d.points_out.resize(COUNT);
+}
+
+static float MaxError(const float* a, const float* b, size_t count)
+{
+  float error = 0.0f;
+  for(size_t i = 0; i < count; ++i)
+    error = std::max(error, fabsf(a[i] - b[i]) / std::max(1.0f, fabsf(b[i])));
+  return error;
+}
+
+static void RunKernel(BatchData& d, unsigned int kernel)
+{
+  switch(kernel)
+  {
+  case 0: BatchMultiply(&d.a[0], &d.b[0], &d.out[0], COUNT); break;
+  case 1: BatchMultiplyAffine(&d.a[0], &d.a_index[0], &d.b[0], &d.out[0], COUNT); break;
+  case 2: BatchTransformPoints(d.a[0], &d.points[0], &d.points_out[0], COUNT); break;
+  case 3: BatchInverseAffine(&d.a[0], &d.out[0], COUNT); break;
+  case 4: BatchComposeTRS(&d.translation[0], &d.rotation[0], &d.scale[0], &d.out[0], COUNT); break;
+  case 5: BatchComposeTRS(&d.a[0], &d.a_index[0], &d.translation[0], &d.rotation[0], &d.scale[0], &d.out[0], COUNT); break;
+  }
+}
+
+static const char* KERNEL_NAMES[] = { "multiply", "multiply affine", "transform points", "inverse affine", "compose TRS", "compose TRS parented" };
+const unsigned int NUM_KERNELS = sizeof(KERNEL_NAMES) / sizeof(KERNEL_NAMES[0]);
+
+//the points kernel writes vec3s, the rest matrices
+static const float* Output(const BatchData& d, unsigned int kernel, size_t& count)
+{
+  if(kernel == 2)
+  {
+    count = COUNT * 3;
+    return &d.points_out[0].x;
+  }
+  count = COUNT * 16;
+  return &d.out[0][0].x;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Times every kernel on every path the CPU has, 100000 elements at a time,
+// and checks each path against the plain glm one.  The tolerance is
+// relative, since the SIMD paths round in a different order.
+//////////////////////////////////////////////////////////////////////////////
+void BatchMathBench()
+{
+  BatchData d;
+  MakeData(d);
+  BatchMathPath best = BestBatchMathPath();
+  BatchMathPath old_path = GetBatchMathPath();
+  printf("  %u elements, best path %s\n", COUNT, PATH_NAMES[best]);
+
+  std::vector<float> reference;
+  BenchTimer timer;
+  for(unsigned int kernel = 0; kernel < NUM_KERNELS; ++kernel)
+  {
+    printf("  %-21s", KERNEL_NAMES[kernel]);
+    for(int path = BATCH_MATH_SCALAR; path <= best; ++path)
+    {
+      SetBatchMathPath((BatchMathPath)path);
+      RunKernel(d, kernel);
+      timer.Start();
+      for(unsigned int r = 0; r < REPEATS; ++r)
+        RunKernel(d, kernel);
+      double ms = timer.Milliseconds() / REPEATS;
+
+      size_t count = 0;
+      const float* out = Output(d, kernel, count);
+      if(path == BATCH_MATH_SCALAR)
+        reference.assign(out, out + count);
+      else
+        BENCH_CHECK(MaxError(out, &reference[0], count) < TOLERANCE);
+      g_bench_sink += (unsigned int)out[count - 1];
+      printf("  %s %7.3f ms", PATH_NAMES[path], ms);
+    }
+    printf("\n");
+  }
+  SetBatchMathPath(old_path);
+}
@@ -0,0 +1,77 @@
+#pragma once
+//========================================================================
+// BenchResourceFile.h : An IResourceFile for the resource benches
+//========================================================================
+
+#include "../../Engine/ResourceCache/ResourceCache.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// A resource file held in memory.  Every resource has the same bytes, only
+// the sizes differ, and none can be bigger than max_size.  Names ending in
+// .ogg are stored, so the cache maps them, and everything else has to be
+// copied out.
+//////////////////////////////////////////////////////////////////////////////
+class BenchResourceFile : public IResourceFile
+{
+  typedef std::tr1::unordered_map<std::string, unsigned int> Sizes;
+
+  Sizes _sizes;
+  StringVec _names;
+  std::vector<char> _bytes;
+
+public:
+  explicit BenchResourceFile(unsigned int max_size) : _bytes(max_size, 'x') {}
+
+  void Add(const std::string& name, unsigned int size)
+  {
+    _sizes[Resource(name).Name()] = size;
+    _names.push_back(name);
+  }
+
+  virtual bool Open() { return true; }
+
+  virtual int RawResourceSize(const Resource& r)
+  {
+    Sizes::iterator it = _sizes.find(r.Name());
+    return it == _sizes.end() ? -1 : (int)it->second;
+  }
+
+  virtual int RawResource(const Resource& r, char* buffer)
+  {
+    int size = RawResourceSize(r);
+    if(size > 0)
+      memcpy(buffer, &_bytes[0], size);
+    return size;
+  }
+
+  virtual const char* MappedResource(const Resource& r, int& out_size)
+  {
+    out_size = 0;
+    const std::string& name = r.Name();
+    if(name.size() < 4 || name.compare(name.size() - 4, 4, ".ogg") != 0)
+      return 0;
+    int size = RawResourceSize(r);
+    if(size < 0)
+      return 0;
+    out_size = size;
+    return &_bytes[0];
+  }
+
+  virtual bool PrefetchResource(const Resource& r) { return RawResourceSize(r) >= 0; }
+  virtual int NumResources() const { return (int)_names.size(); }
+  virtual std::string ResourceName(int num) const { return _names[num]; }
+
+  virtual int MatchResources(const WildcardPattern& pattern, std::vector<int>& out_nums) const
+  {
+    int matched = 0;
+    for(size_t i = 0; i < _names.size(); ++i)
+    {
+      if(pattern.Match(_names[i].c_str(), _names[i].size()))
+      {
+        out_nums.push_back((int)i);
+        ++matched;
+      }
+    }
+    return matched;
+  }
+};
@@ -0,0 +1,239 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "../../Engine/Text/DistanceField.h"
+#include "../../Engine/Math/BatchMath.h"
+
+static const unsigned int SIZES[] = { 12, 16, 20, 24, 32 };
+const unsigned int NUM_SIZES = sizeof(SIZES) / sizeof(SIZES[0]);
+const unsigned int BASE_SIZE = 32;
+const unsigned int SPREAD = 4;
+const unsigned int UPSCALE = 4;
+const int SHAPE_SIZE = 128;
+const unsigned int NUM_SHAPES = 8;
+//8SSEDT can carry along an offset that isnt quite the nearest, which is a fraction of an upscaled
+//pixel out and after averaging and rounding at most a step
+const int MAX_ERROR = 1;
+
+#pragma region Brute force
+
+struct BenchPoint
+{
+  int x;
+  int y;
+};
+
+//the distance from a pixel's center to the nearest of the points, squared
+static float NearestSquared(const std::vector<BenchPoint>& points, int x, int y)
+{
+  float best = FLT_MAX;
+  for(size_t i = 0; i < points.size(); ++i)
+  {
+    float dx = (float)(points[i].x - x), dy = (float)(points[i].y - y);
+    best = std::min(best, dx * dx + dy * dy);
+  }
+  return best;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The same distance field as DistanceTransform::Build(), with every
+// distance found by looking at every pixel.  Outside the image counts as
+// outside, which for the nearest outside pixel only the ring around the
+// image can be.
+//////////////////////////////////////////////////////////////////////////////
+static void BruteForce(const unsigned char* coverage, int width, int height, int scale, float spread, unsigned char* out)
+{
+  std::vector<BenchPoint> inside, outside;
+  for(int y = -1; y <= height; ++y)
+  {
+    for(int x = -1; x <= width; ++x)
+    {
+      BenchPoint point = { x, y };
+      bool border = x < 0 || y < 0 || x == width || y == height;
+      if(!border && coverage[y * width + x] >= 128)
+        inside.push_back(point);
+      else
+        outside.push_back(point);
+    }
+  }
+
+  float to_value = 127.0f / (spread * scale);
+  int out_width = width / scale, out_height = height / scale;
+  for(int j = 0; j < out_height; ++j)
+  {
+    for(int i = 0; i < out_width; ++i)
+    {
+      float sum = 0.0f;
+      for(int sy = (scale - 1) / 2; sy <= scale / 2; ++sy)
+      {
+        for(int sx = (scale - 1) / 2; sx <= scale / 2; ++sx)
+        {
+          int x = i * scale + sx, y = j * scale + sy;
+          if(coverage[y * width + x] >= 128)
+            sum += sqrtf(NearestSquared(outside, x, y)) - 0.5f;
+          else
+            sum -= sqrtf(NearestSquared(inside, x, y)) - 0.5f;
+        }
+      }
+      int samples = (scale % 2) ? 1 : 4;
+      float value = 128.0f + sum / samples * to_value;
+      out[j * out_width + i] = (unsigned char)std::max(0.0f, std::min(value + 0.5f, 255.0f));
+    }
+  }
+}
+
+//discs and bars, some of them holes, so there are curves, straight edges and thin parts
+static void MakeShape(BenchRandom& random, std::vector<unsigned char>& coverage)
+{
+  coverage.assign(SHAPE_SIZE * SHAPE_SIZE, 0);
+  for(unsigned int n = 0; n < 6; ++n)
+  {
+    unsigned char value = n % 3 == 2 ? 0 : 255;
+    float cx = random.Range(0.0f, (float)SHAPE_SIZE), cy = random.Range(0.0f, (float)SHAPE_SIZE);
+    float rx = random.Range(2.0f, 40.0f), ry = random.Range(2.0f, 40.0f);
+    bool disc = random.Next() % 2 == 0;
+    for(int y = 0; y < SHAPE_SIZE; ++y)
+    {
+      for(int x = 0; x < SHAPE_SIZE; ++x)
+      {
+        float dx = (x - cx) / rx, dy = (y - cy) / ry;
+        bool in = disc ? dx * dx + dy * dy <= 1.0f : fabsf(dx) <= 1.0f && fabsf(dy) <= 0.2f;
+        if(in)
+          coverage[y * SHAPE_SIZE + x] = value;
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Made up shapes through the transform on each path and by brute force.
+// SSE has to give exactly what the plain loop does, and both have to be
+// within MAX_ERROR of the true distances.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckTransform()
+{
+  BatchMathPath old_path = GetBatchMathPath();
+  BenchRandom random(48);
+  DistanceTransform transform;
+  std::vector<unsigned char> coverage;
+  int out_size = SHAPE_SIZE / UPSCALE;
+  std::vector<unsigned char> expected(out_size * out_size), scalar(out_size * out_size), sse(out_size * out_size);
+  int max_error = 0;
+  double total_error = 0.0;
+  unsigned int mismatched = 0;
+  for(unsigned int s = 0; s < NUM_SHAPES; ++s)
+  {
+    MakeShape(random, coverage);
+    BruteForce(&coverage[0], SHAPE_SIZE, SHAPE_SIZE, UPSCALE, (float)SPREAD, &expected[0]);
+    SetBatchMathPath(BATCH_MATH_SCALAR);
+    transform.Build(&coverage[0], SHAPE_SIZE, SHAPE_SIZE, SHAPE_SIZE, UPSCALE, (float)SPREAD, &scalar[0]);
+    SetBatchMathPath(BestBatchMathPath());
+    transform.Build(&coverage[0], SHAPE_SIZE, SHAPE_SIZE, SHAPE_SIZE, UPSCALE, (float)SPREAD, &sse[0]);
+    for(size_t i = 0; i < expected.size(); ++i)
+    {
+      int error = abs((int)scalar[i] - (int)expected[i]);
+      max_error = std::max(max_error, error);
+      total_error += error;
+      mismatched += scalar[i] != sse[i];
+    }
+  }
+  SetBatchMathPath(old_path);
+  printf("  %u shapes against brute force, largest error %d, mean %.3f of 255\n",
+         NUM_SHAPES, max_error, total_error / (NUM_SHAPES * expected.size()));
+  BENCH_CHECK(mismatched == 0);
+  BENCH_CHECK(max_error <= MAX_ERROR);
+}
+
+#pragma endregion
+
+//the glyphs for the characters the font has, from space up through Latin Extended-B
+static void FontGlyphs(FontCache& fonts, FontId font, std::vector<unsigned int>& glyphs)
+{
+  for(unsigned int c = 0x20; c < 0x250; ++c)
+  {
+    unsigned int glyph_index = fonts.GlyphIndex(font, c);
+    if(glyph_index != 0)
+      glyphs.push_back(glyph_index);
+  }
+  std::sort(glyphs.begin(), glyphs.end());
+  glyphs.erase(std::unique(glyphs.begin(), glyphs.end()), glyphs.end());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Makes every glyph on the scalar path and the best one, which have to
+// agree, and times them.  Returns the atlas pixels they take.
+//////////////////////////////////////////////////////////////////////////////
+static unsigned int MakeGlyphs(FontCache& fonts, FontId font, const std::vector<unsigned int>& glyphs)
+{
+  BatchMathPath old_path = GetBatchMathPath();
+  DistanceFieldGlyphs distance_fields(fonts, BASE_SIZE, SPREAD, UPSCALE);
+  std::vector<std::vector<unsigned char> > scalar(glyphs.size());
+  unsigned int pixels = 0, wrong = 0;      //with the atlas's one pixel of padding
+  BenchTimer timer;
+  for(int pass = 0; pass < 2; ++pass)
+  {
+    SetBatchMathPath(pass == 0 ? BATCH_MATH_SCALAR : BestBatchMathPath());
+    timer.Start();
+    for(size_t i = 0; i < glyphs.size(); ++i)
+    {
+      GlyphBitmap bitmap;
+      BENCH_CHECK(distance_fields.Glyph(font, glyphs[i], bitmap));
+      const unsigned char* begin = bitmap.pixels;
+      const unsigned char* end = bitmap.pixels ? bitmap.pixels + bitmap.width * bitmap.height : 0;
+      if(pass == 0)
+      {
+        scalar[i].assign(begin, end);
+        pixels += (bitmap.width + 1) * (bitmap.height + 1);
+      }
+      else
+      {
+        wrong += scalar[i].size() != (size_t)(end - begin) || !std::equal(begin, end, scalar[i].begin());
+      }
+    }
+    double ms = timer.Milliseconds();
+    printf("  distance fields %-6s %.3f ms, %.0f glyphs/s\n", pass == 0 ? "scalar" : "sse", ms, glyphs.size() / ms * 1000.0);
+  }
+  SetBatchMathPath(old_path);
+  BENCH_CHECK(wrong == 0);
+  return pixels;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The transform against brute force on made up shapes, then every glyph
+// in the font in the tree as a distance field, timed, and the atlas space
+// they take against plain glyphs at every HUD size.
+//////////////////////////////////////////////////////////////////////////////
+void DistanceFieldBench()
+{
+  CheckTransform();
+
+  const char* path = BenchFontPath();
+  BENCH_CHECK(path != 0);
+  if(!path)
+    return;
+  FontCache fonts;
+  FontId font = fonts.AddFont(path);
+  std::vector<unsigned int> glyphs;
+  FontGlyphs(fonts, font, glyphs);
+  BENCH_CHECK(!glyphs.empty());
+
+  //each size rendered fresh, so the FontCache's bitmap cache doesnt hide the rendering
+  unsigned int plain_pixels = 0;    //with the atlas's one pixel of padding
+  BenchTimer timer;
+  for(unsigned int s = 0; s < NUM_SIZES; ++s)
+  {
+    FontCache sized;
+    FontId sized_font = sized.AddFont(path);
+    for(size_t i = 0; i < glyphs.size(); ++i)
+    {
+      GlyphBitmap bitmap;
+      if(sized.Glyph(sized_font, SIZES[s], glyphs[i], bitmap) && bitmap.pixels)
+        plain_pixels += (bitmap.width + 1) * (bitmap.height + 1);
+    }
+  }
+  double plain_ms = timer.Milliseconds();
+  printf("  %u glyphs, plain at %u sizes %.3f ms\n", (unsigned int)glyphs.size(), NUM_SIZES, plain_ms);
+
+  unsigned int distance_pixels = MakeGlyphs(fonts, font, glyphs);
+  printf("  atlas pixels, plain at %u sizes %u, distance fields at %u %u\n", NUM_SIZES, plain_pixels, BASE_SIZE, distance_pixels);
+  BENCH_CHECK(distance_pixels < plain_pixels);
+}
@@ -0,0 +1,153 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "../../Engine/EventManager/EventManager.h"
+#include "../../Engine/Multicore/CriticalSection.h"
+
+const unsigned int EVENTS_PER_PRODUCER = 200000;
+const unsigned int MAX_PRODUCERS = 8;
+
+//the producer is in the top byte and its count in the rest, so the listener can check the order
+class BenchEvent : public BaseEventData
+{
+  unsigned int _payload;
+
+public:
+  static const EventType sk_EventType;
+
+  explicit BenchEvent(unsigned int payload) : _payload(payload) {}
+  virtual const EventType& Type() const { return sk_EventType; }
+  virtual IEventDataPtr Copy() const { return IEventDataPtr(SOL_NEW BenchEvent(_payload)); }
+  virtual const char* Name() const { return "BenchEvent"; }
+  unsigned int Payload() const { return _payload; }
+};
+
+const EventType BenchEvent::sk_EventType(0x3e5c1a6d);
+
+class BenchListener
+{
+  unsigned int _next[MAX_PRODUCERS];
+
+public:
+  unsigned int received;
+  unsigned int out_of_order;
+
+  BenchListener() : received(0), out_of_order(0) { memset(_next, 0, sizeof(_next)); }
+
+  //events from one producer have to arrive in the order it sent them
+  void OnEvent(const IEventDataPtr& event)
+  {
+    unsigned int payload = static_cast<BenchEvent*>(event.get())->Payload();
+    unsigned int producer = payload >> 24;
+    if(producer >= MAX_PRODUCERS || (payload & 0xffffff) != _next[producer])
+      ++out_of_order;
+    else
+      ++_next[producer];
+    ++received;
+  }
+};
+
+//the plainer way: every post takes a lock, and the main thread swaps the whole queue out at once
+class LockedEventQueue
+{
+  CriticalSection _cs;
+  std::vector<IEventDataPtr> _events;
+
+public:
+  void Push(const IEventDataPtr& event)
+  {
+    ScopedCriticalSection lock(_cs);
+    _events.push_back(event);
+  }
+
+  void Swap(std::vector<IEventDataPtr>& out_events)
+  {
+    ScopedCriticalSection lock(_cs);
+    _events.swap(out_events);
+  }
+};
+
+struct Producer
+{
+  unsigned int number;
+  EventManager* manager;
+  LockedEventQueue* locked;     //used instead of the manager when set
+};
+
+static DWORD WINAPI ProducerProc(void* param)
+{
+  Producer* producer = (Producer*)param;
+  for(unsigned int i = 0; i < EVENTS_PER_PRODUCER; ++i)
+  {
+    IEventDataPtr event(SOL_NEW BenchEvent((producer->number << 24) | i));
+    if(producer->locked)
+      producer->locked->Push(event);
+    else
+      producer->manager->ThreadSafeQueueEvent(event);
+  }
+  return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Starts the producers and drains on this thread until every event has
+// been sent, so the time covers making, posting and dispatching them.
+// Both ways go through Update(), only the hand over between the threads
+// differs.
+//////////////////////////////////////////////////////////////////////////////
+static double Run(unsigned int num_producers, bool locked)
+{
+  EventManager manager("Bench Event Mgr", false);
+  BenchListener listener;
+  manager.AddListener(EventListenerDelegate::FromMethod<BenchListener, &BenchListener::OnEvent>(&listener), BenchEvent::sk_EventType);
+  LockedEventQueue locked_queue;
+  std::vector<IEventDataPtr> swapped;
+
+  Producer producers[MAX_PRODUCERS];
+  HANDLE threads[MAX_PRODUCERS];
+  unsigned int total = num_producers * EVENTS_PER_PRODUCER;
+  BenchTimer timer;
+  for(unsigned int i = 0; i < num_producers; ++i)
+  {
+    producers[i].number = i;
+    producers[i].manager = &manager;
+    producers[i].locked = locked ? &locked_queue : 0;
+    threads[i] = CreateThread(NULL, 0, ProducerProc, &producers[i], 0, NULL);
+  }
+  while(listener.received < total)
+  {
+    if(locked)
+    {
+      locked_queue.Swap(swapped);
+      for(size_t i = 0; i < swapped.size(); ++i)
+        manager.QueueEvent(swapped[i]);
+      swapped.clear();
+    }
+    manager.Update();
+    if(listener.received < total)
+      SwitchToThread();
+  }
+  double ms = timer.Milliseconds();
+  WaitForMultipleObjects(num_producers, threads, TRUE, INFINITE);
+  for(unsigned int i = 0; i < num_producers; ++i)
+    CloseHandle(threads[i]);
+
+  BENCH_CHECK(listener.received == total);
+  BENCH_CHECK(listener.out_of_order == 0);
+  return ms;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Worker threads posting to the main thread, through the EventManager's
+// lock free queue and through a locked one, with more and more producers.
+//////////////////////////////////////////////////////////////////////////////
+void EventBench()
+{
+  printf("  %u events per producer\n", EVENTS_PER_PRODUCER);
+  for(unsigned int producers = 1; producers <= MAX_PRODUCERS; producers *= 2)
+  {
+    unsigned int total = producers * EVENTS_PER_PRODUCER;
+    double lock_free_ms = Run(producers, false);
+    double locked_ms = Run(producers, true);
+    printf("  %u producers: lock free %.2f M events/s, locked %.2f M events/s\n",
+           producers, total / lock_free_ms / 1000.0, total / locked_ms / 1000.0);
+  }
+}
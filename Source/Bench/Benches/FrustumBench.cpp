@@ -0,0 +1,182 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include <math.h>
+#include "../../Engine/Scene/FrustumCuller.h"
+#include "../../Engine/Math/BatchMath.h"
+#include "../../Engine/Multicore/JobSystem.h"
+#include "3rdParty/glm-0.9.3.4/glm/gtc/matrix_transform.hpp"
+
+const unsigned int NUM_VOLUMES = 1000000;
+const unsigned int REPEATS = 10;
+const float WORLD_SIZE = 1000.0f;
+//one in this many volumes is put against a plane, to test the boundary
+const unsigned int TOUCHING_EVERY = 16;
+//see FrustumCuller.h
+const double TOLERANCE = 1e-6;
+
+static const char* PATH_NAMES[] = { "scalar", "SSE", "AVX" };
+
+static glm::vec3 RandomPoint(BenchRandom& random)
+{
+  return glm::vec3(random.Range(-WORLD_SIZE, WORLD_SIZE), random.Range(-WORLD_SIZE, WORLD_SIZE), random.Range(-WORLD_SIZE, WORLD_SIZE));
+}
+
+//moves center onto a random plane, then out along the normal by reach so the volume just touches it
+static glm::vec3 Touching(const Frustum& frustum, BenchRandom& random, const glm::vec3& center, const glm::vec3& extent, float radius)
+{
+  glm::vec4 plane = frustum.Plane((FrustumPlane)(random.Next() % NUM_FRUSTUM_PLANES));
+  glm::vec3 normal(plane);
+  float reach = radius + glm::dot(glm::abs(normal), extent);
+  return center - normal * (glm::dot(normal, center) + plane.w + reach);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Whether a volume is so close to a plane that rounding can decide it.
+// The sums are redone in double, and a plane within TOLERANCE of the size
+// of its terms leaves the answer open unless another plane rules the
+// volume out for certain.
+//////////////////////////////////////////////////////////////////////////////
+static bool Ambiguous(const Frustum& frustum, const glm::vec3& center, const glm::vec3& extent, float radius)
+{
+  bool close = false;
+  for(int p = 0; p < NUM_FRUSTUM_PLANES; ++p)
+  {
+    const glm::vec4& plane = frustum.Plane((FrustumPlane)p);
+    double d = (double)plane.x * center.x + (double)plane.y * center.y + (double)plane.z * center.z + plane.w;
+    double r = (double)radius + fabs((double)plane.x) * extent.x + fabs((double)plane.y) * extent.y + fabs((double)plane.z) * extent.z;
+    double size = fabs((double)plane.x * center.x) + fabs((double)plane.y * center.y) + fabs((double)plane.z * center.z) + fabs((double)plane.w) + r;
+    double margin = d + r;
+    if(margin < -TOLERANCE * size)
+      return false;
+    if(margin <= TOLERANCE * size)
+      close = true;
+  }
+  return close;
+}
+
+//one flag per volume, from the culler's index list
+static void Flags(const FrustumCuller& culler, unsigned int count, std::vector<char>& flags)
+{
+  flags.assign(count, 0);
+  for(unsigned int i = 0; i < culler.NumVisible(); ++i)
+    flags[culler.Visible()[i]] = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Culls with every path, on one thread, and then the best path on the job
+// system.  Every result has to match the scalar one except for volumes
+// Ambiguous() says rounding decides, and those are reported.  The scalar
+// path is also checked against Frustum's own one at a time tests.
+//////////////////////////////////////////////////////////////////////////////
+template <class Volumes>
+static void Run(const char* name, const Frustum& frustum, const Volumes& volumes, JobSystem* jobs,
+                bool (*test)(const Frustum&, const Volumes&, unsigned int),
+                bool (*ambiguous)(const Frustum&, const Volumes&, unsigned int))
+{
+  unsigned int count = volumes.Count();
+  BatchMathPath best = BestBatchMathPath();
+  BatchMathPath old_path = GetBatchMathPath();
+  std::vector<char> reference, flags;
+  unsigned int differ = 0, wrong = 0, boundary = 0;
+  BenchTimer timer;
+
+  printf("  %-7s", name);
+  for(int path = BATCH_MATH_SCALAR; path <= best + 1; ++path)
+  {
+    bool threaded = path > best;
+    SetBatchMathPath(threaded ? best : (BatchMathPath)path);
+    FrustumCuller culler(threaded ? jobs : 0);
+    culler.Cull(frustum, volumes);
+    timer.Start();
+    for(unsigned int r = 0; r < REPEATS; ++r)
+      culler.Cull(frustum, volumes);
+    double ms = timer.Milliseconds() / REPEATS;
+
+    if(path == BATCH_MATH_SCALAR)
+    {
+      Flags(culler, count, reference);
+      for(unsigned int i = 0; i < count; ++i)
+      {
+        boundary += ambiguous(frustum, volumes, i);
+        if(reference[i] != (char)test(frustum, volumes, i) && !ambiguous(frustum, volumes, i))
+          ++wrong;
+      }
+    }
+    else
+    {
+      Flags(culler, count, flags);
+      for(unsigned int i = 0; i < count; ++i)
+      {
+        if(flags[i] == reference[i])
+          continue;
+        if(ambiguous(frustum, volumes, i))
+          ++differ;
+        else
+          ++wrong;
+      }
+    }
+    g_bench_sink += culler.NumVisible();
+    if(threaded)
+      printf("  %s %u threads %.3f ms", PATH_NAMES[best], jobs->NumThreads(), ms);
+    else
+      printf("  %s %.3f ms", PATH_NAMES[path], ms);
+  }
+  printf("\n  %-7s  %u of %u within rounding of a plane, %u of those differ from scalar\n", "", boundary, count, differ);
+  BENCH_CHECK(wrong == 0);
+  SetBatchMathPath(old_path);
+}
+
+static bool TestSphere(const Frustum& frustum, const BoundingSpheres& spheres, unsigned int i)
+{
+  return frustum.TestSphere(spheres.Center(i), spheres.Radius(i));
+}
+
+static bool AmbiguousSphere(const Frustum& frustum, const BoundingSpheres& spheres, unsigned int i)
+{
+  return Ambiguous(frustum, spheres.Center(i), glm::vec3(0.0f), spheres.Radius(i));
+}
+
+static bool TestBox(const Frustum& frustum, const BoundingBoxes& boxes, unsigned int i)
+{
+  glm::vec3 center = boxes.Center(i), extent = boxes.Extent(i);
+  return frustum.TestBox(center - extent, center + extent);
+}
+
+static bool AmbiguousBox(const Frustum& frustum, const BoundingBoxes& boxes, unsigned int i)
+{
+  return Ambiguous(frustum, boxes.Center(i), boxes.Extent(i), 0.0f);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// A million spheres and a million boxes scattered through a world a
+// camera sees part of, with one in sixteen moved to just touch a plane.
+//////////////////////////////////////////////////////////////////////////////
+void FrustumBench()
+{
+  glm::mat4 projection = glm::perspective(60.0f, 16.0f / 9.0f, 0.1f, WORLD_SIZE);
+  glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(100.0f, 0.0f, 100.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+  Frustum frustum(projection * view);
+
+  BenchRandom random(40);
+  BoundingSpheres spheres;
+  BoundingBoxes boxes;
+  for(unsigned int i = 0; i < NUM_VOLUMES; ++i)
+  {
+    glm::vec3 center = RandomPoint(random);
+    float radius = random.Range(0.1f, 10.0f);
+    if(i % TOUCHING_EVERY == 0)
+      center = Touching(frustum, random, center, glm::vec3(0.0f), radius);
+    spheres.Add(center, radius);
+
+    center = RandomPoint(random);
+    glm::vec3 extent(random.Range(0.1f, 10.0f), random.Range(0.1f, 10.0f), random.Range(0.1f, 10.0f));
+    if(i % TOUCHING_EVERY == 0)
+      center = Touching(frustum, random, center, extent, 0.0f);
+    boxes.Add(center - extent, center + extent);
+  }
+
+  printf("  %u volumes of each kind\n", NUM_VOLUMES);
+  JobSystem jobs;
+  Run("spheres", frustum, spheres, &jobs, TestSphere, AmbiguousSphere);
+  Run("boxes", frustum, boxes, &jobs, TestBox, AmbiguousBox);
+}
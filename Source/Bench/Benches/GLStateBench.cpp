@@ -0,0 +1,222 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "../../Engine/Graphics/GLStateCache.h"
+
+const unsigned int NUM_DRAWS = 20000;
+const unsigned int NUM_SHADERS = 32;
+const unsigned int NUM_MATERIALS = 512;
+const unsigned int NUM_MESHES = 200;
+const unsigned int FRAMES = 50;
+const unsigned int MAX_NAMES = 4096;
+
+//////////////////////////////////////////////////////////////////////////////
+// Stand in GL.  It counts the calls and keeps the state they leave behind
+// the way GL would, the element array buffer belonging to the bound vertex
+// array, so what the cache lets through can be checked against what the
+// renderer asked for.
+//////////////////////////////////////////////////////////////////////////////
+struct StubGL
+{
+  unsigned int calls;
+  GLuint program;
+  GLuint vertex_array;
+  GLuint elements[MAX_NAMES];   //for each vertex array
+  GLuint uniform_buffer;
+  GLuint active_unit;
+  GLuint textures[GLStateCache::MAX_TEXTURE_UNITS];
+  bool blend;
+  bool depth_test;
+  GLenum blend_source, blend_destination, blend_equation, depth_func;
+  GLboolean depth_mask;
+};
+static StubGL s_gl;
+
+static void GLAPIENTRY StubUseProgram(GLuint program) { ++s_gl.calls; s_gl.program = program; }
+static void GLAPIENTRY StubBindVertexArray(GLuint array) { ++s_gl.calls; s_gl.vertex_array = array; }
+static void GLAPIENTRY StubBindBuffer(GLenum target, GLuint buffer)
+{
+  ++s_gl.calls;
+  if(target == GL_ELEMENT_ARRAY_BUFFER)
+    s_gl.elements[s_gl.vertex_array] = buffer;
+  else if(target == GL_UNIFORM_BUFFER)
+    s_gl.uniform_buffer = buffer;
+}
+static void GLAPIENTRY StubActiveTexture(GLenum texture) { ++s_gl.calls; s_gl.active_unit = texture - GL_TEXTURE0; }
+static void GLAPIENTRY StubBindTexture(GLenum target, GLuint texture) { ++s_gl.calls; s_gl.textures[s_gl.active_unit] = texture; }
+static void StubCap(GLenum cap, bool enabled)
+{
+  ++s_gl.calls;
+  if(cap == GL_BLEND)
+    s_gl.blend = enabled;
+  else if(cap == GL_DEPTH_TEST)
+    s_gl.depth_test = enabled;
+}
+static void GLAPIENTRY StubEnable(GLenum cap) { StubCap(cap, true); }
+static void GLAPIENTRY StubDisable(GLenum cap) { StubCap(cap, false); }
+static void GLAPIENTRY StubBlendFunc(GLenum source, GLenum destination) { ++s_gl.calls; s_gl.blend_source = source; s_gl.blend_destination = destination; }
+static void GLAPIENTRY StubBlendEquation(GLenum mode) { ++s_gl.calls; s_gl.blend_equation = mode; }
+static void GLAPIENTRY StubDepthFunc(GLenum func) { ++s_gl.calls; s_gl.depth_func = func; }
+static void GLAPIENTRY StubDepthMask(GLboolean flag) { ++s_gl.calls; s_gl.depth_mask = flag; }
+
+static GLFunctions StubFunctions()
+{
+  GLFunctions gl;
+  gl.use_program = StubUseProgram;
+  gl.bind_vertex_array = StubBindVertexArray;
+  gl.bind_buffer = StubBindBuffer;
+  gl.active_texture = StubActiveTexture;
+  gl.bind_texture = StubBindTexture;
+  gl.enable = StubEnable;
+  gl.disable = StubDisable;
+  gl.blend_func = StubBlendFunc;
+  gl.blend_equation = StubBlendEquation;
+  gl.depth_func = StubDepthFunc;
+  gl.depth_mask = StubDepthMask;
+  return gl;
+}
+
+//what a draw needs bound, the way a renderer asks for it without knowing what is there already
+struct BenchDraw
+{
+  GLuint program;
+  GLuint vertex_array;
+  GLuint elements;
+  GLuint uniforms;
+  GLuint diffuse;
+  GLuint normals;
+  bool translucent;
+};
+
+static bool operator<(const BenchDraw& a, const BenchDraw& b)
+{
+  if(a.translucent != b.translucent)
+    return !a.translucent;
+  if(a.program != b.program)
+    return a.program < b.program;
+  return a.uniforms < b.uniforms;
+}
+
+static void MakeDraws(std::vector<BenchDraw>& draws)
+{
+  BenchRandom random(45);
+  for(unsigned int i = 0; i < NUM_DRAWS; ++i)
+  {
+    BenchDraw draw;
+    unsigned int mesh = random.Next() % NUM_MESHES;
+    unsigned int shader = random.Next() % NUM_SHADERS;
+    unsigned int material = shader * (NUM_MATERIALS / NUM_SHADERS) + random.Next() % (NUM_MATERIALS / NUM_SHADERS);
+    draw.program = 1 + shader;
+    draw.vertex_array = 1 + mesh;
+    draw.elements = 1 + mesh;
+    draw.uniforms = 1 + material;
+    draw.diffuse = 1 + material * 2;
+    draw.normals = 2 + material * 2;
+    draw.translucent = random.Next() % 8 == 0;
+    draws.push_back(draw);
+  }
+}
+
+static void SetState(GLStateCache& cache, const BenchDraw& draw)
+{
+  cache.UseProgram(draw.program);
+  cache.BindVertexArray(draw.vertex_array);
+  cache.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, draw.elements);
+  cache.BindBuffer(GL_UNIFORM_BUFFER, draw.uniforms);
+  cache.BindTexture(0, GL_TEXTURE_2D, draw.diffuse);
+  cache.BindTexture(1, GL_TEXTURE_2D, draw.normals);
+  cache.SetDepthTest(true);
+  cache.DepthFunc(GL_LEQUAL);
+  cache.SetBlend(draw.translucent);
+  if(draw.translucent)
+  {
+    cache.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    cache.BlendEquation(GL_FUNC_ADD);
+  }
+  cache.DepthMask(!draw.translucent);
+}
+
+static bool StateMatches(const BenchDraw& draw)
+{
+  bool blend_ok = !draw.translucent ||
+    (s_gl.blend_source == GL_SRC_ALPHA && s_gl.blend_destination == GL_ONE_MINUS_SRC_ALPHA && s_gl.blend_equation == GL_FUNC_ADD);
+  return s_gl.program == draw.program && s_gl.vertex_array == draw.vertex_array &&
+         s_gl.elements[s_gl.vertex_array] == draw.elements && s_gl.uniform_buffer == draw.uniforms &&
+         s_gl.textures[0] == draw.diffuse && s_gl.textures[1] == draw.normals &&
+         s_gl.depth_test && s_gl.depth_func == GL_LEQUAL && s_gl.blend == draw.translucent && blend_ok &&
+         s_gl.depth_mask == (draw.translucent ? GL_FALSE : GL_TRUE);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Sets every draw's state through the cache for FRAMES frames.  The stub
+// has to have been called exactly as often as the cache says it issued,
+// and has to hold each draw's state once it is set.
+//////////////////////////////////////////////////////////////////////////////
+static void Run(const char* name, const std::vector<BenchDraw>& draws)
+{
+  memset(&s_gl, 0, sizeof(s_gl));
+  GLStateCache cache(StubFunctions());
+  unsigned int wrong = 0;
+  for(size_t i = 0; i < draws.size(); ++i)
+  {
+    SetState(cache, draws[i]);
+    wrong += !StateMatches(draws[i]);
+  }
+  BENCH_CHECK(wrong == 0);
+  BENCH_CHECK(s_gl.calls == cache.Stats().issued);
+
+  cache.ResetStats();
+  BenchTimer timer;
+  for(unsigned int f = 0; f < FRAMES; ++f)
+  {
+    for(size_t i = 0; i < draws.size(); ++i)
+      SetState(cache, draws[i]);
+  }
+  double ms = timer.Milliseconds() / FRAMES;
+  const GLStateStats& stats = cache.Stats();
+  printf("  %-9s %u calls asked for a frame, %u made, %u removed, %.3f ms\n",
+         name, stats.requested / FRAMES, stats.issued / FRAMES, (stats.requested - stats.issued) / FRAMES, ms);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Deleted objects and state changed behind the cache's back have to be
+// bound again the next time they are asked for.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckForgetting()
+{
+  memset(&s_gl, 0, sizeof(s_gl));
+  GLStateCache cache(StubFunctions());
+  cache.BindVertexArray(1);
+  cache.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 5);
+  cache.BindVertexArray(2);
+  cache.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 5);
+  BENCH_CHECK(s_gl.elements[2] == 5);
+
+  cache.BindTexture(3, GL_TEXTURE_2D, 9);
+  cache.OnDeleteTexture(9);
+  s_gl.textures[3] = 0;
+  cache.BindTexture(3, GL_TEXTURE_2D, 9);
+  BENCH_CHECK(s_gl.textures[3] == 9);
+
+  cache.UseProgram(4);
+  s_gl.program = 0;
+  cache.Invalidate();
+  cache.UseProgram(4);
+  BENCH_CHECK(s_gl.program == 4);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// 20000 draws a frame, an eighth of them translucent, setting their state
+// through the cache onto the stub GL.  In the order they were made every
+// draw changes almost everything, sorted by translucency, shader and
+// material most of the calls are already bound.
+//////////////////////////////////////////////////////////////////////////////
+void GLStateBench()
+{
+  std::vector<BenchDraw> draws;
+  MakeDraws(draws);
+  printf("  %u draws, %u shaders, %u materials, %u meshes\n", NUM_DRAWS, NUM_SHADERS, NUM_MATERIALS, NUM_MESHES);
+  Run("unsorted", draws);
+  std::stable_sort(draws.begin(), draws.end());
+  Run("sorted", draws);
+  CheckForgetting();
+}
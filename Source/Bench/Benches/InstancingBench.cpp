@@ -0,0 +1,157 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "../../Engine/Graphics/InstanceBatcher.h"
+#include "../../Engine/Graphics/RenderQueue.h"
+#include "../../Engine/Scene/TransformHierarchy.h"
+#include "../../Engine/Multicore/JobSystem.h"
+
+const unsigned int NUM_OBJECTS = 100000;
+const unsigned int NUM_MESHES = 40;
+const unsigned int NUM_MATERIALS = 8;
+const unsigned int FRAMES = 20;
+
+//////////////////////////////////////////////////////////////////////////////
+// Foliage and a crowd, a handful of meshes copied many times over.  A
+// tenth of the copies also draw in a shadow pass, the rest only in the main
+// one.  Keys are either front to back or instanced.
+//////////////////////////////////////////////////////////////////////////////
+static void AddScene(RenderQueue& queue, const std::vector<TransformId>& transforms, bool instanced)
+{
+  BenchRandom random(46);
+  queue.Begin(1);
+  RenderBucket& bucket = queue.Bucket(0);
+  for(unsigned int i = 0; i < NUM_OBJECTS; ++i)
+  {
+    DrawCommand command;
+    command.mesh = random.Next() % NUM_MESHES;
+    command.material = command.mesh % NUM_MATERIALS;
+    command.shader = command.material / 4;
+    command.transform = transforms[i];
+    command.colour = glm::vec4(random.Range(0.5f, 1.0f), random.Range(0.5f, 1.0f), random.Range(0.5f, 1.0f), 1.0f);
+    float depth = random.Range(0.0f, 1.0f);
+    unsigned int passes = random.Next() % 10 == 0 ? 2 : 1;
+    for(unsigned int pass = 0; pass < passes; ++pass)
+    {
+      if(instanced)
+        bucket.Add(MakeInstancedRenderKey(0, pass, command.shader, command.material, command.mesh), command);
+      else
+        bucket.Add(MakeRenderKey(0, pass, command.shader, command.material, depth), command);
+    }
+  }
+  queue.Sort();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Every command is in exactly one draw, in order, alike with the rest of
+// its draw and unlike the draw before, and its instance has its world
+// matrix and colour.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckDraws(const InstanceBatcher& batcher, const RenderQueue& queue, const TransformHierarchy& hierarchy)
+{
+  const RenderKey* keys = queue.Keys();
+  const DrawCommand* commands = queue.Commands();
+  unsigned int next = 0, wrong = 0;
+  for(unsigned int d = 0; d < batcher.NumDraws(); ++d)
+  {
+    const InstancedDraw& draw = batcher.Draws()[d];
+    wrong += draw.first_instance != next || draw.num_instances == 0;
+    for(unsigned int i = draw.first_instance; i < draw.first_instance + draw.num_instances && i < queue.Count(); ++i)
+    {
+      wrong += commands[i].mesh != draw.mesh || commands[i].shader != draw.shader || commands[i].material != draw.material;
+      wrong += RenderKeyLayer(keys[i]) != RenderKeyLayer(draw.key) || RenderKeyPass(keys[i]) != RenderKeyPass(draw.key);
+      wrong += batcher.Instances()[i].world != hierarchy.World(commands[i].transform);
+      wrong += batcher.Instances()[i].colour != commands[i].colour;
+    }
+    if(d > 0 && draw.first_instance < queue.Count())
+    {
+      unsigned int last = draw.first_instance - 1;
+      bool alike = commands[last].mesh == draw.mesh && commands[last].shader == draw.shader && commands[last].material == draw.material &&
+                   RenderKeyLayer(keys[last]) == RenderKeyLayer(draw.key) && RenderKeyPass(keys[last]) == RenderKeyPass(draw.key);
+      wrong += alike;
+    }
+    next = draw.first_instance + draw.num_instances;
+  }
+  BENCH_CHECK(next == queue.Count());
+  BENCH_CHECK(batcher.NumInstances() == queue.Count());
+  BENCH_CHECK(wrong == 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The same mesh and material either side of a pass change is two draws.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckPasses(const TransformHierarchy& hierarchy)
+{
+  DrawCommand commands[2];
+  commands[0].mesh = commands[1].mesh = 3;
+  commands[0].shader = commands[1].shader = 1;
+  commands[0].material = commands[1].material = 2;
+  commands[0].transform = commands[1].transform = INVALID_TRANSFORM_ID;
+  commands[0].colour = commands[1].colour = glm::vec4(1.0f);
+  RenderKey keys[2] = { MakeInstancedRenderKey(0, 0, 1, 2, 3), MakeInstancedRenderKey(0, 1, 1, 2, 3) };
+  InstanceBatcher batcher;
+  batcher.Build(keys, commands, 2, hierarchy);
+  BENCH_CHECK(batcher.NumDraws() == 2);
+  keys[1] = MakeInstancedRenderKey(1, 0, 1, 2, 3);
+  batcher.Build(keys, commands, 2, hierarchy);
+  BENCH_CHECK(batcher.NumDraws() == 2);
+}
+
+static void Run(JobSystem* jobs, const char* name, const RenderQueue& queue, const TransformHierarchy& hierarchy)
+{
+  InstanceBatcher batcher(jobs);
+  std::vector<InstanceData> mapped(queue.Count());
+  BenchTimer timer;
+  for(unsigned int f = 0; f < FRAMES; ++f)
+    batcher.Build(queue, hierarchy);
+  double own_ms = timer.Milliseconds() / FRAMES;
+  CheckDraws(batcher, queue, hierarchy);
+  timer.Start();
+  for(unsigned int f = 0; f < FRAMES; ++f)
+    batcher.Build(queue, hierarchy, &mapped[0]);
+  double mapped_ms = timer.Milliseconds() / FRAMES;
+  BENCH_CHECK(batcher.Instances() == &mapped[0]);
+  CheckDraws(batcher, queue, hierarchy);
+  printf("  %-10s build %.3f ms, into a caller's buffer %.3f ms\n", name, own_ms, mapped_ms);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// 100000 objects from 40 meshes, sorted with front to back keys and with
+// instanced keys, and the draws the batcher makes of each.  Building, which
+// packs a matrix and colour per command, is timed on one thread and on the
+// job system.
+//////////////////////////////////////////////////////////////////////////////
+void InstancingBench()
+{
+  TransformHierarchy hierarchy;
+  BenchRandom random(146);
+  std::vector<TransformId> transforms;
+  for(unsigned int i = 0; i < NUM_OBJECTS; ++i)
+  {
+    transforms.push_back(hierarchy.Create());
+    glm::vec3 position(random.Range(-500.0f, 500.0f), 0.0f, random.Range(-500.0f, 500.0f));
+    hierarchy.SetLocal(transforms.back(), position, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(random.Range(0.8f, 1.2f)));
+  }
+  hierarchy.Update();
+
+  RenderQueue queue;
+  AddScene(queue, transforms, false);
+  InstanceBatcher batcher;
+  batcher.Build(queue, hierarchy);
+  CheckDraws(batcher, queue, hierarchy);
+  unsigned int depth_draws = batcher.NumDraws();
+
+  AddScene(queue, transforms, true);
+  batcher.Build(queue, hierarchy);
+  CheckDraws(batcher, queue, hierarchy);
+  BENCH_CHECK(batcher.NumDraws() <= NUM_MESHES * 2);
+
+  printf("  %u objects, %u commands with the shadow pass, %u meshes\n", NUM_OBJECTS, queue.Count(), NUM_MESHES);
+  printf("  front to back keys %u draws, instanced keys %u draws, %.1f MB of instances\n",
+         depth_draws, batcher.NumDraws(), batcher.InstanceBytes() / (1024.0 * 1024.0));
+  Run(0, "1 thread", queue, hierarchy);
+  JobSystem jobs;
+  char name[32];
+  _snprintf_s(name, sizeof(name), _TRUNCATE, "%u threads", jobs.NumThreads());
+  Run(&jobs, name, queue, hierarchy);
+  CheckPasses(hierarchy);
+}
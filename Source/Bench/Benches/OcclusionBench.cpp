@@ -0,0 +1,150 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "../../Engine/Scene/OcclusionBuffer.h"
+#include "../../Engine/Scene/FrustumCuller.h"
+#include "../../Engine/Multicore/JobSystem.h"
+#include "3rdParty/glm-0.9.3.4/glm/gtc/matrix_transform.hpp"
+
+const unsigned int BLOCKS = 40;             //buildings along each side of the city
+const float BLOCK_SPACING = 20.0f;
+const float BUILDING_SIZE = 14.0f;
+const unsigned int NUM_PROPS = 100000;
+const unsigned int REPEATS = 20;
+
+//a unit cube from 0 to 1, its triangles counter-clockwise seen from outside
+static const glm::vec3 CUBE_VERTICES[8] =
+{
+  glm::vec3(0, 0, 0), glm::vec3(1, 0, 0), glm::vec3(1, 1, 0), glm::vec3(0, 1, 0),
+  glm::vec3(0, 0, 1), glm::vec3(1, 0, 1), glm::vec3(1, 1, 1), glm::vec3(0, 1, 1)
+};
+static const unsigned int CUBE_INDICES[36] =
+{
+  0, 2, 1, 0, 3, 2,   //-z
+  4, 5, 6, 4, 6, 7,   //+z
+  0, 1, 5, 0, 5, 4,   //-y
+  3, 6, 2, 3, 7, 6,   //+y
+  0, 4, 7, 0, 7, 3,   //-x
+  1, 2, 6, 1, 6, 5    //+x
+};
+
+static glm::mat4 Projection()
+{
+  return glm::perspective(60.0f, 2.0f, 0.5f, 2000.0f);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// One wall across the whole view 50 units away.  Everything behind it has
+// to be hidden and everything in front of it visible, on one thread and on
+// the job system.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckWall(JobSystem* jobs)
+{
+  glm::mat4 view_projection = Projection();
+  glm::mat4 wall = glm::translate(glm::mat4(1.0f), glm::vec3(-1000.0f, -1000.0f, -51.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(2000.0f, 2000.0f, 1.0f));
+
+  BenchRandom random(43);
+  std::vector<Aabb> boxes;
+  std::vector<unsigned char> expected;
+  for(unsigned int i = 0; i < 2000; ++i)
+  {
+    bool behind = i % 2 == 0;
+    float z = behind ? random.Range(-500.0f, -60.0f) : random.Range(-45.0f, -5.0f);
+    glm::vec3 center(random.Range(-0.4f, 0.4f) * -z, random.Range(-0.2f, 0.2f) * -z, z);
+    glm::vec3 extent(random.Range(0.1f, 2.0f));
+    boxes.push_back(Aabb(center - extent, center + extent));
+    expected.push_back(behind ? 0 : 1);
+  }
+
+  for(int threaded = 0; threaded < 2; ++threaded)
+  {
+    OcclusionBuffer buffer(256, 128, threaded ? jobs : 0);
+    buffer.Begin(view_projection);
+    buffer.AddOccluder(wall, CUBE_VERTICES, CUBE_INDICES, 36);
+    buffer.Render();
+    std::vector<unsigned char> visible(boxes.size());
+    buffer.TestBoxes(&boxes[0], (unsigned int)boxes.size(), &visible[0]);
+    BENCH_CHECK(visible == expected);
+    for(unsigned int i = 0; i < boxes.size(); ++i)
+      BENCH_CHECK(buffer.IsVisible(boxes[i]) == (visible[i] != 0));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// A city of BLOCKS x BLOCKS buildings seen from the street, with props
+// scattered through it.  The props the frustum lets through are tested
+// against the occlusion buffer, and the buffer and results have to be the
+// same on one thread and on the job system.
+//////////////////////////////////////////////////////////////////////////////
+void OcclusionBench()
+{
+  BenchRandom random(143);
+  std::vector<glm::mat4> buildings;
+  for(unsigned int bx = 0; bx < BLOCKS; ++bx)
+  {
+    for(unsigned int bz = 0; bz < BLOCKS; ++bz)
+    {
+      glm::vec3 corner(bx * BLOCK_SPACING, 0.0f, bz * BLOCK_SPACING);
+      glm::vec3 size(BUILDING_SIZE, random.Range(10.0f, 60.0f), BUILDING_SIZE);
+      buildings.push_back(glm::translate(glm::mat4(1.0f), corner) * glm::scale(glm::mat4(1.0f), size));
+    }
+  }
+  float city = BLOCKS * BLOCK_SPACING;
+  BoundingBoxes props;
+  for(unsigned int i = 0; i < NUM_PROPS; ++i)
+  {
+    glm::vec3 min(random.Range(0.0f, city), 0.0f, random.Range(0.0f, city));
+    props.Add(min, min + glm::vec3(random.Range(1.0f, 4.0f), random.Range(1.0f, 3.0f), random.Range(1.0f, 4.0f)));
+  }
+
+  //down a street, from just inside the city
+  glm::vec3 eye(BUILDING_SIZE + 3.0f, 1.7f, 2.0f);
+  glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(0.3f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+  glm::mat4 view_projection = Projection() * view;
+  Frustum frustum(view_projection);
+  FrustumCuller culler;
+  culler.Cull(frustum, props);
+  std::vector<Aabb> candidates;
+  for(unsigned int i = 0; i < culler.NumVisible(); ++i)
+  {
+    unsigned int p = culler.Visible()[i];
+    candidates.push_back(Aabb(props.Center(p) - props.Extent(p), props.Center(p) + props.Extent(p)));
+  }
+
+  JobSystem jobs;
+  std::vector<unsigned char> visible[2];
+  std::vector<float> depth[2];
+  double render_ms[2], test_ms[2];
+  unsigned int num_triangles = 0;
+  BenchTimer timer;
+  for(int threaded = 0; threaded < 2; ++threaded)
+  {
+    OcclusionBuffer buffer(256, 128, threaded ? &jobs : 0);
+    visible[threaded].resize(candidates.size());
+    timer.Start();
+    for(unsigned int r = 0; r < REPEATS; ++r)
+    {
+      buffer.Begin(view_projection);
+      for(size_t b = 0; b < buildings.size(); ++b)
+        buffer.AddOccluder(buildings[b], CUBE_VERTICES, CUBE_INDICES, 36);
+      buffer.Render();
+    }
+    render_ms[threaded] = timer.Milliseconds() / REPEATS;
+    timer.Start();
+    for(unsigned int r = 0; r < REPEATS; ++r)
+      buffer.TestBoxes(&candidates[0], (unsigned int)candidates.size(), &visible[threaded][0]);
+    test_ms[threaded] = timer.Milliseconds() / REPEATS;
+    depth[threaded].assign(buffer.Depth(), buffer.Depth() + buffer.Width() * buffer.Height());
+    num_triangles = buffer.NumTriangles();
+  }
+  BENCH_CHECK(visible[0] == visible[1]);
+  BENCH_CHECK(depth[0] == depth[1]);
+  CheckWall(&jobs);
+
+  unsigned int num_visible = 0;
+  for(size_t i = 0; i < visible[0].size(); ++i)
+    num_visible += visible[0][i];
+  printf("  %u buildings, %u front facing occluder triangles, 256x128 buffer\n", (unsigned int)buildings.size(), num_triangles);
+  printf("  %u props, %u in the frustum, %u not occluded\n", NUM_PROPS, (unsigned int)candidates.size(), num_visible);
+  printf("  1 thread:  render %.3f ms, test %.3f ms\n", render_ms[0], test_ms[0]);
+  printf("  %u threads: render %.3f ms, test %.3f ms\n", jobs.NumThreads(), render_ms[1], test_ms[1]);
+}
@@ -0,0 +1,223 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "../../Engine/ResourceCache/PackBuilder.h"
+#include "../../Engine/ResourceCache/Resource.h"
+#include "../../Engine/ResourceCache/ZipDeflate.h"
+#include "../../Engine/ResourceCache/ZipInflate.h"
+#include "../../Engine/ResourceCache/ZipFile.h"
+
+const unsigned int WINDOW_SIZE = 32768;
+const unsigned int MAX_MATCH = 258;
+const unsigned int TIMED_SIZE = 4 * 1024 * 1024;
+static const wchar_t* ARCHIVE = L"bench_pack.zip";
+
+static void RandomBytes(BenchRandom& random, unsigned int count, std::string& out)
+{
+  for(unsigned int i = 0; i < count; ++i)
+    out += (char)(random.Next() >> 24);
+}
+
+//words from a small vocabulary, about what XML and scripts compress like
+static void Text(BenchRandom& random, unsigned int size, std::string& out)
+{
+  static const char* WORDS[] = { "<actor ", "name=\"", "Tree", "Rock", "\" ", "x=\"", "y=\"", "12", "0.5", "/>\n", "component", "type" };
+  while(out.size() < size)
+    out += WORDS[random.Next() % (sizeof(WORDS) / sizeof(WORDS[0]))];
+  out.resize(size);
+}
+
+#pragma region Deflate round trip
+
+//deflates then inflates, returns false unless the bytes came back the same
+static bool RoundTrip(const std::string& input, unsigned int& out_packed_size)
+{
+  unsigned int size = (unsigned int)input.size();
+  //one more readable byte after the deflate data, the way a zip always has one
+  std::vector<char> packed(ZipDeflateBound(size) + 1);
+  out_packed_size = ZipDeflate(input.data(), size, &packed[0], (unsigned int)packed.size() - 1);
+  if(out_packed_size == 0)
+    return false;
+  std::vector<char> unpacked(size + 1);
+  int written = ZipInflate(&packed[0], out_packed_size, &unpacked[0], size);
+  return written == (int)size && memcmp(&unpacked[0], input.data(), size) == 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Inputs that reach every corner of the encoder: nothing, a byte or two,
+// data that wont compress, runs at and past the longest match, repeats
+// right at the edge of the window and just past it, and text.  Each one
+// has to come back from ZipInflate exactly.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckRoundTrips()
+{
+  BenchRandom random(32);
+  std::vector<std::string> inputs;
+  std::vector<const char*> names;
+
+  inputs.push_back(std::string());
+  names.push_back("empty");
+  inputs.push_back(std::string("a"));
+  names.push_back("1 byte");
+  inputs.push_back(std::string("ab"));
+  names.push_back("2 bytes");
+
+  inputs.push_back(std::string());
+  RandomBytes(random, 100000, inputs.back());
+  names.push_back("random");
+
+  inputs.push_back(std::string(MAX_MATCH, 'r'));
+  names.push_back("258 run");
+  inputs.push_back(std::string(MAX_MATCH + 1, 'r') + "x" + std::string(MAX_MATCH * 40 + 7, 'r'));
+  names.push_back("long runs");
+
+  //the same 300 bytes again exactly a window back, then a byte past it
+  for(unsigned int distance = WINDOW_SIZE - 1; distance <= WINDOW_SIZE + 1; ++distance)
+  {
+    std::string block;
+    RandomBytes(random, 300, block);
+    std::string filler;
+    RandomBytes(random, distance - (unsigned int)block.size(), filler);
+    inputs.push_back(block + filler + block);
+    names.push_back(distance < WINDOW_SIZE ? "window - 1" : distance == WINDOW_SIZE ? "window edge" : "window + 1");
+  }
+
+  inputs.push_back(std::string());
+  Text(random, 200000, inputs.back());
+  names.push_back("text");
+
+  unsigned int wrong = 0;
+  for(size_t i = 0; i < inputs.size(); ++i)
+  {
+    unsigned int packed_size = 0;
+    bool same = RoundTrip(inputs[i], packed_size);
+    wrong += !same;
+    printf("  %-12s %7u bytes to %7u%s\n", names[i], (unsigned int)inputs[i].size(), packed_size, same ? "" : ", WRONG");
+  }
+  BENCH_CHECK(wrong == 0);
+}
+
+static void TimeDeflate()
+{
+  BenchRandom random(320);
+  std::string input;
+  Text(random, TIMED_SIZE, input);
+  std::vector<char> packed(ZipDeflateBound(TIMED_SIZE) + 1), unpacked(TIMED_SIZE);
+
+  BenchTimer timer;
+  unsigned int packed_size = ZipDeflate(input.data(), TIMED_SIZE, &packed[0], (unsigned int)packed.size() - 1);
+  double deflate_ms = timer.Milliseconds();
+  timer.Start();
+  int written = ZipInflate(&packed[0], packed_size, &unpacked[0], TIMED_SIZE);
+  double inflate_ms = timer.Milliseconds();
+  printf("  %u MB of text to %.1f%%, deflate %.0f MB/s, inflate %.0f MB/s\n", TIMED_SIZE >> 20, packed_size * 100.0 / TIMED_SIZE,
+         (TIMED_SIZE >> 20) / deflate_ms * 1000.0, (TIMED_SIZE >> 20) / inflate_ms * 1000.0);
+  BENCH_CHECK(written == (int)TIMED_SIZE && memcmp(&unpacked[0], input.data(), TIMED_SIZE) == 0);
+}
+
+#pragma endregion
+
+#pragma region PackBuilder
+
+static bool WriteBenchFile(const std::wstring& path, const std::string& data)
+{
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if(file == INVALID_HANDLE_VALUE)
+    return false;
+  DWORD written = 0;
+  bool success = data.empty() || (WriteFile(file, data.data(), (DWORD)data.size(), &written, NULL) && written == data.size());
+  CloseHandle(file);
+  return success;
+}
+
+static bool FileExists(const std::wstring& path)
+{
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if(file == INVALID_HANDLE_VALUE)
+    return false;
+  CloseHandle(file);
+  return true;
+}
+
+struct BenchPackFile
+{
+  const char* name;
+  const wchar_t* path;
+  std::string data;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Packs text, a copy of it under another name, random bytes, a sound and
+// an empty file, and reads every one back through ResourceZipFile.  Then
+// a build with a file that cant be read has to fail without leaving an
+// archive behind.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckPack()
+{
+  BenchRandom random(3200);
+  BenchPackFile files[] =
+  {
+    { "actors/tree.xml", L"bench_pack_tree.xml", "" },
+    { "actors/copy of tree.xml", L"bench_pack_copy.xml", "" },
+    { "textures/noise.dds", L"bench_pack_noise.dds", "" },
+    { "sounds/wind.ogg", L"bench_pack_wind.ogg", "" },
+    { "scripts/empty.lua", L"bench_pack_empty.lua", "" }
+  };
+  const unsigned int num_files = sizeof(files) / sizeof(files[0]);
+  Text(random, 50000, files[0].data);
+  files[1].data = files[0].data;
+  RandomBytes(random, 50000, files[2].data);
+  Text(random, 20000, files[3].data);
+
+  PackBuilder builder;
+  for(unsigned int i = 0; i < num_files; ++i)
+  {
+    BENCH_CHECK(WriteBenchFile(files[i].path, files[i].data));
+    builder.AddFile(files[i].name, files[i].path);
+  }
+  BENCH_CHECK(builder.Build(ARCHIVE));
+  const PackBuilderStats& stats = builder.Stats();
+  printf("  packed %u files, %u duplicates, %u deflated, %u stored, %llu bytes to %llu\n",
+         stats.files, stats.duplicates, stats.deflated, stats.stored, stats.raw_bytes, stats.packed_bytes);
+  //the text deflates, the noise doesnt shrink enough and the sound is never tried
+  BENCH_CHECK(stats.files == num_files && stats.duplicates == 1 && stats.deflated == 1 && stats.stored == 3);
+
+  {
+    ResourceZipFile zip(ARCHIVE);
+    BENCH_CHECK(zip.Open() && zip.NumResources() == (int)num_files);
+    unsigned int wrong = 0;
+    for(unsigned int i = 0; i < num_files; ++i)
+    {
+      Resource resource(files[i].name);
+      int size = zip.RawResourceSize(resource);
+      std::vector<char> buffer(files[i].data.size() + 1);
+      wrong += size != (int)files[i].data.size() || zip.RawResource(resource, &buffer[0]) != size ||
+               memcmp(&buffer[0], files[i].data.data(), size) != 0;
+    }
+    int mapped_size = 0;
+    wrong += zip.MappedResource(Resource(files[3].name), mapped_size) == 0 || mapped_size != (int)files[3].data.size();
+    BENCH_CHECK(wrong == 0);
+  }
+
+  PackBuilder failing;
+  failing.AddFile(files[0].name, files[0].path);
+  failing.AddFile("missing.xml", L"bench_pack_missing.xml");
+  BENCH_CHECK(!failing.Build(ARCHIVE));
+  BENCH_CHECK(!FileExists(ARCHIVE));
+
+  for(unsigned int i = 0; i < num_files; ++i)
+    DeleteFileW(files[i].path);
+  DeleteFileW(ARCHIVE);
+}
+
+#pragma endregion
+
+//////////////////////////////////////////////////////////////////////////////
+// ZipDeflate round trips through ZipInflate and its speed, then a pack
+// built and read back.
+//////////////////////////////////////////////////////////////////////////////
+void PackBench()
+{
+  CheckRoundTrips();
+  TimeDeflate();
+  CheckPack();
+}
@@ -0,0 +1,182 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "../../Engine/MainLoop/ProcessManager.h"
+
+const unsigned int NUM_TIMERS = 10000;
+const unsigned int FRAMES = 1000;
+const int FRAME_MS = 16;
+const unsigned int MIN_PERIOD = 5000;
+const unsigned int MAX_PERIOD = 60000;
+const int CO_WAIT_MS = 100;
+
+#pragma region Timers
+
+//fires every period by sleeping in between, so it is parked and costs nothing while it waits
+class SleepingTimer : public Process
+{
+  int _period;
+  unsigned int& _fired;
+
+public:
+  SleepingTimer(int period, unsigned int& fired) : _period(period), _fired(fired) {}
+
+protected:
+  virtual void OnUpdate(int delta)
+  {
+    ++_fired;
+    Sleep(_period);
+  }
+};
+
+//the same timer the way it is written without Sleep(), counting its deltas every frame
+class PollingTimer : public Process
+{
+  int _period;
+  int _waited;
+  bool _started;
+  unsigned int& _fired;
+
+public:
+  PollingTimer(int period, unsigned int& fired) : _period(period), _waited(0), _started(false), _fired(fired) {}
+
+protected:
+  virtual void OnUpdate(int delta)
+  {
+    _waited += delta;
+    if(!_started || _waited >= _period)
+    {
+      ++_fired;
+      _waited = 0;
+      _started = true;
+    }
+  }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// NUM_TIMERS timers with periods of seconds, run for FRAMES frames as
+// sleeping processes and as processes that poll.  Both have to fire the
+// same number of times, and the sleeping ones have to leave nothing in
+// the update list between frames.
+//////////////////////////////////////////////////////////////////////////////
+static void TimeTimers()
+{
+  BenchRandom random(34);
+  std::vector<int> periods(NUM_TIMERS);
+  for(unsigned int i = 0; i < NUM_TIMERS; ++i)
+    periods[i] = MIN_PERIOD + random.Next() % (MAX_PERIOD - MIN_PERIOD);
+
+  unsigned int sleeping_fired = 0, polling_fired = 0, most_active = 0;
+  double sleeping_ms = 0.0, polling_ms = 0.0;
+  {
+    ProcessManager manager;
+    for(unsigned int i = 0; i < NUM_TIMERS; ++i)
+      manager.AttachProcess(StrongProcessPtr(SOL_NEW SleepingTimer(periods[i], sleeping_fired)));
+    //the first frame starts every timer, which isnt what is being timed
+    manager.UpdateProcesses(FRAME_MS);
+    BenchTimer timer;
+    for(unsigned int frame = 1; frame < FRAMES; ++frame)
+    {
+      manager.UpdateProcesses(FRAME_MS);
+      most_active = std::max(most_active, manager.ActiveProcessCount());
+    }
+    sleeping_ms = timer.Milliseconds();
+    BENCH_CHECK(manager.ProcessCount() == NUM_TIMERS);
+  }
+  {
+    ProcessManager manager;
+    for(unsigned int i = 0; i < NUM_TIMERS; ++i)
+      manager.AttachProcess(StrongProcessPtr(SOL_NEW PollingTimer(periods[i], polling_fired)));
+    manager.UpdateProcesses(FRAME_MS);
+    BenchTimer timer;
+    for(unsigned int frame = 1; frame < FRAMES; ++frame)
+      manager.UpdateProcesses(FRAME_MS);
+    polling_ms = timer.Milliseconds();
+  }
+
+  printf("  %u timers of %u to %u s, %u frames, %u fired\n", NUM_TIMERS, MIN_PERIOD / 1000, MAX_PERIOD / 1000, FRAMES, sleeping_fired);
+  printf("  sleeping %.4f ms a frame, polling %.4f ms a frame\n", sleeping_ms / (FRAMES - 1), polling_ms / (FRAMES - 1));
+  BENCH_CHECK(sleeping_fired == polling_fired);
+  BENCH_CHECK(most_active == 0);
+  BENCH_CHECK(sleeping_ms < polling_ms);
+}
+
+#pragma endregion
+
+#pragma region Coroutines
+
+//writes down each resume point it reaches and the manager time it got there
+class BenchCoroutine : public CoroutineProcess
+{
+  int& _time;
+
+public:
+  std::vector<std::pair<int, int> > reached;    //point, time
+  bool ready;
+
+  explicit BenchCoroutine(int& time) : _time(time), ready(false) {}
+
+protected:
+  virtual void Run(int delta)
+  {
+    SOL_CO_BEGIN();
+    reached.push_back(std::make_pair(1, _time));
+    SOL_CO_YIELD();
+    reached.push_back(std::make_pair(2, _time));
+    SOL_CO_WAIT(CO_WAIT_MS);
+    reached.push_back(std::make_pair(3, _time));
+    SOL_CO_WAIT_UNTIL(ready);
+    reached.push_back(std::make_pair(4, _time));
+    SOL_CO_END();
+  }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Steps a coroutine through a yield, a wait and a wait until, and checks
+// it carries on from each at the right frame: the frame after the yield,
+// the first frame CO_WAIT_MS after the wait, and the frame after the
+// condition comes true, which then succeeds it.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckCoroutine()
+{
+  int time = 0;
+  ProcessManager manager;
+  shared_ptr<BenchCoroutine> co(SOL_NEW BenchCoroutine(time));
+  manager.AttachProcess(co);
+
+  int ready_time = -1;
+  for(unsigned int frame = 0; frame < 20 && !co->IsDead(); ++frame)
+  {
+    time += FRAME_MS;
+    manager.UpdateProcesses(FRAME_MS);
+    //a few frames of waiting on the condition before it comes true
+    if(co->reached.size() == 3 && ready_time < 0 && time >= co->reached[2].second + 3 * FRAME_MS)
+    {
+      co->ready = true;
+      ready_time = time;
+    }
+  }
+
+  BENCH_CHECK(co->reached.size() == 4);
+  if(co->reached.size() != 4)
+    return;
+  BENCH_CHECK(co->reached[0].first == 1 && co->reached[0].second == FRAME_MS);
+  BENCH_CHECK(co->reached[1].first == 2 && co->reached[1].second == 2 * FRAME_MS);
+  int waited = co->reached[2].second - co->reached[1].second;
+  BENCH_CHECK(co->reached[2].first == 3 && waited >= CO_WAIT_MS && waited < CO_WAIT_MS + FRAME_MS);
+  BENCH_CHECK(co->reached[3].first == 4 && co->reached[3].second == ready_time + FRAME_MS);
+  BENCH_CHECK(co->GetState() == Process::SUCCEEDED);
+  printf("  coroutine resumed at %d, %d, %d and %d ms\n",
+         co->reached[0].second, co->reached[1].second, co->reached[2].second, co->reached[3].second);
+}
+
+#pragma endregion
+
+//////////////////////////////////////////////////////////////////////////////
+// Thousands of sleeping timers against polling ones, and a coroutine
+// stepped through every kind of resume point.
+//////////////////////////////////////////////////////////////////////////////
+void ProcessBench()
+{
+  TimeTimers();
+  CheckCoroutine();
+}
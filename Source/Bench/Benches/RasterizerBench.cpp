@@ -0,0 +1,171 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "../../Engine/Text/GlyphRasterizer.h"
+#include "../../Engine/Text/TextLayoutCache.h"
+#include "../../Engine/Multicore/JobSystem.h"
+#include "../../Engine/Utility/Utf8.h"
+
+//a scene change to a screen of text at every size from 10 to 40 pixels
+const unsigned int FIRST_SIZE = 10;
+const unsigned int LAST_SIZE = 40;
+const unsigned int SIZE_STEP = 2;
+const unsigned int ATLAS_SIZE = 2048;
+
+//every character from space up through Latin Extended-B, the font has a glyph for some of them
+static std::string AllCharacters()
+{
+  std::vector<Utf32Char> characters;
+  for(Utf32Char c = 0x20; c < 0x250; ++c)
+  {
+    if(c < 0x7f || c >= 0xa0)
+      characters.push_back(c);
+  }
+  std::string text(characters.size() * 4, '\0');
+  size_t length = 0;
+  Utf32ToUtf8(&characters[0], characters.size(), &text[0], text.size(), length, true);
+  text.resize(length);
+  return text;
+}
+
+//the glyph in the atlas has to have the same pixels and metrics as the bitmap
+static bool SameGlyph(GlyphAtlas& atlas, GlyphKey key, const GlyphBitmap& bitmap)
+{
+  GlyphAtlas::Handle handle = atlas.Find(key);
+  if(handle == GlyphAtlas::INVALID_HANDLE)
+    return false;
+  const AtlasGlyph& glyph = atlas.Glyph(handle);
+  int width = bitmap.pixels ? bitmap.width : 0, height = bitmap.pixels ? bitmap.height : 0;
+  if(glyph.width != width || glyph.height != height || glyph.left != bitmap.left || glyph.top != bitmap.top || glyph.advance != bitmap.advance)
+    return false;
+  for(int row = 0; row < height; ++row)
+  {
+    if(memcmp(atlas.Pixels() + (glyph.y + row) * atlas.Width() + glyph.x, bitmap.pixels + row * bitmap.pitch, width) != 0)
+      return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Renders the text at every size through the rasterizer, timed, then
+// checks each glyph is in the atlas exactly as the FontCache or the
+// DistanceFieldGlyphs would have made it, under the key the layout cache
+// looks for, so laying the text out afterwards renders nothing.
+//////////////////////////////////////////////////////////////////////////////
+static void Run(JobSystem* jobs, const char* name, const char* path, const std::string& text, bool distance_fields)
+{
+  FontCache fonts;
+  FontId font = fonts.AddFont(path);
+  GlyphAtlas atlas(ATLAS_SIZE, ATLAS_SIZE, 1);
+  DistanceFieldGlyphs distance_field_glyphs(fonts);
+  GlyphRasterizer rasterizer(fonts, atlas, jobs);
+  TextLayoutCache layouts(fonts, atlas);
+  if(distance_fields)
+  {
+    rasterizer.SetDistanceFields(&distance_field_glyphs);
+    layouts.SetDistanceFields(&distance_field_glyphs);
+  }
+
+  BenchTimer timer;
+  for(unsigned int size = FIRST_SIZE; size <= LAST_SIZE; size += SIZE_STEP)
+    rasterizer.Add(font, size, text);
+  unsigned int queued = rasterizer.NumQueued();
+  unsigned int inserted = rasterizer.Flush();
+  double ms = timer.Milliseconds();
+  const GlyphRasterizerStats& stats = rasterizer.Stats();
+  printf("  %-14s %u glyphs, %.3f ms, %.0f glyphs/s, %u workers\n", name, queued, ms, queued / ms * 1000.0, rasterizer.NumWorkers());
+  BENCH_CHECK(queued > 0 && inserted == queued && stats.failures == 0);
+
+  //asking the FontCache afterwards, so the timing above doesnt get its cache warmed
+  std::vector<Utf32Char> characters(text.size());
+  size_t num_characters = 0;
+  Utf8ToUtf32(text.c_str(), text.size(), &characters[0], characters.size(), num_characters, true);
+  unsigned int wrong = 0;
+  for(unsigned int size = FIRST_SIZE; size <= LAST_SIZE; size += SIZE_STEP)
+  {
+    //distance fields are the same glyphs at every size
+    for(size_t i = 0; i < num_characters && (!distance_fields || size == FIRST_SIZE); ++i)
+    {
+      unsigned int glyph_index = fonts.GlyphIndex(font, characters[i]);
+      GlyphBitmap bitmap;
+      if(distance_fields)
+      {
+        BENCH_CHECK(distance_field_glyphs.Glyph(font, glyph_index, bitmap));
+        wrong += !SameGlyph(atlas, distance_field_glyphs.Key(font, glyph_index), bitmap);
+      }
+      else
+      {
+        BENCH_CHECK(fonts.Glyph(font, size, glyph_index, bitmap));
+        wrong += !SameGlyph(atlas, MakeGlyphKey(font, size, glyph_index), bitmap);
+      }
+    }
+    layouts.Layout(font, size, text);
+  }
+  BENCH_CHECK(wrong == 0);
+  BENCH_CHECK(layouts.Stats().glyphs_rendered == 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// A font that cant be opened fails its glyphs in the jobs without them
+// logging anything, Flush() logs it on this thread.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckMissingFont(JobSystem& jobs)
+{
+  FontCache fonts;
+  FontId font = fonts.AddFont("no such font.ttf");
+  GlyphAtlas atlas(256, 256, 1);
+  GlyphRasterizer rasterizer(fonts, atlas, &jobs);
+  rasterizer.Add(font, 16, "Missing");
+  unsigned int queued = rasterizer.NumQueued();
+  BENCH_CHECK(rasterizer.Flush() == 0);
+  BENCH_CHECK(rasterizer.Stats().failures == queued && rasterizer.Stats().inserted == 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Glyphs put in the atlas last frame that are asked for again this frame
+// have to survive the rest of the text overflowing the atlas, rather than
+// being evicted to make room as if nothing used them.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckInUse(const char* path, const std::string& text)
+{
+  FontCache fonts;
+  FontId font = fonts.AddFont(path);
+  GlyphAtlas atlas(64, 64, 1);
+  GlyphRasterizer rasterizer(fonts, atlas);
+  const unsigned int size = 16;
+  const char* kept = "Hi";
+  atlas.BeginFrame();
+  rasterizer.Add(font, size, kept);
+  BENCH_CHECK(rasterizer.Flush() == 2);
+
+  atlas.BeginFrame();
+  rasterizer.Add(font, size, text);
+  rasterizer.Flush();
+  BENCH_CHECK(rasterizer.Stats().failures > 0);
+  for(const char* c = kept; *c; ++c)
+    BENCH_CHECK(atlas.Contains(MakeGlyphKey(font, size, fonts.GlyphIndex(font, *c))));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Every glyph the font in the tree has at 16 sizes, plain and as distance
+// fields, rendered on one thread and across the job system.  Then a full
+// atlas has to keep the glyphs still in use.
+//////////////////////////////////////////////////////////////////////////////
+void RasterizerBench()
+{
+  const char* path = BenchFontPath();
+  BENCH_CHECK(path != 0);
+  if(!path)
+    return;
+  std::string text = AllCharacters();
+
+  JobSystem jobs;
+  char name[32];
+  _snprintf_s(name, sizeof(name), _TRUNCATE, "%u threads", jobs.NumThreads());
+  Run(0, "1 thread", path, text, false);
+  Run(&jobs, name, path, text, false);
+  _snprintf_s(name, sizeof(name), _TRUNCATE, "distance, %u", jobs.NumThreads());
+  Run(0, "distance, 1", path, text, true);
+  Run(&jobs, name, path, text, true);
+  CheckMissingFont(jobs);
+  CheckInUse(path, text);
+}
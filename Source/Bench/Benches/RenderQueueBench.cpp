@@ -0,0 +1,141 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "../../Engine/Graphics/RenderQueue.h"
+#include "../../Engine/Graphics/NullRenderBackend.h"
+#include "../../Engine/Multicore/JobSystem.h"
+
+const unsigned int NUM_DRAWS = 200000;
+const unsigned int DRAWS_PER_BUCKET = 4096;
+const unsigned int NUM_SHADERS = 32;
+const unsigned int NUM_MATERIALS = 512;
+const unsigned int NUM_MESHES = 1000;
+const unsigned int FRAMES = 20;
+
+//a draw from its index alone, so every bucket and thread makes the same ones
+static void MakeDraw(unsigned int i, RenderKey& key, DrawCommand& command)
+{
+  BenchRandom random(i * 2654435761u + 44);
+  random.Next();
+  command.mesh = random.Next() % NUM_MESHES;
+  command.shader = random.Next() % NUM_SHADERS;
+  command.material = command.shader * (NUM_MATERIALS / NUM_SHADERS) + random.Next() % (NUM_MATERIALS / NUM_SHADERS);
+  command.transform = i;
+  command.colour = glm::vec4(1.0f);
+  float depth = random.Range(0.0f, 1.0f);
+  unsigned int kind = random.Next() % 16;
+  if(kind < 12)
+    key = MakeRenderKey(0, 0, command.shader, command.material, depth);
+  else if(kind < 15)
+    key = MakeDepthFirstRenderKey(0, 1, command.shader, command.material, depth);
+  else
+    key = MakeRenderKey(2, 0, command.shader, command.material, depth);
+}
+
+//each chunk is a job writing its own bucket
+static void AddRange(void* data, unsigned int begin, unsigned int end)
+{
+  RenderQueue* queue = (RenderQueue*)data;
+  RenderBucket& bucket = queue->Bucket(begin / DRAWS_PER_BUCKET);
+  RenderKey key;
+  DrawCommand command;
+  for(unsigned int i = begin; i < end; ++i)
+  {
+    MakeDraw(i, key, command);
+    bucket.Add(key, command);
+  }
+}
+
+struct KeyOrder
+{
+  RenderKey key;
+  unsigned int index;
+  bool operator<(const KeyOrder& other) const { return key < other.key; }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Fills, sorts and submits a frame at a time, on one thread or the job
+// system, and checks the backend got every draw in the order a stable sort
+// of the keys gives.
+//////////////////////////////////////////////////////////////////////////////
+static void Run(JobSystem* jobs, const char* name, const std::vector<KeyOrder>& expected)
+{
+  RenderQueue queue(jobs);
+  NullRenderBackend backend;
+  unsigned int num_buckets = (NUM_DRAWS + DRAWS_PER_BUCKET - 1) / DRAWS_PER_BUCKET;
+  double add_ms = 0.0, sort_ms = 0.0, submit_ms = 0.0;
+  BenchTimer timer;
+  for(unsigned int f = 0; f < FRAMES; ++f)
+  {
+    timer.Start();
+    queue.Begin(num_buckets);
+    if(jobs)
+      jobs->ParallelFor(AddRange, &queue, NUM_DRAWS, DRAWS_PER_BUCKET);
+    else
+      AddRange(&queue, 0, NUM_DRAWS);
+    add_ms += timer.Milliseconds();
+    timer.Start();
+    queue.Sort();
+    sort_ms += timer.Milliseconds();
+    timer.Start();
+    queue.Submit(&backend);
+    submit_ms += timer.Milliseconds();
+  }
+  printf("  %-10s add %.3f ms, sort %.3f ms, submit %.3f ms\n", name, add_ms / FRAMES, sort_ms / FRAMES, submit_ms / FRAMES);
+
+  NullRenderBackend recorder(true);
+  queue.Submit(&recorder);
+  BENCH_CHECK(recorder.NumRecorded() == NUM_DRAWS);
+  unsigned int wrong = 0;
+  for(unsigned int i = 0; i < recorder.NumRecorded(); ++i)
+    wrong += recorder.RecordedKey(i) != expected[i].key || recorder.RecordedCommand(i).transform != expected[i].index;
+  BENCH_CHECK(wrong == 0);
+  BENCH_CHECK(backend.Stats().draws == NUM_DRAWS * FRAMES);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// 200000 draws a frame, mostly opaque with some translucent and some HUD,
+// sorted by the queue against std::stable_sort, and the state changes
+// a backend sees with the draws sorted and in the order they were added.
+//////////////////////////////////////////////////////////////////////////////
+void RenderQueueBench()
+{
+  std::vector<KeyOrder> expected(NUM_DRAWS);
+  NullRenderBackend unsorted;
+  std::vector<RenderKey> keys(NUM_DRAWS);
+  std::vector<DrawCommand> commands(NUM_DRAWS);
+  for(unsigned int i = 0; i < NUM_DRAWS; ++i)
+  {
+    MakeDraw(i, keys[i], commands[i]);
+    expected[i].key = keys[i];
+    expected[i].index = i;
+  }
+  unsorted.Submit(&keys[0], &commands[0], NUM_DRAWS);
+
+  BenchTimer timer;
+  std::vector<KeyOrder> stable;
+  for(unsigned int f = 0; f < FRAMES; ++f)
+  {
+    stable = expected;
+    std::stable_sort(stable.begin(), stable.end());
+  }
+  double stable_ms = timer.Milliseconds() / FRAMES;
+  expected.swap(stable);
+
+  NullRenderBackend sorted;
+  for(unsigned int i = 0; i < NUM_DRAWS; ++i)
+  {
+    keys[i] = expected[i].key;
+    MakeDraw(expected[i].index, keys[i], commands[i]);
+  }
+  sorted.Submit(&keys[0], &commands[0], NUM_DRAWS);
+
+  printf("  %u draws, %u shaders, %u materials, %u meshes\n", NUM_DRAWS, NUM_SHADERS, NUM_MATERIALS, NUM_MESHES);
+  printf("  changes unsorted: shader %u, material %u, mesh %u\n", unsorted.Stats().shader_changes, unsorted.Stats().material_changes, unsorted.Stats().mesh_changes);
+  printf("  changes sorted:   shader %u, material %u, mesh %u\n", sorted.Stats().shader_changes, sorted.Stats().material_changes, sorted.Stats().mesh_changes);
+  printf("  std::stable_sort of the keys %.3f ms\n", stable_ms);
+  Run(0, "1 thread", expected);
+  JobSystem jobs;
+  char name[32];
+  _snprintf_s(name, sizeof(name), _TRUNCATE, "%u threads", jobs.NumThreads());
+  Run(&jobs, name, expected);
+}
@@ -0,0 +1,160 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "BenchResourceFile.h"
+
+const unsigned int LEVELS = 4;
+const unsigned int LEVEL_RESOURCES = 400;
+const unsigned int SHARED_RESOURCES = 200;
+const unsigned int FRAMES_PER_LEVEL = 2000;
+const unsigned int ACCESSES_PER_FRAME = 8;
+const unsigned int MAX_RESOURCE_SIZE = 512 * 1024;
+
+static std::string ResourceName(const char* directory, unsigned int number, const char* extension)
+{
+  char name[64];
+  _snprintf_s(name, sizeof(name), _TRUNCATE, "%s/Asset%u.%s", directory, number, extension);
+  return name;
+}
+
+static const char* const EXTENSIONS[] = { "dds", "dds", "dds", "xml", "sdkmesh", "ogg" };
+const unsigned int NUM_EXTENSIONS = sizeof(EXTENSIONS) / sizeof(EXTENSIONS[0]);
+
+//a few resources are used all the time and most hardly ever
+static unsigned int Skewed(BenchRandom& random, unsigned int count)
+{
+  float f = random.Range(0.0f, 1.0f);
+  return std::min(count - 1, (unsigned int)(f * f * f * count));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// There is no recorded trace in the tree, so this makes one up from a
+// fixed seed in its place.  The trace plays through the levels twice.  Each frame asks for a few of
+// the level's own resources and a few shared ones, the way a game asks
+// the cache for its textures, meshes and sounds.
+//////////////////////////////////////////////////////////////////////////////
+static void MakeTrace(BenchResourceFile& file, StringVec& trace)
+{
+  BenchRandom random(30);
+  StringVec level_names[LEVELS], shared_names;
+  for(unsigned int i = 0; i < SHARED_RESOURCES; ++i)
+  {
+    shared_names.push_back(ResourceName("Shared", i, EXTENSIONS[i % NUM_EXTENSIONS]));
+    file.Add(shared_names.back(), 1024 + random.Next() % (MAX_RESOURCE_SIZE - 1024));
+  }
+  for(unsigned int level = 0; level < LEVELS; ++level)
+  {
+    char directory[16];
+    _snprintf_s(directory, sizeof(directory), _TRUNCATE, "Level%u", level);
+    for(unsigned int i = 0; i < LEVEL_RESOURCES; ++i)
+    {
+      level_names[level].push_back(ResourceName(directory, i, EXTENSIONS[i % NUM_EXTENSIONS]));
+      file.Add(level_names[level].back(), 1024 + random.Next() % (MAX_RESOURCE_SIZE - 1024));
+    }
+  }
+
+  for(unsigned int visit = 0; visit < LEVELS * 2; ++visit)
+  {
+    const StringVec& level = level_names[visit % LEVELS];
+    for(unsigned int frame = 0; frame < FRAMES_PER_LEVEL; ++frame)
+    {
+      for(unsigned int i = 0; i < ACCESSES_PER_FRAME; ++i)
+      {
+        if(random.Next() % 10 < 7)
+          trace.push_back(level[Skewed(random, LEVEL_RESOURCES)]);
+        else
+          trace.push_back(shared_names[Skewed(random, SHARED_RESOURCES)]);
+      }
+    }
+  }
+}
+
+static void Replay(const StringVec& trace, unsigned int budget_mb)
+{
+  BenchResourceFile* file = SOL_NEW BenchResourceFile(MAX_RESOURCE_SIZE);
+  StringVec unused;
+  MakeTrace(*file, unused);
+  ResourceCache cache(budget_mb, file);
+  cache.Init();
+
+  //the names are made into Resources first, so only the cache is timed
+  std::vector<Resource> resources;
+  resources.reserve(trace.size());
+  for(size_t i = 0; i < trace.size(); ++i)
+    resources.push_back(Resource(trace[i]));
+
+  bool over_budget = false;
+  BenchTimer timer;
+  for(size_t i = 0; i < resources.size(); ++i)
+  {
+    shared_ptr<ResHandle> handle = cache.Handle(resources[i]);
+    g_bench_sink += handle ? (unsigned char)handle->Buffer()[0] : 0;
+    over_budget |= cache.Allocated() > cache.Budget();
+  }
+  double ms = timer.Milliseconds();
+
+  const ResourceCacheStats& stats = cache.Stats();
+  BENCH_CHECK(stats.hits + stats.misses == trace.size());
+  BENCH_CHECK(stats.load_failures == 0);
+  BENCH_CHECK(!over_budget);
+  printf("  %3u MB budget: %.1f%% hits, %u misses, %u evictions (%.0f MB), %.0f ns per Handle()\n",
+         budget_mb, 100.0 * stats.hits / trace.size(), stats.misses, stats.evictions,
+         stats.evicted_bytes / (1024.0 * 1024.0), ms * 1000000.0 / trace.size());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Mapped resources cost nothing, so making room for a copied one has to
+// evict copied ones and leave every mapped one where it is.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckMappedStay()
+{
+  const unsigned int size = 400 * 1024;
+  BenchResourceFile* file = SOL_NEW BenchResourceFile(MAX_RESOURCE_SIZE);
+  for(unsigned int i = 0; i < 100; ++i)
+    file->Add(ResourceName("Sounds", i, "ogg"), size);
+  for(unsigned int i = 0; i < 10; ++i)
+    file->Add(ResourceName("Textures", i, "dds"), size);
+
+  ResourceCache cache(1, file);
+  cache.Init();
+  for(unsigned int i = 0; i < 100; ++i)
+    cache.Handle(Resource(ResourceName("Sounds", i, "ogg")));
+  for(unsigned int i = 0; i < 10; ++i)
+    BENCH_CHECK(cache.Handle(Resource(ResourceName("Textures", i, "dds"))));
+
+  const ResourceCacheStats& stats = cache.Stats();
+  BENCH_CHECK(cache.NumResources() == 102);
+  BENCH_CHECK(stats.evictions == 8 && stats.evicted_bytes == 8ull * size);
+}
+
+//an empty resource is still a resource, copied or mapped, one that isnt in the file isnt
+static void CheckEmpty()
+{
+  BenchResourceFile* file = SOL_NEW BenchResourceFile(MAX_RESOURCE_SIZE);
+  file->Add("Empty.xml", 0);
+  file->Add("Empty.ogg", 0);
+  ResourceCache cache(1, file);
+  cache.Init();
+  shared_ptr<ResHandle> copied = cache.Handle(Resource("Empty.xml"));
+  shared_ptr<ResHandle> mapped = cache.Handle(Resource("Empty.ogg"));
+  BENCH_CHECK(copied && copied->Size() == 0);
+  BENCH_CHECK(mapped && mapped->Size() == 0);
+  BENCH_CHECK(!cache.Handle(Resource("Missing.xml")));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Replays a trace of levels being played in turn through caches of a few
+// sizes and reports the hit rate and the cost of a lookup.
+//////////////////////////////////////////////////////////////////////////////
+void ResourceCacheBench()
+{
+  BenchResourceFile file(MAX_RESOURCE_SIZE);
+  StringVec trace;
+  MakeTrace(file, trace);
+  printf("  %u accesses to %u resources\n", (unsigned int)trace.size(), LEVELS * LEVEL_RESOURCES + SHARED_RESOURCES);
+
+  const unsigned int budgets[] = { 16, 64, 256 };
+  for(unsigned int i = 0; i < sizeof(budgets) / sizeof(budgets[0]); ++i)
+    Replay(trace, budgets[i]);
+  CheckMappedStay();
+  CheckEmpty();
+}
@@ -0,0 +1,480 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include <math.h>
+#include "../../Engine/Actors/Actor.h"
+#include "../../Engine/Actors/ComponentScheduler.h"
+#include "../../Engine/Multicore/JobSystem.h"
+#include "../../Engine/Scene/AabbTree.h"
+
+const unsigned int NUM_ACTORS = 50000;
+const unsigned int FRAMES = 100;
+const int FRAME_MS = 16;
+
+//the frame being updated, so a component can tell whether what it reads was updated before it
+static unsigned int s_frame = 0;
+static unsigned int s_order_errors = 0;   //counted from the job threads, so under a lock
+static CriticalSection s_order_cs;
+
+static void OrderError()
+{
+  ScopedCriticalSection lock(s_order_cs);
+  ++s_order_errors;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Five component types that read each other the way game components do.
+// Motion moves the actor, Bounds follows it, Health ticks on its own,
+// Brain reads Bounds and Health, and Noise reads Motion and adds to a
+// total every actor shares, so it is serial.  Each one that reads another
+// checks the other was updated earlier in the same frame.
+//////////////////////////////////////////////////////////////////////////////
+class BenchComponent : public ActorComponent
+{
+public:
+  unsigned int frame;
+
+  BenchComponent() : frame(0) {}
+  virtual bool Init(XMLElement* data) { return true; }
+  virtual XMLElement* GenerateXml() { return 0; }
+  void GoToSleep() { Sleep(); }
+
+protected:
+  void Updated() { frame = s_frame; }
+  static void CheckRead(const BenchComponent* other)
+  {
+    if(other->frame != s_frame)
+      OrderError();
+  }
+};
+
+class MotionComponent : public BenchComponent
+{
+public:
+  float position[3];
+  float velocity[3];
+
+  virtual const char* Name() const { return "Motion"; }
+  virtual void Update(int delta)
+  {
+    float t = delta * 0.001f;
+    for(int i = 0; i < 3; ++i)
+    {
+      position[i] += velocity[i] * t;
+      if(position[i] < -100.0f || position[i] > 100.0f)
+        velocity[i] = -velocity[i];
+    }
+    Updated();
+  }
+};
+
+class BoundsComponent : public BenchComponent
+{
+public:
+  const MotionComponent* motion;
+  float low[3], high[3];
+  float radius;
+
+  virtual const char* Name() const { return "Bounds"; }
+  virtual void UpdateAccess(ComponentAccess& access) const { access.reads.push_back(GetIdFromName("Motion")); }
+  virtual void Update(int delta)
+  {
+    CheckRead(motion);
+    for(int i = 0; i < 3; ++i)
+    {
+      low[i] = motion->position[i] - radius;
+      high[i] = motion->position[i] + radius;
+    }
+    Updated();
+  }
+};
+
+class HealthComponent : public BenchComponent
+{
+public:
+  float health;
+
+  virtual const char* Name() const { return "Health"; }
+  virtual void Update(int delta)
+  {
+    health = std::min(100.0f, health + delta * 0.01f);
+    Updated();
+  }
+};
+
+class BrainComponent : public BenchComponent
+{
+public:
+  const BoundsComponent* bounds;
+  const HealthComponent* health;
+  float urgency;
+
+  virtual const char* Name() const { return "Brain"; }
+  virtual void UpdateAccess(ComponentAccess& access) const
+  {
+    access.reads.push_back(GetIdFromName("Bounds"));
+    access.reads.push_back(GetIdFromName("Health"));
+  }
+  virtual void Update(int delta)
+  {
+    CheckRead(bounds);
+    CheckRead(health);
+    float size = bounds->high[0] - bounds->low[0] + bounds->high[2] - bounds->low[2];
+    urgency = urgency * 0.9f + (100.0f - health->health) * 0.01f + sqrtf(size) * 0.1f;
+    Updated();
+  }
+};
+
+static float s_noise_total = 0.0f;
+
+class NoiseComponent : public BenchComponent
+{
+public:
+  const MotionComponent* motion;
+
+  virtual const char* Name() const { return "Noise"; }
+  virtual void UpdateAccess(ComponentAccess& access) const
+  {
+    access.reads.push_back(GetIdFromName("Motion"));
+    access.serial = true;
+  }
+  virtual void Update(int delta)
+  {
+    CheckRead(motion);
+    s_noise_total += fabsf(motion->velocity[0]) * 0.001f;
+    Updated();
+  }
+};
+
+struct BenchActor
+{
+  StrongActorPtr actor;
+  shared_ptr<MotionComponent> motion;
+  shared_ptr<BoundsComponent> bounds;
+  shared_ptr<HealthComponent> health;
+  shared_ptr<BrainComponent> brain;
+  shared_ptr<NoiseComponent> noise;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// The readers are added before what they read, so only the declared reads
+// can put them in the right order.
+//////////////////////////////////////////////////////////////////////////////
+static void MakeActors(std::vector<BenchActor>& actors)
+{
+  BenchRandom random(35);
+  actors.resize(NUM_ACTORS);
+  for(unsigned int i = 0; i < NUM_ACTORS; ++i)
+  {
+    BenchActor& a = actors[i];
+    a.actor.reset(SOL_NEW Actor(i + 1));
+    a.motion.reset(SOL_NEW MotionComponent);
+    a.bounds.reset(SOL_NEW BoundsComponent);
+    a.health.reset(SOL_NEW HealthComponent);
+    a.brain.reset(SOL_NEW BrainComponent);
+    a.noise.reset(SOL_NEW NoiseComponent);
+    for(int k = 0; k < 3; ++k)
+    {
+      a.motion->position[k] = random.Range(-100.0f, 100.0f);
+      a.motion->velocity[k] = random.Range(-10.0f, 10.0f);
+    }
+    a.bounds->motion = a.motion.get();
+    a.bounds->radius = random.Range(0.5f, 4.0f);
+    a.health->health = random.Range(0.0f, 100.0f);
+    a.brain->bounds = a.bounds.get();
+    a.brain->health = a.health.get();
+    a.brain->urgency = 0.0f;
+    a.noise->motion = a.motion.get();
+
+    a.actor->AddComponent(a.brain);
+    a.actor->AddComponent(a.noise);
+    a.actor->AddComponent(a.bounds);
+    a.actor->AddComponent(a.health);
+    a.actor->AddComponent(a.motion);
+  }
+}
+
+//what each actor ended up with, to compare the runs
+static void Results(const std::vector<BenchActor>& actors, std::vector<float>& out)
+{
+  out.clear();
+  for(size_t i = 0; i < actors.size(); ++i)
+  {
+    const BenchActor& a = actors[i];
+    out.insert(out.end(), a.motion->position, a.motion->position + 3);
+    out.push_back(a.bounds->low[1]);
+    out.push_back(a.health->health);
+    out.push_back(a.brain->urgency);
+  }
+  out.push_back(s_noise_total);
+}
+
+static void Reset()
+{
+  s_frame = 0;
+  s_order_errors = 0;
+  s_noise_total = 0.0f;
+}
+
+//the old way, each actor updates its own components in turn, in component id order
+static double ActorByActor(std::vector<float>& results)
+{
+  Reset();
+  std::vector<BenchActor> actors;
+  MakeActors(actors);
+  BenchTimer timer;
+  for(unsigned int frame = 0; frame < FRAMES; ++frame)
+  {
+    ++s_frame;
+    for(size_t i = 0; i < actors.size(); ++i)
+      actors[i].actor->Update(FRAME_MS);
+  }
+  double ms = timer.Milliseconds();
+  Results(actors, results);
+  return ms;
+}
+
+static double Scheduled(JobSystem* jobs, std::vector<float>& results)
+{
+  Reset();
+  ComponentScheduler scheduler(jobs, true);
+  double ms = 0.0;
+  {
+    std::vector<BenchActor> actors;
+    MakeActors(actors);
+    BENCH_CHECK(scheduler.NumActors() == NUM_ACTORS);
+    BENCH_CHECK(scheduler.NumStages() == 3);
+
+    BenchTimer timer;
+    for(unsigned int frame = 0; frame < FRAMES; ++frame)
+    {
+      ++s_frame;
+      scheduler.Update(FRAME_MS);
+    }
+    ms = timer.Milliseconds();
+    Results(actors, results);
+  }
+  //the actors took their components out as they went
+  BENCH_CHECK(scheduler.NumActors() == 0);
+  BENCH_CHECK(s_order_errors == 0);
+  return ms;
+}
+
+class SleepyComponent : public BenchComponent
+{
+  const char* _name;
+
+public:
+  explicit SleepyComponent(const char* name) : _name(name) {}
+  virtual const char* Name() const { return _name; }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Removing the one component that hadnt asked to sleep puts the actor to
+// sleep, and waking by proximity only wakes the actors near the point.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckSleep()
+{
+  ComponentScheduler scheduler(0, false);
+  SleepyComponent sleepy("Sleepy"), awake("Awake");
+  scheduler.AddComponent(1, &sleepy);
+  scheduler.AddComponent(1, &awake);
+  sleepy.GoToSleep();
+  BENCH_CHECK(!scheduler.IsActorAsleep(1));
+  scheduler.RemoveComponent(&awake);
+  BENCH_CHECK(scheduler.IsActorAsleep(1));
+  BENCH_CHECK(scheduler.NumAwakeActors() == 0);
+  scheduler.RemoveComponent(&sleepy);
+
+  //actors a unit apart along x, each box reaching half a unit plus the tree's margin
+  const unsigned int count = 100;
+  AabbTree tree(0.1f);
+  std::vector<SleepyComponent*> components;
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    components.push_back(SOL_NEW SleepyComponent("Sleepy"));
+    scheduler.AddComponent(i + 1, components[i]);
+    components[i]->GoToSleep();
+    glm::vec3 center((float)i, 0.0f, 0.0f);
+    tree.Insert(Aabb(center - glm::vec3(0.5f), center + glm::vec3(0.5f)), i + 1);
+  }
+  BENCH_CHECK(scheduler.NumAwakeActors() == 0);
+  scheduler.WakeActorsNear(tree, glm::vec3(50.0f, 0.0f, 0.0f), 2.5f);
+  unsigned int woken = 0;
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    bool in_reach = i >= 47 && i <= 53;
+    BENCH_CHECK(scheduler.IsActorAsleep(i + 1) != in_reach);
+    woken += in_reach;
+  }
+  BENCH_CHECK(scheduler.NumAwakeActors() == woken);
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    scheduler.RemoveComponent(components[i]);
+    delete components[i];
+  }
+}
+
+const unsigned int TIER_ACTORS = 64;    //per tier
+const unsigned int TIER_FRAMES = 8;     //every tier's full cycle
+
+static int s_serial_inside = 0;         //serial updates running right now
+static int s_serial_tier = 0;           //tier of the last serial update this frame
+static unsigned int s_tier_errors = 0;
+static unsigned int s_frame_updates = 0;
+
+//counts its updates and adds up their deltas
+class TierComponent : public BenchComponent
+{
+  const char* _name;
+  bool _serial;
+
+public:
+  int tier;
+  unsigned int updates;
+  int total_delta;
+
+  TierComponent(const char* name, bool serial, int tier) : _name(name), _serial(serial), tier(tier), updates(0), total_delta(0) {}
+  virtual const char* Name() const { return _name; }
+  virtual void UpdateAccess(ComponentAccess& access) const { access.serial = _serial; }
+  virtual void Update(int delta)
+  {
+    ++updates;
+    total_delta += delta;
+    ScopedCriticalSection lock(s_order_cs);
+    ++s_frame_updates;
+    if(_serial)
+    {
+      //one at a time, walking the tiers in order
+      if(s_serial_inside++ != 0 || tier < s_serial_tier)
+        ++s_tier_errors;
+      s_serial_tier = tier;
+      --s_serial_inside;
+    }
+  }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// TIER_ACTORS actors in each tier, each with a component of a parallel
+// type and one of a serial type, run for TIER_FRAMES frames.  A tier is
+// dealt out round robin, so the kth actor put in tier t is updated on the
+// frames f with f % 2^t == k % 2^t, and each frame updates as many
+// components as the next.  The deltas an actor is passed have to add up
+// to the time from when it was added to its last update.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckTiers(JobSystem* jobs)
+{
+  ComponentScheduler scheduler(jobs, false);
+  std::vector<TierComponent*> components;
+  for(int tier = 0; tier < NUM_UPDATE_TIERS; ++tier)
+  {
+    for(unsigned int i = 0; i < TIER_ACTORS; ++i)
+    {
+      ActorId actor = (ActorId)components.size() / 2 + 1;
+      components.push_back(SOL_NEW TierComponent("Tiered", false, tier));
+      components.push_back(SOL_NEW TierComponent("TieredSerial", true, tier));
+      scheduler.AddComponent(actor, components[components.size() - 2]);
+      scheduler.AddComponent(actor, components.back());
+      scheduler.SetActorUpdateTier(actor, (UpdateTier)tier);
+    }
+  }
+
+  s_tier_errors = 0;
+  unsigned int uneven_frames = 0, first_frame_updates = 0;
+  for(unsigned int frame = 0; frame < TIER_FRAMES; ++frame)
+  {
+    s_serial_tier = 0;
+    s_frame_updates = 0;
+    scheduler.Update(FRAME_MS);
+    if(frame == 0)
+      first_frame_updates = s_frame_updates;
+    uneven_frames += s_frame_updates != first_frame_updates;
+  }
+
+  unsigned int wrong = 0;
+  for(size_t i = 0; i < components.size(); ++i)
+  {
+    TierComponent* component = components[i];
+    unsigned int period = 1 << component->tier;
+    unsigned int slot = (unsigned int)(i / 2 % TIER_ACTORS) % period;
+    unsigned int last_frame = TIER_FRAMES - period + slot;
+    wrong += component->updates != TIER_FRAMES / period || component->total_delta != (int)(last_frame + 1) * FRAME_MS;
+    scheduler.RemoveComponent(component);
+    delete component;
+  }
+  printf("  %u actors over %u tiers, %u updates a frame\n", TIER_ACTORS * NUM_UPDATE_TIERS, NUM_UPDATE_TIERS, first_frame_updates);
+  BENCH_CHECK(wrong == 0);
+  BENCH_CHECK(uneven_frames == 0);
+  BENCH_CHECK(s_tier_errors == 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The bench actors with only awake_percent of them awake, spread through
+// the arrays.  The others put all five components to sleep before the
+// first frame, so a frame should only cost what the awake ones do.
+//////////////////////////////////////////////////////////////////////////////
+static double AwakeFrames(JobSystem* jobs, unsigned int awake_percent)
+{
+  Reset();
+  ComponentScheduler scheduler(jobs, true);
+  std::vector<BenchActor> actors;
+  MakeActors(actors);
+  unsigned int awake = 0;
+  for(unsigned int i = 0; i < NUM_ACTORS; ++i)
+  {
+    if(i % 100 < awake_percent)
+    {
+      ++awake;
+      continue;
+    }
+    BenchActor& a = actors[i];
+    a.motion->GoToSleep();
+    a.bounds->GoToSleep();
+    a.health->GoToSleep();
+    a.brain->GoToSleep();
+    a.noise->GoToSleep();
+  }
+  BENCH_CHECK(scheduler.NumAwakeActors() == awake);
+
+  BenchTimer timer;
+  for(unsigned int frame = 0; frame < FRAMES; ++frame)
+  {
+    ++s_frame;
+    scheduler.Update(FRAME_MS);
+  }
+  double ms = timer.Milliseconds();
+  BENCH_CHECK(scheduler.NumAwakeActors() == awake);
+  BENCH_CHECK(s_order_errors == 0);
+  return ms;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// 50000 actors with five components each, updated actor by actor and by
+// the ComponentScheduler with and without the job system.  The scheduled
+// runs have to match each other exactly and never update a reader before
+// what it reads.  The update tiers are checked with the job system, then
+// the frame is timed with a tenth, half and all of the actors awake.
+//////////////////////////////////////////////////////////////////////////////
+void SchedulerBench()
+{
+  std::vector<float> by_actor, serial, parallel;
+  double by_actor_ms = ActorByActor(by_actor);
+  double serial_ms = Scheduled(0, serial);
+  JobSystem jobs;
+  double parallel_ms = Scheduled(&jobs, parallel);
+  BENCH_CHECK(serial == parallel);
+  CheckSleep();
+  CheckTiers(&jobs);
+  const unsigned int awake_percents[] = { 10, 50, 100 };
+  double awake_ms[3];
+  for(int i = 0; i < 3; ++i)
+    awake_ms[i] = AwakeFrames(&jobs, awake_percents[i]);
+
+  printf("  %u actors, %u components, %u frames\n", NUM_ACTORS, NUM_ACTORS * 5, FRAMES);
+  printf("  actor by actor        %.3f ms a frame\n", by_actor_ms / FRAMES);
+  printf("  scheduled             %.3f ms a frame\n", serial_ms / FRAMES);
+  printf("  scheduled, %u threads  %.3f ms a frame\n", jobs.NumThreads(), parallel_ms / FRAMES);
+  for(int i = 0; i < 3; ++i)
+    printf("  %3u%% awake            %.3f ms a frame\n", awake_percents[i], awake_ms[i] / FRAMES);
+  //the cost follows the awake actors, not all of them
+  BENCH_CHECK(awake_ms[0] < awake_ms[1] && awake_ms[1] < awake_ms[2]);
+}
@@ -0,0 +1,148 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "../../Engine/Scene/AabbTree.h"
+#include "../../Engine/Scene/SpatialHashGrid.h"
+#include "../../Engine/Multicore/JobSystem.h"
+
+const unsigned int NUM_POINTS = 100000;
+const unsigned int FRAMES = 10;
+const unsigned int QUERIES_PER_FRAME = 10000;
+const float AREA = 500.0f;
+const float HEIGHT = 20.0f;
+const float QUERY_RADIUS = 5.0f;
+const float SPEED = 2.0f;         //how far a point can move in a frame
+const float CELL_SIZE = 5.0f;
+const float TREE_MARGIN = 1.0f;
+
+//a crowd spread over a flat area, wandering a little each frame
+struct Crowd
+{
+  std::vector<glm::vec3> positions;
+  std::vector<ActorId> actors;
+  std::vector<glm::vec3> centers;   //this frame's queries
+};
+
+static void Wander(Crowd& crowd, BenchRandom& random)
+{
+  for(unsigned int i = 0; i < crowd.positions.size(); ++i)
+  {
+    glm::vec3& p = crowd.positions[i];
+    p += glm::vec3(random.Range(-SPEED, SPEED), random.Range(-SPEED, SPEED) * 0.1f, random.Range(-SPEED, SPEED));
+    p = glm::clamp(p, glm::vec3(0.0f), glm::vec3(AREA, HEIGHT, AREA));
+  }
+  for(unsigned int q = 0; q < crowd.centers.size(); ++q)
+    crowd.centers[q] = crowd.positions[random.Next() % crowd.positions.size()];
+}
+
+//the tree's results are fat boxes, so they get the same exact distance check the grid does
+static void Exact(const Crowd& crowd, const glm::vec3& center, float radius, std::vector<ActorId>& actors)
+{
+  unsigned int kept = 0;
+  for(size_t i = 0; i < actors.size(); ++i)
+  {
+    glm::vec3 offset = crowd.positions[actors[i]] - center;
+    if(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z <= radius * radius)
+      actors[kept++] = actors[i];
+  }
+  actors.resize(kept);
+  std::sort(actors.begin(), actors.end());
+}
+
+static void GridActors(const SpatialHashGrid& grid, const std::vector<unsigned int>& indices, std::vector<ActorId>& actors)
+{
+  actors.clear();
+  for(size_t i = 0; i < indices.size(); ++i)
+    actors.push_back(grid.Actor(indices[i]));
+  std::sort(actors.begin(), actors.end());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Queries far bigger than the crowd, and one nowhere near it, have to cost
+// about a scan of the points however many cells the radius covers.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckLargeQueries(const Crowd& crowd, const SpatialHashGrid& grid)
+{
+  std::vector<unsigned int> found;
+  BenchTimer timer;
+  grid.QueryRadius(glm::vec3(AREA * 0.5f), 1e6f, found);
+  BENCH_CHECK(found.size() == NUM_POINTS);
+  found.clear();
+  grid.QueryRadius(glm::vec3(0.0f), 1e30f, found);
+  BENCH_CHECK(found.size() == NUM_POINTS);
+  found.clear();
+  grid.QueryRadius(glm::vec3(-1e6f), 10.0f, found);
+  BENCH_CHECK(found.empty());
+  grid.QueryNeighbours(glm::vec3(AREA * 0.5f), 1e6f, 8, found);
+  BENCH_CHECK(found.size() == 8);
+  double ms = timer.Milliseconds();
+  printf("  radius 1e6, 1e30, one far off and 8 neighbours in 1e6: %.3f ms\n", ms);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Every frame the whole crowd moves, then QUERIES_PER_FRAME radius queries
+// are run around members of it.  The grid is rebuilt from scratch, the
+// tree has every actor moved, which only reinserts the ones that left
+// their fat boxes.  Both have to find the same actors.
+//////////////////////////////////////////////////////////////////////////////
+void SpatialBench()
+{
+  BenchRandom random(42);
+  Crowd crowd;
+  for(unsigned int i = 0; i < NUM_POINTS; ++i)
+  {
+    crowd.positions.push_back(glm::vec3(random.Range(0.0f, AREA), random.Range(0.0f, HEIGHT), random.Range(0.0f, AREA)));
+    crowd.actors.push_back(i);
+  }
+  crowd.centers.resize(QUERIES_PER_FRAME);
+
+  JobSystem jobs;
+  SpatialHashGrid grid(CELL_SIZE, 16, &jobs);
+  AabbTree tree(TREE_MARGIN);
+  std::vector<ProxyId> proxies;
+  for(unsigned int i = 0; i < NUM_POINTS; ++i)
+    proxies.push_back(tree.Insert(Aabb(crowd.positions[i], crowd.positions[i]), i));
+
+  double grid_update_ms = 0.0, grid_query_ms = 0.0, tree_update_ms = 0.0, tree_query_ms = 0.0;
+  unsigned int mismatches = 0, found = 0;
+  std::vector<unsigned int> grid_results;
+  std::vector<ActorId> grid_actors, tree_results;
+  BenchTimer timer;
+  for(unsigned int frame = 0; frame < FRAMES; ++frame)
+  {
+    Wander(crowd, random);
+
+    timer.Start();
+    grid.Rebuild(&crowd.positions[0], &crowd.actors[0], NUM_POINTS);
+    grid_update_ms += timer.Milliseconds();
+
+    timer.Start();
+    for(unsigned int i = 0; i < NUM_POINTS; ++i)
+      tree.Move(proxies[i], Aabb(crowd.positions[i], crowd.positions[i]));
+    tree_update_ms += timer.Milliseconds();
+
+    for(unsigned int q = 0; q < QUERIES_PER_FRAME; ++q)
+    {
+      grid_results.clear();
+      timer.Start();
+      grid.QueryRadius(crowd.centers[q], QUERY_RADIUS, grid_results);
+      grid_query_ms += timer.Milliseconds();
+
+      tree_results.clear();
+      timer.Start();
+      tree.QuerySphere(crowd.centers[q], QUERY_RADIUS, tree_results);
+      tree_query_ms += timer.Milliseconds();
+
+      GridActors(grid, grid_results, grid_actors);
+      Exact(crowd, crowd.centers[q], QUERY_RADIUS, tree_results);
+      mismatches += grid_actors != tree_results;
+      found += (unsigned int)grid_actors.size();
+    }
+  }
+  BENCH_CHECK(mismatches == 0);
+  CheckLargeQueries(crowd, grid);
+
+  printf("  %u points moving every frame, %u queries of radius %.0f a frame, %.1f found a query\n",
+         NUM_POINTS, QUERIES_PER_FRAME, QUERY_RADIUS, (double)found / (FRAMES * QUERIES_PER_FRAME));
+  printf("  hash grid, %u threads: rebuild %.3f ms, queries %.3f ms a frame\n", jobs.NumThreads(), grid_update_ms / FRAMES, grid_query_ms / FRAMES);
+  printf("  AabbTree:             move %.3f ms, queries %.3f ms a frame\n", tree_update_ms / FRAMES, tree_query_ms / FRAMES);
+}
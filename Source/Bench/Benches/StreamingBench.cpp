@@ -0,0 +1,181 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "BenchResourceFile.h"
+#include "../../Engine/ResourceCache/ResourceStreamer.h"
+
+const unsigned int NUM_RESOURCES = 240;
+const unsigned int MIN_RESOURCE_SIZE = 256 * 1024;
+const unsigned int MAX_RESOURCE_SIZE = 1024 * 1024;
+const unsigned int LOADS_PER_FRAME = 2;
+const unsigned int CACHE_MB = 512;
+const unsigned int MAX_DRAIN_FRAMES = 1000;
+const double FRAME_MS = 1000.0 / 60.0;
+const double DELIVER_BUDGET_MS = 2.0;
+
+//////////////////////////////////////////////////////////////////////////////
+// Stands in for a texture or mesh loader.  Every byte goes through a few
+// passes of arithmetic, so loading costs about what decoding a real asset
+// would instead of just a copy.
+//////////////////////////////////////////////////////////////////////////////
+class DecodingLoader : public IResourceLoader
+{
+public:
+  virtual std::string Pattern() { return "*.dds"; }
+  virtual bool UseRawFile() { return false; }
+  virtual bool DiscardRawBufferAfterLoad() { return true; }
+  virtual unsigned int LoadedResourceSize(char* raw_buffer, unsigned int raw_size) { return raw_size; }
+
+  virtual bool LoadResource(char* raw_buffer, unsigned int raw_size, shared_ptr<ResHandle> handle)
+  {
+    unsigned char* out = (unsigned char*)handle->WritableBuffer();
+    unsigned int hash = 2166136261u;
+    for(unsigned int pass = 0; pass < 4; ++pass)
+    {
+      for(unsigned int i = 0; i < raw_size; ++i)
+      {
+        hash = (hash ^ (unsigned char)raw_buffer[i]) * 16777619u;
+        out[i] = (unsigned char)(hash >> 24);
+      }
+    }
+    return true;
+  }
+};
+
+struct Delivered
+{
+  unsigned int count;
+  unsigned int failures;
+};
+
+static void OnStreamed(const Resource& resource, shared_ptr<ResHandle> handle, void* user_data)
+{
+  Delivered* delivered = (Delivered*)user_data;
+  ++delivered->count;
+  if(!handle || handle->Size() == 0)
+    ++delivered->failures;
+  else
+    g_bench_sink += (unsigned char)handle->Buffer()[0];
+}
+
+static std::string ResourceName(unsigned int number)
+{
+  char name[64];
+  _snprintf_s(name, sizeof(name), _TRUNCATE, "Level/Asset%u.dds", number);
+  return name;
+}
+
+static ResourceCache* MakeCache()
+{
+  BenchResourceFile* file = SOL_NEW BenchResourceFile(MAX_RESOURCE_SIZE);
+  BenchRandom random(31);
+  for(unsigned int i = 0; i < NUM_RESOURCES; ++i)
+    file->Add(ResourceName(i), MIN_RESOURCE_SIZE + random.Next() % (MAX_RESOURCE_SIZE - MIN_RESOURCE_SIZE + 1));
+  ResourceCache* cache = SOL_NEW ResourceCache(CACHE_MB, file);
+  cache->Init();
+  cache->RegisterLoader(shared_ptr<IResourceLoader>(SOL_NEW DecodingLoader()));
+  return cache;
+}
+
+//the rest of the frame is given to the other threads, the way present and vsync would
+static void WaitForFrameEnd(const BenchTimer& frame)
+{
+  double left = FRAME_MS - frame.Milliseconds();
+  if(left > 1.0)
+    Sleep((DWORD)left);
+}
+
+static void Report(const char* name, std::vector<double>& frame_ms, double total_ms)
+{
+  std::sort(frame_ms.begin(), frame_ms.end());
+  double sum = 0.0;
+  for(size_t i = 0; i < frame_ms.size(); ++i)
+    sum += frame_ms[i];
+  size_t p99 = std::min(frame_ms.size() - 1, frame_ms.size() * 99 / 100);
+  printf("  %-9s %4u frames, main thread load time per frame: %.3f ms mean, %.3f ms 99th, %.3f ms worst, %.0f ms total\n",
+         name, (unsigned int)frame_ms.size(), sum / frame_ms.size(), frame_ms[p99], frame_ms.back(), total_ms);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Every load is done inside the frame that asks for it, the way
+// ResourceCache::Handle() does when nothing streams.
+//////////////////////////////////////////////////////////////////////////////
+static void Synchronous()
+{
+  ResourceCache* cache = MakeCache();
+  std::vector<double> frame_ms;
+  unsigned int failures = 0;
+  double total_ms = 0.0;
+  BenchTimer frame, load;
+  for(unsigned int next = 0; next < NUM_RESOURCES; next += LOADS_PER_FRAME)
+  {
+    frame.Start();
+    load.Start();
+    for(unsigned int i = next; i < std::min(NUM_RESOURCES, next + LOADS_PER_FRAME); ++i)
+    {
+      shared_ptr<ResHandle> handle = cache->Handle(Resource(ResourceName(i)));
+      if(handle)
+        g_bench_sink += (unsigned char)handle->Buffer()[0];
+      else
+        ++failures;
+    }
+    frame_ms.push_back(load.Milliseconds());
+    total_ms += frame_ms.back();
+    WaitForFrameEnd(frame);
+  }
+  BENCH_CHECK(failures == 0);
+  BENCH_CHECK(cache->NumResources() == NUM_RESOURCES);
+  delete cache;
+  Report("blocking", frame_ms, total_ms);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The same loads asked for at the same rate, but the frame only pays for
+// queueing them and for handing the finished ones to the cache.  Frames
+// go on until the last one is delivered.
+//////////////////////////////////////////////////////////////////////////////
+static void Streaming()
+{
+  ResourceCache* cache = MakeCache();
+  Delivered delivered = { 0, 0 };
+  std::vector<double> frame_ms;
+  double total_ms = 0.0;
+  {
+    ResourceStreamer streamer(cache);
+    BenchTimer frame, load;
+    unsigned int next = 0;
+    while((next < NUM_RESOURCES || streamer.NumPending() > 0) && frame_ms.size() < NUM_RESOURCES / LOADS_PER_FRAME + MAX_DRAIN_FRAMES)
+    {
+      frame.Start();
+      load.Start();
+      for(unsigned int i = 0; i < LOADS_PER_FRAME && next < NUM_RESOURCES; ++i, ++next)
+      {
+        StreamPriority priority = next % 4 == 0 ? STREAM_CRITICAL : (next % 4 == 1 ? STREAM_VISIBLE : STREAM_PREFETCH);
+        streamer.Request(Resource(ResourceName(next)), priority, OnStreamed, &delivered);
+      }
+      if(streamer.NumPending() > 0)
+        streamer.DeliverCompleted(DELIVER_BUDGET_MS);
+      frame_ms.push_back(load.Milliseconds());
+      total_ms += frame_ms.back();
+      WaitForFrameEnd(frame);
+    }
+    BENCH_CHECK(streamer.NumPending() == 0);
+  }
+  BENCH_CHECK(delivered.count == NUM_RESOURCES);
+  BENCH_CHECK(delivered.failures == 0);
+  BENCH_CHECK(cache->NumResources() == NUM_RESOURCES);
+  delete cache;
+  Report("streaming", frame_ms, total_ms);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Loads a level's worth of big assets a couple a frame, once blocking and
+// once through the ResourceStreamer, and reports how long each frame spent
+// on loading.  The worst frame is the spike a player would see.
+//////////////////////////////////////////////////////////////////////////////
+void StreamingBench()
+{
+  printf("  %u resources of %u to %u KB, %u asked for a frame\n",
+         NUM_RESOURCES, MIN_RESOURCE_SIZE / 1024, MAX_RESOURCE_SIZE / 1024, LOADS_PER_FRAME);
+  Synchronous();
+  Streaming();
+}
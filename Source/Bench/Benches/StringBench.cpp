@@ -0,0 +1,220 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "../../Engine/Utility/String.h"
+
+#include <float.h>
+
+const unsigned int SPLIT_LINES = 100000;
+const unsigned int NUMBERS = 1000000;
+const unsigned int FLOATS = 200000;
+const unsigned int WIDE_STRINGS = 200000;
+
+//////////////////////////////////////////////////////////////////////////////
+// The std::string Split() and ToStr() are declared but were never written
+// in this tree, so these are what they would do, a new string for every
+// token and every number.  The float one is the printf search ToStr() used
+// before it worked the digits out itself.
+//////////////////////////////////////////////////////////////////////////////
+static void SplitCopies(const std::string& str, StringVec& vec, char delimiter)
+{
+  vec.clear();
+  size_t start = 0;
+  while(start < str.size())
+  {
+    size_t found = str.find(delimiter, start);
+    if(found == std::string::npos)
+      found = str.size();
+    vec.push_back(str.substr(start, found - start));
+    start = found + 1;
+  }
+}
+
+static std::string IntToString(int num)
+{
+  char temp[MAX_DIGITS_IN_INT + 1];
+  _snprintf_s(temp, sizeof(temp), _TRUNCATE, "%d", num);
+  return std::string(temp);
+}
+
+static std::string FloatToString(float num)
+{
+  char temp[MAX_CHARS_IN_FLOAT + 8];
+  for(int precision = FLT_DIG; precision <= 9; ++precision)
+  {
+    _snprintf_s(temp, sizeof(temp), _TRUNCATE, "%.*g", precision, (double)num);
+    if((float)strtod(temp, 0) == num)
+      break;
+  }
+  return std::string(temp);
+}
+
+static unsigned int SignificantDigits(const char* str)
+{
+  while(*str == '-' || *str == '0' || *str == '.')
+    ++str;
+  const char* end = strchr(str, 'e');
+  if(!end)
+    end = str + strlen(str);
+  while(end > str && (end[-1] == '0' || end[-1] == '.'))
+    --end;
+  unsigned int digits = 0;
+  for(; str < end; ++str)
+    digits += *str != '.';
+  return digits;
+}
+
+static void BenchSplit()
+{
+  //an XML attribute list sort of line
+  std::string line;
+  for(unsigned int i = 0; i < 16; ++i)
+  {
+    char token[32];
+    _snprintf_s(token, sizeof(token), _TRUNCATE, "%sattribute%u=%u", i ? "," : "", i, i * 37);
+    line += token;
+  }
+
+  StringVec copies;
+  StringRefVec refs;
+  BenchTimer timer;
+  for(unsigned int i = 0; i < SPLIT_LINES; ++i)
+  {
+    SplitCopies(line, copies, ',');
+    g_bench_sink += (unsigned int)copies.size();
+  }
+  double copies_ms = timer.Milliseconds();
+
+  timer.Start();
+  for(unsigned int i = 0; i < SPLIT_LINES; ++i)
+  {
+    Split(StringRef(line), refs, ',');
+    g_bench_sink += (unsigned int)refs.size();
+  }
+  double refs_ms = timer.Milliseconds();
+
+  BENCH_CHECK(copies.size() == refs.size());
+  for(size_t i = 0; i < copies.size() && i < refs.size(); ++i)
+    BENCH_CHECK(copies[i] == refs[i].ToString());
+  printf("  split %u lines of 16: %.2f ms std::string, %.2f ms StringRef (%.1fx)\n",
+         SPLIT_LINES, copies_ms, refs_ms, copies_ms / refs_ms);
+}
+
+static void BenchIntegers()
+{
+  std::vector<int> numbers(NUMBERS);
+  BenchRandom random(26);
+  for(unsigned int i = 0; i < NUMBERS; ++i)
+    numbers[i] = (int)random.Next() >> (random.Next() % 31);
+
+  BenchTimer timer;
+  for(unsigned int i = 0; i < NUMBERS; ++i)
+    g_bench_sink += (unsigned int)IntToString(numbers[i]).size();
+  double printf_ms = timer.Milliseconds();
+
+  char buffer[MAX_DIGITS_IN_INT + 1];
+  timer.Start();
+  for(unsigned int i = 0; i < NUMBERS; ++i)
+    g_bench_sink += (unsigned int)ToStr(numbers[i], buffer, sizeof(buffer));
+  double buffer_ms = timer.Milliseconds();
+
+  for(unsigned int i = 0; i < NUMBERS; i += 97)
+  {
+    ToStr(numbers[i], buffer, sizeof(buffer));
+    BENCH_CHECK(IntToString(numbers[i]) == buffer);
+  }
+  printf("  %u ints: %.2f ms printf, %.2f ms ToStr (%.1fx)\n",
+         NUMBERS, printf_ms, buffer_ms, printf_ms / buffer_ms);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Every float has to read back exactly and never take more digits than
+// the printf search found.  VS2010 has no strtof, a double read rounded
+// to float can be off for a decimal right on a halfway point, but none of
+// the ones from this seed are.
+//////////////////////////////////////////////////////////////////////////////
+static void BenchFloats()
+{
+  std::vector<float> numbers(FLOATS);
+  BenchRandom random(2600);
+  for(unsigned int i = 0; i < FLOATS; ++i)
+  {
+    //game sized values and any bit pattern at all, alternately
+    if(i % 2)
+      numbers[i] = random.Range(-1000.0f, 1000.0f);
+    else
+    {
+      unsigned int bits = random.Next();
+      memcpy(&numbers[i], &bits, sizeof(bits));
+      if(numbers[i] != numbers[i] || numbers[i] > FLT_MAX || numbers[i] < -FLT_MAX)
+        numbers[i] = 0.0f;
+    }
+  }
+
+  BenchTimer timer;
+  for(unsigned int i = 0; i < FLOATS; ++i)
+    g_bench_sink += (unsigned int)FloatToString(numbers[i]).size();
+  double printf_ms = timer.Milliseconds();
+
+  char buffer[MAX_CHARS_IN_FLOAT];
+  timer.Start();
+  for(unsigned int i = 0; i < FLOATS; ++i)
+    g_bench_sink += (unsigned int)ToStr(numbers[i], buffer, sizeof(buffer));
+  double buffer_ms = timer.Milliseconds();
+
+  unsigned int bad = 0, longer = 0;
+  for(unsigned int i = 0; i < FLOATS; ++i)
+  {
+    if(ToStr(numbers[i], buffer, sizeof(buffer)) == 0 || (float)strtod(buffer, 0) != numbers[i])
+      ++bad;
+    else if(SignificantDigits(buffer) > SignificantDigits(FloatToString(numbers[i]).c_str()))
+      ++longer;
+  }
+  BENCH_CHECK(bad == 0);
+  BENCH_CHECK(longer == 0);
+  printf("  %u floats: %.2f ms printf, %.2f ms ToStr (%.1fx)\n",
+         FLOATS, printf_ms, buffer_ms, printf_ms / buffer_ms);
+}
+
+static void BenchWide()
+{
+  std::vector<std::wstring> strings;
+  for(unsigned int i = 0; i < 64; ++i)
+  {
+    wchar_t name[64];
+    _snwprintf_s(name, 64, _TRUNCATE, L"Art\\Textures\\Level%02u\\Wall_%u%s.dds", i % 8, i, i % 5 ? L"" : L"_\x00e9\x4e2d");
+    strings.push_back(name);
+  }
+
+  BenchTimer timer;
+  for(unsigned int i = 0; i < WIDE_STRINGS; ++i)
+    g_bench_sink += (unsigned int)ws2s(strings[i % strings.size()]).size();
+  double string_ms = timer.Milliseconds();
+
+  char buffer[256];
+  timer.Start();
+  for(unsigned int i = 0; i < WIDE_STRINGS; ++i)
+  {
+    const std::wstring& str = strings[i % strings.size()];
+    g_bench_sink += (unsigned int)ws2s(str.c_str(), str.size(), buffer, sizeof(buffer));
+  }
+  double buffer_ms = timer.Milliseconds();
+
+  for(unsigned int i = 0; i < strings.size(); ++i)
+  {
+    ws2s(strings[i].c_str(), strings[i].size(), buffer, sizeof(buffer));
+    BENCH_CHECK(ws2s(strings[i]) == buffer);
+  }
+  printf("  %u ws2s: %.2f ms std::string, %.2f ms buffer (%.1fx)\n",
+         WIDE_STRINGS, string_ms, buffer_ms, string_ms / buffer_ms);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The allocation free string functions against the std::string way.
+//////////////////////////////////////////////////////////////////////////////
+void StringBench()
+{
+  BenchSplit();
+  BenchIntegers();
+  BenchFloats();
+  BenchWide();
+}
@@ -0,0 +1,263 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "../../Engine/Text/FontCache.h"
+#include "../../Engine/Text/GlyphAtlas.h"
+#include "../../Engine/Text/TextLayoutCache.h"
+
+static const unsigned int SIZES[] = { 12, 16, 20, 24, 32 };
+const unsigned int NUM_SIZES = sizeof(SIZES) / sizeof(SIZES[0]);
+const unsigned int NUM_STATIC = 300;
+const unsigned int NUM_CHANGING = 30;
+const unsigned int FRAMES = 200;
+const unsigned int PAGE_FRAMES = 10;
+
+static const char* WORDS[] =
+{
+  "Options", "Video", "Audio", "Controls", "Quit", "Resume", "Inventory", "Health", "Armour",
+  "Gold", "Level", "Quest", "Map", "Journal", "Save", "Load", "Back", "Apply", "Volume", "Brightness"
+};
+const unsigned int NUM_WORDS = sizeof(WORDS) / sizeof(WORDS[0]);
+
+#pragma region Atlas
+
+//a glyph filled with one value, so it can be told apart from its neighbours
+struct BenchGlyph
+{
+  std::vector<unsigned char> pixels;
+  GlyphBitmap bitmap;
+
+  BenchGlyph(int width, int height, unsigned char value) : pixels(width * height, value)
+  {
+    bitmap.glyph_index = value;
+    bitmap.width = width;
+    bitmap.height = height;
+    bitmap.left = 0;
+    bitmap.top = height;
+    bitmap.advance = (float)width;
+    bitmap.pitch = width;
+    bitmap.pixels = &pixels[0];
+  }
+};
+
+static unsigned char Fill(GlyphKey key)
+{
+  return (unsigned char)(1 + key % 255);
+}
+
+static GlyphAtlas::Handle Insert(GlyphAtlas& atlas, GlyphKey key, int width, int height)
+{
+  BenchGlyph glyph(width, height, Fill(key));
+  return atlas.Insert(key, glyph.bitmap);
+}
+
+//every glyph still in the atlas has to have its own pixels, nothing was put on top of it
+static bool Intact(GlyphAtlas& atlas, GlyphKey first, GlyphKey end)
+{
+  for(GlyphKey key = first; key < end; ++key)
+  {
+    if(!atlas.Contains(key))
+      continue;
+    const AtlasGlyph& glyph = atlas.Glyph(atlas.Find(key));
+    for(int y = 0; y < glyph.height; ++y)
+    {
+      for(int x = 0; x < glyph.width; ++x)
+      {
+        if(atlas.Pixels()[(glyph.y + y) * atlas.Width() + glyph.x + x] != Fill(key))
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// An atlas full of small glyphs from an earlier frame, then a glyph taller
+// than any shelf.  Freeing small glyphs one at a time from the least
+// recently used end only leaves gaps too short for it, it needs a few
+// whole shelves emptied.  Once every glyph has been used this
+// frame nothing can be evicted and it has to fail without losing any.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckFragmented()
+{
+  //21 shelves 12 pixels high of 28 glyphs 9 pixels wide, with the padding
+  GlyphAtlas atlas(256, 256, 1);
+  const unsigned int per_shelf = 256 / 9;
+  GlyphKey key = 0;
+  for(; key < 21 * per_shelf; ++key)
+    Insert(atlas, key, 8, 8);
+  BENCH_CHECK(atlas.Stats().evictions == 0 && atlas.Stats().failures == 0);
+
+  //4 shelves make room for the 44 pixel shelf it needs
+  atlas.BeginFrame();
+  atlas.ResetStats();
+  BENCH_CHECK(Insert(atlas, key++, 40, 40) != GlyphAtlas::INVALID_HANDLE);
+  BENCH_CHECK(atlas.Stats().evictions <= 4 * per_shelf);
+  BENCH_CHECK(Intact(atlas, 0, key));
+
+  atlas.BeginFrame();
+  for(GlyphKey k = 0; k < key; ++k)
+  {
+    if(atlas.Contains(k))
+      atlas.Find(k);
+  }
+  atlas.ResetStats();
+  BENCH_CHECK(Insert(atlas, key++, 40, 60) == GlyphAtlas::INVALID_HANDLE);
+  BENCH_CHECK(atlas.Stats().evictions == 0 && atlas.Stats().failures == 1);
+  BENCH_CHECK(Intact(atlas, 0, key));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// A glyph whose height fits the atlas but whose rounded up shelf doesnt
+// can never go in, so it mustnt evict anything trying.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckRounding()
+{
+  GlyphAtlas atlas(64, 42, 1);
+  for(GlyphKey key = 0; key < 4; ++key)
+    Insert(atlas, key, 8, 8);
+  atlas.BeginFrame();
+  atlas.ResetStats();
+  BENCH_CHECK(Insert(atlas, 100, 8, 40) == GlyphAtlas::INVALID_HANDLE);
+  BENCH_CHECK(atlas.Stats().evictions == 0 && atlas.Stats().failures == 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Glyphs of every size coming and going over many frames, each frame
+// using some of the old ones again, and then checking nothing overlaps.
+//////////////////////////////////////////////////////////////////////////////
+static void Churn()
+{
+  GlyphAtlas atlas(512, 512, 1);
+  BenchRandom random(47);
+  GlyphKey next = 0;
+  unsigned int inserted = 0;
+  BenchTimer timer;
+  for(unsigned int frame = 0; frame < 500; ++frame)
+  {
+    atlas.BeginFrame();
+    for(unsigned int i = 0; i < 200; ++i)
+    {
+      GlyphKey key = next > 0 && random.Next() % 4 ? next - 1 - random.Next() % std::min(next, (GlyphKey)2000) : next++;
+      if(atlas.Find(key) != GlyphAtlas::INVALID_HANDLE)
+        continue;
+      int height = 4 + random.Next() % 60;
+      Insert(atlas, key, 2 + random.Next() % height, height);
+      ++inserted;
+    }
+  }
+  double ms = timer.Milliseconds();
+  GlyphAtlasStats stats = atlas.Stats();
+  BENCH_CHECK(Intact(atlas, 0, next));
+  printf("  atlas churn  %u inserts, %u evictions, %u failures, hit rate %.1f%%, %.0f inserts/s\n",
+         inserted, stats.evictions, stats.failures, 100.0 * stats.hits / (stats.hits + stats.misses), inserted / ms * 1000.0);
+}
+
+#pragma endregion
+
+//a UI's worth of strings, made up from the words
+static void MakeStrings(std::vector<std::string>& strings, std::vector<unsigned int>& sizes)
+{
+  BenchRandom random(147);
+  for(unsigned int i = 0; i < NUM_STATIC; ++i)
+  {
+    std::string text = WORDS[random.Next() % NUM_WORDS];
+    unsigned int num_words = random.Next() % 4;
+    for(unsigned int w = 0; w < num_words; ++w)
+      text += std::string(" ") + WORDS[random.Next() % NUM_WORDS];
+    strings.push_back(text);
+    sizes.push_back(SIZES[i % NUM_SIZES]);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// A UI drawn for FRAMES frames, NUM_STATIC strings that never change and
+// NUM_CHANGING that do every frame, like scores and timers.  The first
+// frame renders every glyph through FreeType, afterwards the static text
+// should all be layout cache hits and the changing text atlas hits.  With
+// a page for each size the static strings are split between them and the
+// page changes every PAGE_FRAMES frames, so an atlas that only holds one
+// size has to evict.
+//////////////////////////////////////////////////////////////////////////////
+static void DrawUI(FontCache& fonts, FontId font, unsigned int atlas_size, bool paged, const char* name)
+{
+  GlyphAtlas atlas(atlas_size, atlas_size, 1);
+  TextLayoutCache layouts(fonts, atlas);
+  std::vector<std::string> strings;
+  std::vector<unsigned int> sizes;
+  MakeStrings(strings, sizes);
+
+  double first_ms = 0.0, rest_ms = 0.0;
+  unsigned int first_glyphs = 0, rest_glyphs = 0, rendered = 0;
+  BenchTimer timer;
+  char text[64];
+  for(unsigned int frame = 0; frame < FRAMES; ++frame)
+  {
+    if(frame == 1)
+    {
+      rendered = layouts.Stats().glyphs_rendered;
+      layouts.ResetStats();
+      atlas.ResetStats();
+    }
+    unsigned int glyphs = 0;
+    timer.Start();
+    atlas.BeginFrame();
+    unsigned int pages = paged ? NUM_SIZES : 1;
+    unsigned int page = frame / PAGE_FRAMES % pages;
+    for(unsigned int i = page; i < NUM_STATIC; i += pages)
+      glyphs += (unsigned int)layouts.Layout(font, sizes[i], strings[i])->glyphs.size();
+    for(unsigned int i = 0; i < NUM_CHANGING; ++i)
+    {
+      _snprintf_s(text, sizeof(text), _TRUNCATE, "Score %u  Time %u:%02u", frame * 37 + i * 1000, frame / 60, frame % 60);
+      glyphs += (unsigned int)layouts.Layout(font, SIZES[i % NUM_SIZES], text, strlen(text))->glyphs.size();
+    }
+    double ms = timer.Milliseconds();
+    if(frame == 0)
+    {
+      first_ms = ms;
+      first_glyphs = glyphs;
+    }
+    else
+    {
+      rest_ms += ms;
+      rest_glyphs += glyphs;
+    }
+  }
+
+  const TextLayoutStats& layout_stats = layouts.Stats();
+  const GlyphAtlasStats& atlas_stats = atlas.Stats();
+  printf("  %-7s first frame %u glyphs, %u from FreeType, %.3f ms, %.0f glyphs/s\n",
+         name, first_glyphs, rendered, first_ms, first_glyphs / first_ms * 1000.0);
+  printf("  %-7s after that %.3f ms a frame, %.0f glyphs/s, layout hit rate %.1f%%, atlas hit rate %.1f%%, %u evictions, %u failures\n",
+         "", rest_ms / (FRAMES - 1), rest_glyphs / rest_ms * 1000.0,
+         100.0 * layout_stats.hits / (layout_stats.hits + layout_stats.misses),
+         100.0 * atlas_stats.hits / std::max(1u, atlas_stats.hits + atlas_stats.misses), atlas_stats.evictions, atlas_stats.failures);
+  BENCH_CHECK(atlas_stats.failures == 0);
+  if(!paged)
+    BENCH_CHECK(layout_stats.hits >= NUM_STATIC * (FRAMES - 1) && atlas_stats.evictions == 0);
+  else
+    BENCH_CHECK(atlas_stats.evictions > 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The atlas on its own with made up glyphs, then text laid out with the
+// one font in the tree, into an atlas big enough for all of it and one
+// only big enough for one size at a time.
+//////////////////////////////////////////////////////////////////////////////
+void TextBench()
+{
+  CheckFragmented();
+  CheckRounding();
+  Churn();
+
+  const char* path = BenchFontPath();
+  BENCH_CHECK(path != 0);
+  if(!path)
+    return;
+
+  FontCache fonts;
+  FontId font = fonts.AddFont(path);
+  BENCH_CHECK(fonts.GlyphIndex(font, 'A') != 0);
+  printf("  %u static strings and %u changing ones at %u sizes, %s\n", NUM_STATIC, NUM_CHANGING, NUM_SIZES, path);
+  DrawUI(fonts, font, 1024, false, "1024px");
+  DrawUI(fonts, font, 192, true, "192px");
+}
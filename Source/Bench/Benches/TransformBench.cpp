@@ -0,0 +1,191 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include <math.h>
+#include "../../Engine/Scene/TransformHierarchy.h"
+#include "../../Engine/Multicore/JobSystem.h"
+#include "3rdParty/glm-0.9.3.4/glm/gtc/matrix_transform.hpp"
+
+const unsigned int NUM_ROOTS = 1000;
+const unsigned int CHILDREN = 9;
+const unsigned int GRANDCHILDREN = 10;
+const unsigned int NUM_TRANSFORMS = NUM_ROOTS * (1 + CHILDREN + CHILDREN * GRANDCHILDREN);
+const unsigned int UPDATES = 50;
+const float TOLERANCE = 1e-4f;
+//a tenth of the roots moving has to update on one thread in well under this
+const double PARTIAL_BUDGET_MS = 1.0;
+
+struct BenchTransforms
+{
+  std::vector<TransformId> ids;
+  std::vector<unsigned int> parents;    //index into ids, UINT_MAX for a root
+  std::vector<glm::vec3> positions;
+  std::vector<glm::quat> rotations;
+  std::vector<glm::vec3> scales;
+};
+
+static glm::quat RandomRotation(BenchRandom& random)
+{
+  glm::quat q(random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f));
+  return glm::normalize(q);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Roots with children and grandchildren, the way a scene is mostly
+// objects with a few attached parts each.  They are created roots first,
+// so the plain way can walk them in creation order.
+//////////////////////////////////////////////////////////////////////////////
+static void MakeTransforms(TransformHierarchy& hierarchy, BenchTransforms& t)
+{
+  BenchRandom random(38);
+  for(unsigned int r = 0; r < NUM_ROOTS; ++r)
+  {
+    t.ids.push_back(hierarchy.Create());
+    t.parents.push_back(UINT_MAX);
+  }
+  for(unsigned int level = 0; level < 2; ++level)
+  {
+    unsigned int begin = level == 0 ? 0 : NUM_ROOTS;
+    unsigned int end = (unsigned int)t.ids.size();
+    unsigned int children = level == 0 ? CHILDREN : GRANDCHILDREN;
+    for(unsigned int p = begin; p < end; ++p)
+    {
+      for(unsigned int c = 0; c < children; ++c)
+      {
+        t.ids.push_back(hierarchy.Create(t.ids[p]));
+        t.parents.push_back(p);
+      }
+    }
+  }
+  for(unsigned int i = 0; i < t.ids.size(); ++i)
+  {
+    t.positions.push_back(glm::vec3(random.Range(-10.0f, 10.0f), random.Range(-10.0f, 10.0f), random.Range(-10.0f, 10.0f)));
+    t.rotations.push_back(RandomRotation(random));
+    float scale = random.Range(0.5f, 1.5f);
+    t.scales.push_back(glm::vec3(scale));
+    hierarchy.SetLocal(t.ids[i], t.positions[i], t.rotations[i], t.scales[i]);
+  }
+}
+
+//the plain way, a glm::mat4 per transform built from its parent's
+static void PlainUpdate(const BenchTransforms& t, std::vector<glm::mat4>& world)
+{
+  for(size_t i = 0; i < t.ids.size(); ++i)
+  {
+    glm::mat4 local = glm::translate(glm::mat4(1.0f), t.positions[i]) * glm::mat4_cast(t.rotations[i]) * glm::scale(glm::mat4(1.0f), t.scales[i]);
+    world[i] = t.parents[i] == UINT_MAX ? local : world[t.parents[i]] * local;
+  }
+}
+
+static bool Matches(const glm::mat4& a, const glm::mat4& b)
+{
+  for(int c = 0; c < 4; ++c)
+  {
+    for(int r = 0; r < 4; ++r)
+    {
+      if(fabsf(a[c][r] - b[c][r]) > TOLERANCE * std::max(1.0f, fabsf(b[c][r])))
+        return false;
+    }
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Times full, partial and idle updates.  A full update has every local
+// transform set first, a partial one a tenth of the roots, which updates
+// their whole subtrees, and an idle one nothing.  Returns the time of a
+// partial update.
+//////////////////////////////////////////////////////////////////////////////
+static double Run(JobSystem* jobs, const char* name)
+{
+  TransformHierarchy hierarchy(jobs);
+  BenchTransforms t;
+  MakeTransforms(hierarchy, t);
+  hierarchy.Update();
+
+  double full_ms = 0.0, partial_ms = 0.0, idle_ms = 0.0;
+  BenchTimer timer;
+  for(unsigned int u = 0; u < UPDATES; ++u)
+  {
+    for(unsigned int i = 0; i < t.ids.size(); ++i)
+      hierarchy.SetLocalPosition(t.ids[i], t.positions[i]);
+    timer.Start();
+    hierarchy.Update();
+    full_ms += timer.Milliseconds();
+
+    for(unsigned int r = u % 10; r < NUM_ROOTS; r += 10)
+      hierarchy.SetLocalPosition(t.ids[r], t.positions[r]);
+    timer.Start();
+    hierarchy.Update();
+    partial_ms += timer.Milliseconds();
+
+    timer.Start();
+    hierarchy.Update();
+    idle_ms += timer.Milliseconds();
+  }
+
+  std::vector<glm::mat4> plain(t.ids.size());
+  timer.Start();
+  for(unsigned int u = 0; u < UPDATES; ++u)
+    PlainUpdate(t, plain);
+  double plain_ms = timer.Milliseconds();
+
+  unsigned int mismatches = 0;
+  for(unsigned int i = 0; i < t.ids.size(); ++i)
+    mismatches += Matches(hierarchy.World(t.ids[i]), plain[i]) ? 0 : 1;
+  BENCH_CHECK(mismatches == 0);
+  BENCH_CHECK(hierarchy.NumLevels() == 3);
+
+  printf("  %-10s full %.3f ms, a tenth moving %.3f ms, idle %.3f ms, plain glm %.3f ms\n",
+         name, full_ms / UPDATES, partial_ms / UPDATES, idle_ms / UPDATES, plain_ms / UPDATES);
+  return partial_ms / UPDATES;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// An id kept after its transform is destroyed must not reach the
+// transform that reuses its slot.
+//////////////////////////////////////////////////////////////////////////////
+static void CheckStaleIds()
+{
+  TransformHierarchy hierarchy;
+  TransformId old_id = hierarchy.Create();
+  hierarchy.Destroy(old_id);
+  BENCH_CHECK(!hierarchy.IsValid(old_id));
+  hierarchy.Update();
+
+  TransformId new_id = hierarchy.Create();
+  BENCH_CHECK((new_id & TRANSFORM_SLOT_MASK) == (old_id & TRANSFORM_SLOT_MASK));
+  BENCH_CHECK(new_id != old_id);
+  BENCH_CHECK(!hierarchy.IsValid(old_id));
+
+  hierarchy.SetLocalPosition(new_id, glm::vec3(1.0f, 2.0f, 3.0f));
+  hierarchy.SetLocalPosition(old_id, glm::vec3(7.0f));
+  hierarchy.Update();
+  BENCH_CHECK(hierarchy.World(new_id)[3] == glm::vec4(1.0f, 2.0f, 3.0f, 1.0f));
+  BENCH_CHECK(hierarchy.World(old_id) == glm::mat4(1.0f));
+  BENCH_CHECK(!hierarchy.WorldChanged(old_id));
+  BENCH_CHECK(hierarchy.Parent(old_id) == INVALID_TRANSFORM_ID);
+  BENCH_CHECK(!hierarchy.SetParent(old_id, new_id));
+  BENCH_CHECK(hierarchy.Count() == 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// 100000 transforms in three levels, updated on one thread, on the job
+// system, and the plain way for comparison.  The hierarchy's world
+// matrices have to match the plain ones, and in a release build a tenth
+// of the roots moving has to fit the budget on one thread.
+//////////////////////////////////////////////////////////////////////////////
+void TransformBench()
+{
+  printf("  %u transforms, %u roots with %u children and %u grandchildren each\n",
+         NUM_TRANSFORMS, NUM_ROOTS, CHILDREN, CHILDREN * GRANDCHILDREN);
+  double partial_ms = Run(0, "1 thread");
+#ifndef _DEBUG
+  printf("  a tenth moving on 1 thread %.3f ms, budget %.3f ms\n", partial_ms, PARTIAL_BUDGET_MS);
+  BENCH_CHECK(partial_ms < PARTIAL_BUDGET_MS);
+#endif
+  JobSystem jobs;
+  char name[32];
+  _snprintf_s(name, sizeof(name), _TRUNCATE, "%u threads", jobs.NumThreads());
+  Run(&jobs, name);
+  CheckStaleIds();
+}
@@ -0,0 +1,166 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "../../Engine/Utility/Utf8.h"
+
+//about a megabyte of each kind of text, converted this many times
+const size_t TEXT_BYTES = 1 << 20;
+const unsigned int PASSES = 20;
+
+//////////////////////////////////////////////////////////////////////////////
+// A byte at a time decoder with no checks, what the converters' scalar
+// loop does for valid text.  The results are checked against it.
+//////////////////////////////////////////////////////////////////////////////
+static size_t PlainUtf8ToUtf16(const unsigned char* src, size_t len, Utf16Char* dest)
+{
+  size_t out = 0;
+  for(size_t i = 0; i < len;)
+  {
+    unsigned int code_point = src[i];
+    size_t units = 1;
+    if(code_point >= 0xf0)
+    {
+      code_point &= 0x07;
+      units = 4;
+    }
+    else if(code_point >= 0xe0)
+    {
+      code_point &= 0x0f;
+      units = 3;
+    }
+    else if(code_point >= 0x80)
+    {
+      code_point &= 0x1f;
+      units = 2;
+    }
+    for(size_t k = 1; k < units; ++k)
+      code_point = (code_point << 6) | (src[i + k] & 0x3f);
+    i += units;
+
+    if(code_point >= 0x10000)
+    {
+      code_point -= 0x10000;
+      dest[out++] = (Utf16Char)(0xd800 + (code_point >> 10));
+      dest[out++] = (Utf16Char)(0xdc00 + (code_point & 0x3ff));
+    }
+    else
+    {
+      dest[out++] = (Utf16Char)code_point;
+    }
+  }
+  return out;
+}
+
+//random picks from the fragments until the text is TEXT_BYTES long
+static void MakeText(const char* const* fragments, unsigned int num_fragments, unsigned int seed, std::string& text)
+{
+  BenchRandom random(seed);
+  text.clear();
+  while(text.size() < TEXT_BYTES)
+    text += fragments[random.Next() % num_fragments];
+}
+
+static void BenchText(const char* name, const std::string& text)
+{
+  const unsigned char* src = (const unsigned char*)text.c_str();
+  std::vector<Utf16Char> wide(text.size() + 1), plain(text.size() + 1);
+  std::vector<char> narrow(text.size() * 3 + 1);
+  size_t wide_length = 0, narrow_length = 0, plain_length = 0;
+
+  BenchTimer timer;
+  for(unsigned int i = 0; i < PASSES; ++i)
+    plain_length = PlainUtf8ToUtf16(src, text.size(), &plain[0]);
+  double plain_ms = timer.Milliseconds();
+
+  UtfResult to_wide = UTF_OK, to_narrow = UTF_OK;
+  timer.Start();
+  for(unsigned int i = 0; i < PASSES; ++i)
+    to_wide = Utf8ToUtf16(text.c_str(), text.size(), &wide[0], wide.size(), wide_length);
+  double to_wide_ms = timer.Milliseconds();
+
+  timer.Start();
+  for(unsigned int i = 0; i < PASSES; ++i)
+    to_narrow = Utf16ToUtf8(&wide[0], wide_length, &narrow[0], narrow.size(), narrow_length);
+  double to_narrow_ms = timer.Milliseconds();
+
+  timer.Start();
+  int win32_length = 0;
+  for(unsigned int i = 0; i < PASSES; ++i)
+    win32_length = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), (int)text.size(), (LPWSTR)&plain[0], (int)plain.size());
+  double win32_ms = timer.Milliseconds();
+  g_bench_sink += win32_length;
+
+  //the Win32 pass wrote over it
+  plain_length = PlainUtf8ToUtf16(src, text.size(), &plain[0]);
+  BENCH_CHECK(to_wide == UTF_OK && to_narrow == UTF_OK);
+  BENCH_CHECK(wide_length == plain_length && memcmp(&wide[0], &plain[0], plain_length * sizeof(Utf16Char)) == 0);
+  BENCH_CHECK(narrow_length == text.size() && memcmp(&narrow[0], text.c_str(), text.size()) == 0);
+  BENCH_CHECK(IsValidUtf8(text.c_str(), text.size()));
+
+  double megabytes = (double)text.size() * PASSES / (1024.0 * 1024.0);
+  printf("  %s: UTF-8 to UTF-16 %.0f MB/s (plain loop %.0f MB/s, MultiByteToWideChar %.0f MB/s), UTF-16 to UTF-8 %.0f MB/s\n",
+         name, megabytes * 1000.0 / to_wide_ms, megabytes * 1000.0 / plain_ms, megabytes * 1000.0 / win32_ms,
+         megabytes * 1000.0 / to_narrow_ms);
+}
+
+//every kind of malformed input the converters promise to reject
+static void CheckInvalid()
+{
+  static const char* const INVALID[] =
+  {
+    "\xc0\x80",             //overlong '\0'
+    "\xe0\x80\xaf",         //overlong '/'
+    "\xed\xa0\x80",         //a surrogate
+    "\xf4\x90\x80\x80",     //past U+10FFFF
+    "\xe4\xb8",             //cut short
+    "\x80",                 //a continuation on its own
+    "\xfe",
+  };
+  for(unsigned int i = 0; i < sizeof(INVALID) / sizeof(INVALID[0]); ++i)
+  {
+    //buried in ASCII so the fast path runs up to it
+    std::string text = std::string(40, 'a') + INVALID[i] + std::string(40, 'b');
+    Utf16Char wide[128];
+    size_t length = 0;
+    BENCH_CHECK(!IsValidUtf8(text.c_str(), text.size()));
+    BENCH_CHECK(Utf8ToUtf16(text.c_str(), text.size(), wide, 128, length) == UTF_INVALID_SEQUENCE && length == 40);
+    BENCH_CHECK(Utf8ToUtf16(text.c_str(), text.size(), wide, 128, length, true) == UTF_OK && wide[40] == UTF_REPLACEMENT_CHAR);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Throughput of the UTF-8 converters on paths and XML, where the ASCII
+// fast path does everything, and on localized text where it does little.
+//////////////////////////////////////////////////////////////////////////////
+void Utf8Bench()
+{
+  static const char* const ASCII[] =
+  {
+    "Art\\Textures\\Level01\\Wall_Brick.dds",
+    "<Actor type=\"Sphere\" resource=\"actors\\sphere.xml\">",
+    "<TransformComponent><Position x=\"0\" y=\"1.5\" z=\"-20\"/></TransformComponent>",
+    "Sounds\\Music\\Theme.ogg",
+  };
+  static const char* const LOCALIZED[] =
+  {
+    "Options du jeu ",
+    "Schwierigkeitsgrad: m\xc3\xa4\xc3\x9fig ",
+    "\xe3\x82\xb2\xe3\x83\xbc\xe3\x83\xa0\xe3\x82\x92\xe7\xb6\x9a\xe3\x81\x91\xe3\x82\x8b ",
+    "\xe6\x96\xb0\xe6\xb8\xb8\xe6\x88\x8f",
+    "Press Start \xf0\x9f\x8e\xae ",
+  };
+  static const char* const CJK[] =
+  {
+    "\xe6\x96\xb0\xe6\xb8\xb8\xe6\x88\x8f",
+    "\xe8\xae\xbe\xe7\xbd\xae",
+    "\xe3\x82\xb2\xe3\x83\xbc\xe3\x83\xa0",
+  };
+
+  std::string text;
+  MakeText(ASCII, sizeof(ASCII) / sizeof(ASCII[0]), 27, text);
+  BenchText("ascii", text);
+  MakeText(LOCALIZED, sizeof(LOCALIZED) / sizeof(LOCALIZED[0]), 270, text);
+  BenchText("localized", text);
+  MakeText(CJK, sizeof(CJK) / sizeof(CJK[0]), 2700, text);
+  BenchText("cjk", text);
+  CheckInvalid();
+}
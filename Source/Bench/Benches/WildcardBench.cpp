@@ -0,0 +1,109 @@
+#include "BenchStd.h"
+#include "Bench.h"
+#include "../../Engine/Utility/WildcardPattern.h"
+
+const unsigned int RANDOM_PATTERNS = 2000;
+const unsigned int RANDOM_NAMES = 500;
+const unsigned int DIRECTORY_NAMES = 20000;
+const unsigned int DIRECTORY_PASSES = 20;
+
+//patterns and names that have gone wrong in matchers before
+static const char* PATTERNS[] =
+{
+  "", "*", "**", "***", "?", "??", "*?", "?*", "*?*", "a", "a*", "*a", "*a*", "a*a", "a**a", "*a*a*",
+  "*.*", "*.???", "?.?", "a?b", "a*b*c", "*ab*ab", "ab*ab*", "*.txt", "data/*.dds", "*/*", "a.b.c"
+};
+static const char* NAMES[] =
+{
+  "", "a", "aa", "aaa", "ab", "aab", "abab", "ababab", "abc", "a.b", "a.b.c", ".", "..", ".a", "a.",
+  "abc.txt", "abc.txt.bak", "data/rock.dds", "data/sub/rock.dds", "a/b", "axbxc", "xab"
+};
+const unsigned int NUM_PATTERNS = sizeof(PATTERNS) / sizeof(PATTERNS[0]);
+const unsigned int NUM_NAMES = sizeof(NAMES) / sizeof(NAMES[0]);
+
+//a few letters, dots and stars, so runs of stars, ?s next to dots and repeats all come up often
+static std::string RandomString(BenchRandom& random, const char* alphabet, unsigned int max_length)
+{
+  size_t alphabet_size = strlen(alphabet);
+  unsigned int length = random.Next() % (max_length + 1);
+  std::string str;
+  for(unsigned int i = 0; i < length; ++i)
+    str += alphabet[random.Next() % alphabet_size];
+  return str;
+}
+
+//counts the pattern and name pairs the two matchers disagree on, MatchAll() included
+static unsigned int Compare(const char* pattern_text, const StringVec& names)
+{
+  WildcardPattern pattern(pattern_text);
+  std::vector<size_t> expected, found;
+  unsigned int wrong = 0;
+  for(size_t i = 0; i < names.size(); ++i)
+  {
+    bool match = WildcardMatch(pattern_text, names[i].c_str()) != FALSE;
+    wrong += pattern.Match(names[i].c_str(), names[i].size()) != match;
+    if(match)
+      expected.push_back(i);
+  }
+  pattern.MatchAll(names, found);
+  wrong += found != expected;
+  return wrong;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// WildcardPattern has to give what WildcardMatch() does for every pattern
+// and name, the listed ones and random ones, then both are timed over a
+// directory of asset names.
+//////////////////////////////////////////////////////////////////////////////
+void WildcardBench()
+{
+  BenchRandom random(28);
+  StringVec names(NAMES, NAMES + NUM_NAMES);
+  for(unsigned int i = 0; i < RANDOM_NAMES; ++i)
+    names.push_back(RandomString(random, "ab.", 10));
+
+  unsigned int wrong = 0, compared = 0;
+  for(unsigned int i = 0; i < NUM_PATTERNS; ++i)
+  {
+    wrong += Compare(PATTERNS[i], names);
+    ++compared;
+  }
+  for(unsigned int i = 0; i < RANDOM_PATTERNS; ++i)
+  {
+    wrong += Compare(RandomString(random, "ab.*?", 8).c_str(), names);
+    ++compared;
+  }
+  printf("  %u patterns against %u names, %u disagree\n", compared, (unsigned int)names.size(), wrong);
+  BENCH_CHECK(wrong == 0);
+
+  StringVec directory;
+  static const char* EXTENSIONS[] = { "dds", "xml", "ogg", "mesh", "lua" };
+  for(unsigned int i = 0; i < DIRECTORY_NAMES; ++i)
+  {
+    char name[64];
+    _snprintf_s(name, sizeof(name), _TRUNCATE, "level%u/asset%05u.%s", i % 12, i, EXTENSIONS[random.Next() % 5]);
+    directory.push_back(name);
+  }
+  const char* text = "level3/*.dds";
+  WildcardPattern pattern(text);
+  std::vector<size_t> matches;
+  unsigned int old_matches = 0;
+  BenchTimer timer;
+  for(unsigned int pass = 0; pass < DIRECTORY_PASSES; ++pass)
+  {
+    for(size_t i = 0; i < directory.size(); ++i)
+      old_matches += WildcardMatch(text, directory[i].c_str()) != FALSE;
+  }
+  double old_ms = timer.Milliseconds();
+  timer.Start();
+  for(unsigned int pass = 0; pass < DIRECTORY_PASSES; ++pass)
+  {
+    matches.clear();
+    pattern.MatchAll(directory, matches);
+  }
+  double compiled_ms = timer.Milliseconds();
+  g_bench_sink += old_matches;
+  printf("  %s over %u names, WildcardMatch %.3f ms, WildcardPattern %.3f ms\n",
+         text, DIRECTORY_NAMES, old_ms / DIRECTORY_PASSES, compiled_ms / DIRECTORY_PASSES);
+  BENCH_CHECK(old_matches == matches.size() * DIRECTORY_PASSES);
+}
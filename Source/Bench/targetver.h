@@ -0,0 +1,3 @@
+#pragma once
+
+#include <sdkddkver.h>
\ No newline at end of file
@@ -1,2 +1,63 @@
 #include "EngineStd.h"
-#include "Actor.h"
\ No newline at end of file
+#include "Actor.h"
+#include "ActorComponent.h"
+#include "ComponentScheduler.h"
+
+Actor::Actor(ActorId id)
+{
+  _id = id;
+  _proxy = INVALID_PROXY_ID;
+}
+
+Actor::~Actor()
+{
+  //the scheduler doesnt own the components, so they cant be left in it
+  Destroy();
+}
+
+void Actor::Destroy()
+{
+  ComponentScheduler* scheduler = ComponentScheduler::Get();
+  for(ActorComponents::iterator it = _components.begin(); it != _components.end(); ++it)
+  {
+    if(scheduler)
+      scheduler->RemoveComponent(it->second.get());
+  }
+  _components.clear();
+
+  AabbTree* tree = AabbTree::Get();
+  if(tree && _proxy != INVALID_PROXY_ID)
+    tree->Remove(_proxy);
+  _proxy = INVALID_PROXY_ID;
+}
+
+void Actor::Update(int delta)
+{
+  for(ActorComponents::iterator it = _components.begin(); it != _components.end(); ++it)
+  {
+    if(!it->second->IsScheduled())
+      it->second->Update(delta);
+  }
+}
+
+void Actor::AddComponent(StrongActorComponentPtr component)
+{
+  ComponentScheduler* scheduler = ComponentScheduler::Get();
+  ActorComponents::iterator it = _components.find(component->Id());
+  if(it != _components.end() && scheduler)
+    scheduler->RemoveComponent(it->second.get());
+  _components[component->Id()] = component;
+  if(scheduler)
+    scheduler->AddComponent(_id, component.get());
+}
+
+void Actor::SetBounds(const Aabb& box)
+{
+  AabbTree* tree = AabbTree::Get();
+  if(!tree)
+    return;
+  if(_proxy == INVALID_PROXY_ID)
+    _proxy = tree->Insert(box, _id);
+  else
+    tree->Move(_proxy, box);
+}
@@ -38,6 +38,8 @@
 //
 //========================================================================
 
+#include "ActorComponent.h"
+#include "../Scene/AabbTree.h"
 
 class XMLElement;
 typedef std::string ActorType;
@@ -51,6 +53,7 @@ private:
   ActorId _id;
   ActorComponents _components;
   ActorType _type;
+  ProxyId _proxy;         //in the global AabbTree, once SetBounds() has been called
 
   std::string _resource;  //xml file from which this actor was initialized
 
@@ -59,7 +62,9 @@ public:
   ~Actor();
   bool Init(XMLElement* data);
   void PostInit();
+  //takes the components out of the scheduler and the actor out of the AabbTree
   void Destroy();
+  //updates the components the ComponentScheduler isnt running, the scheduler does the rest
   void Update(int delta);
 
   //editor functions
@@ -86,14 +91,14 @@ public:
     }
   }
 
-  template<class CompnentType>
-  weak_ptr<CompnentType> Component(const char* name)
+  template<class ComponentType>
+  weak_ptr<ComponentType> Component(const char* name)
   {
-    ComponentId id = ActorCompnent::GetIdFromName(name);
-    ActorComponents::iterator it = _compnents.find(id);
+    ComponentId id = ActorComponent::GetIdFromName(name);
+    ActorComponents::iterator it = _components.find(id);
     if(it != _components.end())
     {
-      StrongActorCompnentPtr base(it->second);
+      StrongActorComponentPtr base(it->second);
       shared_ptr<ComponentType> sub(static_pointer_cast<ComponentType>(base));
       weak_ptr<ComponentType> weak_sub(sub);
       return weak_sub;
@@ -106,5 +111,11 @@ public:
 
   const ActorComponents* Components() { return &_components; }
 
+  //the component is added to the global ComponentScheduler, if there is one
   void AddComponent(StrongActorComponentPtr component);
+
+  //puts the actor in the global AabbTree, if there is one, or moves it there.  Whatever
+  //moves the actor calls this, the spatial queries find it by its last bounds.
+  void SetBounds(const Aabb& box);
+  ProxyId Proxy() const { return _proxy; }
 };
\ No newline at end of file
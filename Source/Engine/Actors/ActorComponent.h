@@ -38,13 +38,42 @@
 //========================================================================
 
 class XMLElement;
+class ComponentScheduler;
+
+//////////////////////////////////////////////////////////////////////////////
+// What a component type's Update() touches, so the ComponentScheduler knows
+// which types can be updated at the same time.  reads and writes name other
+// component types on the same actor.  A type always counts as writing
+// itself.
+//////////////////////////////////////////////////////////////////////////////
+struct ComponentAccess
+{
+  unsigned int phase;               //phases run in increasing order, each one finishes before the next starts
+  std::vector<ComponentId> reads;
+  std::vector<ComponentId> writes;
+  bool serial;                      //Update() touches other actors, so this type's components are updated one at a time
+
+  ComponentAccess() : phase(0), serial(false) {}
+};
 
 class ActorComponent
 {
+  friend class ComponentScheduler;
+
 protected:
   StrongActorPtr _owner;
 
+private:
+  //owned by the scheduler
+  ComponentScheduler* _scheduler;
+  ActorId _schedule_actor;
+  unsigned int _schedule_index;   //where it is in its type's array, UINT_MAX while its actor sleeps
+  unsigned int _schedule_bucket;  //which of the array's update rate buckets it is in
+  unsigned long _last_update;     //scheduler time it was last updated at
+  bool _wants_sleep;
+
 public:
+  ActorComponent() : _scheduler(0), _schedule_actor(INVALID_ACTOR_ID), _schedule_index(UINT_MAX), _schedule_bucket(0), _last_update(0), _wants_sleep(false) {}
   virtual ~ActorComponent() { _owner.reset(); }
 
   //these functions are meant to be overridden by implemenation classes of the components
@@ -53,6 +82,20 @@ public:
   virtual void Update(int delta) {}
   virtual void OnChanged() {}
 
+  //called once per component type when the first one is added to the scheduler
+  virtual void UpdateAccess(ComponentAccess& access) const {}
+  bool IsScheduled() const { return _scheduler != 0; }
+
+protected:
+  //the actor stops being updated once all of its components have asked to sleep.  With
+  //wake_after_ms >= 0 it is woken after that much game time, otherwise it sleeps until
+  //something wakes it, such as an event listener or a trigger calling Wake().
+  void Sleep(int wake_after_ms = -1);
+  //wakes the actor and cancels any sleep its components asked for
+  void Wake();
+
+public:
+
   //for the editor
   virtual XMLElement* GenerateXml() = 0;
 
@@ -61,6 +104,11 @@ public:
   virtual const char* Name() const  = 0;
   static ComponentId GetIdFromName(const char* component_str)
   {
+    //FNV-1a, so the same name gives the same id on every run
+    ComponentId id = 2166136261u;
+    for(const char* c = component_str; *c; ++c)
+      id = (id ^ (unsigned char)*c) * 16777619u;
+    return id;
   }
 
 };
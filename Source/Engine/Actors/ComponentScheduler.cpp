@@ -0,0 +1,564 @@
+#include "EngineStd.h"
+#include "ComponentScheduler.h"
+#include "../Multicore/JobSystem.h"
+#include "../Scene/AabbTree.h"
+#include "../Debugging/Logger.h"
+
+//components per job.  Big enough that queuing the job is cheap next to running it.
+const unsigned int COMPONENTS_PER_CHUNK = 256;
+
+#pragma region ComponentScheduler
+
+ComponentScheduler* ComponentScheduler::_global = 0;
+
+ComponentScheduler::ComponentScheduler(JobSystem* jobs, bool set_as_global)
+{
+  _jobs = jobs;
+  _stages_dirty = false;
+  _num_asleep = 0;
+  _time = 0;
+  _next_sleep_serial = 0;
+  _frame = 0;
+  for(int i = 0; i < NUM_UPDATE_TIERS; ++i)
+  {
+    _next_slot[i] = 0;
+    _frame_buckets[i] = 0;
+  }
+  _updating = false;
+
+  if(set_as_global)
+  {
+    if(_global)
+      SOL_ERROR("Attempting to create two global component schedulers! Actors will use the new one.");
+    _global = this;
+  }
+}
+
+ComponentScheduler::~ComponentScheduler()
+{
+  if(_global == this)
+    _global = 0;
+
+  for(ActorMap::iterator it = _actors.begin(); it != _actors.end(); ++it)
+  {
+    std::vector<ActorComponent*>& components = it->second.components;
+    for(size_t i = 0; i < components.size(); ++i)
+    {
+      components[i]->_scheduler = 0;
+      components[i]->_schedule_index = UINT_MAX;
+    }
+  }
+  for(TypeMap::iterator it = _types.begin(); it != _types.end(); ++it)
+    delete it->second;
+}
+
+void ComponentScheduler::AddComponent(ActorId actor, ActorComponent* component)
+{
+  SOL_ASSERT(!_updating);
+  SOL_ASSERT(!component->_scheduler);
+
+  ComponentId id = component->Id();
+  if(_types.find(id) == _types.end())
+  {
+    TypeBatch* batch = SOL_NEW TypeBatch;
+    batch->id = id;
+    batch->order = (unsigned int)_registered.size();
+    component->UpdateAccess(batch->access);
+    _types[id] = batch;
+    _registered.push_back(batch);
+    _stages_dirty = true;
+  }
+
+  component->_scheduler = this;
+  component->_schedule_actor = actor;
+  component->_wants_sleep = false;
+  component->_last_update = _time;
+
+  DoWake(actor);
+  ActorRecord& record = _actors[actor];
+  record.components.push_back(component);
+  ++record.awake_count;
+  Insert(component, record.bucket);
+}
+
+void ComponentScheduler::RemoveComponent(ActorComponent* component)
+{
+  SOL_ASSERT(!_updating);
+  if(component->_scheduler != this)
+    return;
+
+  ActorMap::iterator it = _actors.find(component->_schedule_actor);
+  SOL_ASSERT(it != _actors.end());
+  ActorRecord& record = it->second;
+  std::vector<ActorComponent*>::iterator found = std::find(record.components.begin(), record.components.end(), component);
+  SOL_ASSERT(found != record.components.end());
+  record.components.erase(found);
+  if(!component->_wants_sleep)
+    --record.awake_count;
+
+  if(component->_schedule_index != UINT_MAX)
+    Extract(component);
+  component->_scheduler = 0;
+  component->_schedule_actor = INVALID_ACTOR_ID;
+  component->_wants_sleep = false;
+
+  //any heap entry for the actor is skipped once the record is gone
+  if(record.components.empty())
+  {
+    if(record.asleep)
+      --_num_asleep;
+    _actors.erase(it);
+  }
+  //the one removed was the only one keeping the actor awake
+  else if(!record.asleep && record.awake_count == 0)
+  {
+    FallAsleep(it->first, record);
+  }
+}
+
+void ComponentScheduler::Update(int delta)
+{
+  if(_stages_dirty)
+    BuildStages();
+
+  _time += delta;
+  WakeSleepers();
+
+  for(int tier = 0; tier < NUM_UPDATE_TIERS; ++tier)
+    _frame_buckets[tier] = (1 << tier) - 1 + (_frame & ((1 << tier) - 1));
+  ++_frame;
+
+  _updating = true;
+  for(size_t s = 0; s < _stages.size(); ++s)
+  {
+    _chunks.clear();
+    Stage& stage = _stages[s];
+    for(size_t t = 0; t < stage.size(); ++t)
+    {
+      TypeBatch* batch = stage[t];
+      Chunk chunk;
+      chunk.batch = batch;
+      chunk.all_tiers = batch->access.serial;
+      if(chunk.all_tiers)
+      {
+        chunk.tier = 0;
+        chunk.begin = chunk.end = 0;
+        _chunks.push_back(chunk);
+        continue;
+      }
+      for(int tier = 0; tier < NUM_UPDATE_TIERS; ++tier)
+      {
+        unsigned int count = (unsigned int)batch->buckets[_frame_buckets[tier]].size();
+        chunk.tier = tier;
+        for(unsigned int begin = 0; begin < count; begin += COMPONENTS_PER_CHUNK)
+        {
+          chunk.begin = begin;
+          chunk.end = std::min(count, begin + COMPONENTS_PER_CHUNK);
+          _chunks.push_back(chunk);
+        }
+      }
+    }
+
+    if(_jobs)
+      _jobs->ParallelFor(UpdateChunks, this, (unsigned int)_chunks.size(), 1);
+    else
+      UpdateChunks(this, 0, (unsigned int)_chunks.size());
+  }
+  _updating = false;
+
+  RunRequests();
+}
+
+void ComponentScheduler::WakeActor(ActorId actor)
+{
+  Request(ActivityRequest::WAKE, actor, 0, 0);
+}
+
+void ComponentScheduler::WakeActorsNear(const AabbTree& tree, const glm::vec3& center, float radius)
+{
+  std::vector<ActorId> nearby;
+  tree.QuerySphere(center, radius, nearby);
+  for(size_t i = 0; i < nearby.size(); ++i)
+    WakeActor(nearby[i]);
+}
+
+bool ComponentScheduler::IsActorAsleep(ActorId actor) const
+{
+  ActorMap::const_iterator it = _actors.find(actor);
+  return it != _actors.end() && it->second.asleep;
+}
+
+void ComponentScheduler::SetActorUpdateTier(ActorId actor, UpdateTier tier)
+{
+  Request(ActivityRequest::SET_TIER, actor, 0, tier);
+}
+
+UpdateTier ComponentScheduler::ActorUpdateTier(ActorId actor) const
+{
+  ActorMap::const_iterator it = _actors.find(actor);
+  return it == _actors.end() ? UPDATE_EVERY_FRAME : it->second.tier;
+}
+
+unsigned int ComponentScheduler::NumStages()
+{
+  if(_stages_dirty)
+    BuildStages();
+  return (unsigned int)_stages.size();
+}
+
+unsigned int ComponentScheduler::ComponentCount(ComponentId id) const
+{
+  TypeMap::const_iterator it = _types.find(id);
+  if(it == _types.end())
+    return 0;
+
+  size_t count = 0;
+  for(unsigned int i = 0; i < NUM_UPDATE_BUCKETS; ++i)
+    count += it->second->buckets[i].size();
+  return (unsigned int)count;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Each type goes in the first stage of its phase that comes after every
+// stage holding a type it conflicts with, which keeps conflicting types in
+// the order SortPhase() puts them in.  The types are walked phase by phase
+// in that order, so that is always a stage that already exists or the next
+// new one.
+//////////////////////////////////////////////////////////////////////////////
+void ComponentScheduler::BuildStages()
+{
+  std::map<unsigned int, std::vector<TypeBatch*> > phases;
+  for(size_t i = 0; i < _registered.size(); ++i)
+    phases[_registered[i]->access.phase].push_back(_registered[i]);
+
+  _stages.clear();
+  for(std::map<unsigned int, std::vector<TypeBatch*> >::iterator phase = phases.begin(); phase != phases.end(); ++phase)
+  {
+    size_t first_stage = _stages.size();
+    std::vector<TypeBatch*>& types = phase->second;
+    SortPhase(types);
+    for(size_t t = 0; t < types.size(); ++t)
+    {
+      size_t stage = first_stage;
+      for(size_t s = first_stage; s < _stages.size(); ++s)
+      {
+        for(size_t other = 0; other < _stages[s].size(); ++other)
+        {
+          if(Conflicts(types[t], _stages[s][other]))
+          {
+            stage = s + 1;
+            break;
+          }
+        }
+      }
+
+      if(stage == _stages.size())
+        _stages.push_back(Stage());
+      _stages[stage].push_back(types[t]);
+    }
+  }
+  _stages_dirty = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Puts a phase's types, which come in registration order, in the order
+// they are updated.  Each pick is the earliest registered type that reads
+// nothing the types still left write.  If every type left reads one of
+// the others, they read each other in a loop and the earliest registered
+// goes next anyway.  A phase only has a handful of types.
+//////////////////////////////////////////////////////////////////////////////
+void ComponentScheduler::SortPhase(std::vector<TypeBatch*>& types)
+{
+  std::vector<TypeBatch*> left(types);
+  types.clear();
+  while(!left.empty())
+  {
+    size_t next = 0;
+    for(size_t i = 0; i < left.size(); ++i)
+    {
+      bool ready = true;
+      for(size_t j = 0; j < left.size() && ready; ++j)
+        ready = i == j || !Reads(left[i], left[j]);
+      if(ready)
+      {
+        next = i;
+        break;
+      }
+    }
+    types.push_back(left[next]);
+    left.erase(left.begin() + next);
+  }
+}
+
+//true if reader reads writer's type or something writer writes
+bool ComponentScheduler::Reads(const TypeBatch* reader, const TypeBatch* writer)
+{
+  const std::vector<ComponentId>& reads = reader->access.reads;
+  if(std::find(reads.begin(), reads.end(), writer->id) != reads.end())
+    return true;
+  for(size_t i = 0; i < writer->access.writes.size(); ++i)
+  {
+    if(std::find(reads.begin(), reads.end(), writer->access.writes[i]) != reads.end())
+      return true;
+  }
+  return false;
+}
+
+bool ComponentScheduler::Conflicts(const TypeBatch* a, const TypeBatch* b)
+{
+  //everything each one writes, including itself
+  std::vector<ComponentId> a_writes(a->access.writes);
+  a_writes.push_back(a->id);
+  std::vector<ComponentId> b_writes(b->access.writes);
+  b_writes.push_back(b->id);
+
+  for(size_t i = 0; i < a_writes.size(); ++i)
+  {
+    ComponentId id = a_writes[i];
+    if(std::find(b_writes.begin(), b_writes.end(), id) != b_writes.end() ||
+       std::find(b->access.reads.begin(), b->access.reads.end(), id) != b->access.reads.end())
+      return true;
+  }
+  for(size_t i = 0; i < b_writes.size(); ++i)
+  {
+    ComponentId id = b_writes[i];
+    if(std::find(a->access.reads.begin(), a->access.reads.end(), id) != a->access.reads.end())
+      return true;
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Swaps the last component of the bucket into the hole, the order within a
+// bucket doesnt matter.
+//////////////////////////////////////////////////////////////////////////////
+void ComponentScheduler::Insert(ActorComponent* component, unsigned int bucket)
+{
+  std::vector<ActorComponent*>& components = _types[component->Id()]->buckets[bucket];
+  component->_schedule_index = (unsigned int)components.size();
+  component->_schedule_bucket = bucket;
+  components.push_back(component);
+}
+
+void ComponentScheduler::Extract(ActorComponent* component)
+{
+  std::vector<ActorComponent*>& components = _types[component->Id()]->buckets[component->_schedule_bucket];
+  unsigned int index = component->_schedule_index;
+  SOL_ASSERT(components[index] == component);
+  components[index] = components.back();
+  components[index]->_schedule_index = index;
+  components.pop_back();
+  component->_schedule_index = UINT_MAX;
+}
+
+void ComponentScheduler::UpdateChunks(void* data, unsigned int begin, unsigned int end)
+{
+  ComponentScheduler* scheduler = (ComponentScheduler*)data;
+  for(unsigned int c = begin; c < end; ++c)
+  {
+    const Chunk& chunk = scheduler->_chunks[c];
+    if(!chunk.all_tiers)
+    {
+      scheduler->UpdateComponents(chunk.batch->buckets[scheduler->_frame_buckets[chunk.tier]], chunk.begin, chunk.end);
+      continue;
+    }
+    //a serial type's components are only ever updated by this one job
+    for(int tier = 0; tier < NUM_UPDATE_TIERS; ++tier)
+    {
+      std::vector<ActorComponent*>& components = chunk.batch->buckets[scheduler->_frame_buckets[tier]];
+      scheduler->UpdateComponents(components, 0, (unsigned int)components.size());
+    }
+  }
+}
+
+void ComponentScheduler::UpdateComponents(std::vector<ActorComponent*>& components, unsigned int begin, unsigned int end)
+{
+  for(unsigned int i = begin; i < end; ++i)
+  {
+    //slower tiers get all the time since they last ran
+    ActorComponent* component = components[i];
+    int delta = (int)(_time - component->_last_update);
+    component->_last_update = _time;
+    component->Update(delta);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Requests from inside Update() may come from any of the job system's
+// threads, so they are queued and carried out after the update.  Anywhere
+// else they happen straight away.
+//////////////////////////////////////////////////////////////////////////////
+void ComponentScheduler::Request(ActivityRequest::Kind kind, ActorId actor, ActorComponent* component, int value)
+{
+  ActivityRequest request;
+  request.kind = kind;
+  request.actor = actor;
+  request.component = component;
+  request.value = value;
+
+  if(_updating)
+  {
+    _requests.Push(request);
+    return;
+  }
+
+  switch(kind)
+  {
+  case ActivityRequest::SLEEP:
+    DoSleep(component, value);
+    break;
+  case ActivityRequest::WAKE:
+    DoWake(actor);
+    break;
+  case ActivityRequest::SET_TIER:
+    DoSetTier(actor, (UpdateTier)value);
+    break;
+  }
+}
+
+void ComponentScheduler::RunRequests()
+{
+  ActivityRequest request;
+  while(_requests.TryPop(request))
+  {
+    switch(request.kind)
+    {
+    case ActivityRequest::SLEEP:
+      DoSleep(request.component, request.value);
+      break;
+    case ActivityRequest::WAKE:
+      DoWake(request.actor);
+      break;
+    case ActivityRequest::SET_TIER:
+      DoSetTier(request.actor, (UpdateTier)request.value);
+      break;
+    }
+  }
+}
+
+void ComponentScheduler::DoSleep(ActorComponent* component, int wake_after_ms)
+{
+  ActorMap::iterator it = _actors.find(component->_schedule_actor);
+  if(it == _actors.end() || it->second.asleep)
+    return;
+  ActorRecord& record = it->second;
+
+  if(wake_after_ms >= 0)
+    record.wake_time = std::min(record.wake_time, _time + wake_after_ms);
+  if(!component->_wants_sleep)
+  {
+    component->_wants_sleep = true;
+    --record.awake_count;
+  }
+  //the last one asked, so the whole actor goes to sleep
+  if(record.awake_count == 0)
+    FallAsleep(component->_schedule_actor, record);
+}
+
+void ComponentScheduler::FallAsleep(ActorId actor, ActorRecord& record)
+{
+  for(size_t i = 0; i < record.components.size(); ++i)
+    Extract(record.components[i]);
+  record.asleep = true;
+  ++_num_asleep;
+
+  if(record.wake_time != ULONG_MAX)
+  {
+    Sleeper sleeper;
+    sleeper.wake_time = record.wake_time;
+    sleeper.serial = ++_next_sleep_serial;
+    sleeper.actor = actor;
+    record.sleep_serial = sleeper.serial;
+    _sleepers.push_back(sleeper);
+    std::push_heap(_sleepers.begin(), _sleepers.end());
+  }
+}
+
+void ComponentScheduler::DoWake(ActorId actor)
+{
+  ActorMap::iterator it = _actors.find(actor);
+  if(it == _actors.end())
+    return;
+  ActorRecord& record = it->second;
+
+  for(size_t i = 0; i < record.components.size(); ++i)
+  {
+    ActorComponent* component = record.components[i];
+    component->_wants_sleep = false;
+    if(record.asleep)
+    {
+      //the time it slept isnt passed on in its next delta
+      component->_last_update = _time;
+      Insert(component, record.bucket);
+    }
+  }
+  if(record.asleep)
+  {
+    record.asleep = false;
+    --_num_asleep;
+  }
+  record.awake_count = (unsigned int)record.components.size();
+  record.wake_time = ULONG_MAX;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The actor is dealt the tier's next frame.  Its components keep their last
+// update time, so their next delta covers the whole gap whichever tier it
+// was in before.
+//////////////////////////////////////////////////////////////////////////////
+void ComponentScheduler::DoSetTier(ActorId actor, UpdateTier tier)
+{
+  ActorMap::iterator it = _actors.find(actor);
+  if(it == _actors.end() || it->second.tier == tier)
+    return;
+  ActorRecord& record = it->second;
+
+  unsigned int num_slots = 1 << tier;
+  record.tier = tier;
+  record.bucket = num_slots - 1 + (_next_slot[tier]++ & (num_slots - 1));
+  if(record.asleep)
+    return;
+
+  for(size_t i = 0; i < record.components.size(); ++i)
+  {
+    Extract(record.components[i]);
+    Insert(record.components[i], record.bucket);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Entries for actors that were woken early, removed, or have gone back to
+// sleep since are skipped.
+//////////////////////////////////////////////////////////////////////////////
+void ComponentScheduler::WakeSleepers()
+{
+  while(!_sleepers.empty() && _sleepers.front().wake_time <= _time)
+  {
+    Sleeper sleeper = _sleepers.front();
+    std::pop_heap(_sleepers.begin(), _sleepers.end());
+    _sleepers.pop_back();
+
+    ActorMap::iterator it = _actors.find(sleeper.actor);
+    if(it == _actors.end() || !it->second.asleep || it->second.sleep_serial != sleeper.serial)
+      continue;
+    DoWake(sleeper.actor);
+  }
+}
+
+#pragma endregion
+
+#pragma region ActorComponent
+
+void ActorComponent::Sleep(int wake_after_ms)
+{
+  if(_scheduler)
+    _scheduler->Request(ComponentScheduler::ActivityRequest::SLEEP, _schedule_actor, this, wake_after_ms);
+}
+
+void ActorComponent::Wake()
+{
+  if(_scheduler)
+    _scheduler->Request(ComponentScheduler::ActivityRequest::WAKE, _schedule_actor, 0, 0);
+}
+
+#pragma endregion
@@ -0,0 +1,188 @@
+#pragma once
+//========================================================================
+// ComponentScheduler.h : Updates components by type across the job system
+//
+// Instead of each actor updating its own components in turn, every
+// component of a type is kept in one array and the arrays are updated
+// one after another.  Each type describes itself with a ComponentAccess:
+// which phase it runs in and which other types on its actor it reads and
+// writes.  Within a phase, types that dont conflict are put in the same
+// stage, and a stage's arrays are cut into chunks and updated in parallel.
+// Two types conflict when either writes a type the other reads or writes.
+// Of two types that conflict, one that reads what the other writes goes
+// after it.  If they both read what the other writes, or only write the
+// same type, the one whose first component was added first goes first.
+//
+// Actors that have gone to sleep have their components taken out of the
+// arrays, so Update() only costs as much as the actors that are awake.
+// Sleeping and waking move each of the actor's components with one swap.
+// Actors sleeping on a timer wait in a heap ordered by wake time.  Others
+// sleep until an event listener or trigger calls WakeActor(), or until
+// WakeActorsNear() finds them in the AabbTree around a point, such as the
+// player or an explosion.
+//
+// Awake actors can also be put in a slower update tier, so that distant or
+// unimportant ones are updated every 2nd, 4th or 8th frame.  The actors in
+// a tier are dealt out round robin across its frames, so each frame does
+// about the same amount of work, and each type's array is split by tier
+// and frame so a frame only walks the components it updates.  A component
+// is always passed the time since its own last update.
+//
+// An Update() must only touch its own actor unless its type is marked
+// serial, and components must not be added or removed during Update().
+// Sleeps, wakes and tier changes made during Update() are queued and done
+// once the update finishes.  The scheduler doesnt own the components, so a
+// component has to be removed before it is destroyed.
+//========================================================================
+
+#include "ActorComponent.h"
+#include "../Multicore/MpscQueue.h"
+#include "../Scene/Aabb.h"
+
+class JobSystem;
+class AabbTree;
+
+enum UpdateTier
+{
+  UPDATE_EVERY_FRAME,
+  UPDATE_HALF_RATE,
+  UPDATE_QUARTER_RATE,
+  UPDATE_EIGHTH_RATE,
+  NUM_UPDATE_TIERS
+};
+
+//tier n runs on one of 2^n frames, each frame of each tier gets its own bucket
+const unsigned int NUM_UPDATE_BUCKETS = (1 << NUM_UPDATE_TIERS) - 1;
+
+class ComponentScheduler : public SOL_noncopyable
+{
+  struct TypeBatch
+  {
+    ComponentId id;
+    unsigned int order;           //when its first component was added
+    ComponentAccess access;
+    std::vector<ActorComponent*> buckets[NUM_UPDATE_BUCKETS];  //awake components only
+  };
+
+  //a run of one batch's components for a single job.  A serial type gets
+  //one chunk that walks this frame's bucket of every tier in turn.
+  struct Chunk
+  {
+    TypeBatch* batch;
+    bool all_tiers;
+    unsigned int tier;
+    unsigned int begin;
+    unsigned int end;
+  };
+
+  struct ActorRecord
+  {
+    std::vector<ActorComponent*> components;
+    unsigned int awake_count;   //components that havent asked to sleep
+    bool asleep;
+    unsigned long wake_time;    //earliest time a component asked to be woken, ULONG_MAX for never
+    unsigned int sleep_serial;  //matches the heap entry for the current sleep
+    UpdateTier tier;
+    unsigned int bucket;        //the tier's frame it is updated on
+
+    ActorRecord() : awake_count(0), asleep(false), wake_time(ULONG_MAX), sleep_serial(0), tier(UPDATE_EVERY_FRAME), bucket(0) {}
+  };
+
+  struct Sleeper
+  {
+    unsigned long wake_time;
+    unsigned int serial;
+    ActorId actor;
+
+    //the heap keeps the earliest wake time on top
+    bool operator<(const Sleeper& rhs) const { return wake_time > rhs.wake_time; }
+  };
+
+  //a Sleep(), Wake() or tier change made during Update()
+  struct ActivityRequest
+  {
+    enum Kind { SLEEP, WAKE, SET_TIER };
+
+    Kind kind;
+    ActorId actor;
+    ActorComponent* component;  //the component going to sleep
+    int value;                  //how long to sleep for, or the new tier
+  };
+
+  typedef std::map<ComponentId, TypeBatch*> TypeMap;
+  typedef std::vector<TypeBatch*> Stage;
+  typedef std::tr1::unordered_map<ActorId, ActorRecord> ActorMap;
+
+  JobSystem* _jobs;
+  TypeMap _types;
+  std::vector<TypeBatch*> _registered;  //the types in the order they turned up
+  std::vector<Stage> _stages;   //rebuilt when a new type turns up
+  bool _stages_dirty;
+
+  ActorMap _actors;
+  unsigned int _num_asleep;
+  std::vector<Sleeper> _sleepers;
+  unsigned long _time;          //sum of every delta passed to Update()
+  unsigned int _next_sleep_serial;
+  MpscQueue<ActivityRequest> _requests;
+  unsigned int _frame;
+  unsigned int _next_slot[NUM_UPDATE_TIERS];  //where each tier deals its next actor
+
+  //used during Update()
+  std::vector<Chunk> _chunks;
+  unsigned int _frame_buckets[NUM_UPDATE_TIERS];  //the bucket each tier updates this frame
+  bool _updating;
+
+  static ComponentScheduler* _global;
+
+public:
+  //actors add their components to the global scheduler
+  ComponentScheduler(JobSystem* jobs, bool set_as_global);
+  ~ComponentScheduler();
+
+  static ComponentScheduler* Get() { return _global; }
+
+  //adding a component to a sleeping actor wakes it
+  void AddComponent(ActorId actor, ActorComponent* component);
+  void RemoveComponent(ActorComponent* component);
+
+  void Update(int delta);
+
+  //wakes actor and cancels any sleep its components asked for.  Can be called from an
+  //Update() on any thread, for instance by a trigger waking the actors around it.
+  void WakeActor(ActorId actor);
+  //wakes every actor whose box in tree is within radius of center.  Can be called from an Update()
+  //on any thread, as long as nothing moves the tree's boxes meanwhile.
+  void WakeActorsNear(const AabbTree& tree, const glm::vec3& center, float radius);
+  bool IsActorAsleep(ActorId actor) const;
+
+  //actors start out updated every frame.  Can be called from an Update() on any thread.
+  void SetActorUpdateTier(ActorId actor, UpdateTier tier);
+  UpdateTier ActorUpdateTier(ActorId actor) const;
+
+  unsigned int NumStages();
+  unsigned int ComponentCount(ComponentId id) const;    //awake components of the type, in any tier
+  unsigned int NumActors() const { return (unsigned int)_actors.size(); }
+  unsigned int NumAwakeActors() const { return (unsigned int)_actors.size() - _num_asleep; }
+
+private:
+  friend class ActorComponent;
+
+  void BuildStages();
+  static bool Conflicts(const TypeBatch* a, const TypeBatch* b);
+  static bool Reads(const TypeBatch* reader, const TypeBatch* writer);
+  static void SortPhase(std::vector<TypeBatch*>& types);
+  static void UpdateChunks(void* data, unsigned int begin, unsigned int end);
+  void UpdateComponents(std::vector<ActorComponent*>& components, unsigned int begin, unsigned int end);
+
+  void Insert(ActorComponent* component, unsigned int bucket);
+  void Extract(ActorComponent* component);
+
+  void Request(ActivityRequest::Kind kind, ActorId actor, ActorComponent* component, int value);
+  void DoSleep(ActorComponent* component, int wake_after_ms);
+  void FallAsleep(ActorId actor, ActorRecord& record);
+  void DoWake(ActorId actor);
+  void DoSetTier(ActorId actor, UpdateTier tier);
+  void RunRequests();
+  void WakeSleepers();
+};
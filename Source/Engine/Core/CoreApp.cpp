@@ -1,10 +1,25 @@
 #include "EngineStd.h"
 #include "CoreApp.h"
 #include "GLAppWindow.h"
+#include "../Actors/ComponentScheduler.h"
+#include "../EventManager/EventManager.h"
+#include "../MainLoop/ProcessManager.h"
+#include "../Multicore/JobSystem.h"
+#include "../ResourceCache/DevelopmentResourceFile.h"
+#include "../ResourceCache/ResourceStreamer.h"
+#include "../ResourceCache/ZipFile.h"
+#include "../Scene/AabbTree.h"
 #include "../Debugging/Logger.h"
 
 CoreApp* the_app_pointer = 0;
 
+//longest the main loop spends handing streamed resources to the cache each pass
+const double RESOURCE_DELIVERY_BUDGET_MS = 2.0;
+//longest the main loop spends sending queued events each pass
+const double EVENT_BUDGET_MS = 4.0;
+//longest the main loop spends updating processes each pass
+const double PROCESS_BUDGET_MS = 4.0;
+
 CoreApp::CoreApp()
 {
   the_app_pointer = this;
@@ -12,25 +27,106 @@ CoreApp::CoreApp()
   _quit_requested = false;
   _quitting = false;
   _app_window = 0;
+  _resource_cache = 0;
+  _resource_streamer = 0;
+  _event_manager = 0;
+  _process_manager = 0;
+  _job_system = 0;
+  _component_scheduler = 0;
+  _actor_tree = 0;
+  _last_update_time = 0;
 }
 
 bool CoreApp::InitInstance(HINSTANCE hinstance, LPWSTR cmd_line, HWND hwnd, int screen_width, int screen_height)
 {
   _hinstance = hinstance;
 
+  _event_manager = SOL_NEW EventManager("CoreApp Event Mgr", true);
+  _job_system = SOL_NEW JobSystem;
+  _component_scheduler = SOL_NEW ComponentScheduler(_job_system, true);
+  _actor_tree = SOL_NEW AabbTree(0.1f, true);
+  _process_manager = SOL_NEW ProcessManager;
+
+  //the pack is optional, without one the loose files it is built from are used
+  if(GetFileAttributesW(L"Assets.zip") != INVALID_FILE_ATTRIBUTES)
+  {
+    _resource_cache = SOL_NEW ResourceCache(50, SOL_NEW ResourceZipFile(L"Assets.zip"));
+    if(!_resource_cache->Init())
+    {
+      SOL_WARNING("Assets.zip couldnt be opened, loading loose files from Assets instead");
+      delete _resource_cache;
+      _resource_cache = 0;
+    }
+  }
+  else
+  {
+    SOL_INFO("No Assets.zip, loading loose files from Assets");
+  }
+  if(!_resource_cache)
+  {
+    _resource_cache = SOL_NEW ResourceCache(50, SOL_NEW DevelopmentResourceFile(L"Assets"));
+    if(!_resource_cache->Init())
+    {
+      SOL_ERROR("Failed to initialize resource cache!  Are your paths set up correctly?");
+      DestroySystems();
+      return false;
+    }
+  }
+  _resource_streamer = SOL_NEW ResourceStreamer(_resource_cache);
+
   //create GLAppWindow
   _app_window = new GLAppWindow();
   SOL_INFO("GL App Window created");
   _app_window->Create(L"EngineTest", 800, 600);
   _running = true;
+  _last_update_time = GetTickCount();
   return true;
 }
 
+void CoreApp::OnUpdate()
+{
+  DWORD now = GetTickCount();
+  int delta = (int)(now - _last_update_time);
+  _last_update_time = now;
+
+  if(_event_manager)
+    _event_manager->Update(EVENT_BUDGET_MS);
+  if(_resource_streamer)
+    _resource_streamer->DeliverCompleted(RESOURCE_DELIVERY_BUDGET_MS);
+  if(_process_manager)
+    _process_manager->UpdateProcesses(delta, PROCESS_BUDGET_MS);
+  if(_component_scheduler)
+    _component_scheduler->Update(delta);
+}
+
 void CoreApp::OnClose()
 {
   _quit_requested = true;
   _quitting = true;
   delete _app_window;
+  _app_window = 0;
+  DestroySystems();
+}
+
+void CoreApp::DestroySystems()
+{
+  //processes may hold resources or listen for events, so they go before both
+  delete _process_manager;
+  _process_manager = 0;
+  //the streamer's threads use the cache, so it goes first
+  delete _resource_streamer;
+  _resource_streamer = 0;
+  delete _resource_cache;
+  _resource_cache = 0;
+  delete _actor_tree;
+  _actor_tree = 0;
+  //its jobs run on the job system's threads
+  delete _component_scheduler;
+  _component_scheduler = 0;
+  delete _job_system;
+  _job_system = 0;
+  delete _event_manager;
+  _event_manager = 0;
 }
 
 LRESULT CALLBACK CoreApp::MsgProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
@@ -2,6 +2,13 @@
 
 #include <Windows.h>
 class GLAppWindow;
+class ResourceCache;
+class ResourceStreamer;
+class EventManager;
+class ProcessManager;
+class JobSystem;
+class ComponentScheduler;
+class AabbTree;
 
 class CoreApp
 {
@@ -13,15 +20,37 @@ protected:
   bool _quitting;
   
   GLAppWindow* _app_window;
+  DWORD _last_update_time;
+
+  ResourceCache* _resource_cache;
+  ResourceStreamer* _resource_streamer;
+  EventManager* _event_manager;
+  ProcessManager* _process_manager;
+  JobSystem* _job_system;
+  ComponentScheduler* _component_scheduler;
+  AabbTree* _actor_tree;
 
 public:
   CoreApp();
   HINSTANCE GetInstance() { return _hinstance; }
+  ResourceCache* GetResourceCache() { return _resource_cache; }
+  ResourceStreamer* GetResourceStreamer() { return _resource_streamer; }
+  EventManager* GetEventManager() { return _event_manager; }
+  ProcessManager* GetProcessManager() { return _process_manager; }
+  JobSystem* GetJobSystem() { return _job_system; }
+  ComponentScheduler* GetComponentScheduler() { return _component_scheduler; }
+  AabbTree* GetActorTree() { return _actor_tree; }
   virtual bool InitInstance(HINSTANCE hinstance, LPWSTR cmd_line, HWND hwnd = NULL, int screen_width = SCREEN_WIDTH, int screen_height = SCREEN_HEIGHT);
 
   static LRESULT CALLBACK MsgProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
 
+  //called once per pass of the main loop when there are no messages
+  virtual void OnUpdate();
   virtual void OnClose();
+
+protected:
+  //deletes whatever InitInstance() made, in the order they depend on each other
+  void DestroySystems();
 };
 
 extern CoreApp* the_app_pointer;
\ No newline at end of file
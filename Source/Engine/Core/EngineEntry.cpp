@@ -38,6 +38,7 @@ INT WINAPI EngineEntry(HINSTANCE hInstance,
     }
     else
     {
+      the_app_pointer->OnUpdate();
     }
   }while(msg.message != WM_QUIT);
   //shutdown
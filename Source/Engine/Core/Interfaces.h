@@ -39,9 +39,14 @@
 
 class Actor;
 class ActorComponent;
+class Resource;
+class ResHandle;
+class WildcardPattern;
+struct DrawCommand;
 
 typedef unsigned int ActorId;
 typedef unsigned int ComponentId;
+typedef unsigned long long RenderKey;
 
 const ActorId INVALID_ACTOR_ID = 0;
 const ComponentId INVALID_COMPONENT_ID = 0;
@@ -58,4 +63,75 @@ struct SortBy_SharedPtr_Content
   {
     return *lhs < *rhs; 
   }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// IResourceFile - a file that packs many resources together, like a zip
+//////////////////////////////////////////////////////////////////////////////
+class IResourceFile
+{
+public:
+  virtual bool Open() = 0;
+
+  //returns -1 if the resource isnt in the file, 0 is an empty resource
+  virtual int RawResourceSize(const Resource& r) = 0;
+  //copies the resource into buffer, which must hold RawResourceSize() bytes.  returns the bytes written or -1 on error
+  virtual int RawResource(const Resource& r, char* buffer) = 0;
+  //returns the resource's bytes in place with no copy, or NULL if it is compressed and has to go through RawResource()
+  virtual const char* MappedResource(const Resource& r, int& out_size) = 0;
+  //brings the resource's stored bytes into memory without decoding them, returns false if it isnt in the file
+  virtual bool PrefetchResource(const Resource& r) = 0;
+
+  virtual int NumResources() const = 0;
+  virtual std::string ResourceName(int num) const = 0;
+  //appends the number of every resource whose name matches pattern to out_nums, returns how many were added
+  virtual int MatchResources(const WildcardPattern& pattern, std::vector<int>& out_nums) const = 0;
+
+  virtual ~IResourceFile() {}
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// IResourceLoader - turns the raw bytes of a resource into something usable.
+// The ResourceCache picks the first registered loader whose pattern matches
+// the resource name.
+//////////////////////////////////////////////////////////////////////////////
+class IResourceLoader
+{
+public:
+  virtual ~IResourceLoader() {}
+
+  //wildcard pattern of the resource names this loader handles, e.g. "*.xml"
+  virtual std::string Pattern() = 0;
+  //true if the raw bytes are the loaded resource and there is nothing to do
+  virtual bool UseRawFile() = 0;
+  //true if the raw bytes can be freed once LoadResource() has finished with them, otherwise the loader owns them
+  virtual bool DiscardRawBufferAfterLoad() = 0;
+  //true if the loaded buffer needs a '\0' after the data, like text for a parser
+  virtual bool AddNullZero() { return false; }
+  //raw_buffer can point straight into a mapped resource file, so it must be treated as read only
+  virtual unsigned int LoadedResourceSize(char* raw_buffer, unsigned int raw_size) = 0;
+  virtual bool LoadResource(char* raw_buffer, unsigned int raw_size, shared_ptr<ResHandle> handle) = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// IResourceExtraData - anything a loader wants to keep with a resource
+//////////////////////////////////////////////////////////////////////////////
+class IResourceExtraData
+{
+public:
+  virtual ~IResourceExtraData() {}
+  virtual std::string ToString() = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// IRenderBackend - takes a frame's sorted draw commands and draws them.  The
+// RenderQueue hands over the whole frame in one call, in key order, so the
+// backend only has to look at what changed from one command to the next.
+//////////////////////////////////////////////////////////////////////////////
+class IRenderBackend
+{
+public:
+  virtual ~IRenderBackend() {}
+
+  virtual void Submit(const RenderKey* keys, const DrawCommand* commands, unsigned int count) = 0;
 };
\ No newline at end of file
@@ -20,9 +20,12 @@
 #include <algorithm>
 #include <string>
 #include <list>
+#include <deque>
 #include <vector>
 #include <queue>
 #include <map>
+#include <set>
+#include <unordered_map>
 
 #include "TinyXML/tinyxml2.h"
 
@@ -0,0 +1,192 @@
+#include "EngineStd.h"
+#include "EventManager.h"
+#include "../Debugging/Logger.h"
+
+EventManager* EventManager::_global = 0;
+
+EventManager::EventManager(const char* name, bool set_as_global)
+  : _name(name)
+{
+  _active_queue = 0;
+  _dispatch_depth = 0;
+  _needs_compaction = false;
+
+  if(set_as_global)
+  {
+    if(_global)
+    {
+      SOL_ERROR("Attempting to create two global event managers! The old one will be destroyed and overwritten with this one.");
+      delete _global;
+    }
+    _global = this;
+  }
+}
+
+EventManager::~EventManager()
+{
+  if(_global == this)
+    _global = 0;
+}
+
+bool EventManager::AddListener(const EventListenerDelegate& listener, const EventType& type)
+{
+  EventListenerList& listeners = _listeners[type];
+  for(EventListenerList::iterator it = listeners.begin(); it != listeners.end(); ++it)
+  {
+    if(*it == listener)
+    {
+      SOL_WARNING("Attempting to double-register a delegate");
+      return false;
+    }
+  }
+  listeners.push_back(listener);
+  return true;
+}
+
+bool EventManager::RemoveListener(const EventListenerDelegate& listener, const EventType& type)
+{
+  EventListenerMap::iterator found = _listeners.find(type);
+  if(found == _listeners.end())
+    return false;
+
+  EventListenerList& listeners = found->second;
+  for(EventListenerList::iterator it = listeners.begin(); it != listeners.end(); ++it)
+  {
+    if(*it == listener)
+    {
+      //the list might be being walked by Dispatch(), so leave a hole to fill in later
+      if(_dispatch_depth > 0)
+      {
+        *it = EventListenerDelegate();
+        _needs_compaction = true;
+      }
+      else
+      {
+        listeners.erase(it);
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+bool EventManager::TriggerEvent(const IEventDataPtr& event)
+{
+  EventListenerMap::iterator found = _listeners.find(event->Type());
+  if(found == _listeners.end() || found->second.empty())
+    return false;
+  Dispatch(event, found->second);
+  return true;
+}
+
+bool EventManager::QueueEvent(const IEventDataPtr& event)
+{
+  SOL_ASSERT(_active_queue >= 0 && _active_queue < NUM_QUEUES);
+
+  EventListenerMap::iterator found = _listeners.find(event->Type());
+  if(found == _listeners.end() || found->second.empty())
+    return false;
+  _queues[_active_queue].push_back(event);
+  return true;
+}
+
+void EventManager::ThreadSafeQueueEvent(const IEventDataPtr& event)
+{
+  _realtime_queue.Push(event);
+}
+
+bool EventManager::AbortEvent(const EventType& type, bool all_of_type)
+{
+  SOL_ASSERT(_active_queue >= 0 && _active_queue < NUM_QUEUES);
+
+  bool success = false;
+  EventQueue& queue = _queues[_active_queue];
+  EventQueue::iterator it = queue.begin();
+  while(it != queue.end())
+  {
+    if((*it)->Type() == type)
+    {
+      it = queue.erase(it);
+      success = true;
+      if(!all_of_type)
+        break;
+    }
+    else
+    {
+      ++it;
+    }
+  }
+  return success;
+}
+
+bool EventManager::Update(double budget_ms)
+{
+  LARGE_INTEGER frequency, start, now;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&start);
+  double budget_ticks = budget_ms * frequency.QuadPart / 1000.0;
+
+  //events from other threads join this frame's queue
+  IEventDataPtr event;
+  while(_realtime_queue.TryPop(event))
+    _queues[_active_queue].push_back(event);
+
+  //swap queues, anything queued from here on waits for the next update
+  int queue_to_process = _active_queue;
+  _active_queue = (_active_queue + 1) % NUM_QUEUES;
+  _queues[_active_queue].clear();
+
+  EventQueue& queue = _queues[queue_to_process];
+  while(!queue.empty())
+  {
+    event = queue.front();
+    queue.pop_front();
+
+    EventListenerMap::iterator found = _listeners.find(event->Type());
+    if(found != _listeners.end())
+      Dispatch(event, found->second);
+
+    QueryPerformanceCounter(&now);
+    if(now.QuadPart - start.QuadPart >= budget_ticks)
+      break;
+  }
+
+  //whatever didnt fit goes ahead of the events queued since
+  bool flushed = queue.empty();
+  if(!flushed)
+  {
+    EventQueue& next = _queues[_active_queue];
+    next.insert(next.begin(), queue.begin(), queue.end());
+    queue.clear();
+  }
+  return flushed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Listeners added while the event is being sent dont get it.  Ones removed
+// are skipped.
+//////////////////////////////////////////////////////////////////////////////
+void EventManager::Dispatch(const IEventDataPtr& event, EventListenerList& listeners)
+{
+  ++_dispatch_depth;
+  size_t count = listeners.size();
+  for(size_t i = 0; i < count; ++i)
+  {
+    //copied, a listener can add to the list and move it
+    EventListenerDelegate listener = listeners[i];
+    if(!listener.Empty())
+      listener(event);
+  }
+  if(--_dispatch_depth == 0 && _needs_compaction)
+    Compact();
+}
+
+void EventManager::Compact()
+{
+  for(EventListenerMap::iterator it = _listeners.begin(); it != _listeners.end(); ++it)
+  {
+    EventListenerList& listeners = it->second;
+    listeners.erase(std::remove(listeners.begin(), listeners.end(), EventListenerDelegate()), listeners.end());
+  }
+  _needs_compaction = false;
+}
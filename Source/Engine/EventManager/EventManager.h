@@ -0,0 +1,101 @@
+#pragma once
+//========================================================================
+// EventManager.h : Sends events to the listeners registered for them
+//
+// Every event class has its own EventType.  Listeners are delegates, so
+// registering one doesnt allocate and sending an event is a call per
+// listener.  TriggerEvent() calls the listeners straight away.
+// QueueEvent() holds the event until the next Update(), which works
+// through the queue until its time budget runs out.  There are two
+// queues: events queued while Update() is running go in the other one
+// and wait for the next frame, so a listener that queues events cant keep
+// Update() going forever.
+//
+// The manager belongs to the main thread.  Other threads, like the
+// resource streamer or a job, post with ThreadSafeQueueEvent(), which goes
+// through a lock free queue that Update() empties first.
+//========================================================================
+
+#include <float.h>
+#include "../Utility/Delegate.h"
+#include "../Multicore/MpscQueue.h"
+
+typedef unsigned long EventType;
+
+class IEventData;
+typedef shared_ptr<IEventData> IEventDataPtr;
+typedef Delegate<const IEventDataPtr&> EventListenerDelegate;
+
+//////////////////////////////////////////////////////////////////////////////
+// IEventData - base for every event.  Each event class defines its own
+// static const EventType and returns it from Type().
+//////////////////////////////////////////////////////////////////////////////
+class IEventData
+{
+public:
+  virtual ~IEventData() {}
+  virtual const EventType& Type() const = 0;
+  virtual float TimeStamp() const = 0;
+  virtual IEventDataPtr Copy() const = 0;
+  virtual const char* Name() const = 0;
+};
+
+class BaseEventData : public IEventData
+{
+  const float _time_stamp;
+
+public:
+  explicit BaseEventData(const float time_stamp = 0.0f) : _time_stamp(time_stamp) {}
+
+  virtual float TimeStamp() const { return _time_stamp; }
+};
+
+class EventManager : public SOL_noncopyable
+{
+  enum { NUM_QUEUES = 2 };
+
+  typedef std::vector<EventListenerDelegate> EventListenerList;
+  typedef std::tr1::unordered_map<EventType, EventListenerList> EventListenerMap;
+  typedef std::deque<IEventDataPtr> EventQueue;
+
+  EventListenerMap _listeners;
+  EventQueue _queues[NUM_QUEUES];
+  int _active_queue;  //the queue QueueEvent() adds to
+  MpscQueue<IEventDataPtr> _realtime_queue;
+
+  //listeners removed while an event is being sent are cleared and compacted away afterwards
+  int _dispatch_depth;
+  bool _needs_compaction;
+
+  std::string _name;
+  static EventManager* _global;
+
+public:
+  explicit EventManager(const char* name, bool set_as_global);
+  ~EventManager();
+
+  static EventManager* Get() { return _global; }
+
+  //returns false if the delegate is already listening for type
+  bool AddListener(const EventListenerDelegate& listener, const EventType& type);
+  //returns false if the delegate wasnt listening for type
+  bool RemoveListener(const EventListenerDelegate& listener, const EventType& type);
+
+  //sends the event now, bypassing the queue.  Returns true if anyone was listening.
+  bool TriggerEvent(const IEventDataPtr& event);
+  //sends the event on the next Update().  Returns false if no one is listening for it.
+  bool QueueEvent(const IEventDataPtr& event);
+  //QueueEvent() for any thread, the listeners are checked when the event is sent
+  void ThreadSafeQueueEvent(const IEventDataPtr& event);
+
+  //removes the first queued event of type, or all of them.  Returns true if any were removed.
+  bool AbortEvent(const EventType& type, bool all_of_type = false);
+
+  //sends queued events until budget_ms has passed.  Returns true if the queue was emptied,
+  //anything left over goes first next time.
+  bool Update(double budget_ms = DBL_MAX);
+
+private:
+  void Dispatch(const IEventDataPtr& event, EventListenerList& listeners);
+  void Compact();
+};
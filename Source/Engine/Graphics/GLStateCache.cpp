@@ -0,0 +1,245 @@
+#include "EngineStd.h"
+#include "GLStateCache.h"
+#include "../Debugging/Logger.h"
+
+//no GL name or enum has this value, so it never matches what is asked for
+const GLuint UNKNOWN = 0xffffffff;
+
+GLFunctions GLFunctions::FromGlew()
+{
+  GLFunctions gl;
+  gl.use_program = glUseProgram;
+  gl.bind_vertex_array = glBindVertexArray;
+  gl.bind_buffer = glBindBuffer;
+  gl.active_texture = glActiveTexture;
+  gl.bind_texture = glBindTexture;
+  gl.enable = glEnable;
+  gl.disable = glDisable;
+  gl.blend_func = glBlendFunc;
+  gl.blend_equation = glBlendEquation;
+  gl.depth_func = glDepthFunc;
+  gl.depth_mask = glDepthMask;
+  return gl;
+}
+
+GLStateCache::GLStateCache(const GLFunctions& gl)
+{
+  _gl = gl;
+  Invalidate();
+  ResetStats();
+}
+
+void GLStateCache::Invalidate()
+{
+  _program = UNKNOWN;
+  _vertex_array = UNKNOWN;
+  for(int i = 0; i < NUM_BUFFER_TARGETS; ++i)
+    _buffers[i] = UNKNOWN;
+  _active_unit = UNKNOWN;
+  for(int unit = 0; unit < MAX_TEXTURE_UNITS; ++unit)
+  {
+    for(int i = 0; i < NUM_TEXTURE_TARGETS; ++i)
+      _textures[unit][i] = UNKNOWN;
+  }
+  _blend = UNKNOWN;
+  _blend_source = UNKNOWN;
+  _blend_destination = UNKNOWN;
+  _blend_equation = UNKNOWN;
+  _depth_test = UNKNOWN;
+  _depth_func = UNKNOWN;
+  _depth_mask = UNKNOWN;
+}
+
+void GLStateCache::ResetStats()
+{
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+int GLStateCache::BufferIndex(GLenum target)
+{
+  switch(target)
+  {
+  case GL_ARRAY_BUFFER: return BUFFER_ARRAY;
+  case GL_ELEMENT_ARRAY_BUFFER: return BUFFER_ELEMENT_ARRAY;
+  case GL_UNIFORM_BUFFER: return BUFFER_UNIFORM;
+  case GL_PIXEL_UNPACK_BUFFER: return BUFFER_PIXEL_UNPACK;
+  case GL_COPY_READ_BUFFER: return BUFFER_COPY_READ;
+  case GL_COPY_WRITE_BUFFER: return BUFFER_COPY_WRITE;
+  }
+  return -1;
+}
+
+int GLStateCache::TextureIndex(GLenum target)
+{
+  switch(target)
+  {
+  case GL_TEXTURE_2D: return TEXTURE_2D;
+  case GL_TEXTURE_3D: return TEXTURE_3D;
+  case GL_TEXTURE_CUBE_MAP: return TEXTURE_CUBE_MAP;
+  case GL_TEXTURE_2D_ARRAY: return TEXTURE_2D_ARRAY;
+  }
+  return -1;
+}
+
+#pragma region Bindings
+
+void GLStateCache::UseProgram(GLuint program)
+{
+  ++_stats.requested;
+  if(program == _program)
+    return;
+  _gl.use_program(program);
+  ++_stats.issued;
+  _program = program;
+}
+
+void GLStateCache::BindVertexArray(GLuint vertex_array)
+{
+  ++_stats.requested;
+  if(vertex_array == _vertex_array)
+    return;
+  _gl.bind_vertex_array(vertex_array);
+  ++_stats.issued;
+  _vertex_array = vertex_array;
+  _buffers[BUFFER_ELEMENT_ARRAY] = UNKNOWN;
+}
+
+void GLStateCache::BindBuffer(GLenum target, GLuint buffer)
+{
+  ++_stats.requested;
+  int index = BufferIndex(target);
+  if(index >= 0)
+  {
+    if(buffer == _buffers[index])
+      return;
+    _buffers[index] = buffer;
+  }
+  _gl.bind_buffer(target, buffer);
+  ++_stats.issued;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Without the cache this is always two calls, picking the unit and then
+// binding to it.  The unit is only changed when the texture has to be
+// bound, so runs of draws sharing textures dont touch the unit at all.
+//////////////////////////////////////////////////////////////////////////////
+void GLStateCache::BindTexture(unsigned int unit, GLenum target, GLuint texture)
+{
+  SOL_ASSERT(unit < MAX_TEXTURE_UNITS);
+  _stats.requested += 2;
+  int index = TextureIndex(target);
+  if(index >= 0 && unit < MAX_TEXTURE_UNITS)
+  {
+    if(texture == _textures[unit][index])
+      return;
+    _textures[unit][index] = texture;
+  }
+  if(unit != _active_unit)
+  {
+    _gl.active_texture(GL_TEXTURE0 + unit);
+    ++_stats.issued;
+    _active_unit = unit;
+  }
+  _gl.bind_texture(target, texture);
+  ++_stats.issued;
+}
+
+void GLStateCache::OnDeleteVertexArray(GLuint vertex_array)
+{
+  if(vertex_array == _vertex_array)
+  {
+    _vertex_array = 0;
+    _buffers[BUFFER_ELEMENT_ARRAY] = UNKNOWN;
+  }
+}
+
+void GLStateCache::OnDeleteBuffer(GLuint buffer)
+{
+  for(int i = 0; i < NUM_BUFFER_TARGETS; ++i)
+  {
+    if(_buffers[i] == buffer)
+      _buffers[i] = 0;
+  }
+}
+
+void GLStateCache::OnDeleteTexture(GLuint texture)
+{
+  for(int unit = 0; unit < MAX_TEXTURE_UNITS; ++unit)
+  {
+    for(int i = 0; i < NUM_TEXTURE_TARGETS; ++i)
+    {
+      if(_textures[unit][i] == texture)
+        _textures[unit][i] = 0;
+    }
+  }
+}
+
+#pragma endregion
+
+#pragma region Blend and Depth
+
+void GLStateCache::SetCap(GLenum cap, bool enabled, GLuint& current)
+{
+  ++_stats.requested;
+  if(current == (GLuint)enabled)
+    return;
+  if(enabled)
+    _gl.enable(cap);
+  else
+    _gl.disable(cap);
+  ++_stats.issued;
+  current = enabled;
+}
+
+void GLStateCache::SetBlend(bool enabled)
+{
+  SetCap(GL_BLEND, enabled, _blend);
+}
+
+void GLStateCache::BlendFunc(GLenum source, GLenum destination)
+{
+  ++_stats.requested;
+  if(source == _blend_source && destination == _blend_destination)
+    return;
+  _gl.blend_func(source, destination);
+  ++_stats.issued;
+  _blend_source = source;
+  _blend_destination = destination;
+}
+
+void GLStateCache::BlendEquation(GLenum mode)
+{
+  ++_stats.requested;
+  if(mode == _blend_equation)
+    return;
+  _gl.blend_equation(mode);
+  ++_stats.issued;
+  _blend_equation = mode;
+}
+
+void GLStateCache::SetDepthTest(bool enabled)
+{
+  SetCap(GL_DEPTH_TEST, enabled, _depth_test);
+}
+
+void GLStateCache::DepthFunc(GLenum func)
+{
+  ++_stats.requested;
+  if(func == _depth_func)
+    return;
+  _gl.depth_func(func);
+  ++_stats.issued;
+  _depth_func = func;
+}
+
+void GLStateCache::DepthMask(bool write)
+{
+  ++_stats.requested;
+  if(_depth_mask == (GLuint)write)
+    return;
+  _gl.depth_mask(write ? GL_TRUE : GL_FALSE);
+  ++_stats.issued;
+  _depth_mask = write;
+}
+
+#pragma endregion
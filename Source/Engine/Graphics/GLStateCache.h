@@ -0,0 +1,125 @@
+#pragma once
+//========================================================================
+// GLStateCache.h : Skips GL calls that wouldnt change anything
+//
+// The renderer sets state through the cache instead of calling GL itself.
+// The cache keeps a copy of what is bound, the program, vertex array,
+// buffers, the texture on each unit, and the blend and depth state, and
+// only calls GL when the value is different.  Sorting the draws by key
+// already keeps neighbouring draws alike, so most of what the renderer
+// asks for turns out to be bound already.
+//
+// GL is called through a GLFunctions table rather than the glew names, so
+// a test can hand the cache its own functions and count what gets through.
+// Stats() counts the calls asked for and the ones actually made, which
+// gives the calls saved on a frame.
+//
+// Anything that changes GL state without going through the cache has to
+// be followed by Invalidate(), after which the next call of each kind is
+// always made.  The element array buffer belongs to the vertex array, so
+// it is forgotten whenever the vertex array changes.
+//========================================================================
+
+#include "3rdParty/glew-1.9.0/include/GL/glew.h"
+
+//the GL entry points the cache calls
+struct GLFunctions
+{
+  void (GLAPIENTRY* use_program)(GLuint program);
+  void (GLAPIENTRY* bind_vertex_array)(GLuint array);
+  void (GLAPIENTRY* bind_buffer)(GLenum target, GLuint buffer);
+  void (GLAPIENTRY* active_texture)(GLenum texture);
+  void (GLAPIENTRY* bind_texture)(GLenum target, GLuint texture);
+  void (GLAPIENTRY* enable)(GLenum cap);
+  void (GLAPIENTRY* disable)(GLenum cap);
+  void (GLAPIENTRY* blend_func)(GLenum source, GLenum destination);
+  void (GLAPIENTRY* blend_equation)(GLenum mode);
+  void (GLAPIENTRY* depth_func)(GLenum func);
+  void (GLAPIENTRY* depth_mask)(GLboolean flag);
+
+  //glew's, once glewInit() has been called
+  static GLFunctions FromGlew();
+};
+
+struct GLStateStats
+{
+  unsigned int requested;   //calls GL would have had without the cache
+  unsigned int issued;      //calls that were actually made
+};
+
+class GLStateCache : public SOL_noncopyable
+{
+public:
+  enum { MAX_TEXTURE_UNITS = 16 };
+
+private:
+  enum BufferTarget
+  {
+    BUFFER_ARRAY,
+    BUFFER_ELEMENT_ARRAY,
+    BUFFER_UNIFORM,
+    BUFFER_PIXEL_UNPACK,
+    BUFFER_COPY_READ,
+    BUFFER_COPY_WRITE,
+    NUM_BUFFER_TARGETS
+  };
+
+  enum TextureTarget
+  {
+    TEXTURE_2D,
+    TEXTURE_3D,
+    TEXTURE_CUBE_MAP,
+    TEXTURE_2D_ARRAY,
+    NUM_TEXTURE_TARGETS
+  };
+
+  GLFunctions _gl;
+  GLStateStats _stats;
+
+  //UNKNOWN where the cache doesnt know what GL has
+  GLuint _program;
+  GLuint _vertex_array;
+  GLuint _buffers[NUM_BUFFER_TARGETS];
+  GLuint _active_unit;
+  GLuint _textures[MAX_TEXTURE_UNITS][NUM_TEXTURE_TARGETS];
+  GLuint _blend;
+  GLenum _blend_source;
+  GLenum _blend_destination;
+  GLenum _blend_equation;
+  GLuint _depth_test;
+  GLenum _depth_func;
+  GLuint _depth_mask;
+
+public:
+  explicit GLStateCache(const GLFunctions& gl);
+
+  //forgets everything, for after something else has changed GL state
+  void Invalidate();
+
+  void UseProgram(GLuint program);
+  void BindVertexArray(GLuint vertex_array);
+  //targets the cache doesnt track are always passed on
+  void BindBuffer(GLenum target, GLuint buffer);
+  //unit counts from 0, not GL_TEXTURE0
+  void BindTexture(unsigned int unit, GLenum target, GLuint texture);
+
+  void SetBlend(bool enabled);
+  void BlendFunc(GLenum source, GLenum destination);
+  void BlendEquation(GLenum mode);
+  void SetDepthTest(bool enabled);
+  void DepthFunc(GLenum func);
+  void DepthMask(bool write);
+
+  //GL unbinds objects when they are deleted, so the cache has to be told
+  void OnDeleteVertexArray(GLuint vertex_array);
+  void OnDeleteBuffer(GLuint buffer);
+  void OnDeleteTexture(GLuint texture);
+
+  const GLStateStats& Stats() const { return _stats; }
+  void ResetStats();
+
+private:
+  static int BufferIndex(GLenum target);
+  static int TextureIndex(GLenum target);
+  void SetCap(GLenum cap, bool enabled, GLuint& current);
+};
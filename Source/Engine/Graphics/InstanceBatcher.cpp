@@ -0,0 +1,81 @@
+#include "EngineStd.h"
+#include "InstanceBatcher.h"
+#include "RenderQueue.h"
+#include "../Scene/TransformHierarchy.h"
+#include "../Multicore/JobSystem.h"
+
+//instances per job.  Fewer than this are packed on the calling thread.
+const unsigned int INSTANCES_PER_JOB = 8192;
+
+InstanceBatcher::InstanceBatcher(JobSystem* jobs)
+{
+  _jobs = jobs;
+  _destination = 0;
+  _num_instances = 0;
+  _commands = 0;
+  _transforms = 0;
+}
+
+void InstanceBatcher::Build(const RenderQueue& queue, const TransformHierarchy& transforms, InstanceData* destination)
+{
+  Build(queue.Keys(), queue.Commands(), queue.Count(), transforms, destination);
+}
+
+void InstanceBatcher::Build(const RenderKey* keys, const DrawCommand* commands, unsigned int count, const TransformHierarchy& transforms, InstanceData* destination)
+{
+  _draws.clear();
+  _num_instances = count;
+  if(!destination)
+  {
+    if(_instances.size() < count)
+      _instances.resize(count);
+    destination = _instances.empty() ? 0 : &_instances[0];
+  }
+  _destination = destination;
+  if(count == 0)
+    return;
+
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    const DrawCommand& command = commands[i];
+    if(!_draws.empty())
+    {
+      InstancedDraw& last = _draws.back();
+      //a draw in another layer or pass has to stay where it is, even with the same mesh
+      if(command.mesh == last.mesh && command.shader == last.shader && command.material == last.material &&
+         RenderKeyLayer(keys[i]) == RenderKeyLayer(last.key) && RenderKeyPass(keys[i]) == RenderKeyPass(last.key))
+      {
+        ++last.num_instances;
+        continue;
+      }
+    }
+
+    InstancedDraw draw;
+    draw.key = keys[i];
+    draw.mesh = command.mesh;
+    draw.shader = command.shader;
+    draw.material = command.material;
+    draw.first_instance = i;
+    draw.num_instances = 1;
+    _draws.push_back(draw);
+  }
+
+  _commands = commands;
+  _transforms = &transforms;
+  if(_jobs)
+    _jobs->ParallelFor(PackRange, this, count, INSTANCES_PER_JOB);
+  else
+    PackRange(this, 0, count);
+}
+
+void InstanceBatcher::PackRange(void* data, unsigned int begin, unsigned int end)
+{
+  InstanceBatcher* batcher = (InstanceBatcher*)data;
+  const DrawCommand* commands = batcher->_commands;
+  InstanceData* instances = batcher->_destination;
+  for(unsigned int i = begin; i < end; ++i)
+  {
+    instances[i].world = batcher->_transforms->World(commands[i].transform);
+    instances[i].colour = commands[i].colour;
+  }
+}
@@ -0,0 +1,70 @@
+#pragma once
+//========================================================================
+// InstanceBatcher.h : Turns runs of alike draw commands into instanced draws
+//
+// Takes the sorted commands and merges each run of neighbours that share a
+// layer, pass, mesh, shader and material into one draw of several
+// instances.  Every command's world matrix and colour is written into one
+// array in the same order, so each draw's instances are a contiguous range
+// of it and the whole array can be uploaded to GL in one go each frame.
+// It can be written straight into a mapped buffer to skip a copy.
+//
+// Only neighbours are merged, the order of the commands is never changed,
+// so keys that want their copies batched should keep them together, which
+// is what MakeInstancedRenderKey() is for.  Finding the runs is a single
+// pass comparing neighbours, filling in the instances is split across the
+// job system.
+//========================================================================
+
+#include "RenderCommand.h"
+
+class JobSystem;
+class RenderQueue;
+class TransformHierarchy;
+
+//what each instance gets, laid out for a per instance vertex buffer
+struct InstanceData
+{
+  glm::mat4 world;
+  glm::vec4 colour;
+};
+
+struct InstancedDraw
+{
+  RenderKey key;                //the first command's
+  unsigned int mesh;
+  unsigned int shader;
+  unsigned int material;
+  unsigned int first_instance;
+  unsigned int num_instances;
+};
+
+class InstanceBatcher : public SOL_noncopyable
+{
+  JobSystem* _jobs;
+  std::vector<InstancedDraw> _draws;
+  std::vector<InstanceData> _instances;     //only grows, so batching doesnt allocate
+  InstanceData* _destination;
+  unsigned int _num_instances;
+
+  //the Build() in progress
+  const DrawCommand* _commands;
+  const TransformHierarchy* _transforms;
+
+public:
+  explicit InstanceBatcher(JobSystem* jobs = 0);
+
+  //destination has to hold count instances.  If it is NULL they are kept in the batcher.
+  void Build(const RenderKey* keys, const DrawCommand* commands, unsigned int count, const TransformHierarchy& transforms, InstanceData* destination = 0);
+  void Build(const RenderQueue& queue, const TransformHierarchy& transforms, InstanceData* destination = 0);
+
+  unsigned int NumDraws() const { return (unsigned int)_draws.size(); }
+  const InstancedDraw* Draws() const { return _draws.empty() ? 0 : &_draws[0]; }
+  //the destination passed to Build(), or the batcher's own
+  unsigned int NumInstances() const { return _num_instances; }
+  const InstanceData* Instances() const { return _destination; }
+  unsigned int InstanceBytes() const { return _num_instances * sizeof(InstanceData); }
+
+private:
+  static void PackRange(void* data, unsigned int begin, unsigned int end);
+};
@@ -0,0 +1,38 @@
+#include "EngineStd.h"
+#include "NullRenderBackend.h"
+
+NullRenderBackend::NullRenderBackend(bool recording)
+{
+  _recording = recording;
+  Reset();
+}
+
+void NullRenderBackend::Reset()
+{
+  memset(&_stats, 0, sizeof(_stats));
+  _keys.clear();
+  _commands.clear();
+}
+
+//each submit starts from nothing bound, the same as a real backend at the start of a frame
+void NullRenderBackend::Submit(const RenderKey* keys, const DrawCommand* commands, unsigned int count)
+{
+  ++_stats.submits;
+  _stats.draws += count;
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    const DrawCommand& command = commands[i];
+    if(i == 0 || command.shader != commands[i - 1].shader)
+      ++_stats.shader_changes;
+    if(i == 0 || command.material != commands[i - 1].material)
+      ++_stats.material_changes;
+    if(i == 0 || command.mesh != commands[i - 1].mesh)
+      ++_stats.mesh_changes;
+  }
+
+  if(_recording && count > 0)
+  {
+    _keys.insert(_keys.end(), keys, keys + count);
+    _commands.insert(_commands.end(), commands, commands + count);
+  }
+}
@@ -0,0 +1,42 @@
+#pragma once
+//========================================================================
+// NullRenderBackend.h : A backend that draws nothing
+//
+// Counts what a real backend would have had to do, the draws and how
+// often the shader, material and mesh change between them, so sorting and
+// submission can be timed and compared without a GL context.  With
+// recording on it also keeps a copy of every command it is given, to
+// check the order they arrived in.
+//========================================================================
+
+#include "RenderCommand.h"
+
+struct RenderBackendStats
+{
+  unsigned int submits;
+  unsigned int draws;
+  unsigned int shader_changes;
+  unsigned int material_changes;
+  unsigned int mesh_changes;
+};
+
+class NullRenderBackend : public IRenderBackend, public SOL_noncopyable
+{
+  RenderBackendStats _stats;
+  bool _recording;
+  std::vector<RenderKey> _keys;
+  std::vector<DrawCommand> _commands;
+
+public:
+  explicit NullRenderBackend(bool recording = false);
+
+  virtual void Submit(const RenderKey* keys, const DrawCommand* commands, unsigned int count);
+
+  //zeroes the stats and forgets what was recorded
+  void Reset();
+
+  const RenderBackendStats& Stats() const { return _stats; }
+  unsigned int NumRecorded() const { return (unsigned int)_commands.size(); }
+  RenderKey RecordedKey(unsigned int index) const { return _keys[index]; }
+  const DrawCommand& RecordedCommand(unsigned int index) const { return _commands[index]; }
+};
@@ -0,0 +1,93 @@
+#pragma once
+//========================================================================
+// RenderCommand.h : A draw command and the 64 bit key it is sorted by
+//
+// The key packs everything the order of a frame's draws depends on, most
+// significant first, so sorting the keys as plain integers gives the draw
+// order.  From the top it is
+//
+//    layer 8 bits | pass 8 bits | shader 12 bits | material 12 bits | depth 24 bits
+//
+// which draws by layer (world, then effects, then HUD) and pass, then
+// groups by shader and material so the state changes as little as it can,
+// and draws front to back within a material.  Translucent passes need to
+// draw back to front over everything, so MakeDepthFirstRenderKey() moves
+// the depth up above the shader and material and flips it.
+//
+// Depth is 0 at the near plane and 1 at the far plane, it is clamped and
+// kept to 24 bits.
+//
+// Draws that are meant to be instanced, like foliage and crowds, gain
+// nothing from front to back order and lose their batching to it, since
+// copies of different meshes interleave by depth.  MakeInstancedRenderKey()
+// puts the mesh where the depth goes so each mesh's copies sort together.
+//========================================================================
+
+#include "3rdParty/glm-0.9.3.4/glm/glm.hpp"
+
+struct DrawCommand
+{
+  unsigned int mesh;
+  unsigned int shader;
+  unsigned int material;
+  unsigned int transform;     //its TransformId in the TransformHierarchy
+  glm::vec4 colour;
+};
+
+const unsigned int RENDER_KEY_LAYER_BITS = 8;
+const unsigned int RENDER_KEY_PASS_BITS = 8;
+const unsigned int RENDER_KEY_SHADER_BITS = 12;
+const unsigned int RENDER_KEY_MATERIAL_BITS = 12;
+const unsigned int RENDER_KEY_DEPTH_BITS = 24;
+
+const unsigned int RENDER_KEY_DEPTH_SHIFT = 0;
+const unsigned int RENDER_KEY_MATERIAL_SHIFT = RENDER_KEY_DEPTH_SHIFT + RENDER_KEY_DEPTH_BITS;
+const unsigned int RENDER_KEY_SHADER_SHIFT = RENDER_KEY_MATERIAL_SHIFT + RENDER_KEY_MATERIAL_BITS;
+const unsigned int RENDER_KEY_PASS_SHIFT = RENDER_KEY_SHADER_SHIFT + RENDER_KEY_SHADER_BITS;
+const unsigned int RENDER_KEY_LAYER_SHIFT = RENDER_KEY_PASS_SHIFT + RENDER_KEY_PASS_BITS;
+
+//the bits of value that fit in the field, moved into place
+inline RenderKey RenderKeyField(unsigned int value, unsigned int bits, unsigned int shift)
+{
+  return (RenderKey)(value & ((1u << bits) - 1)) << shift;
+}
+
+inline unsigned int RenderKeyDepth(float depth)
+{
+  const float max_depth = (float)((1u << RENDER_KEY_DEPTH_BITS) - 1);
+  return (unsigned int)(std::max(0.0f, std::min(depth, 1.0f)) * max_depth);
+}
+
+//opaque geometry, grouped by shader and material then front to back
+inline RenderKey MakeRenderKey(unsigned int layer, unsigned int pass, unsigned int shader, unsigned int material, float depth)
+{
+  return RenderKeyField(layer, RENDER_KEY_LAYER_BITS, RENDER_KEY_LAYER_SHIFT) |
+         RenderKeyField(pass, RENDER_KEY_PASS_BITS, RENDER_KEY_PASS_SHIFT) |
+         RenderKeyField(shader, RENDER_KEY_SHADER_BITS, RENDER_KEY_SHADER_SHIFT) |
+         RenderKeyField(material, RENDER_KEY_MATERIAL_BITS, RENDER_KEY_MATERIAL_SHIFT) |
+         RenderKeyField(RenderKeyDepth(depth), RENDER_KEY_DEPTH_BITS, RENDER_KEY_DEPTH_SHIFT);
+}
+
+//translucent geometry, back to front with shader and material only breaking ties.  The depth
+//takes the shader and material's 24 bits and they take its place.
+inline RenderKey MakeDepthFirstRenderKey(unsigned int layer, unsigned int pass, unsigned int shader, unsigned int material, float depth)
+{
+  unsigned int state = (shader << RENDER_KEY_MATERIAL_BITS) | (material & ((1u << RENDER_KEY_MATERIAL_BITS) - 1));
+  return RenderKeyField(layer, RENDER_KEY_LAYER_BITS, RENDER_KEY_LAYER_SHIFT) |
+         RenderKeyField(pass, RENDER_KEY_PASS_BITS, RENDER_KEY_PASS_SHIFT) |
+         RenderKeyField(~RenderKeyDepth(depth), RENDER_KEY_DEPTH_BITS, RENDER_KEY_MATERIAL_SHIFT) |
+         RenderKeyField(state, RENDER_KEY_DEPTH_BITS, RENDER_KEY_DEPTH_SHIFT);
+}
+
+//instanced geometry, grouped by shader, material and then mesh
+inline RenderKey MakeInstancedRenderKey(unsigned int layer, unsigned int pass, unsigned int shader, unsigned int material, unsigned int mesh)
+{
+  return RenderKeyField(layer, RENDER_KEY_LAYER_BITS, RENDER_KEY_LAYER_SHIFT) |
+         RenderKeyField(pass, RENDER_KEY_PASS_BITS, RENDER_KEY_PASS_SHIFT) |
+         RenderKeyField(shader, RENDER_KEY_SHADER_BITS, RENDER_KEY_SHADER_SHIFT) |
+         RenderKeyField(material, RENDER_KEY_MATERIAL_BITS, RENDER_KEY_MATERIAL_SHIFT) |
+         RenderKeyField(mesh, RENDER_KEY_DEPTH_BITS, RENDER_KEY_DEPTH_SHIFT);
+}
+
+inline unsigned int RenderKeyLayer(RenderKey key) { return (unsigned int)(key >> RENDER_KEY_LAYER_SHIFT) & ((1u << RENDER_KEY_LAYER_BITS) - 1); }
+inline unsigned int RenderKeyPass(RenderKey key) { return (unsigned int)(key >> RENDER_KEY_PASS_SHIFT) & ((1u << RENDER_KEY_PASS_BITS) - 1); }
@@ -0,0 +1,95 @@
+#include "EngineStd.h"
+#include "RenderQueue.h"
+#include "../Debugging/Logger.h"
+
+//commands per job.  Fewer than this are sorted on the calling thread.
+const unsigned int COMMANDS_PER_JOB = 16384;
+
+const unsigned int KEY_BITS = sizeof(RenderKey) * 8;
+
+RenderQueue::RenderQueue(JobSystem* jobs) : _sort(COMMANDS_PER_JOB)
+{
+  _jobs = jobs;
+  _num_buckets = 0;
+  _count = 0;
+}
+
+void RenderQueue::Begin(unsigned int num_buckets)
+{
+  if(_buckets.size() < num_buckets)
+    _buckets.resize(num_buckets);
+  _num_buckets = num_buckets;
+  for(unsigned int i = 0; i < _num_buckets; ++i)
+  {
+    _buckets[i]._keys.clear();
+    _buckets[i]._commands.clear();
+  }
+  _count = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Copies the buckets end to end, sorts their keys, then copies the
+// commands into key order.
+//////////////////////////////////////////////////////////////////////////////
+void RenderQueue::Sort()
+{
+  _bucket_start.resize(_num_buckets + 1);
+  unsigned int count = 0;
+  for(unsigned int i = 0; i < _num_buckets; ++i)
+  {
+    _bucket_start[i] = count;
+    count += _buckets[i].Count();
+  }
+  _bucket_start[_num_buckets] = count;
+
+  if(_sorted_keys.size() < count)
+  {
+    _commands.resize(count);
+    _sort.Reserve(count);
+    _sorted_keys.resize(count);
+    _sorted_commands.resize(count);
+  }
+  _count = count;
+  if(count == 0)
+    return;
+
+  JobSystem::Run(_jobs, MergeRange, this, _num_buckets, 1);
+  _sort.Sort(_jobs, count, KEY_BITS);
+  JobSystem::Run(_jobs, GatherRange, this, count, COMMANDS_PER_JOB);
+}
+
+void RenderQueue::MergeRange(void* data, unsigned int begin, unsigned int end)
+{
+  RenderQueue* queue = (RenderQueue*)data;
+  RenderKey* keys = queue->_sort.Keys();
+  unsigned int* order = queue->_sort.Order();
+  for(unsigned int b = begin; b < end; ++b)
+  {
+    const RenderBucket& bucket = queue->_buckets[b];
+    unsigned int start = queue->_bucket_start[b];
+    for(unsigned int i = 0; i < bucket.Count(); ++i)
+    {
+      keys[start + i] = bucket._keys[i];
+      order[start + i] = start + i;
+      queue->_commands[start + i] = bucket._commands[i];
+    }
+  }
+}
+
+void RenderQueue::GatherRange(void* data, unsigned int begin, unsigned int end)
+{
+  RenderQueue* queue = (RenderQueue*)data;
+  const RenderKey* keys = queue->_sort.SortedKeys();
+  const unsigned int* order = queue->_sort.SortedOrder();
+  for(unsigned int i = begin; i < end; ++i)
+  {
+    queue->_sorted_keys[i] = keys[i];
+    queue->_sorted_commands[i] = queue->_commands[order[i]];
+  }
+}
+
+void RenderQueue::Submit(IRenderBackend* backend) const
+{
+  SOL_ASSERT(backend);
+  backend->Submit(Keys(), Commands(), Count());
+}
@@ -0,0 +1,74 @@
+#pragma once
+//========================================================================
+// RenderQueue.h : Collects a frame's draw commands and sorts them by key
+//
+// Draw commands are written from jobs, so the queue has a bucket for each
+// job and a job only ever adds to its own.  Sort() copies the buckets end
+// to end and sorts the keys with a ParallelRadixSort split across the job
+// system.  It skips the passes where every key has the same byte, which
+// is most of them when a frame only uses a few layers and passes.  The
+// sort is stable, so commands with the same key draw in the order they
+// were added, bucket by bucket.
+//
+// Afterwards the commands are laid out in key order and Submit() hands the
+// whole lot to the backend in one call.
+//========================================================================
+
+#include "RenderCommand.h"
+#include "../Multicore/ParallelRadixSort.h"
+
+//one job's draw commands
+class RenderBucket
+{
+  friend class RenderQueue;
+
+  std::vector<RenderKey> _keys;
+  std::vector<DrawCommand> _commands;
+
+public:
+  void Add(RenderKey key, const DrawCommand& command)
+  {
+    _keys.push_back(key);
+    _commands.push_back(command);
+  }
+
+  unsigned int Count() const { return (unsigned int)_keys.size(); }
+};
+
+class RenderQueue : public SOL_noncopyable
+{
+  JobSystem* _jobs;
+  std::vector<RenderBucket> _buckets;
+  unsigned int _num_buckets;
+
+  //in key order after Sort().  They only grow, so sorting doesnt allocate once they are big enough.
+  unsigned int _count;
+  std::vector<RenderKey> _sorted_keys;
+  std::vector<DrawCommand> _sorted_commands;
+
+  //the Sort() in progress
+  std::vector<unsigned int> _bucket_start;    //where each bucket goes in the merged commands
+  std::vector<DrawCommand> _commands;         //every bucket's commands end to end
+  ParallelRadixSort<RenderKey> _sort;         //each command's key
+
+public:
+  explicit RenderQueue(JobSystem* jobs = 0);
+
+  //empties the buckets, keeping their memory, and makes sure there are at least num_buckets of them
+  void Begin(unsigned int num_buckets);
+  //only one thread may add to a bucket at a time
+  RenderBucket& Bucket(unsigned int index) { return _buckets[index]; }
+  unsigned int NumBuckets() const { return _num_buckets; }
+
+  void Sort();
+  void Submit(IRenderBackend* backend) const;
+
+  //the sorted commands, valid until the next Begin()
+  unsigned int Count() const { return _count; }
+  const RenderKey* Keys() const { return _count ? &_sorted_keys[0] : 0; }
+  const DrawCommand* Commands() const { return _count ? &_sorted_commands[0] : 0; }
+
+private:
+  static void MergeRange(void* data, unsigned int begin, unsigned int end);
+  static void GatherRange(void* data, unsigned int begin, unsigned int end);
+};
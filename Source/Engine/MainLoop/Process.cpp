@@ -0,0 +1,108 @@
+#include "EngineStd.h"
+#include "Process.h"
+#include "ProcessManager.h"
+#include "../Debugging/Logger.h"
+
+#pragma region Process
+
+Process::Process()
+{
+  _state = UNINITIALIZED;
+  _manager = 0;
+  _last_update = 0;
+  _sleep_time = 0;
+  _sleep_serial = 0;
+}
+
+Process::~Process()
+{
+  if(_child)
+    _child->OnAbort();
+}
+
+void Process::Succeed()
+{
+  SOL_ASSERT(IsAlive());
+  _state = SUCCEEDED;
+}
+
+void Process::Fail()
+{
+  SOL_ASSERT(IsAlive());
+  _state = FAILED;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The manager notices the new state the next time it updates the process
+// and parks it then.
+//////////////////////////////////////////////////////////////////////////////
+void Process::Pause()
+{
+  if(_state == RUNNING)
+    _state = PAUSED;
+  else
+    SOL_WARNING("Attempting to pause a process that isn't running");
+}
+
+void Process::UnPause()
+{
+  if(_state == PAUSED || _state == SLEEPING)
+  {
+    _state = RUNNING;
+    if(_manager)
+      _manager->Wake(this);
+  }
+  else
+  {
+    SOL_WARNING("Attempting to unpause a process that isn't paused");
+  }
+}
+
+void Process::Sleep(int delta_ms)
+{
+  if(_state == RUNNING)
+  {
+    _state = SLEEPING;
+    _sleep_time = delta_ms;
+  }
+  else
+  {
+    SOL_WARNING("Attempting to sleep a process that isn't running");
+  }
+}
+
+StrongProcessPtr Process::AttachChild(StrongProcessPtr child)
+{
+  if(_child)
+    _child->AttachChild(child);
+  else
+    _child = child;
+  return child;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Removes the child from this process.  This releases ownership of the
+// child to the caller and completely removes it from the process chain.
+//////////////////////////////////////////////////////////////////////////////
+StrongProcessPtr Process::RemoveChild()
+{
+  if(_child)
+  {
+    StrongProcessPtr child = _child;  //this keeps the child from getting destroyed when we clear it
+    _child.reset();
+    return child;
+  }
+  return StrongProcessPtr();
+}
+
+#pragma endregion
+
+#pragma region DelayProcess
+
+void DelayProcess::OnInit()
+{
+  Process::OnInit();
+  Sleep(_delay);
+}
+
+#pragma endregion
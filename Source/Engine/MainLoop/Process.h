@@ -0,0 +1,157 @@
+#pragma once
+//========================================================================
+// Process.h : Base class for work that runs over many frames
+//
+// A process is updated once a frame by the ProcessManager until it
+// succeeds, fails or is aborted.  When it succeeds its child, if it has
+// one, is started in its place, so processes chain into sequences.
+//
+// A process that is paused or asleep is taken out of the manager's update
+// list and costs nothing until it is woken.
+//
+// CoroutineProcess lets a sequence be written top to bottom instead of as
+// a state machine:
+//
+//   void Run(int delta)
+//   {
+//     SOL_CO_BEGIN();
+//     FadeOut();
+//     SOL_CO_WAIT(500);
+//     Teleport();
+//     SOL_CO_WAIT_UNTIL(IsLoaded());
+//     FadeIn();
+//     SOL_CO_END();
+//   }
+//
+// The coroutine is stackless.  Locals dont survive a wait, so anything
+// that has to is a member, and the SOL_CO_ macros can only be used in
+// Run() itself, not in functions it calls.
+//========================================================================
+
+class Process;
+class ProcessManager;
+typedef shared_ptr<Process> StrongProcessPtr;
+typedef weak_ptr<Process> WeakProcessPtr;
+
+class Process : public SOL_noncopyable
+{
+  friend class ProcessManager;
+
+public:
+  enum State
+  {
+    //neither dead nor alive
+    UNINITIALIZED = 0,  //created but not running
+    REMOVED,            //removed from the process list but not destroyed, like a child waiting for its parent
+
+    //living processes
+    RUNNING,            //initialized and running
+    PAUSED,             //initialized but paused
+    SLEEPING,           //initialized and waiting for its wake time
+
+    //dead processes
+    SUCCEEDED,          //completed successfully
+    FAILED,             //failed to complete
+    ABORTED             //aborted, may not have started
+  };
+
+private:
+  State _state;
+  StrongProcessPtr _child;
+
+  //owned by the manager
+  ProcessManager* _manager;
+  unsigned long _last_update;   //manager time of the last update
+  int _sleep_time;              //how long Sleep() asked for
+  unsigned int _sleep_serial;   //matches the manager's heap entry for the current sleep
+
+public:
+  Process();
+  virtual ~Process();
+
+protected:
+  //overridable
+  virtual void OnInit() { _state = RUNNING; }
+  virtual void OnUpdate(int delta) = 0;
+  virtual void OnSuccess() {}
+  virtual void OnFail() {}
+  virtual void OnAbort() {}
+
+public:
+  //ending the process
+  void Succeed();
+  void Fail();
+
+  //pausing.  A paused or sleeping process is woken by UnPause().
+  void Pause();
+  void UnPause();
+  //stops updating the process until delta_ms of game time have passed
+  void Sleep(int delta_ms);
+
+  //accessors
+  State GetState() const { return _state; }
+  bool IsAlive() const { return (_state == RUNNING || _state == PAUSED || _state == SLEEPING); }
+  bool IsDead() const { return (_state == SUCCEEDED || _state == FAILED || _state == ABORTED); }
+  bool IsRemoved() const { return (_state == REMOVED); }
+  bool IsPaused() const { return _state == PAUSED; }
+  bool IsSleeping() const { return _state == SLEEPING; }
+
+  //child functions
+  StrongProcessPtr AttachChild(StrongProcessPtr child);
+  StrongProcessPtr RemoveChild();
+  StrongProcessPtr PeekChild() { return _child; }
+
+private:
+  void SetState(State new_state) { _state = new_state; }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// CoroutineProcess - a process written as a stackless coroutine.  Run() is
+// called every update and carries on from the last yield or wait.
+// Reaching SOL_CO_END() succeeds the process.
+//
+// The resume points are numbered with __COUNTER__ rather than __LINE__,
+// which isnt a constant when compiling for edit and continue.
+//////////////////////////////////////////////////////////////////////////////
+class CoroutineProcess : public Process
+{
+protected:
+  int _co_point;  //where Run() carries on from, 0 is the start
+
+public:
+  CoroutineProcess() : _co_point(0) {}
+
+protected:
+  virtual void OnUpdate(int delta) { Run(delta); }
+  virtual void Run(int delta) = 0;
+};
+
+#define SOL_CO_BEGIN() switch(_co_point) { case 0:
+#define SOL_CO_END() } Succeed()
+
+//carries on next update
+#define SOL_CO_YIELD() SOL_CO_YIELD_AT(__COUNTER__ + 1)
+#define SOL_CO_YIELD_AT(point) do { _co_point = (point); return; case (point):; } while(0)
+
+//sleeps for delta_ms of game time, the process isnt updated at all until then
+#define SOL_CO_WAIT(delta_ms) SOL_CO_WAIT_AT(__COUNTER__ + 1, delta_ms)
+#define SOL_CO_WAIT_AT(point, delta_ms) do { _co_point = (point); Sleep(delta_ms); return; case (point):; } while(0)
+
+//checks condition every update until it is true
+#define SOL_CO_WAIT_UNTIL(condition) SOL_CO_WAIT_UNTIL_AT(__COUNTER__ + 1, condition)
+#define SOL_CO_WAIT_UNTIL_AT(point, condition) do { _co_point = (point); case (point): if(!(condition)) return; } while(0)
+
+//////////////////////////////////////////////////////////////////////////////
+// DelayProcess - does nothing for a while, for putting gaps in a chain
+//////////////////////////////////////////////////////////////////////////////
+class DelayProcess : public Process
+{
+  int _delay;
+
+public:
+  explicit DelayProcess(int delay_ms) : _delay(delay_ms) {}
+
+protected:
+  virtual void OnInit();
+  virtual void OnUpdate(int delta) { Succeed(); }
+};
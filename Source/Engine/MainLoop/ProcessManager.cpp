@@ -0,0 +1,260 @@
+#include "EngineStd.h"
+#include "ProcessManager.h"
+
+ProcessManager::ProcessManager()
+{
+  _next = 0;
+  _time = 0;
+  _next_sleep_serial = 0;
+  _updating = false;
+}
+
+ProcessManager::~ProcessManager()
+{
+  ClearAllProcesses();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The process update tick.  Called every frame.
+//////////////////////////////////////////////////////////////////////////////
+unsigned int ProcessManager::UpdateProcesses(int delta, double budget_ms)
+{
+  LARGE_INTEGER frequency, start, now;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&start);
+  double budget_ticks = budget_ms * frequency.QuadPart / 1000.0;
+
+  unsigned short success_count = 0;
+  unsigned short fail_count = 0;
+
+  _time += delta;
+  WakeSleepers();
+
+  //the processes here now are visited at most once, ones added during the update go on the end
+  //and wait for the next.  Removed and parked ones leave an empty slot until the pass is over.
+  _updating = true;
+  size_t count = _active.size();
+  size_t first = _next < count ? _next : 0;
+  size_t visited = 0;
+  while(visited < count)
+  {
+    size_t index = (first + visited) % count;
+    ++visited;
+
+    //held here in case the process is removed from the list below
+    StrongProcessPtr current = _active[index];
+    if(!current)
+      continue;
+    int process_delta = (int)(_time - current->_last_update);
+    current->_last_update = _time;
+
+    //process is uninitialized, so initialize it
+    if(current->GetState() == Process::UNINITIALIZED)
+      current->OnInit();
+
+    //give the process an update tick if it's running
+    if(current->GetState() == Process::RUNNING)
+      current->OnUpdate(process_delta);
+
+    //AbortAllProcesses() during its own update has already aborted and removed it
+    if(_active[index])
+    {
+      //check to see if the process is dead
+      if(current->IsDead())
+      {
+        //run the appropriate exit function
+        switch(current->GetState())
+        {
+        case Process::SUCCEEDED:
+          {
+            current->OnSuccess();
+            StrongProcessPtr child = current->RemoveChild();
+            if(child)
+              AttachProcess(child);
+            else
+              ++success_count;  //only counts if the whole chain completed
+            break;
+          }
+
+        case Process::FAILED:
+          {
+            current->OnFail();
+            ++fail_count;
+            break;
+          }
+
+        case Process::ABORTED:
+          {
+            current->OnAbort();
+            ++fail_count;
+            break;
+          }
+        }
+
+        //remove the process and destroy it
+        RemoveActive(index);
+      }
+      else if(current->IsPaused() || current->IsSleeping())
+      {
+        Park(index);
+      }
+    }
+
+    QueryPerformanceCounter(&now);
+    if(now.QuadPart - start.QuadPart >= budget_ticks)
+      break;
+  }
+  _updating = false;
+
+  //the next update starts with the first process this one didnt get to
+  Compact(count > 0 ? (first + visited) % count : 0);
+
+  return ((success_count << 16) | fail_count);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Attaches the process to the process list so it can be run on the next
+// update.
+//////////////////////////////////////////////////////////////////////////////
+WeakProcessPtr ProcessManager::AttachProcess(StrongProcessPtr process)
+{
+  process->_manager = this;
+  Activate(process);
+  return WeakProcessPtr(process);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Aborts all processes.  If immediate == true, it immediately calls each
+// one's OnAbort() function and destroys all the processes.
+//////////////////////////////////////////////////////////////////////////////
+void ProcessManager::AbortAllProcesses(bool immediate)
+{
+  //parked processes go back in the list so they are aborted the same way
+  while(!_parked.empty())
+    Activate(_parked.begin()->second);
+  _sleepers.clear();
+
+  size_t i = 0;
+  while(i < _active.size())
+  {
+    StrongProcessPtr process = _active[i];
+    if(process && (process->IsAlive() || process->GetState() == Process::UNINITIALIZED))
+    {
+      process->SetState(Process::ABORTED);
+      if(immediate)
+      {
+        process->OnAbort();
+        RemoveActive(i);
+      }
+    }
+    ++i;
+  }
+
+  //an update going on compacts the list when it is done
+  if(!_updating)
+    Compact(_next);
+}
+
+void ProcessManager::ClearAllProcesses()
+{
+  for(ProcessList::iterator it = _active.begin(); it != _active.end(); ++it)
+  {
+    if(*it)
+      (*it)->_manager = 0;
+  }
+  for(ParkedProcesses::iterator it = _parked.begin(); it != _parked.end(); ++it)
+    it->second->_manager = 0;
+  _active.clear();
+  _parked.clear();
+  _sleepers.clear();
+  _next = 0;
+}
+
+void ProcessManager::Activate(StrongProcessPtr process)
+{
+  _parked.erase(process.get());
+  process->_last_update = _time;
+  _active.push_back(process);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// moves a paused or sleeping process out of the update list
+//////////////////////////////////////////////////////////////////////////////
+void ProcessManager::Park(size_t index)
+{
+  StrongProcessPtr process = _active[index];
+  _parked[process.get()] = process;
+  if(process->IsSleeping())
+  {
+    Sleeper sleeper;
+    sleeper.wake_time = _time + std::max(0, process->_sleep_time);
+    sleeper.serial = ++_next_sleep_serial;
+    sleeper.process = process.get();
+    process->_sleep_serial = sleeper.serial;
+    _sleepers.push_back(sleeper);
+    std::push_heap(_sleepers.begin(), _sleepers.end());
+  }
+  RemoveActive(index);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Called by Process::UnPause().  The process's heap entry, if it has one,
+// is left behind and skipped when it comes up because its serial is stale.
+//////////////////////////////////////////////////////////////////////////////
+void ProcessManager::Wake(Process* process)
+{
+  ParkedProcesses::iterator it = _parked.find(process);
+  if(it != _parked.end())
+    Activate(it->second);
+}
+
+void ProcessManager::WakeSleepers()
+{
+  while(!_sleepers.empty() && _sleepers.front().wake_time <= _time)
+  {
+    Sleeper sleeper = _sleepers.front();
+    std::pop_heap(_sleepers.begin(), _sleepers.end());
+    _sleepers.pop_back();
+
+    //woken early, or gone back to sleep since
+    ParkedProcesses::iterator it = _parked.find(sleeper.process);
+    if(it == _parked.end())
+      continue;
+    Process* process = it->second.get();
+    if(!process->IsSleeping() || process->_sleep_serial != sleeper.serial)
+      continue;
+
+    //the time it slept isnt passed on in its next delta
+    process->SetState(Process::RUNNING);
+    StrongProcessPtr strong = it->second;
+    Activate(strong);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Only empties the slot.  Moving another process into it in the middle of
+// an update would have that one updated twice or not at all, so the list
+// is compacted once the update is over.
+//////////////////////////////////////////////////////////////////////////////
+void ProcessManager::RemoveActive(size_t index)
+{
+  _active[index].reset();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Closes up the empty slots, keeping the order, and moves the round robin
+// cursor to the process that was at resume, or the first one after it.
+//////////////////////////////////////////////////////////////////////////////
+void ProcessManager::Compact(size_t resume)
+{
+  size_t kept = 0;
+  _next = 0;
+  for(size_t i = 0; i < _active.size(); ++i)
+  {
+    if(i == resume)
+      _next = kept;
+    if(_active[i])
+      _active[kept++] = _active[i];
+  }
+  _active.resize(kept);
+}
@@ -0,0 +1,64 @@
+#pragma once
+//========================================================================
+// ProcessManager.h : Updates processes and chains them together
+//
+// Running processes are kept in one array and updated round robin, so
+// when an update runs out of time the next one carries on where it
+// stopped.  Processes that finish or park during an update leave an empty
+// slot and the array is compacted afterwards, so every process is still
+// visited once.  A process that misses a frame gets the time it missed in its
+// next delta.  Paused and sleeping processes are parked outside the array.
+// Sleepers also go in a heap ordered by wake time, so thousands of timers
+// cost nothing until they are due.
+//========================================================================
+
+#include <float.h>
+#include "Process.h"
+
+class ProcessManager : public SOL_noncopyable
+{
+  struct Sleeper
+  {
+    unsigned long wake_time;
+    unsigned int serial;
+    Process* process;   //only dereferenced once the parked list shows it is still alive
+
+    //the heap keeps the earliest wake time on top
+    bool operator<(const Sleeper& rhs) const { return wake_time > rhs.wake_time; }
+  };
+
+  typedef std::vector<StrongProcessPtr> ProcessList;
+  typedef std::tr1::unordered_map<Process*, StrongProcessPtr> ParkedProcesses;
+
+  ProcessList _active;
+  size_t _next;               //where the round robin carries on from
+  ParkedProcesses _parked;    //paused and sleeping processes
+  std::vector<Sleeper> _sleepers;
+  unsigned long _time;        //sum of every delta passed to UpdateProcesses()
+  unsigned int _next_sleep_serial;
+  bool _updating;             //slots are only emptied while true, never moved
+
+public:
+  ProcessManager();
+  ~ProcessManager();
+
+  //updates processes for up to budget_ms.  Returns the number that succeeded in the upper
+  //16 bits and the number that failed or were aborted in the lower 16.
+  unsigned int UpdateProcesses(int delta, double budget_ms = DBL_MAX);
+  WeakProcessPtr AttachProcess(StrongProcessPtr process);
+  void AbortAllProcesses(bool immediate);
+
+  unsigned int ProcessCount() const { return (unsigned int)(_active.size() + _parked.size()); }
+  unsigned int ActiveProcessCount() const { return (unsigned int)_active.size(); }
+
+private:
+  friend class Process;
+
+  void ClearAllProcesses();
+  void Activate(StrongProcessPtr process);
+  void Park(size_t index);
+  void Wake(Process* process);
+  void RemoveActive(size_t index);
+  void Compact(size_t resume);
+  void WakeSleepers();
+};
@@ -0,0 +1,460 @@
+#include "EngineStd.h"
+#include "BatchMath.h"
+#include <intrin.h>
+#include <immintrin.h>
+
+//-1 until the first kernel is called
+static int batch_math_path = -1;
+
+BatchMathPath BestBatchMathPath()
+{
+  int info[4];
+  __cpuid(info, 1);
+  bool sse2 = (info[3] & (1 << 26)) != 0;
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  bool avx = (info[2] & (1 << 28)) != 0;
+
+  //AVX also needs the OS to save the upper halves of the registers
+  if(avx && osxsave && (_xgetbv(0) & 6) == 6)
+    return BATCH_MATH_AVX;
+  if(sse2)
+    return BATCH_MATH_SSE;
+  return BATCH_MATH_SCALAR;
+}
+
+void SetBatchMathPath(BatchMathPath path)
+{
+  batch_math_path = std::min(path, BestBatchMathPath());
+}
+
+BatchMathPath GetBatchMathPath()
+{
+  if(batch_math_path < 0)
+    batch_math_path = BestBatchMathPath();
+  return (BatchMathPath)batch_math_path;
+}
+
+#pragma region Helpers
+
+#define SHUFFLE(v, x, y, z, w) _mm_shuffle_ps((v), (v), _MM_SHUFFLE(w, z, y, x))
+
+//loads four vec3s, 12 floats, and splits them into x, y and z
+static inline void LoadVec3x4(const glm::vec3* in, __m128& x, __m128& y, __m128& z)
+{
+  const float* f = &in[0].x;
+  __m128 v0 = _mm_loadu_ps(f);      //x0 y0 z0 x1
+  __m128 v1 = _mm_loadu_ps(f + 4);  //y1 z1 x2 y2
+  __m128 v2 = _mm_loadu_ps(f + 8);  //z2 x3 y3 z3
+
+  __m128 t = _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(0, 1, 0, 2));
+  x = _mm_shuffle_ps(v0, t, _MM_SHUFFLE(2, 0, 3, 0));
+  __m128 c = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(0, 0, 0, 1));
+  __m128 d = _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(0, 2, 0, 3));
+  y = _mm_shuffle_ps(c, d, _MM_SHUFFLE(2, 0, 2, 0));
+  __m128 e = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(0, 1, 0, 2));
+  z = _mm_shuffle_ps(e, v2, _MM_SHUFFLE(3, 0, 2, 0));
+}
+
+//the reverse of LoadVec3x4()
+static inline void StoreVec3x4(glm::vec3* out, __m128 x, __m128 y, __m128 z)
+{
+  float* f = &out[0].x;
+  __m128 a = _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0));
+  __m128 b = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+  _mm_storeu_ps(f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+  a = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+  b = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2));
+  _mm_storeu_ps(f + 4, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+  a = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));
+  b = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));
+  _mm_storeu_ps(f + 8, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+//the same matrix as mat4_cast(q), scaled, with t for the translation
+static inline void ComposeTRS(const glm::vec3& t, const glm::quat& q, const glm::vec3& s, glm::mat4& out)
+{
+  float x2 = q.x + q.x, y2 = q.y + q.y, z2 = q.z + q.z;
+  float xx = q.x * x2, yy = q.y * y2, zz = q.z * z2;
+  float xy = q.x * y2, xz = q.x * z2, yz = q.y * z2;
+  float wx = q.w * x2, wy = q.w * y2, wz = q.w * z2;
+
+  out[0] = glm::vec4((1.0f - (yy + zz)) * s.x, (xy + wz) * s.x, (xz - wy) * s.x, 0.0f);
+  out[1] = glm::vec4((xy - wz) * s.y, (1.0f - (xx + zz)) * s.y, (yz + wx) * s.y, 0.0f);
+  out[2] = glm::vec4((xz + wy) * s.z, (yz - wx) * s.z, (1.0f - (xx + yy)) * s.z, 0.0f);
+  out[3] = glm::vec4(t, 1.0f);
+}
+
+#pragma endregion
+
+#pragma region Scalar
+
+static void MultiplyScalar(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, unsigned int count)
+{
+  for(unsigned int i = 0; i < count; ++i)
+    out[i] = a[i] * b[i];
+}
+
+static void MultiplyAffineScalar(const glm::mat4* a, const unsigned int* a_index, const glm::mat4* b, glm::mat4* out, unsigned int count)
+{
+  for(unsigned int i = 0; i < count; ++i)
+    out[i] = a[a_index ? a_index[i] : i] * b[i];
+}
+
+static void TransformScalar(const glm::mat4& m, const glm::vec3* in, glm::vec3* out, unsigned int count, float w)
+{
+  for(unsigned int i = 0; i < count; ++i)
+    out[i] = glm::vec3(m * glm::vec4(in[i], w));
+}
+
+static void InverseAffineScalar(const glm::mat4* in, glm::mat4* out, unsigned int count)
+{
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    glm::mat3 inverse = glm::inverse(glm::mat3(in[i]));
+    glm::vec3 translation = -(inverse * glm::vec3(in[i][3]));
+    out[i] = glm::mat4(inverse);
+    out[i][3] = glm::vec4(translation, 1.0f);
+  }
+}
+
+//parent may be NULL for no parent
+static void ComposeTRSScalar(const glm::mat4* parent, const unsigned int* parent_index, const glm::vec3* translation, const glm::quat* rotation, const glm::vec3* scale, glm::mat4* out, unsigned int count)
+{
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    ComposeTRS(translation[i], rotation[i], scale[i], out[i]);
+    if(parent)
+      out[i] = parent[parent_index[i]] * out[i];
+  }
+}
+
+#pragma endregion
+
+#pragma region SSE
+
+//a's first three columns times b's x, y and z
+static inline __m128 Column(__m128 a0, __m128 a1, __m128 a2, __m128 b)
+{
+  __m128 r = _mm_mul_ps(a0, SHUFFLE(b, 0, 0, 0, 0));
+  r = _mm_add_ps(r, _mm_mul_ps(a1, SHUFFLE(b, 1, 1, 1, 1)));
+  return _mm_add_ps(r, _mm_mul_ps(a2, SHUFFLE(b, 2, 2, 2, 2)));
+}
+
+static void MultiplySSE(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, unsigned int count)
+{
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    const float* fa = &a[i][0][0];
+    const float* fb = &b[i][0][0];
+    __m128 a0 = _mm_loadu_ps(fa), a1 = _mm_loadu_ps(fa + 4), a2 = _mm_loadu_ps(fa + 8), a3 = _mm_loadu_ps(fa + 12);
+    __m128 b0 = _mm_loadu_ps(fb), b1 = _mm_loadu_ps(fb + 4), b2 = _mm_loadu_ps(fb + 8), b3 = _mm_loadu_ps(fb + 12);
+
+    //all of b is loaded before anything is stored, so out can be b
+    float* fo = &out[i][0][0];
+    _mm_storeu_ps(fo, _mm_add_ps(Column(a0, a1, a2, b0), _mm_mul_ps(a3, SHUFFLE(b0, 3, 3, 3, 3))));
+    _mm_storeu_ps(fo + 4, _mm_add_ps(Column(a0, a1, a2, b1), _mm_mul_ps(a3, SHUFFLE(b1, 3, 3, 3, 3))));
+    _mm_storeu_ps(fo + 8, _mm_add_ps(Column(a0, a1, a2, b2), _mm_mul_ps(a3, SHUFFLE(b2, 3, 3, 3, 3))));
+    _mm_storeu_ps(fo + 12, _mm_add_ps(Column(a0, a1, a2, b3), _mm_mul_ps(a3, SHUFFLE(b3, 3, 3, 3, 3))));
+  }
+}
+
+static void MultiplyAffineSSE(const glm::mat4* a, const unsigned int* a_index, const glm::mat4* b, glm::mat4* out, unsigned int count)
+{
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    const float* fa = &a[a_index ? a_index[i] : i][0][0];
+    const float* fb = &b[i][0][0];
+    __m128 a0 = _mm_loadu_ps(fa), a1 = _mm_loadu_ps(fa + 4), a2 = _mm_loadu_ps(fa + 8), a3 = _mm_loadu_ps(fa + 12);
+    __m128 b0 = _mm_loadu_ps(fb), b1 = _mm_loadu_ps(fb + 4), b2 = _mm_loadu_ps(fb + 8), b3 = _mm_loadu_ps(fb + 12);
+
+    //b's bottom row is 0 0 0 1, so a's last column only goes into the translation
+    float* fo = &out[i][0][0];
+    _mm_storeu_ps(fo, Column(a0, a1, a2, b0));
+    _mm_storeu_ps(fo + 4, Column(a0, a1, a2, b1));
+    _mm_storeu_ps(fo + 8, Column(a0, a1, a2, b2));
+    _mm_storeu_ps(fo + 12, _mm_add_ps(Column(a0, a1, a2, b3), a3));
+  }
+}
+
+static void TransformSSE(const glm::mat4& m, const glm::vec3* in, glm::vec3* out, unsigned int count, float w)
+{
+  __m128 m00 = _mm_set1_ps(m[0][0]), m01 = _mm_set1_ps(m[0][1]), m02 = _mm_set1_ps(m[0][2]);
+  __m128 m10 = _mm_set1_ps(m[1][0]), m11 = _mm_set1_ps(m[1][1]), m12 = _mm_set1_ps(m[1][2]);
+  __m128 m20 = _mm_set1_ps(m[2][0]), m21 = _mm_set1_ps(m[2][1]), m22 = _mm_set1_ps(m[2][2]);
+  __m128 m30 = _mm_set1_ps(m[3][0] * w), m31 = _mm_set1_ps(m[3][1] * w), m32 = _mm_set1_ps(m[3][2] * w);
+
+  //four at a time, split into x, y and z so each lane is one point
+  unsigned int i = 0;
+  for(; i + 4 <= count; i += 4)
+  {
+    __m128 x, y, z;
+    LoadVec3x4(in + i, x, y, z);
+    __m128 ox = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, x), _mm_mul_ps(m10, y)), _mm_add_ps(_mm_mul_ps(m20, z), m30));
+    __m128 oy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m01, x), _mm_mul_ps(m11, y)), _mm_add_ps(_mm_mul_ps(m21, z), m31));
+    __m128 oz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m02, x), _mm_mul_ps(m12, y)), _mm_add_ps(_mm_mul_ps(m22, z), m32));
+    StoreVec3x4(out + i, ox, oy, oz);
+  }
+  TransformScalar(m, in + i, out + i, count - i, w);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The rows of the inverse of the upper 3x3 are the cross products of its
+// columns over the determinant.  The zero w of each column keeps the w of
+// each cross product zero.
+//////////////////////////////////////////////////////////////////////////////
+static inline __m128 Cross(__m128 a, __m128 b)
+{
+  __m128 r = _mm_mul_ps(SHUFFLE(a, 1, 2, 0, 3), SHUFFLE(b, 2, 0, 1, 3));
+  return _mm_sub_ps(r, _mm_mul_ps(SHUFFLE(a, 2, 0, 1, 3), SHUFFLE(b, 1, 2, 0, 3)));
+}
+
+static void InverseAffineSSE(const glm::mat4* in, glm::mat4* out, unsigned int count)
+{
+  const __m128 w_mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+  const __m128 w_one = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    const float* f = &in[i][0][0];
+    __m128 c0 = _mm_and_ps(_mm_loadu_ps(f), w_mask);
+    __m128 c1 = _mm_and_ps(_mm_loadu_ps(f + 4), w_mask);
+    __m128 c2 = _mm_and_ps(_mm_loadu_ps(f + 8), w_mask);
+    __m128 t = _mm_loadu_ps(f + 12);
+
+    __m128 r0 = Cross(c1, c2);
+    __m128 r1 = Cross(c2, c0);
+    __m128 r2 = Cross(c0, c1);
+
+    __m128 d = _mm_mul_ps(c0, r0);
+    d = _mm_add_ps(_mm_add_ps(SHUFFLE(d, 0, 0, 0, 0), SHUFFLE(d, 1, 1, 1, 1)), SHUFFLE(d, 2, 2, 2, 2));
+    __m128 inv_det = _mm_div_ps(_mm_set1_ps(1.0f), d);
+    r0 = _mm_mul_ps(r0, inv_det);
+    r1 = _mm_mul_ps(r1, inv_det);
+    r2 = _mm_mul_ps(r2, inv_det);
+    __m128 r3 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+    //-(inverse * t), with the 1 in w
+    __m128 nt = _mm_mul_ps(r0, SHUFFLE(t, 0, 0, 0, 0));
+    nt = _mm_add_ps(nt, _mm_mul_ps(r1, SHUFFLE(t, 1, 1, 1, 1)));
+    nt = _mm_add_ps(nt, _mm_mul_ps(r2, SHUFFLE(t, 2, 2, 2, 2)));
+    nt = _mm_sub_ps(w_one, nt);
+
+    float* fo = &out[i][0][0];
+    _mm_storeu_ps(fo, r0);
+    _mm_storeu_ps(fo + 4, r1);
+    _mm_storeu_ps(fo + 8, r2);
+    _mm_storeu_ps(fo + 12, nt);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Four at a time with one lane per matrix, then each column's four values
+// are transposed back out into the four matrices.
+//////////////////////////////////////////////////////////////////////////////
+static void ComposeTRSSSE(const glm::mat4* parent, const unsigned int* parent_index, const glm::vec3* translation, const glm::quat* rotation, const glm::vec3* scale, glm::mat4* out, unsigned int count)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  unsigned int i = 0;
+  for(; i + 4 <= count; i += 4)
+  {
+    const float* fq = &rotation[i].x;
+    __m128 qx = _mm_loadu_ps(fq), qy = _mm_loadu_ps(fq + 4), qz = _mm_loadu_ps(fq + 8), qw = _mm_loadu_ps(fq + 12);
+    _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+    __m128 sx, sy, sz, tx, ty, tz;
+    LoadVec3x4(scale + i, sx, sy, sz);
+    LoadVec3x4(translation + i, tx, ty, tz);
+
+    __m128 x2 = _mm_add_ps(qx, qx), y2 = _mm_add_ps(qy, qy), z2 = _mm_add_ps(qz, qz);
+    __m128 xx = _mm_mul_ps(qx, x2), yy = _mm_mul_ps(qy, y2), zz = _mm_mul_ps(qz, z2);
+    __m128 xy = _mm_mul_ps(qx, y2), xz = _mm_mul_ps(qx, z2), yz = _mm_mul_ps(qy, z2);
+    __m128 wx = _mm_mul_ps(qw, x2), wy = _mm_mul_ps(qw, y2), wz = _mm_mul_ps(qw, z2);
+
+    __m128 c[4][4] =
+    {
+      {
+        _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx),
+        _mm_mul_ps(_mm_add_ps(xy, wz), sx),
+        _mm_mul_ps(_mm_sub_ps(xz, wy), sx),
+        _mm_setzero_ps()
+      },
+      {
+        _mm_mul_ps(_mm_sub_ps(xy, wz), sy),
+        _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy),
+        _mm_mul_ps(_mm_add_ps(yz, wx), sy),
+        _mm_setzero_ps()
+      },
+      {
+        _mm_mul_ps(_mm_add_ps(xz, wy), sz),
+        _mm_mul_ps(_mm_sub_ps(yz, wx), sz),
+        _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz),
+        _mm_setzero_ps()
+      },
+      { tx, ty, tz, one }
+    };
+
+    for(int col = 0; col < 4; ++col)
+      _MM_TRANSPOSE4_PS(c[col][0], c[col][1], c[col][2], c[col][3]);
+
+    for(int m = 0; m < 4; ++m)
+    {
+      float* fo = &out[i + m][0][0];
+      if(parent)
+      {
+        //the same affine multiply as MultiplyAffineSSE(), straight from the registers
+        const float* fp = &parent[parent_index[i + m]][0][0];
+        __m128 p0 = _mm_loadu_ps(fp), p1 = _mm_loadu_ps(fp + 4), p2 = _mm_loadu_ps(fp + 8), p3 = _mm_loadu_ps(fp + 12);
+        _mm_storeu_ps(fo, Column(p0, p1, p2, c[0][m]));
+        _mm_storeu_ps(fo + 4, Column(p0, p1, p2, c[1][m]));
+        _mm_storeu_ps(fo + 8, Column(p0, p1, p2, c[2][m]));
+        _mm_storeu_ps(fo + 12, _mm_add_ps(Column(p0, p1, p2, c[3][m]), p3));
+      }
+      else
+      {
+        for(int col = 0; col < 4; ++col)
+          _mm_storeu_ps(fo + col * 4, c[col][m]);
+      }
+    }
+  }
+  ComposeTRSScalar(parent, parent_index ? parent_index + i : 0, translation + i, rotation + i, scale + i, out + i, count - i);
+}
+
+#pragma endregion
+
+#pragma region AVX
+
+//////////////////////////////////////////////////////////////////////////////
+// Two columns of b per register.  Each of a's columns is copied into both
+// halves, and the permutes pick each column's x, y, z or w within its half.
+//////////////////////////////////////////////////////////////////////////////
+static void MultiplyAVX(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, unsigned int count)
+{
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    const float* fa = &a[i][0][0];
+    const float* fb = &b[i][0][0];
+    __m256 a0 = _mm256_broadcast_ps((const __m128*)fa);
+    __m256 a1 = _mm256_broadcast_ps((const __m128*)(fa + 4));
+    __m256 a2 = _mm256_broadcast_ps((const __m128*)(fa + 8));
+    __m256 a3 = _mm256_broadcast_ps((const __m128*)(fa + 12));
+    __m256 b01 = _mm256_loadu_ps(fb);
+    __m256 b23 = _mm256_loadu_ps(fb + 8);
+
+    __m256 r01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+    r01 = _mm256_add_ps(r01, _mm256_mul_ps(a1, _mm256_permute_ps(b01, 0x55)));
+    r01 = _mm256_add_ps(r01, _mm256_mul_ps(a2, _mm256_permute_ps(b01, 0xAA)));
+    r01 = _mm256_add_ps(r01, _mm256_mul_ps(a3, _mm256_permute_ps(b01, 0xFF)));
+    __m256 r23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+    r23 = _mm256_add_ps(r23, _mm256_mul_ps(a1, _mm256_permute_ps(b23, 0x55)));
+    r23 = _mm256_add_ps(r23, _mm256_mul_ps(a2, _mm256_permute_ps(b23, 0xAA)));
+    r23 = _mm256_add_ps(r23, _mm256_mul_ps(a3, _mm256_permute_ps(b23, 0xFF)));
+
+    float* fo = &out[i][0][0];
+    _mm256_storeu_ps(fo, r01);
+    _mm256_storeu_ps(fo + 8, r23);
+  }
+  //avoids the penalty for switching back to the SSE code around it
+  _mm256_zeroupper();
+}
+
+static void MultiplyAffineAVX(const glm::mat4* a, const unsigned int* a_index, const glm::mat4* b, glm::mat4* out, unsigned int count)
+{
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    const float* fa = &a[a_index ? a_index[i] : i][0][0];
+    const float* fb = &b[i][0][0];
+    __m256 a0 = _mm256_broadcast_ps((const __m128*)fa);
+    __m256 a1 = _mm256_broadcast_ps((const __m128*)(fa + 4));
+    __m256 a2 = _mm256_broadcast_ps((const __m128*)(fa + 8));
+    //a's last column goes into the translation only, which is the upper half of the second pair
+    __m256 a3 = _mm256_insertf128_ps(_mm256_setzero_ps(), _mm_loadu_ps(fa + 12), 1);
+    __m256 b01 = _mm256_loadu_ps(fb);
+    __m256 b23 = _mm256_loadu_ps(fb + 8);
+
+    __m256 r01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+    r01 = _mm256_add_ps(r01, _mm256_mul_ps(a1, _mm256_permute_ps(b01, 0x55)));
+    r01 = _mm256_add_ps(r01, _mm256_mul_ps(a2, _mm256_permute_ps(b01, 0xAA)));
+    __m256 r23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+    r23 = _mm256_add_ps(r23, _mm256_mul_ps(a1, _mm256_permute_ps(b23, 0x55)));
+    r23 = _mm256_add_ps(r23, _mm256_mul_ps(a2, _mm256_permute_ps(b23, 0xAA)));
+    r23 = _mm256_add_ps(r23, a3);
+
+    float* fo = &out[i][0][0];
+    _mm256_storeu_ps(fo, r01);
+    _mm256_storeu_ps(fo + 8, r23);
+  }
+  _mm256_zeroupper();
+}
+
+#pragma endregion
+
+void BatchMultiply(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, unsigned int count)
+{
+  switch(GetBatchMathPath())
+  {
+  case BATCH_MATH_AVX:
+    MultiplyAVX(a, b, out, count);
+    break;
+  case BATCH_MATH_SSE:
+    MultiplySSE(a, b, out, count);
+    break;
+  default:
+    MultiplyScalar(a, b, out, count);
+    break;
+  }
+}
+
+void BatchMultiplyAffine(const glm::mat4* a, const unsigned int* a_index, const glm::mat4* b, glm::mat4* out, unsigned int count)
+{
+  switch(GetBatchMathPath())
+  {
+  case BATCH_MATH_AVX:
+    MultiplyAffineAVX(a, a_index, b, out, count);
+    break;
+  case BATCH_MATH_SSE:
+    MultiplyAffineSSE(a, a_index, b, out, count);
+    break;
+  default:
+    MultiplyAffineScalar(a, a_index, b, out, count);
+    break;
+  }
+}
+
+void BatchTransformPoints(const glm::mat4& m, const glm::vec3* in, glm::vec3* out, unsigned int count)
+{
+  if(GetBatchMathPath() >= BATCH_MATH_SSE)
+    TransformSSE(m, in, out, count, 1.0f);
+  else
+    TransformScalar(m, in, out, count, 1.0f);
+}
+
+void BatchTransformVectors(const glm::mat4& m, const glm::vec3* in, glm::vec3* out, unsigned int count)
+{
+  if(GetBatchMathPath() >= BATCH_MATH_SSE)
+    TransformSSE(m, in, out, count, 0.0f);
+  else
+    TransformScalar(m, in, out, count, 0.0f);
+}
+
+void BatchInverseAffine(const glm::mat4* in, glm::mat4* out, unsigned int count)
+{
+  if(GetBatchMathPath() >= BATCH_MATH_SSE)
+    InverseAffineSSE(in, out, count);
+  else
+    InverseAffineScalar(in, out, count);
+}
+
+void BatchComposeTRS(const glm::vec3* translation, const glm::quat* rotation, const glm::vec3* scale, glm::mat4* out, unsigned int count)
+{
+  if(GetBatchMathPath() >= BATCH_MATH_SSE)
+    ComposeTRSSSE(0, 0, translation, rotation, scale, out, count);
+  else
+    ComposeTRSScalar(0, 0, translation, rotation, scale, out, count);
+}
+
+void BatchComposeTRS(const glm::mat4* parent, const unsigned int* parent_index, const glm::vec3* translation, const glm::quat* rotation, const glm::vec3* scale, glm::mat4* out, unsigned int count)
+{
+  if(GetBatchMathPath() >= BATCH_MATH_SSE)
+    ComposeTRSSSE(parent, parent_index, translation, rotation, scale, out, count);
+  else
+    ComposeTRSScalar(parent, parent_index, translation, rotation, scale, out, count);
+}
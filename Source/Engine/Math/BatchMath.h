@@ -0,0 +1,51 @@
+#pragma once
+//========================================================================
+// BatchMath.h : Matrix and vector kernels that work on whole arrays
+//
+// Each kernel has a plain glm version, which is the reference the others
+// are checked against, an SSE version and, where it pays, an AVX version.
+// The best one the CPU supports is picked the first time a kernel is
+// called.  AVX only helps where the data fits eight lanes without extra
+// shuffling, which is the 4x4 multiplies.  The other kernels use their SSE
+// version when AVX is selected.
+//
+// The arrays dont have to be aligned.  out may be the same array as an
+// input, but may not partly overlap one.
+//========================================================================
+
+#include "3rdParty/glm-0.9.3.4/glm/glm.hpp"
+#include "3rdParty/glm-0.9.3.4/glm/gtc/quaternion.hpp"
+
+enum BatchMathPath
+{
+  BATCH_MATH_SCALAR,
+  BATCH_MATH_SSE,
+  BATCH_MATH_AVX
+};
+
+//the best path this CPU supports
+BatchMathPath BestBatchMathPath();
+//forces a path, for testing and comparing them.  Paths the CPU doesnt support fall back to one it does.
+void SetBatchMathPath(BatchMathPath path);
+BatchMathPath GetBatchMathPath();
+
+//out[i] = a[i] * b[i]
+void BatchMultiply(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, unsigned int count);
+//out[i] = a[a_index[i]] * b[i], or a[i] * b[i] if a_index is NULL.  Both must be affine,
+//the bottom row is taken to be 0 0 0 1.
+void BatchMultiplyAffine(const glm::mat4* a, const unsigned int* a_index, const glm::mat4* b, glm::mat4* out, unsigned int count);
+
+//out[i] = m * (in[i], 1)
+void BatchTransformPoints(const glm::mat4& m, const glm::vec3* in, glm::vec3* out, unsigned int count);
+//out[i] = m * (in[i], 0)
+void BatchTransformVectors(const glm::mat4& m, const glm::vec3* in, glm::vec3* out, unsigned int count);
+
+//inverses of affine matrices
+void BatchInverseAffine(const glm::mat4* in, glm::mat4* out, unsigned int count);
+
+//out[i] = translate(translation[i]) * mat4_cast(rotation[i]) * scale(scale[i])
+void BatchComposeTRS(const glm::vec3* translation, const glm::quat* rotation, const glm::vec3* scale, glm::mat4* out, unsigned int count);
+//out[i] = parent[parent_index[i]] * translate(translation[i]) * mat4_cast(rotation[i]) * scale(scale[i]), with
+//parent affine.  Cheaper than composing and then calling BatchMultiplyAffine().  out may point into the
+//same array as parent, as long as no parent_index[i] is one of the count entries out covers.
+void BatchComposeTRS(const glm::mat4* parent, const unsigned int* parent_index, const glm::vec3* translation, const glm::quat* rotation, const glm::vec3* scale, glm::mat4* out, unsigned int count);
@@ -0,0 +1,132 @@
+#include "EngineStd.h"
+#include "JobSystem.h"
+#include "../Debugging/Logger.h"
+
+JobSystem::JobSystem(int num_threads)
+{
+  _quitting = 0;
+
+  if(num_threads <= 0)
+  {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    num_threads = (int)info.dwNumberOfProcessors - 1;
+  }
+
+  _semaphore = CreateSemaphoreW(NULL, 0, LONG_MAX, NULL);
+  for(int i = 0; i < num_threads; ++i)
+  {
+    HANDLE thread = CreateThread(NULL, 0, ThreadProc, this, 0, NULL);
+    if(thread)
+      _threads.push_back(thread);
+  }
+}
+
+JobSystem::~JobSystem()
+{
+  InterlockedExchange(&_quitting, 1);
+  if(!_threads.empty())
+  {
+    ReleaseSemaphore(_semaphore, (LONG)_threads.size(), NULL);
+    WaitForMultipleObjects((DWORD)_threads.size(), &_threads[0], TRUE, INFINITE);
+  }
+  for(size_t i = 0; i < _threads.size(); ++i)
+    CloseHandle(_threads[i]);
+  CloseHandle(_semaphore);
+}
+
+void JobSystem::ParallelFor(JobFunction function, void* data, unsigned int count, unsigned int grain)
+{
+  if(count == 0)
+    return;
+  grain = std::max(1u, grain);
+
+  //not worth waking anyone for.  The chunks are still the ones the workers would get,
+  //callers keep per chunk results by begin / grain.
+  if(count <= grain || _threads.empty())
+  {
+    RunInline(function, data, count, grain);
+    return;
+  }
+
+  unsigned int num_jobs = (count + grain - 1) / grain;
+  volatile LONG remaining = (LONG)num_jobs;
+  {
+    ScopedCriticalSection lock(_cs);
+    for(unsigned int begin = 0; begin < count; begin += grain)
+    {
+      Job job;
+      job.function = function;
+      job.data = data;
+      job.begin = begin;
+      job.end = std::min(count, begin + grain);
+      job.remaining = &remaining;
+      _jobs.push_back(job);
+    }
+  }
+  //no point waking more workers than there are chunks for them
+  ReleaseSemaphore(_semaphore, (LONG)std::min(num_jobs, (unsigned int)_threads.size()), NULL);
+
+  //help out until the last chunk is finished, which may be another thread's.  The count
+  //is read with an interlocked op so the chunks' writes are seen once it hits zero.
+  while(InterlockedCompareExchange(&remaining, 0, 0) > 0)
+  {
+    if(!RunOne())
+      SwitchToThread();
+  }
+}
+
+bool JobSystem::RunOne()
+{
+  Job job;
+  {
+    ScopedCriticalSection lock(_cs);
+    if(_jobs.empty())
+      return false;
+    job = _jobs.front();
+    _jobs.pop_front();
+  }
+  RunJob(job);
+  return true;
+}
+
+void JobSystem::Run(JobSystem* jobs, JobFunction function, void* data, unsigned int count, unsigned int grain)
+{
+  if(jobs)
+    jobs->ParallelFor(function, data, count, grain);
+  else
+    RunInline(function, data, count, std::max(1u, grain));
+}
+
+void JobSystem::RunInline(JobFunction function, void* data, unsigned int count, unsigned int grain)
+{
+  for(unsigned int begin = 0; begin < count; begin += grain)
+    function(data, begin, std::min(count, begin + grain));
+}
+
+void JobSystem::RunJob(const Job& job)
+{
+  job.function(job.data, job.begin, job.end);
+  //a full barrier, so the job's writes are visible before the count drops
+  InterlockedDecrement(job.remaining);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// A worker drains the queue each time it is woken.  The semaphore can be
+// ahead of the queue when the calling thread took the jobs itself, in
+// which case the worker just finds nothing and goes back to sleep.
+//////////////////////////////////////////////////////////////////////////////
+DWORD WINAPI JobSystem::ThreadProc(void* param)
+{
+  JobSystem* jobs = (JobSystem*)param;
+  for(;;)
+  {
+    WaitForSingleObject(jobs->_semaphore, INFINITE);
+    if(jobs->_quitting)
+      break;
+    while(jobs->RunOne())
+    {
+    }
+  }
+  return 0;
+}
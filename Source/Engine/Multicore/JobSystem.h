@@ -0,0 +1,57 @@
+#pragma once
+//========================================================================
+// JobSystem.h : A pool of worker threads for splitting a frame's work
+//
+// ParallelFor() cuts a range into chunks, queues them for the workers and
+// then works through the queue itself until every chunk is done, so the
+// calling thread is never idle and a job can call ParallelFor() without
+// deadlocking the pool.  The workers sleep on a semaphore when there is
+// nothing queued.
+//
+// Jobs are plain function pointers with a void* for their data, the same
+// as the streamer's callbacks, so queuing one doesnt allocate.
+//========================================================================
+
+#include "CriticalSection.h"
+
+//called for the indices [begin, end) of a ParallelFor()
+typedef void (*JobFunction)(void* data, unsigned int begin, unsigned int end);
+
+class JobSystem : public SOL_noncopyable
+{
+  struct Job
+  {
+    JobFunction function;
+    void* data;
+    unsigned int begin;
+    unsigned int end;
+    volatile LONG* remaining;   //the ParallelFor() this chunk belongs to
+  };
+
+  CriticalSection _cs;
+  std::deque<Job> _jobs;
+  HANDLE _semaphore;    //counts the jobs queued
+  std::vector<HANDLE> _threads;
+  volatile LONG _quitting;
+
+public:
+  //num_threads of 0 uses one per core, less one for the thread calling ParallelFor()
+  explicit JobSystem(int num_threads = 0);
+  ~JobSystem();
+
+  //calls function on [0, count) in chunks of at most grain indices and returns
+  //once all of them have finished
+  void ParallelFor(JobFunction function, void* data, unsigned int count, unsigned int grain);
+  //ParallelFor() on jobs, or the same chunks in turn on the calling thread when jobs is NULL,
+  //so results kept per chunk line up either way
+  static void Run(JobSystem* jobs, JobFunction function, void* data, unsigned int count, unsigned int grain);
+
+  //worker threads plus the calling thread
+  unsigned int NumThreads() const { return (unsigned int)_threads.size() + 1; }
+
+private:
+  bool RunOne();
+  static void RunJob(const Job& job);
+  static void RunInline(JobFunction function, void* data, unsigned int count, unsigned int grain);
+  static DWORD WINAPI ThreadProc(void* param);
+};
@@ -0,0 +1,75 @@
+#pragma once
+//========================================================================
+// MpscQueue.h : Lock free queue for many producer threads and one consumer
+//
+// Push() can be called from any thread and never blocks: it swaps itself
+// in as the new head with one interlocked exchange and then links the old
+// head to it.  Only one thread may call TryPop().  A push that is halfway
+// done hides the pushes after it until it finishes, so the consumer may
+// see the queue as empty for a moment while items are being added.  That
+// is fine for anything drained once a frame.
+//
+// Nodes are linked with interlocked exchanges, which are full barriers, so
+// a node's value is visible before the node is.  The consumer reads next
+// through a volatile, which MSVC gives acquire semantics.
+//========================================================================
+
+#include <windows.h>
+
+template<class T>
+class MpscQueue : public SOL_noncopyable
+{
+  struct Node
+  {
+    Node* volatile next;
+    T value;
+
+    Node() : next(0) {}
+  };
+
+  Node* volatile _head;   //last node pushed, producers swap themselves in here
+  Node* _tail;            //the consumer's dummy node, its next is the oldest item
+
+public:
+  MpscQueue()
+  {
+    _tail = SOL_NEW Node;
+    _head = _tail;
+  }
+
+  ~MpscQueue()
+  {
+    T value;
+    while(TryPop(value))
+    {
+    }
+    delete _tail;
+  }
+
+  void Push(const T& value)
+  {
+    Node* node = SOL_NEW Node;
+    node->value = value;
+    Node* prev = (Node*)InterlockedExchangePointer((void* volatile*)&_head, node);
+    InterlockedExchangePointer((void* volatile*)&prev->next, node);
+  }
+
+  //consumer thread only
+  bool TryPop(T& out_value)
+  {
+    Node* tail = _tail;
+    Node* next = tail->next;
+    if(!next)
+      return false;
+
+    //next becomes the new dummy, so its value is moved out and cleared
+    out_value = next->value;
+    next->value = T();
+    _tail = next;
+    delete tail;
+    return true;
+  }
+
+  //consumer thread only
+  bool Empty() const { return _tail->next == 0; }
+};
@@ -0,0 +1,121 @@
+#pragma once
+//========================================================================
+// ParallelRadixSort.h : Sorts integer keys with the job system
+//
+// A least significant digit first radix sort, 8 bits of the key a pass.
+// Each pass counts the digits in every job's chunk of keys, turns the
+// counts into where each chunk writes each digit, then has every chunk
+// scatter its keys.  Chunks write in order within a digit, so each pass
+// keeps the order of the last and the sort is stable.  A digit that is
+// the same in every key would only copy the keys across unchanged, so
+// that pass is skipped.
+//
+// Each key carries the index of what it belongs to, so the caller can
+// gather its own data into key order afterwards.  The chunks are the same
+// with or without a job system.
+//========================================================================
+
+#include "JobSystem.h"
+
+template<class Key>
+class ParallelRadixSort : public SOL_noncopyable
+{
+  enum { RADIX_BITS = 8, RADIX_SIZE = 1 << RADIX_BITS };
+
+  unsigned int _grain;
+  std::vector<Key> _keys[2];                  //the passes ping pong between the two
+  std::vector<unsigned int> _order[2];        //each key's index
+  unsigned int _source;
+  unsigned int _shift;
+  std::vector<unsigned int> _chunk_offsets;   //RADIX_SIZE per job
+
+public:
+  //grain keys per job
+  explicit ParallelRadixSort(unsigned int grain) : _grain(grain), _source(0), _shift(0) {}
+
+  //makes room for count keys.  Only grows, so sorting doesnt allocate once it is big enough.
+  void Reserve(unsigned int count)
+  {
+    if(_keys[0].size() >= count)
+      return;
+    for(int i = 0; i < 2; ++i)
+    {
+      _keys[i].resize(count);
+      _order[i].resize(count);
+    }
+  }
+
+  //filled in before Sort(), each key next to the index of what it belongs to
+  Key* Keys() { return &_keys[0][0]; }
+  unsigned int* Order() { return &_order[0][0]; }
+
+  //sorts the first count keys on their low key_bits bits
+  void Sort(JobSystem* jobs, unsigned int count, unsigned int key_bits)
+  {
+    _source = 0;
+    if(count == 0)
+      return;
+
+    unsigned int num_chunks = (count + _grain - 1) / _grain;
+    _chunk_offsets.resize(num_chunks * RADIX_SIZE);
+    for(_shift = 0; _shift < key_bits; _shift += RADIX_BITS)
+    {
+      JobSystem::Run(jobs, HistogramRange, this, count, _grain);
+
+      //every chunk's 0s come first, then every chunk's 1s, and so on
+      unsigned int offset = 0;
+      bool all_same = false;
+      for(unsigned int digit = 0; digit < RADIX_SIZE; ++digit)
+      {
+        unsigned int start = offset;
+        for(unsigned int chunk = 0; chunk < num_chunks; ++chunk)
+        {
+          unsigned int& chunk_offset = _chunk_offsets[chunk * RADIX_SIZE + digit];
+          unsigned int digit_count = chunk_offset;
+          chunk_offset = offset;
+          offset += digit_count;
+        }
+        if(offset - start == count)
+          all_same = true;
+      }
+      if(all_same)
+        continue;
+
+      JobSystem::Run(jobs, ScatterRange, this, count, _grain);
+      _source = 1 - _source;
+    }
+  }
+
+  //valid after Sort()
+  const Key* SortedKeys() const { return &_keys[_source][0]; }
+  const unsigned int* SortedOrder() const { return &_order[_source][0]; }
+
+private:
+  static void HistogramRange(void* data, unsigned int begin, unsigned int end)
+  {
+    ParallelRadixSort* sort = (ParallelRadixSort*)data;
+    const Key* keys = &sort->_keys[sort->_source][0];
+    unsigned int shift = sort->_shift;
+    unsigned int* counts = &sort->_chunk_offsets[(begin / sort->_grain) * RADIX_SIZE];
+    memset(counts, 0, RADIX_SIZE * sizeof(unsigned int));
+    for(unsigned int i = begin; i < end; ++i)
+      ++counts[(unsigned int)(keys[i] >> shift) & (RADIX_SIZE - 1)];
+  }
+
+  static void ScatterRange(void* data, unsigned int begin, unsigned int end)
+  {
+    ParallelRadixSort* sort = (ParallelRadixSort*)data;
+    const Key* keys = &sort->_keys[sort->_source][0];
+    const unsigned int* order = &sort->_order[sort->_source][0];
+    Key* sorted_keys = &sort->_keys[1 - sort->_source][0];
+    unsigned int* sorted_order = &sort->_order[1 - sort->_source][0];
+    unsigned int shift = sort->_shift;
+    unsigned int* offsets = &sort->_chunk_offsets[(begin / sort->_grain) * RADIX_SIZE];
+    for(unsigned int i = begin; i < end; ++i)
+    {
+      unsigned int to = offsets[(unsigned int)(keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+      sorted_keys[to] = keys[i];
+      sorted_order[to] = order[i];
+    }
+  }
+};
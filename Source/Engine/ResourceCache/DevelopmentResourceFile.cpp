@@ -0,0 +1,126 @@
+#include "EngineStd.h"
+#include "DevelopmentResourceFile.h"
+#include "Resource.h"
+#include "../Utility/String.h"
+#include "../Utility/WildcardPattern.h"
+#include "../Debugging/Logger.h"
+
+DevelopmentResourceFile::DevelopmentResourceFile(const std::wstring& directory)
+{
+  _directory = directory;
+}
+
+bool DevelopmentResourceFile::Open()
+{
+  _files.clear();
+  _index.clear();
+  if(!AddDirectory(_directory, L""))
+    return false;
+  for(size_t i = 0; i < _files.size(); ++i)
+    _index[_files[i].name] = (int)i;
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// walks the directory the way PackBuilder::AddDirectory does, so the names
+// come out the same as they would in a pack built from it
+//////////////////////////////////////////////////////////////////////////////
+bool DevelopmentResourceFile::AddDirectory(const std::wstring& directory, const std::wstring& prefix)
+{
+  WIN32_FIND_DATAW find_data;
+  HANDLE find = FindFirstFileW((directory + L"\\*").c_str(), &find_data);
+  if(find == INVALID_HANDLE_VALUE)
+  {
+    SOL_ERROR("Could not read directory " + ws2s(directory));
+    return false;
+  }
+
+  bool success = true;
+  do
+  {
+    std::wstring file_name = find_data.cFileName;
+    if(file_name == L"." || file_name == L"..")
+      continue;
+
+    std::wstring path = directory + L"\\" + file_name;
+    if(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+    {
+      success = AddDirectory(path, prefix + file_name + L"/") && success;
+    }
+    else if(find_data.nFileSizeHigh == 0)
+    {
+      File file;
+      file.name = Resource(ws2s(prefix + file_name)).Name();
+      file.path = path;
+      file.size = find_data.nFileSizeLow;
+      _files.push_back(file);
+    }
+  } while(FindNextFileW(find, &find_data));
+
+  FindClose(find);
+  return success;
+}
+
+int DevelopmentResourceFile::Find(const Resource& r) const
+{
+  FileMap::const_iterator it = _index.find(r.Name());
+  return it == _index.end() ? -1 : it->second;
+}
+
+int DevelopmentResourceFile::RawResourceSize(const Resource& r)
+{
+  int num = Find(r);
+  return num == -1 ? -1 : (int)_files[num].size;
+}
+
+int DevelopmentResourceFile::RawResource(const Resource& r, char* buffer)
+{
+  int num = Find(r);
+  if(num == -1)
+    return -1;
+
+  const File& file = _files[num];
+  HANDLE handle = CreateFileW(file.path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if(handle == INVALID_HANDLE_VALUE)
+    return -1;
+  DWORD read = 0;
+  BOOL success = file.size == 0 || ReadFile(handle, buffer, file.size, &read, NULL);
+  CloseHandle(handle);
+  return success && read == file.size ? (int)file.size : -1;
+}
+
+const char* DevelopmentResourceFile::MappedResource(const Resource& r, int& out_size)
+{
+  out_size = 0;
+  return 0;
+}
+
+//the read in RawResource() is all there is, there is nothing to get ahead of
+bool DevelopmentResourceFile::PrefetchResource(const Resource& r)
+{
+  return Find(r) != -1;
+}
+
+std::string DevelopmentResourceFile::ResourceName(int num) const
+{
+  if(num < 0 || num >= (int)_files.size())
+    return std::string();
+  return _files[num].name;
+}
+
+int DevelopmentResourceFile::MatchResources(const WildcardPattern& pattern, std::vector<int>& out_nums) const
+{
+  WildcardPattern folded(pattern);
+  folded.NormalizePath();
+
+  int matched = 0;
+  for(size_t i = 0; i < _files.size(); ++i)
+  {
+    if(folded.Match(_files[i].name.c_str(), _files[i].name.size()))
+    {
+      out_nums.push_back((int)i);
+      ++matched;
+    }
+  }
+  return matched;
+}
@@ -0,0 +1,44 @@
+#pragma once
+//========================================================================
+// DevelopmentResourceFile.h : IResourceFile over loose files on disk
+//
+// Serves the files under a directory as resources, named by their path
+// under it the same way PackTool names them in a pack, so the game runs
+// the same with or without one.  The directory is walked once in Open(),
+// after that every read opens the file and reads it whole.  Nothing is
+// ever mapped, so the cache copies every resource.
+//
+// Only the walk in Open() changes anything, the rest can be called from
+// the streamer's threads.
+//========================================================================
+
+class DevelopmentResourceFile : public IResourceFile
+{
+  struct File
+  {
+    std::string name;     //lower cased with / separators, like Resource names
+    std::wstring path;
+    unsigned int size;
+  };
+  typedef std::tr1::unordered_map<std::string, int> FileMap;
+
+  std::wstring _directory;
+  std::vector<File> _files;
+  FileMap _index;         //name to its number in _files
+
+public:
+  DevelopmentResourceFile(const std::wstring& directory);
+
+  virtual bool Open();
+  virtual int RawResourceSize(const Resource& r);
+  virtual int RawResource(const Resource& r, char* buffer);
+  virtual const char* MappedResource(const Resource& r, int& out_size);
+  virtual bool PrefetchResource(const Resource& r);
+  virtual int NumResources() const { return (int)_files.size(); }
+  virtual std::string ResourceName(int num) const;
+  virtual int MatchResources(const WildcardPattern& pattern, std::vector<int>& out_nums) const;
+
+private:
+  bool AddDirectory(const std::wstring& directory, const std::wstring& prefix);
+  int Find(const Resource& r) const;
+};
@@ -0,0 +1,463 @@
+#include "EngineStd.h"
+#include "PackBuilder.h"
+#include "ZipDeflate.h"
+#include "Resource.h"
+#include "../Debugging/Logger.h"
+#include "../Utility/String.h"
+
+#pragma region Zip Records
+
+static const unsigned int ZIP_LOCAL_HEADER_SIG = 0x04034b50;
+static const unsigned int ZIP_CENTRAL_HEADER_SIG = 0x02014b50;
+static const unsigned int ZIP_END_OF_DIR_SIG = 0x06054b50;
+static const size_t ZIP_LOCAL_HEADER_SIZE = 30;
+
+static const unsigned short ZIP_VERSION = 20;
+static const unsigned short ZIP_FLAG_UTF8_NAMES = 0x0800;
+static const unsigned short ZIP_STORED = 0;
+static const unsigned short ZIP_DEFLATED = 8;
+//every entry gets 1980-01-01 00:00 so building the same files twice gives the same archive
+static const unsigned short ZIP_DOS_TIME = 0;
+static const unsigned short ZIP_DOS_DATE = (1 << 5) | 1;
+
+static const unsigned int ZIP_MAX_ENTRIES = 0xffff;
+
+static void PutU16(std::string& out, unsigned short value)
+{
+  out += (char)(value & 0xff);
+  out += (char)(value >> 8);
+}
+
+static void PutU32(std::string& out, unsigned int value)
+{
+  PutU16(out, (unsigned short)(value & 0xffff));
+  PutU16(out, (unsigned short)(value >> 16));
+}
+
+static unsigned int Crc32(const void* data, size_t size)
+{
+  static unsigned int table[256];
+  static bool table_built = false;
+  if(!table_built)
+  {
+    for(unsigned int i = 0; i < 256; ++i)
+    {
+      unsigned int c = i;
+      for(int k = 0; k < 8; ++k)
+        c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+      table[i] = c;
+    }
+    table_built = true;
+  }
+
+  const unsigned char* p = (const unsigned char*)data;
+  unsigned int crc = 0xffffffff;
+  for(size_t i = 0; i < size; ++i)
+    crc = table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+  return crc ^ 0xffffffff;
+}
+
+//FNV-1a, only used to find candidates for deduplication.  Matches are always compared byte for byte.
+static unsigned long long ContentHash(const void* data, size_t size)
+{
+  const unsigned char* p = (const unsigned char*)data;
+  unsigned long long hash = 14695981039346656037ULL;
+  for(size_t i = 0; i < size; ++i)
+  {
+    hash ^= p[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+static bool ReadWholeFile(const std::wstring& path, std::vector<char>& out_data)
+{
+  out_data.clear();
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if(file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size;
+  bool success = GetFileSizeEx(file, &size) && size.QuadPart < 0xffffffff;
+  if(success && size.QuadPart > 0)
+  {
+    out_data.resize((size_t)size.QuadPart);
+    DWORD read = 0;
+    success = ReadFile(file, &out_data[0], (DWORD)out_data.size(), &read, NULL) && read == out_data.size();
+  }
+  CloseHandle(file);
+  return success;
+}
+
+//appends to the archive and keeps track of where it is.  The archive is deleted again
+//unless Finish() is called and everything was written, so a failed build leaves nothing behind.
+class PackWriter
+{
+  HANDLE _file;
+  std::wstring _file_name;
+  unsigned long long _offset;
+  bool _failed;
+
+public:
+  PackWriter() : _file(INVALID_HANDLE_VALUE), _offset(0), _failed(false) {}
+  ~PackWriter()
+  {
+    if(_file != INVALID_HANDLE_VALUE)
+    {
+      Close();
+      DeleteFileW(_file_name.c_str());
+    }
+  }
+
+  bool Open(const std::wstring& file_name)
+  {
+    _file_name = file_name;
+    _file = CreateFileW(file_name.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    return _file != INVALID_HANDLE_VALUE;
+  }
+
+  //false if a write failed, and the archive is gone
+  bool Finish()
+  {
+    Close();
+    if(_failed)
+      DeleteFileW(_file_name.c_str());
+    return !_failed;
+  }
+
+  void Write(const void* data, size_t size)
+  {
+    DWORD written = 0;
+    if(size && (!WriteFile(_file, data, (DWORD)size, &written, NULL) || written != size))
+      _failed = true;
+    _offset += size;
+  }
+
+  void Write(const std::string& data) { Write(data.data(), data.size()); }
+
+  unsigned long long Offset() const { return _offset; }
+
+private:
+  void Close()
+  {
+    if(_file != INVALID_HANDLE_VALUE)
+      CloseHandle(_file);
+    _file = INVALID_HANDLE_VALUE;
+  }
+};
+
+#pragma endregion
+
+#pragma region PackBuilder
+
+PackBuilder::PackBuilder()
+{
+  _default_compression = PACK_DEFLATE;
+  _min_savings = 0.1f;
+
+  //formats that are already compressed dont get any smaller
+  const char* compressed[] = { "png", "jpg", "jpeg", "ogg", "mp3", "zip", "gz" };
+  for(size_t i = 0; i < sizeof(compressed) / sizeof(compressed[0]); ++i)
+    _compression[compressed[i]] = PACK_STORE;
+}
+
+bool PackBuilder::AddDirectory(const std::wstring& directory)
+{
+  return AddDirectory(directory, L"");
+}
+
+bool PackBuilder::AddDirectory(const std::wstring& directory, const std::wstring& prefix)
+{
+  WIN32_FIND_DATAW find_data;
+  HANDLE find = FindFirstFileW((directory + L"\\*").c_str(), &find_data);
+  if(find == INVALID_HANDLE_VALUE)
+  {
+    SOL_ERROR("Could not read directory " + ws2s(directory));
+    return false;
+  }
+
+  bool success = true;
+  do
+  {
+    std::wstring file_name = find_data.cFileName;
+    if(file_name == L"." || file_name == L"..")
+      continue;
+
+    std::wstring path = directory + L"\\" + file_name;
+    if(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+      success = AddDirectory(path, prefix + file_name + L"/") && success;
+    else
+      AddFile(ws2s(prefix + file_name), path);
+  } while(FindNextFileW(find, &find_data));
+
+  FindClose(find);
+  return success;
+}
+
+void PackBuilder::AddFile(const std::string& name, const std::wstring& path)
+{
+  SourceFile file;
+  file.name = Resource(name).Name();
+  file.path = path;
+  _files.push_back(file);
+}
+
+void PackBuilder::SetCompression(const std::string& extension, PackCompression compression)
+{
+  _compression[Resource(extension).Name()] = compression;
+}
+
+PackCompression PackBuilder::CompressionFor(const std::string& name) const
+{
+  size_t dot = name.rfind('.');
+  if(dot == std::string::npos || name.find('/', dot) != std::string::npos)
+    return _default_compression;
+  std::map<std::string, PackCompression>::const_iterator it = _compression.find(name.substr(dot + 1));
+  return it == _compression.end() ? _default_compression : it->second;
+}
+
+bool PackBuilder::LoadOrder(const std::wstring& file_name)
+{
+  std::vector<char> text;
+  if(!ReadWholeFile(file_name, text))
+  {
+    SOL_ERROR("Could not read load order " + ws2s(file_name));
+    return false;
+  }
+
+  _load_order.clear();
+  std::string line;
+  for(size_t i = 0; i <= text.size(); ++i)
+  {
+    if(i == text.size() || text[i] == '\n' || text[i] == '\r')
+    {
+      if(!line.empty())
+        _load_order.push_back(Resource(line).Name());
+      line.clear();
+    }
+    else
+    {
+      line += text[i];
+    }
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Files the load order names come first, in the order they were first
+// loaded, then everything else by name.
+//////////////////////////////////////////////////////////////////////////////
+void PackBuilder::SortFiles()
+{
+  std::map<std::string, size_t> first_load;
+  for(size_t i = 0; i < _load_order.size(); ++i)
+    first_load.insert(std::make_pair(_load_order[i], i));
+
+  std::vector<std::pair<std::pair<size_t, std::string>, size_t> > keys(_files.size());
+  for(size_t i = 0; i < _files.size(); ++i)
+  {
+    std::map<std::string, size_t>::iterator it = first_load.find(_files[i].name);
+    size_t order = it == first_load.end() ? _load_order.size() : it->second;
+    keys[i] = std::make_pair(std::make_pair(order, _files[i].name), i);
+  }
+  std::sort(keys.begin(), keys.end());
+
+  SourceFiles sorted;
+  sorted.reserve(_files.size());
+  for(size_t i = 0; i < keys.size(); ++i)
+  {
+    if(keys[i].first.first < _load_order.size())
+      ++_stats.in_load_order;
+    sorted.push_back(_files[keys[i].second]);
+  }
+  _files.swap(sorted);
+}
+
+bool PackBuilder::Build(const std::wstring& archive_name)
+{
+  //one per distinct file contents
+  struct Blob
+  {
+    std::wstring path;  //to compare against when another file hashes the same
+    unsigned int size;
+    unsigned int packed_size;
+    unsigned int crc;
+    unsigned int offset;
+    unsigned short method;
+  };
+  //one per name in the central directory
+  struct DirectoryEntry
+  {
+    std::string name;
+    size_t blob;
+  };
+
+  _stats = PackBuilderStats();
+  SortFiles();
+
+  PackWriter writer;
+  if(!writer.Open(archive_name))
+  {
+    SOL_ERROR("Could not create " + ws2s(archive_name));
+    return false;
+  }
+
+  std::vector<Blob> blobs;
+  std::multimap<unsigned long long, size_t> blobs_by_hash;
+  std::vector<DirectoryEntry> directory;
+  std::set<std::string> names;
+  std::vector<char> data;
+  std::vector<char> other;
+  std::vector<char> packed;
+
+  for(size_t i = 0; i < _files.size(); ++i)
+  {
+    const SourceFile& file = _files[i];
+    if(!names.insert(file.name).second)
+    {
+      SOL_WARNING("Skipping second file named " + file.name);
+      continue;
+    }
+    if(directory.size() == ZIP_MAX_ENTRIES)
+    {
+      SOL_ERROR("Too many files for a zip archive");
+      return false;
+    }
+    if(!ReadWholeFile(file.path, data))
+    {
+      SOL_ERROR("Could not read " + ws2s(file.path));
+      return false;
+    }
+
+    ++_stats.files;
+    _stats.raw_bytes += data.size();
+    const char* bytes = data.empty() ? "" : &data[0];
+    unsigned long long hash = ContentHash(bytes, data.size());
+
+    DirectoryEntry entry;
+    entry.name = file.name;
+    entry.blob = blobs.size();
+
+    typedef std::multimap<unsigned long long, size_t>::iterator HashIterator;
+    std::pair<HashIterator, HashIterator> candidates = blobs_by_hash.equal_range(hash);
+    for(HashIterator it = candidates.first; it != candidates.second; ++it)
+    {
+      const Blob& blob = blobs[it->second];
+      if(blob.size == data.size() && ReadWholeFile(blob.path, other) && other == data)
+      {
+        entry.blob = it->second;
+        break;
+      }
+    }
+    directory.push_back(entry);
+    if(entry.blob != blobs.size())
+    {
+      ++_stats.duplicates;
+      continue;
+    }
+
+    Blob blob;
+    blob.path = file.path;
+    blob.size = (unsigned int)data.size();
+    blob.crc = Crc32(bytes, data.size());
+    blob.method = ZIP_STORED;
+    blob.packed_size = blob.size;
+    const char* payload = bytes;
+
+    if(CompressionFor(file.name) == PACK_DEFLATE && blob.size > 0)
+    {
+      packed.resize(ZipDeflateBound(blob.size));
+      unsigned int packed_size = ZipDeflate(bytes, blob.size, &packed[0], (unsigned int)packed.size());
+      if(packed_size && packed_size <= blob.size - (unsigned int)(blob.size * _min_savings))
+      {
+        blob.method = ZIP_DEFLATED;
+        blob.packed_size = packed_size;
+        payload = &packed[0];
+      }
+    }
+    if(blob.method == ZIP_DEFLATED)
+      ++_stats.deflated;
+    else
+      ++_stats.stored;
+
+    if(writer.Offset() + ZIP_LOCAL_HEADER_SIZE + file.name.size() + blob.packed_size >= 0xffffffffULL)
+    {
+      SOL_ERROR("Archive is too big for a zip file without zip64");
+      return false;
+    }
+    blob.offset = (unsigned int)writer.Offset();
+
+    std::string header;
+    PutU32(header, ZIP_LOCAL_HEADER_SIG);
+    PutU16(header, ZIP_VERSION);
+    PutU16(header, ZIP_FLAG_UTF8_NAMES);
+    PutU16(header, blob.method);
+    PutU16(header, ZIP_DOS_TIME);
+    PutU16(header, ZIP_DOS_DATE);
+    PutU32(header, blob.crc);
+    PutU32(header, blob.packed_size);
+    PutU32(header, blob.size);
+    PutU16(header, (unsigned short)file.name.size());
+    PutU16(header, 0);
+    header += file.name;
+    writer.Write(header);
+    writer.Write(payload, blob.packed_size);
+    _stats.packed_bytes += blob.packed_size;
+
+    blobs.push_back(blob);
+    blobs_by_hash.insert(std::make_pair(hash, blobs.size() - 1));
+  }
+
+  //the central directory, names that share contents all point at the same local header
+  unsigned long long directory_offset = writer.Offset();
+  std::string records;
+  for(size_t i = 0; i < directory.size(); ++i)
+  {
+    const DirectoryEntry& entry = directory[i];
+    const Blob& blob = blobs[entry.blob];
+    PutU32(records, ZIP_CENTRAL_HEADER_SIG);
+    PutU16(records, ZIP_VERSION);
+    PutU16(records, ZIP_VERSION);
+    PutU16(records, ZIP_FLAG_UTF8_NAMES);
+    PutU16(records, blob.method);
+    PutU16(records, ZIP_DOS_TIME);
+    PutU16(records, ZIP_DOS_DATE);
+    PutU32(records, blob.crc);
+    PutU32(records, blob.packed_size);
+    PutU32(records, blob.size);
+    PutU16(records, (unsigned short)entry.name.size());
+    PutU16(records, 0);   //extra field
+    PutU16(records, 0);   //comment
+    PutU16(records, 0);   //disk
+    PutU16(records, 0);   //internal attributes
+    PutU32(records, 0);   //external attributes
+    PutU32(records, blob.offset);
+    records += entry.name;
+  }
+  if(directory_offset + records.size() >= 0xffffffffULL)
+  {
+    SOL_ERROR("Archive is too big for a zip file without zip64");
+    return false;
+  }
+  writer.Write(records);
+
+  std::string end;
+  PutU32(end, ZIP_END_OF_DIR_SIG);
+  PutU16(end, 0);
+  PutU16(end, 0);
+  PutU16(end, (unsigned short)directory.size());
+  PutU16(end, (unsigned short)directory.size());
+  PutU32(end, (unsigned int)records.size());
+  PutU32(end, (unsigned int)directory_offset);
+  PutU16(end, 0);
+  writer.Write(end);
+
+  if(!writer.Finish())
+  {
+    SOL_ERROR("Could not write " + ws2s(archive_name));
+    return false;
+  }
+  return true;
+}
+
+#pragma endregion
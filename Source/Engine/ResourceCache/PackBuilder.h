@@ -0,0 +1,79 @@
+#pragma once
+//========================================================================
+// PackBuilder.h : Builds the zip archive the ResourceCache reads from
+//
+// Files are named the way Resource names them, lower case with /
+// between directories.  Files with identical contents are written once
+// and every name for them points at that one copy.  ZipFile reads that
+// fine, but some zip tools refuse archives whose entries share data.
+// Each extension can be stored or deflated, and a deflated file that
+// barely shrinks is stored instead, since stored resources are used
+// straight from the mapped archive.
+//
+// The archive is written in the order the game loads from it, taken from
+// a load order file saved by ResourceCache::SaveLoadOrder() during a real
+// level load.  A cold start then reads the archive front to back instead
+// of seeking all over it.  Files the recording never saw go after, in
+// name order.
+//========================================================================
+
+#include "../Utility/String.h"
+
+enum PackCompression
+{
+  PACK_STORE,
+  PACK_DEFLATE
+};
+
+struct PackBuilderStats
+{
+  unsigned int files;
+  unsigned int duplicates;        //files that shared another file's contents
+  unsigned int stored;
+  unsigned int deflated;
+  unsigned int in_load_order;     //files placed by the load order
+  unsigned long long raw_bytes;   //total size of every file added
+  unsigned long long packed_bytes;//file data written to the archive
+
+  PackBuilderStats() : files(0), duplicates(0), stored(0), deflated(0), in_load_order(0), raw_bytes(0), packed_bytes(0) {}
+};
+
+class PackBuilder : public SOL_noncopyable
+{
+  struct SourceFile
+  {
+    std::string name;
+    std::wstring path;
+  };
+  typedef std::vector<SourceFile> SourceFiles;
+
+  SourceFiles _files;
+  std::map<std::string, PackCompression> _compression;  //by extension, without the dot
+  PackCompression _default_compression;
+  float _min_savings;
+  StringVec _load_order;
+  PackBuilderStats _stats;
+
+public:
+  PackBuilder();
+
+  //adds every file under directory, named by its path relative to directory
+  bool AddDirectory(const std::wstring& directory);
+  void AddFile(const std::string& name, const std::wstring& path);
+
+  //extension is without the dot, like "png"
+  void SetCompression(const std::string& extension, PackCompression compression);
+  void SetDefaultCompression(PackCompression compression) { _default_compression = compression; }
+  //a deflated file is stored unless it comes out at least this fraction smaller
+  void SetMinSavings(float fraction) { _min_savings = fraction; }
+
+  bool LoadOrder(const std::wstring& file_name);
+
+  bool Build(const std::wstring& archive_name);
+  const PackBuilderStats& Stats() const { return _stats; }
+
+private:
+  bool AddDirectory(const std::wstring& directory, const std::wstring& prefix);
+  PackCompression CompressionFor(const std::string& name) const;
+  void SortFiles();
+};
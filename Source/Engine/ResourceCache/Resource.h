@@ -0,0 +1,27 @@
+#pragma once
+//========================================================================
+// Resource.h : Names a resource inside a resource file
+//========================================================================
+
+//////////////////////////////////////////////////////////////////////////////
+// Resource names are case insensitive and always use / between directories,
+// so the name is stored lower cased with any \ turned into /.
+//////////////////////////////////////////////////////////////////////////////
+class Resource
+{
+  std::string _name;
+
+public:
+  Resource(const std::string& name) : _name(name)
+  {
+    for(std::string::iterator it = _name.begin(); it != _name.end(); ++it)
+    {
+      if(*it == '\\')
+        *it = '/';
+      else if(*it >= 'A' && *it <= 'Z')
+        *it = *it - 'A' + 'a';
+    }
+  }
+
+  const std::string& Name() const { return _name; }
+};
@@ -0,0 +1,395 @@
+#include "EngineStd.h"
+#include "ResourceCache.h"
+#include "../Debugging/Logger.h"
+#include "../Utility/String.h"
+
+#pragma region ResHandle
+
+ResHandle::ResHandle(const Resource& resource, char* buffer, const char* data, unsigned int size, ResourceCache* cache)
+  : _resource(resource)
+{
+  _buffer = buffer;
+  _data = data;
+  _size = size;
+  _cache = cache;
+  _lru_prev = 0;
+  _lru_next = 0;
+}
+
+ResHandle::~ResHandle()
+{
+  if(_cache)
+    _cache->MemoryHasBeenFreed(AllocatedSize());
+  delete[] _buffer;
+}
+
+#pragma endregion
+
+#pragma region ResourceCache
+
+ResourceCache::ResourceCache(unsigned int size_in_mb, IResourceFile* file)
+{
+  _cache_size = (size_t)size_in_mb * 1024 * 1024;
+  _allocated = 0;
+  _file = file;
+  _lru_head = 0;
+  _lru_tail = 0;
+  _record_load_order = false;
+}
+
+ResourceCache::~ResourceCache()
+{
+  Flush();
+  delete _file;
+}
+
+bool ResourceCache::Init()
+{
+  if(!_file->Open())
+    return false;
+  RegisterLoader(shared_ptr<IResourceLoader>(SOL_NEW DefaultResourceLoader()));
+  return true;
+}
+
+void ResourceCache::RegisterLoader(shared_ptr<IResourceLoader> loader)
+{
+  Loader entry;
+  entry.loader = loader;
+  entry.pattern.Compile(loader->Pattern().c_str());
+  _resource_loaders.push_front(entry);
+}
+
+shared_ptr<ResHandle> ResourceCache::Handle(const Resource& r)
+{
+  ResHandleMap::iterator it = _resources.find(r.Name());
+  if(it != _resources.end())
+  {
+    ++_stats.hits;
+    Touch(it->second.get());
+    return it->second;
+  }
+
+  ++_stats.misses;
+  shared_ptr<ResHandle> handle = Load(r);
+  if(!handle)
+    ++_stats.load_failures;
+  else
+    RecordLoad(r.Name());
+  return handle;
+}
+
+shared_ptr<ResHandle> ResourceCache::Find(const Resource& r)
+{
+  ResHandleMap::iterator it = _resources.find(r.Name());
+  if(it == _resources.end())
+    return shared_ptr<ResHandle>();
+  return it->second;
+}
+
+shared_ptr<ResHandle> ResourceCache::Lookup(const Resource& r)
+{
+  ResHandleMap::iterator it = _resources.find(r.Name());
+  if(it == _resources.end())
+    return shared_ptr<ResHandle>();
+  ++_stats.hits;
+  Touch(it->second.get());
+  return it->second;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Handles built on another thread dont count against the budget until they
+// get here, so room is made for them now rather than before the load.
+//////////////////////////////////////////////////////////////////////////////
+shared_ptr<ResHandle> ResourceCache::Adopt(shared_ptr<ResHandle> handle)
+{
+  ResHandleMap::iterator it = _resources.find(handle->Name());
+  if(it != _resources.end())
+  {
+    Touch(it->second.get());
+    return it->second;
+  }
+
+  ++_stats.misses;
+  if(!MakeRoom(handle->AllocatedSize()))
+  {
+    ++_stats.load_failures;
+    return shared_ptr<ResHandle>();
+  }
+  handle->_cache = this;
+  _allocated += handle->AllocatedSize();
+  Insert(handle);
+  RecordLoad(handle->Name());
+  return handle;
+}
+
+IResourceLoader* ResourceCache::FindLoader(const Resource& r)
+{
+  for(ResourceLoaders::iterator it = _resource_loaders.begin(); it != _resource_loaders.end(); ++it)
+  {
+    if(it->pattern.Match(r.Name().c_str(), r.Name().size()))
+      return it->loader.get();
+  }
+  return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Raw resources that are stored uncompressed are used straight from the
+// resource file's mapping and cost nothing against the budget.  Everything
+// else is copied or inflated into memory the cache allocates.
+//////////////////////////////////////////////////////////////////////////////
+shared_ptr<ResHandle> ResourceCache::Load(const Resource& r)
+{
+  IResourceLoader* loader = FindLoader(r);
+  if(!loader)
+  {
+    SOL_ERROR("Default resource loader not found!");
+    return shared_ptr<ResHandle>();
+  }
+
+  int mapped_size = 0;
+  const char* mapped = 0;
+  if(!loader->AddNullZero() && loader->DiscardRawBufferAfterLoad())
+    mapped = _file->MappedResource(r, mapped_size);
+
+  shared_ptr<ResHandle> handle;
+  if(loader->UseRawFile() && mapped)
+  {
+    handle = shared_ptr<ResHandle>(SOL_NEW ResHandle(r, 0, mapped, mapped_size, this));
+    Insert(handle);
+    return handle;
+  }
+
+  //an empty resource still gets a handle, of zero size
+  int stored_size = mapped ? mapped_size : _file->RawResourceSize(r);
+  if(stored_size < 0)
+    return handle;
+  unsigned int raw_size = (unsigned int)stored_size;
+
+  char* raw_buffer = const_cast<char*>(mapped);
+  if(!raw_buffer)
+  {
+    unsigned int alloc_size = raw_size + (loader->AddNullZero() ? 1 : 0);
+    raw_buffer = loader->UseRawFile() ? Allocate(alloc_size) : SOL_NEW char[alloc_size];
+    if(!raw_buffer)
+      return handle;
+    if(loader->AddNullZero())
+      raw_buffer[raw_size] = '\0';
+    if(_file->RawResource(r, raw_buffer) != stored_size)
+    {
+      if(loader->UseRawFile())
+        MemoryHasBeenFreed(alloc_size);
+      delete[] raw_buffer;
+      return handle;
+    }
+  }
+
+  if(loader->UseRawFile())
+  {
+    //the null zero isnt part of the resource, but it is part of the allocation
+    handle = shared_ptr<ResHandle>(SOL_NEW ResHandle(r, raw_buffer, raw_buffer, raw_size, this));
+    if(loader->AddNullZero())
+      MemoryHasBeenFreed(1);
+  }
+  else
+  {
+    unsigned int size = loader->LoadedResourceSize(raw_buffer, raw_size);
+    char* buffer = Allocate(size);
+    if(!buffer)
+    {
+      if(raw_buffer != mapped)
+        delete[] raw_buffer;
+      return handle;
+    }
+    handle = shared_ptr<ResHandle>(SOL_NEW ResHandle(r, buffer, buffer, size, this));
+    bool success = loader->LoadResource(raw_buffer, raw_size, handle);
+    if(raw_buffer != mapped && loader->DiscardRawBufferAfterLoad())
+      delete[] raw_buffer;
+    if(!success)
+      return shared_ptr<ResHandle>();
+  }
+
+  Insert(handle);
+  return handle;
+}
+
+int ResourceCache::Preload(const std::string& pattern, void (*progress)(int, bool&))
+{
+  if(!_file)
+    return 0;
+
+  std::vector<int> matches;
+  _file->MatchResources(WildcardPattern(pattern.c_str()), matches);
+
+  int loaded = 0;
+  for(size_t i = 0; i < matches.size(); ++i)
+  {
+    Resource resource(_file->ResourceName(matches[i]));
+    if(Handle(resource))
+      ++loaded;
+
+    if(progress)
+    {
+      bool cancel = false;
+      progress((int)i, cancel);
+      if(cancel)
+        break;
+    }
+  }
+  return loaded;
+}
+
+void ResourceCache::Flush()
+{
+  while(_lru_head)
+    Remove(_lru_head);
+}
+
+void ResourceCache::SetBudget(size_t bytes)
+{
+  _cache_size = bytes;
+  while(_allocated > _cache_size && FreeOneResource())
+  {
+  }
+}
+
+void ResourceCache::RecordLoadOrder(bool record)
+{
+  if(record && !_record_load_order)
+    _load_order.clear();
+  _record_load_order = record;
+}
+
+void ResourceCache::RecordLoad(const std::string& name)
+{
+  if(_record_load_order)
+    _load_order.push_back(name);
+}
+
+bool ResourceCache::SaveLoadOrder(const std::wstring& file_name) const
+{
+  std::string text;
+  for(size_t i = 0; i < _load_order.size(); ++i)
+  {
+    text += _load_order[i];
+    text += '\n';
+  }
+
+  HANDLE file = CreateFileW(file_name.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if(file == INVALID_HANDLE_VALUE)
+  {
+    SOL_ERROR("Could not write load order " + ws2s(file_name));
+    return false;
+  }
+  DWORD written = 0;
+  BOOL success = WriteFile(file, text.data(), (DWORD)text.size(), &written, NULL);
+  CloseHandle(file);
+  return success && written == text.size();
+}
+
+bool ResourceCache::MakeRoom(size_t size)
+{
+  if(size > _cache_size)
+    return false;
+
+  //return null if there's no possible way to allocate the memory
+  while(size > (_cache_size - std::min(_cache_size, _allocated)))
+  {
+    //the cache is empty, and there's still not enough room
+    if(!FreeOneResource())
+      return false;
+  }
+  return true;
+}
+
+char* ResourceCache::Allocate(unsigned int size)
+{
+  if(!MakeRoom(size))
+    return 0;
+
+  char* mem = SOL_NEW char[size];
+  if(mem)
+    _allocated += size;
+  return mem;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// frees the least recently used handle nobody else is holding, returns false
+// if every handle is in use.  Mapped handles are skipped, freeing them
+// wouldnt make any room and they are just as cheap to keep.
+//////////////////////////////////////////////////////////////////////////////
+bool ResourceCache::FreeOneResource()
+{
+  for(ResHandle* handle = _lru_tail; handle; handle = handle->_lru_prev)
+  {
+    if(handle->AllocatedSize() == 0)
+      continue;
+    ResHandleMap::iterator it = _resources.find(handle->Name());
+    if(it->second.use_count() > 1)
+      continue;
+
+    ++_stats.evictions;
+    _stats.evicted_bytes += handle->AllocatedSize();
+    Remove(handle);
+    return true;
+  }
+  return false;
+}
+
+void ResourceCache::MemoryHasBeenFreed(unsigned int size)
+{
+  _allocated -= size;
+}
+
+void ResourceCache::Insert(shared_ptr<ResHandle> handle)
+{
+  _resources[handle->Name()] = handle;
+  LruPushFront(handle.get());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// takes the handle out of the list and the map.  If the map held the last
+// reference the handle is destroyed here, so dont touch it afterwards.
+//////////////////////////////////////////////////////////////////////////////
+void ResourceCache::Remove(ResHandle* handle)
+{
+  LruUnlink(handle);
+  ResHandleMap::iterator it = _resources.find(handle->Name());
+  _resources.erase(it);
+}
+
+void ResourceCache::LruPushFront(ResHandle* handle)
+{
+  handle->_lru_prev = 0;
+  handle->_lru_next = _lru_head;
+  if(_lru_head)
+    _lru_head->_lru_prev = handle;
+  _lru_head = handle;
+  if(!_lru_tail)
+    _lru_tail = handle;
+}
+
+void ResourceCache::LruUnlink(ResHandle* handle)
+{
+  if(handle->_lru_prev)
+    handle->_lru_prev->_lru_next = handle->_lru_next;
+  else
+    _lru_head = handle->_lru_next;
+
+  if(handle->_lru_next)
+    handle->_lru_next->_lru_prev = handle->_lru_prev;
+  else
+    _lru_tail = handle->_lru_prev;
+
+  handle->_lru_prev = 0;
+  handle->_lru_next = 0;
+}
+
+void ResourceCache::Touch(ResHandle* handle)
+{
+  if(handle == _lru_head)
+    return;
+  LruUnlink(handle);
+  LruPushFront(handle);
+}
+
+#pragma endregion
@@ -0,0 +1,167 @@
+#pragma once
+//========================================================================
+// ResourceCache.h : Keeps loaded resources in memory under a byte budget
+//
+// Resources are looked up by name in a hash table and handed out as
+// shared_ptr<ResHandle>.  Every handle the cache holds is also on an
+// intrusive LRU list, most recently used at the head.  When a new resource
+// doesnt fit in the budget the cache frees handles from the tail, skipping
+// any that a caller still holds and any mapped ones that cost nothing,
+// until it does.
+//
+// The cache isnt thread safe, use it from the main thread.  Handles must
+// not outlive the cache that made them.
+//========================================================================
+
+#include "Resource.h"
+#include "../Utility/WildcardPattern.h"
+
+class ResourceCache;
+
+//////////////////////////////////////////////////////////////////////////////
+// ResHandle - a loaded resource
+//////////////////////////////////////////////////////////////////////////////
+class ResHandle : public SOL_noncopyable
+{
+  friend class ResourceCache;
+  friend class ResourceStreamer;
+
+protected:
+  Resource _resource;
+  char* _buffer;          //owned by the handle, NULL if the data lives in the resource file's mapping
+  const char* _data;      //_buffer or the mapped bytes
+  unsigned int _size;
+  shared_ptr<IResourceExtraData> _extra;
+  ResourceCache* _cache;  //NULL until the cache adopts a handle built off the main thread
+
+  //intrusive LRU links, only the cache touches these
+  ResHandle* _lru_prev;
+  ResHandle* _lru_next;
+
+public:
+  //buffer is NULL when data points into the resource file's mapping, otherwise they are the same
+  ResHandle(const Resource& resource, char* buffer, const char* data, unsigned int size, ResourceCache* cache);
+  virtual ~ResHandle();
+
+  const std::string& Name() const { return _resource.Name(); }
+  unsigned int Size() const { return _size; }
+  const char* Buffer() const { return _data; }
+  //writable buffer for loaders, NULL for mapped resources
+  char* WritableBuffer() { return _buffer; }
+  //bytes this handle counts against the cache budget
+  unsigned int AllocatedSize() const { return _buffer ? _size : 0; }
+
+  shared_ptr<IResourceExtraData> Extra() { return _extra; }
+  void SetExtra(shared_ptr<IResourceExtraData> extra) { _extra = extra; }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// DefaultResourceLoader - hands back the raw bytes for anything not claimed
+// by a more specific loader
+//////////////////////////////////////////////////////////////////////////////
+class DefaultResourceLoader : public IResourceLoader
+{
+public:
+  virtual std::string Pattern() { return "*"; }
+  virtual bool UseRawFile() { return true; }
+  virtual bool DiscardRawBufferAfterLoad() { return true; }
+  virtual unsigned int LoadedResourceSize(char* raw_buffer, unsigned int raw_size) { return raw_size; }
+  virtual bool LoadResource(char* raw_buffer, unsigned int raw_size, shared_ptr<ResHandle> handle) { return true; }
+};
+
+struct ResourceCacheStats
+{
+  unsigned int hits;
+  unsigned int misses;
+  unsigned int evictions;
+  unsigned long long evicted_bytes;
+  unsigned int load_failures;
+
+  ResourceCacheStats() : hits(0), misses(0), evictions(0), evicted_bytes(0), load_failures(0) {}
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// ResourceCache
+//////////////////////////////////////////////////////////////////////////////
+class ResourceCache : public SOL_noncopyable
+{
+  friend class ResHandle;
+  friend class ResourceStreamer;
+
+  struct Loader
+  {
+    shared_ptr<IResourceLoader> loader;
+    WildcardPattern pattern;
+  };
+  typedef std::list<Loader> ResourceLoaders;
+  typedef std::tr1::unordered_map<std::string, shared_ptr<ResHandle> > ResHandleMap;
+
+  ResHandleMap _resources;
+  ResHandle* _lru_head;   //most recently used
+  ResHandle* _lru_tail;   //least recently used
+  ResourceLoaders _resource_loaders;
+
+  IResourceFile* _file;
+
+  size_t _cache_size;     //budget in bytes
+  size_t _allocated;      //bytes held by live handles, including evicted ones callers still hold
+  ResourceCacheStats _stats;
+
+  bool _record_load_order;
+  StringVec _load_order;  //names in the order they were first loaded while recording
+
+public:
+  ResourceCache(unsigned int size_in_mb, IResourceFile* file);
+  virtual ~ResourceCache();
+
+  bool Init();
+  //loaders registered later are tried first
+  void RegisterLoader(shared_ptr<IResourceLoader> loader);
+
+  //returns the resource, loading it on a miss.  NULL if it doesnt exist or couldnt be made to fit.
+  shared_ptr<ResHandle> Handle(const Resource& r);
+  //returns the resource only if it is already loaded.  Doesnt count as a hit or a miss.
+  shared_ptr<ResHandle> Find(const Resource& r);
+
+  //loads every resource matching pattern, progress is called after each one and can cancel by setting its bool
+  int Preload(const std::string& pattern, void (*progress)(int, bool&));
+  //drops every handle the cache holds, memory is freed as callers let go of theirs
+  void Flush();
+
+  //changes the budget, evicting straight away if the cache is now over it
+  void SetBudget(size_t bytes);
+  size_t Budget() const { return _cache_size; }
+  size_t Allocated() const { return _allocated; }
+  size_t NumResources() const { return _resources.size(); }
+
+  const ResourceCacheStats& Stats() const { return _stats; }
+  void ResetStats() { _stats = ResourceCacheStats(); }
+
+  //records the name of every resource loaded from the file, for the pack builder to lay the
+  //archive out in.  Starting a recording clears the last one.
+  void RecordLoadOrder(bool record);
+  const StringVec& LoadOrder() const { return _load_order; }
+  //writes the recorded names one per line
+  bool SaveLoadOrder(const std::wstring& file_name) const;
+
+protected:
+  shared_ptr<ResHandle> Load(const Resource& r);
+  IResourceLoader* FindLoader(const Resource& r);
+  //returns the resource if it is loaded, counting a hit.  Never loads.
+  shared_ptr<ResHandle> Lookup(const Resource& r);
+  //takes ownership of a handle built without a cache.  If the resource was loaded in the meantime
+  //the loaded one is returned instead.  NULL if it couldnt be made to fit.
+  shared_ptr<ResHandle> Adopt(shared_ptr<ResHandle> handle);
+
+  bool MakeRoom(size_t size);
+  bool FreeOneResource();
+  char* Allocate(unsigned int size);
+  void MemoryHasBeenFreed(unsigned int size);
+
+  void Insert(shared_ptr<ResHandle> handle);
+  void RecordLoad(const std::string& name);
+  void Remove(ResHandle* handle);
+  void LruPushFront(ResHandle* handle);
+  void LruUnlink(ResHandle* handle);
+  void Touch(ResHandle* handle);
+};
@@ -0,0 +1,255 @@
+#include "EngineStd.h"
+#include "ResourceStreamer.h"
+#include "../Debugging/Logger.h"
+
+#pragma region RequestQueue
+
+ResourceStreamer::StreamRequest* ResourceStreamer::RequestQueue::Pop()
+{
+  for(int i = 0; i < NUM_STREAM_PRIORITIES; ++i)
+  {
+    if(!_queues[i].empty())
+    {
+      StreamRequest* request = _queues[i].front();
+      _queues[i].pop_front();
+      return request;
+    }
+  }
+  return 0;
+}
+
+#pragma endregion
+
+#pragma region ResourceStreamer
+
+ResourceStreamer::ResourceStreamer(ResourceCache* cache, int num_decode_threads)
+{
+  _cache = cache;
+  _next_id = INVALID_STREAM_REQUEST_ID;
+  _quitting = 0;
+
+  if(num_decode_threads <= 0)
+  {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    num_decode_threads = std::max(1, (int)info.dwNumberOfProcessors - 1);
+  }
+
+  _read.semaphore = CreateSemaphoreW(NULL, 0, LONG_MAX, NULL);
+  _decode.semaphore = CreateSemaphoreW(NULL, 0, LONG_MAX, NULL);
+
+  HANDLE thread = CreateThread(NULL, 0, ReadThreadProc, this, 0, NULL);
+  if(thread)
+    _read.threads.push_back(thread);
+  for(int i = 0; i < num_decode_threads; ++i)
+  {
+    thread = CreateThread(NULL, 0, DecodeThreadProc, this, 0, NULL);
+    if(thread)
+      _decode.threads.push_back(thread);
+  }
+  SOL_ASSERT(!_read.threads.empty() && !_decode.threads.empty());
+}
+
+ResourceStreamer::~ResourceStreamer()
+{
+  InterlockedExchange(&_quitting, 1);
+  Stage* stages[] = { &_read, &_decode };
+  for(int i = 0; i < 2; ++i)
+  {
+    Stage& stage = *stages[i];
+    if(!stage.threads.empty())
+    {
+      ReleaseSemaphore(stage.semaphore, (LONG)stage.threads.size(), NULL);
+      WaitForMultipleObjects((DWORD)stage.threads.size(), &stage.threads[0], TRUE, INFINITE);
+    }
+    for(size_t t = 0; t < stage.threads.size(); ++t)
+      CloseHandle(stage.threads[t]);
+    CloseHandle(stage.semaphore);
+  }
+
+  //every request is in the map until it is delivered, wherever else it is queued
+  for(RequestMap::iterator it = _requests.begin(); it != _requests.end(); ++it)
+    delete it->second;
+}
+
+StreamRequestId ResourceStreamer::Request(const Resource& r, StreamPriority priority, StreamCallback callback, void* user_data)
+{
+  if(++_next_id == INVALID_STREAM_REQUEST_ID)
+    ++_next_id;
+
+  StreamRequest* request = SOL_NEW StreamRequest(_next_id, r, priority, callback, user_data);
+  _requests[request->id] = request;
+
+  request->handle = _cache->Lookup(r);
+  if(request->handle)
+    Complete(request);
+  else
+    Push(_read, request);
+  return request->id;
+}
+
+void ResourceStreamer::Cancel(StreamRequestId id)
+{
+  //the request stays wherever it is, each stage passes cancelled requests straight through
+  RequestMap::iterator it = _requests.find(id);
+  if(it != _requests.end())
+    InterlockedExchange(&it->second->cancelled, 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Critical requests were pushed ahead of everything else by the stages, so
+// they are near the front of the completed list too.
+//////////////////////////////////////////////////////////////////////////////
+int ResourceStreamer::DeliverCompleted(double budget_ms)
+{
+  LARGE_INTEGER frequency, start, now;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&start);
+  LONGLONG budget_ticks = (LONGLONG)(budget_ms * frequency.QuadPart / 1000.0);
+
+  int delivered = 0;
+  for(;;)
+  {
+    StreamRequest* request = 0;
+    {
+      ScopedCriticalSection lock(_completed_cs);
+      if(_completed.empty())
+        break;
+      request = _completed.front();
+      _completed.pop_front();
+    }
+    _requests.erase(request->id);
+
+    if(!request->cancelled)
+    {
+      shared_ptr<ResHandle> handle;
+      if(request->handle)
+        handle = _cache->Adopt(request->handle);
+      request->handle.reset();
+      if(request->callback)
+        request->callback(request->resource, handle, request->user_data);
+      ++delivered;
+    }
+    delete request;
+
+    QueryPerformanceCounter(&now);
+    if(now.QuadPart - start.QuadPart >= budget_ticks)
+      break;
+  }
+  return delivered;
+}
+
+void ResourceStreamer::Push(Stage& stage, StreamRequest* request)
+{
+  {
+    ScopedCriticalSection lock(stage.cs);
+    stage.queue.Push(request);
+  }
+  ReleaseSemaphore(stage.semaphore, 1, NULL);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// blocks until the stage has work, returns NULL when the streamer is
+// shutting down
+//////////////////////////////////////////////////////////////////////////////
+ResourceStreamer::StreamRequest* ResourceStreamer::Pop(Stage& stage)
+{
+  WaitForSingleObject(stage.semaphore, INFINITE);
+  if(_quitting)
+    return 0;
+  ScopedCriticalSection lock(stage.cs);
+  return stage.queue.Pop();
+}
+
+void ResourceStreamer::Complete(StreamRequest* request)
+{
+  ScopedCriticalSection lock(_completed_cs);
+  _completed.push_back(request);
+}
+
+void ResourceStreamer::ReadRequest(StreamRequest* request)
+{
+  if(request->cancelled || !_cache->_file->PrefetchResource(request->resource))
+    Complete(request);
+  else
+    Push(_decode, request);
+}
+
+void ResourceStreamer::DecodeRequest(StreamRequest* request)
+{
+  if(!request->cancelled)
+  {
+    IResourceLoader* loader = _cache->FindLoader(request->resource);
+    if(loader)
+      request->handle = Decode(loader, request->resource);
+    else
+      SOL_ERROR("Default resource loader not found!");
+  }
+  Complete(request);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Does what ResourceCache::Load does, except the handle has no cache and
+// nothing is counted against the budget until the main thread adopts it.
+//////////////////////////////////////////////////////////////////////////////
+shared_ptr<ResHandle> ResourceStreamer::Decode(IResourceLoader* loader, const Resource& r)
+{
+  IResourceFile* file = _cache->_file;
+
+  int mapped_size = 0;
+  const char* mapped = 0;
+  if(!loader->AddNullZero() && loader->DiscardRawBufferAfterLoad())
+    mapped = file->MappedResource(r, mapped_size);
+
+  if(loader->UseRawFile() && mapped)
+    return shared_ptr<ResHandle>(SOL_NEW ResHandle(r, 0, mapped, mapped_size, 0));
+
+  int stored_size = mapped ? mapped_size : file->RawResourceSize(r);
+  if(stored_size < 0)
+    return shared_ptr<ResHandle>();
+  unsigned int raw_size = (unsigned int)stored_size;
+
+  char* raw_buffer = const_cast<char*>(mapped);
+  if(!raw_buffer)
+  {
+    raw_buffer = SOL_NEW char[raw_size + (loader->AddNullZero() ? 1 : 0)];
+    if(loader->AddNullZero())
+      raw_buffer[raw_size] = '\0';
+    if(file->RawResource(r, raw_buffer) != stored_size)
+    {
+      delete[] raw_buffer;
+      return shared_ptr<ResHandle>();
+    }
+  }
+
+  if(loader->UseRawFile())
+    return shared_ptr<ResHandle>(SOL_NEW ResHandle(r, raw_buffer, raw_buffer, raw_size, 0));
+
+  unsigned int size = loader->LoadedResourceSize(raw_buffer, raw_size);
+  char* buffer = SOL_NEW char[size];
+  shared_ptr<ResHandle> handle(SOL_NEW ResHandle(r, buffer, buffer, size, 0));
+  bool success = loader->LoadResource(raw_buffer, raw_size, handle);
+  if(raw_buffer != mapped && loader->DiscardRawBufferAfterLoad())
+    delete[] raw_buffer;
+  if(!success)
+    return shared_ptr<ResHandle>();
+  return handle;
+}
+
+DWORD WINAPI ResourceStreamer::ReadThreadProc(void* param)
+{
+  ResourceStreamer* streamer = (ResourceStreamer*)param;
+  while(StreamRequest* request = streamer->Pop(streamer->_read))
+    streamer->ReadRequest(request);
+  return 0;
+}
+
+DWORD WINAPI ResourceStreamer::DecodeThreadProc(void* param)
+{
+  ResourceStreamer* streamer = (ResourceStreamer*)param;
+  while(StreamRequest* request = streamer->Pop(streamer->_decode))
+    streamer->DecodeRequest(request);
+  return 0;
+}
+
+#pragma endregion
@@ -0,0 +1,115 @@
+#pragma once
+//========================================================================
+// ResourceStreamer.h : Loads resources on background threads
+//
+// Requests go through two stages.  A single read thread pulls the stored
+// bytes of each resource off the disk, one at a time so the drive only
+// ever sees one stream.  A pool of decode threads then decompresses them
+// and runs the resource's loader.  Both stages serve critical requests
+// before visible ones and visible ones before prefetches, so a burst of
+// prefetching never holds up something the frame needs.
+//
+// Finished resources wait until the main thread calls DeliverCompleted(),
+// which hands them to the ResourceCache and calls each request's callback.
+// Delivery stops once its time budget is spent and picks up again next
+// frame.
+//
+// Request(), Cancel() and DeliverCompleted() are main thread only.  Loaders
+// and the resource file are used from the worker threads, so they must not
+// keep state between calls, and loaders must all be registered before the
+// first request.
+//========================================================================
+
+#include "ResourceCache.h"
+#include "../Multicore/CriticalSection.h"
+
+enum StreamPriority
+{
+  STREAM_CRITICAL,  //needed this frame
+  STREAM_VISIBLE,   //on screen soon
+  STREAM_PREFETCH,  //might be needed later
+  NUM_STREAM_PRIORITIES
+};
+
+typedef unsigned int StreamRequestId;
+const StreamRequestId INVALID_STREAM_REQUEST_ID = 0;
+
+//called on the main thread when a request finishes.  handle is NULL if the resource couldnt be loaded.
+typedef void (*StreamCallback)(const Resource& resource, shared_ptr<ResHandle> handle, void* user_data);
+
+class ResourceStreamer : public SOL_noncopyable
+{
+  struct StreamRequest
+  {
+    StreamRequestId id;
+    Resource resource;
+    StreamPriority priority;
+    StreamCallback callback;
+    void* user_data;
+    volatile LONG cancelled;
+    shared_ptr<ResHandle> handle; //set by the decode stage, or on the main thread for cache hits
+
+    StreamRequest(StreamRequestId id, const Resource& resource, StreamPriority priority, StreamCallback callback, void* user_data)
+      : id(id), resource(resource), priority(priority), callback(callback), user_data(user_data), cancelled(0) {}
+  };
+
+  //a stage's pending work, highest priority first
+  class RequestQueue
+  {
+    std::deque<StreamRequest*> _queues[NUM_STREAM_PRIORITIES];
+  public:
+    void Push(StreamRequest* request) { _queues[request->priority].push_back(request); }
+    StreamRequest* Pop();
+  };
+
+  struct Stage
+  {
+    CriticalSection cs;
+    RequestQueue queue;
+    HANDLE semaphore;   //counts the requests in queue
+    std::vector<HANDLE> threads;
+  };
+
+  typedef std::map<StreamRequestId, StreamRequest*> RequestMap;
+
+  ResourceCache* _cache;
+  Stage _read;
+  Stage _decode;
+
+  CriticalSection _completed_cs;
+  std::deque<StreamRequest*> _completed;
+
+  RequestMap _requests;     //every request not yet delivered, main thread only
+  StreamRequestId _next_id;
+  volatile LONG _quitting;
+
+public:
+  //num_decode_threads of 0 uses one per core, less one for the main thread
+  ResourceStreamer(ResourceCache* cache, int num_decode_threads = 0);
+  ~ResourceStreamer();
+
+  //queues r for loading and returns straight away.  If r is already in the cache
+  //the callback still waits for the next DeliverCompleted().
+  StreamRequestId Request(const Resource& r, StreamPriority priority, StreamCallback callback, void* user_data = 0);
+  //the request's callback wont be called.  Work already started on it is thrown away.
+  void Cancel(StreamRequestId id);
+
+  //hands finished resources to the cache and calls their callbacks until budget_ms runs out,
+  //at least one is always delivered.  Returns how many were delivered.
+  int DeliverCompleted(double budget_ms);
+
+  //requests not yet delivered, including ones still being loaded
+  size_t NumPending() const { return _requests.size(); }
+
+private:
+  void Push(Stage& stage, StreamRequest* request);
+  StreamRequest* Pop(Stage& stage);
+  void Complete(StreamRequest* request);
+
+  void ReadRequest(StreamRequest* request);
+  void DecodeRequest(StreamRequest* request);
+  shared_ptr<ResHandle> Decode(IResourceLoader* loader, const Resource& r);
+
+  static DWORD WINAPI ReadThreadProc(void* param);
+  static DWORD WINAPI DecodeThreadProc(void* param);
+};
@@ -0,0 +1,283 @@
+#include "EngineStd.h"
+#include "ZipDeflate.h"
+
+#pragma region Deflate Format
+
+static const unsigned int DEFLATE_MIN_MATCH = 3;
+static const unsigned int DEFLATE_MAX_MATCH = 258;
+static const unsigned int DEFLATE_WINDOW_SIZE = 32768;
+static const unsigned int DEFLATE_WINDOW_MASK = DEFLATE_WINDOW_SIZE - 1;
+static const unsigned int DEFLATE_END_OF_BLOCK = 256;
+
+//length codes 257-285
+static const unsigned short LENGTH_BASE[29] =
+{
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const unsigned char LENGTH_EXTRA[29] =
+{
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+//distance codes 0-29
+static const unsigned short DISTANCE_BASE[30] =
+{
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const unsigned char DISTANCE_EXTRA[30] =
+{
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+//match search effort.  Chains are cut off after this many candidates, and a match
+//at least LAZY_LIMIT long is taken without checking the next position for a longer one.
+static const int MAX_CHAIN = 128;
+static const unsigned int LAZY_LIMIT = 32;
+
+static const int HASH_BITS = 15;
+static const unsigned int HASH_SIZE = 1 << HASH_BITS;
+
+#pragma endregion
+
+#pragma region Bit Writer
+
+//deflate packs bits starting at the least significant bit of each byte
+class DeflateBitWriter
+{
+  unsigned char* _out;
+  unsigned char* _end;
+  unsigned int _bits;
+  int _count;
+  bool _overflow;
+
+public:
+  DeflateBitWriter(void* dest, unsigned int dest_size)
+  {
+    _out = (unsigned char*)dest;
+    _end = _out + dest_size;
+    _bits = 0;
+    _count = 0;
+    _overflow = false;
+  }
+
+  void Put(unsigned int value, int num_bits)
+  {
+    _bits |= value << _count;
+    _count += num_bits;
+    while(_count >= 8)
+    {
+      PutByte((unsigned char)_bits);
+      _bits >>= 8;
+      _count -= 8;
+    }
+  }
+
+  //huffman codes go out most significant bit first
+  void PutCode(unsigned int code, int num_bits)
+  {
+    unsigned int reversed = 0;
+    for(int i = 0; i < num_bits; ++i)
+    {
+      reversed = (reversed << 1) | (code & 1);
+      code >>= 1;
+    }
+    Put(reversed, num_bits);
+  }
+
+  void Flush()
+  {
+    if(_count > 0)
+      PutByte((unsigned char)_bits);
+    _bits = 0;
+    _count = 0;
+  }
+
+  bool Overflow() const { return _overflow; }
+  unsigned char* Position() const { return _out; }
+
+private:
+  void PutByte(unsigned char byte)
+  {
+    if(_out < _end)
+      *_out++ = byte;
+    else
+      _overflow = true;
+  }
+};
+
+//the fixed literal/length code from the deflate spec
+static void PutFixedSymbol(DeflateBitWriter& out, unsigned int symbol)
+{
+  if(symbol < 144)
+    out.PutCode(0x30 + symbol, 8);
+  else if(symbol < 256)
+    out.PutCode(0x190 + symbol - 144, 9);
+  else if(symbol < 280)
+    out.PutCode(symbol - 256, 7);
+  else
+    out.PutCode(0xc0 + symbol - 280, 8);
+}
+
+static void PutMatch(DeflateBitWriter& out, unsigned int length, unsigned int distance)
+{
+  int code = 28;
+  while(LENGTH_BASE[code] > length)
+    --code;
+  PutFixedSymbol(out, 257 + code);
+  out.Put(length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+
+  code = 29;
+  while(DISTANCE_BASE[code] > distance)
+    --code;
+  out.PutCode(code, 5);
+  out.Put(distance - DISTANCE_BASE[code], DISTANCE_EXTRA[code]);
+}
+
+#pragma endregion
+
+#pragma region Match Finder
+
+//hash chains over the last 32k of input
+class DeflateMatchFinder
+{
+  const unsigned char* _src;
+  unsigned int _size;
+  std::vector<int> _head;   //most recent position for each hash, -1 for none
+  std::vector<int> _prev;   //previous position with the same hash, indexed by position & DEFLATE_WINDOW_MASK
+
+public:
+  DeflateMatchFinder(const unsigned char* src, unsigned int size)
+    : _src(src), _size(size), _head(HASH_SIZE, -1), _prev(DEFLATE_WINDOW_SIZE, -1)
+  {
+  }
+
+  void Insert(unsigned int pos)
+  {
+    if(pos + DEFLATE_MIN_MATCH > _size)
+      return;
+    unsigned int h = Hash(pos);
+    _prev[pos & DEFLATE_WINDOW_MASK] = _head[h];
+    _head[h] = (int)pos;
+  }
+
+  //longest match for pos among the positions already inserted, 0 if there isnt one of at least DEFLATE_MIN_MATCH
+  unsigned int Find(unsigned int pos, unsigned int& out_distance) const
+  {
+    if(pos + DEFLATE_MIN_MATCH > _size)
+      return 0;
+
+    unsigned int max_length = std::min(DEFLATE_MAX_MATCH, _size - pos);
+    const unsigned char* current = _src + pos;
+    unsigned int best_length = DEFLATE_MIN_MATCH - 1;
+    int chain = MAX_CHAIN;
+    int candidate = _head[Hash(pos)];
+
+    //positions go down as the chain is followed, once one is out of the window the rest are too
+    while(candidate >= 0 && pos - candidate <= DEFLATE_WINDOW_SIZE && chain-- > 0)
+    {
+      const unsigned char* match = _src + candidate;
+      if(match[best_length] == current[best_length] && match[0] == current[0])
+      {
+        unsigned int length = 1;
+        while(length < max_length && match[length] == current[length])
+          ++length;
+        if(length > best_length)
+        {
+          best_length = length;
+          out_distance = pos - candidate;
+          if(length == max_length)
+            break;
+        }
+      }
+
+      int next = _prev[candidate & DEFLATE_WINDOW_MASK];
+      if(next >= candidate)
+        break;
+      candidate = next;
+    }
+    return best_length >= DEFLATE_MIN_MATCH ? best_length : 0;
+  }
+
+private:
+  unsigned int Hash(unsigned int pos) const
+  {
+    const unsigned char* p = _src + pos;
+    return ((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & (HASH_SIZE - 1);
+  }
+};
+
+#pragma endregion
+
+#pragma region ZipDeflate
+
+unsigned int ZipDeflateBound(unsigned int src_size)
+{
+  //literals cost at most 9 bits, plus the block header and end of block code
+  return src_size + src_size / 8 + 8;
+}
+
+unsigned int ZipDeflate(const void* src, unsigned int src_size, void* dest, unsigned int dest_size)
+{
+  const unsigned char* data = (const unsigned char*)src;
+  DeflateBitWriter out(dest, dest_size);
+  DeflateMatchFinder finder(data, src_size);
+
+  //one final block using the fixed codes
+  out.Put(1, 1);
+  out.Put(1, 2);
+
+  unsigned int pos = 0;
+  unsigned int length = 0;
+  unsigned int distance = 0;
+  bool have_match = false;  //length and distance were already found for pos by the lazy check
+  while(pos < src_size)
+  {
+    if(out.Overflow())
+      return 0;
+
+    if(!have_match)
+      length = finder.Find(pos, distance);
+    have_match = false;
+    finder.Insert(pos);
+
+    if(length == 0)
+    {
+      PutFixedSymbol(out, data[pos]);
+      ++pos;
+      continue;
+    }
+
+    //a longer match starting one byte later is worth a literal
+    if(length < LAZY_LIMIT)
+    {
+      unsigned int next_distance = 0;
+      unsigned int next_length = finder.Find(pos + 1, next_distance);
+      if(next_length > length)
+      {
+        PutFixedSymbol(out, data[pos]);
+        ++pos;
+        length = next_length;
+        distance = next_distance;
+        have_match = true;
+        continue;
+      }
+    }
+
+    PutMatch(out, length, distance);
+    for(unsigned int i = 1; i < length; ++i)
+      finder.Insert(pos + i);
+    pos += length;
+  }
+
+  PutFixedSymbol(out, DEFLATE_END_OF_BLOCK);
+  out.Flush();
+  if(out.Overflow())
+    return 0;
+  return (unsigned int)(out.Position() - (unsigned char*)dest);
+}
+
+#pragma endregion
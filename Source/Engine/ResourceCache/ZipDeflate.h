@@ -0,0 +1,17 @@
+#pragma once
+//========================================================================
+// ZipDeflate.h : raw deflate compression for building zip archives
+//
+// The counterpart to ZipInflate for offline tools.  It is a plain LZ77
+// encoder with hash chains and one step of lazy matching, written out as
+// a single block of fixed Huffman codes.  That gives up a little ratio
+// against zlib's dynamic trees but needs no code tables in the output and
+// any inflater can read it.
+//========================================================================
+
+//largest output ZipDeflate can produce for src_size bytes of input
+unsigned int ZipDeflateBound(unsigned int src_size);
+
+//compresses src into dest as raw deflate data (no zlib or gzip header).  Returns the number of bytes
+//written, or 0 if dest_size wasnt enough.
+unsigned int ZipDeflate(const void* src, unsigned int src_size, void* dest, unsigned int dest_size);
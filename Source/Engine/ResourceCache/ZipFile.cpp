@@ -0,0 +1,438 @@
+#include "EngineStd.h"
+#include "ZipFile.h"
+#include "ZipInflate.h"
+#include "Resource.h"
+#include "../Debugging/Logger.h"
+#include "../Utility/String.h"
+#include "../Utility/WildcardPattern.h"
+
+#pragma region Zip Format
+
+//record signatures
+static const unsigned int ZIP_LOCAL_HEADER_SIG = 0x04034b50;
+static const unsigned int ZIP_CENTRAL_HEADER_SIG = 0x02014b50;
+static const unsigned int ZIP_END_OF_DIR_SIG = 0x06054b50;
+
+//fixed record sizes, the variable length name, extra and comment fields follow them
+static const size_t ZIP_LOCAL_HEADER_SIZE = 30;
+static const size_t ZIP_CENTRAL_HEADER_SIZE = 46;
+static const size_t ZIP_END_OF_DIR_SIZE = 22;
+static const size_t ZIP_MAX_COMMENT = 0xffff;
+
+//general purpose flag bit for encrypted entries
+static const unsigned short ZIP_FLAG_ENCRYPTED = 0x0001;
+
+//the archive is little endian and the records arent aligned
+static unsigned short ReadU16(const unsigned char* p)
+{
+  return (unsigned short)(p[0] | (p[1] << 8));
+}
+
+static unsigned int ReadU32(const unsigned char* p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+//folds a name character for hashing and comparing
+static char NormalizeNameChar(char c)
+{
+  if(c == '\\')
+    return '/';
+  if(c >= 'A' && c <= 'Z')
+    return c - 'A' + 'a';
+  return c;
+}
+
+#pragma endregion
+
+#pragma region ZipFile
+
+ZipFile::ZipFile()
+{
+  _file = INVALID_HANDLE_VALUE;
+  _mapping = NULL;
+  _view = 0;
+  _view_size = 0;
+  _index_mask = 0;
+}
+
+ZipFile::~ZipFile()
+{
+  Close();
+}
+
+bool ZipFile::Open(const std::wstring& file_name)
+{
+  Close();
+
+  _file = CreateFileW(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+  if(_file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size;
+  if(!GetFileSizeEx(_file, &size) || size.QuadPart < (LONGLONG)ZIP_END_OF_DIR_SIZE ||
+     (unsigned long long)size.QuadPart > (size_t)-1)
+  {
+    Close();
+    return false;
+  }
+  _view_size = (size_t)size.QuadPart;
+
+  _mapping = CreateFileMappingW(_file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if(!_mapping)
+  {
+    Close();
+    return false;
+  }
+  _view = (const unsigned char*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+  if(!_view)
+  {
+    Close();
+    return false;
+  }
+
+  if(!ReadCentralDirectory())
+  {
+    Close();
+    return false;
+  }
+  BuildIndex();
+  return true;
+}
+
+void ZipFile::Close()
+{
+  _entries.clear();
+  _folded_names.clear();
+  _index.clear();
+  _index_mask = 0;
+
+  if(_view)
+    UnmapViewOfFile(_view);
+  _view = 0;
+  _view_size = 0;
+  if(_mapping)
+    CloseHandle(_mapping);
+  _mapping = NULL;
+  if(_file != INVALID_HANDLE_VALUE)
+    CloseHandle(_file);
+  _file = INVALID_HANDLE_VALUE;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// finds the end of central directory record, which sits at the very end of
+// the file unless there is an archive comment after it, and reads every
+// central directory header into _entries.  Directories are skipped.
+//////////////////////////////////////////////////////////////////////////////
+bool ZipFile::ReadCentralDirectory()
+{
+  const unsigned char* end_of_dir = 0;
+  size_t search_start = _view_size > ZIP_END_OF_DIR_SIZE + ZIP_MAX_COMMENT ?
+                        _view_size - ZIP_END_OF_DIR_SIZE - ZIP_MAX_COMMENT : 0;
+  for(size_t pos = _view_size - ZIP_END_OF_DIR_SIZE + 1; pos-- > search_start;)
+  {
+    if(ReadU32(_view + pos) == ZIP_END_OF_DIR_SIG)
+    {
+      end_of_dir = _view + pos;
+      break;
+    }
+  }
+  if(!end_of_dir)
+    return false;
+
+  unsigned int num_entries = ReadU16(end_of_dir + 10);
+  size_t dir_size = ReadU32(end_of_dir + 12);
+  size_t dir_offset = ReadU32(end_of_dir + 16);
+  if(dir_offset > _view_size || dir_size > _view_size - dir_offset)
+    return false;
+
+  _entries.reserve(num_entries);
+  const unsigned char* cur = _view + dir_offset;
+  const unsigned char* dir_end = cur + dir_size;
+  for(unsigned int i = 0; i < num_entries; ++i)
+  {
+    if((size_t)(dir_end - cur) < ZIP_CENTRAL_HEADER_SIZE || ReadU32(cur) != ZIP_CENTRAL_HEADER_SIG)
+      return false;
+
+    unsigned int name_length = ReadU16(cur + 28);
+    unsigned int extra_length = ReadU16(cur + 30);
+    unsigned int comment_length = ReadU16(cur + 32);
+    size_t record_size = ZIP_CENTRAL_HEADER_SIZE + name_length + extra_length + comment_length;
+    if((size_t)(dir_end - cur) < record_size)
+      return false;
+
+    Entry entry;
+    entry.name = (const char*)cur + ZIP_CENTRAL_HEADER_SIZE;
+    entry.name_length = name_length;
+    entry.flags = ReadU16(cur + 8);
+    entry.method = ReadU16(cur + 10);
+    entry.compressed_size = ReadU32(cur + 20);
+    entry.uncompressed_size = ReadU32(cur + 24);
+    entry.local_header_offset = ReadU32(cur + 42);
+    cur += record_size;
+
+    //directories arent resources, so they arent hashed or folded either
+    bool is_directory = name_length > 0 && (entry.name[name_length - 1] == '/' || entry.name[name_length - 1] == '\\');
+    if(is_directory)
+      continue;
+    entry.hash = HashName(entry.name, entry.name_length);
+    entry.folded_name = (unsigned int)_folded_names.size();
+    for(unsigned int c = 0; c < name_length; ++c)
+      _folded_names.push_back(NormalizeNameChar(entry.name[c]));
+    _entries.push_back(entry);
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// the index has at least twice as many slots as entries so probe chains
+// stay short
+//////////////////////////////////////////////////////////////////////////////
+void ZipFile::BuildIndex()
+{
+  size_t slots = 16;
+  while(slots < _entries.size() * 2)
+    slots <<= 1;
+  _index.assign(slots, -1);
+  _index_mask = (unsigned int)(slots - 1);
+
+  for(size_t i = 0; i < _entries.size(); ++i)
+  {
+    unsigned int slot = _entries[i].hash & _index_mask;
+    while(_index[slot] != -1)
+      slot = (slot + 1) & _index_mask;
+    _index[slot] = (int)i;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// FNV-1a over the normalized name
+//////////////////////////////////////////////////////////////////////////////
+unsigned int ZipFile::HashName(const char* name, size_t length)
+{
+  unsigned int hash = 2166136261u;
+  for(size_t i = 0; i < length; ++i)
+  {
+    hash ^= (unsigned char)NormalizeNameChar(name[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+int ZipFile::Find(const char* name, size_t length) const
+{
+  if(_index.empty())
+    return -1;
+
+  unsigned int hash = HashName(name, length);
+  for(unsigned int slot = hash & _index_mask; _index[slot] != -1; slot = (slot + 1) & _index_mask)
+  {
+    const Entry& entry = _entries[_index[slot]];
+    if(entry.hash != hash || entry.name_length != length)
+      continue;
+
+    size_t i = 0;
+    while(i < length && NormalizeNameChar(entry.name[i]) == NormalizeNameChar(name[i]))
+      ++i;
+    if(i == length)
+      return _index[slot];
+  }
+  return -1;
+}
+
+std::string ZipFile::FileName(int i) const
+{
+  const Entry& entry = _entries[i];
+  return std::string(entry.name, entry.name_length);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// the local header repeats the name and has its own extra field, so the
+// data offset is only known once it has been read
+//////////////////////////////////////////////////////////////////////////////
+const unsigned char* ZipFile::EntryData(const Entry& entry) const
+{
+  size_t offset = entry.local_header_offset;
+  if(offset > _view_size || _view_size - offset < ZIP_LOCAL_HEADER_SIZE)
+    return 0;
+  const unsigned char* header = _view + offset;
+  if(ReadU32(header) != ZIP_LOCAL_HEADER_SIG)
+    return 0;
+
+  //stored data is used for FileSize() bytes straight out of the view, so a mismatch would read past the entry
+  if(entry.method == ZIP_STORED && entry.compressed_size != entry.uncompressed_size)
+    return 0;
+
+  size_t data_offset = offset + ZIP_LOCAL_HEADER_SIZE + ReadU16(header + 26) + ReadU16(header + 28);
+  if(data_offset > _view_size || _view_size - data_offset < entry.compressed_size)
+    return 0;
+  return _view + data_offset;
+}
+
+const char* ZipFile::MappedData(int i) const
+{
+  const Entry& entry = _entries[i];
+  if(entry.method != ZIP_STORED || (entry.flags & ZIP_FLAG_ENCRYPTED))
+    return 0;
+  return (const char*)EntryData(entry);
+}
+
+bool ZipFile::ReadFile(int i, void* buffer) const
+{
+  const Entry& entry = _entries[i];
+  if(entry.flags & ZIP_FLAG_ENCRYPTED)
+    return false;
+
+  const unsigned char* data = EntryData(entry);
+  if(!data)
+    return false;
+
+  if(entry.method == ZIP_STORED)
+  {
+    memcpy(buffer, data, entry.uncompressed_size);
+    return true;
+  }
+  if(entry.method == ZIP_DEFLATED)
+  {
+    //raw inflate may peek one byte past the data, there is always a header or the central directory there
+    if(data + entry.compressed_size >= _view + _view_size)
+      return false;
+    int written = ZipInflate(data, entry.compressed_size, buffer, entry.uncompressed_size);
+    return written == (int)entry.uncompressed_size;
+  }
+  return false;
+}
+
+bool ZipFile::Prefetch(int i) const
+{
+  const Entry& entry = _entries[i];
+  const unsigned char* data = EntryData(entry);
+  if(!data)
+    return false;
+
+  //one read per page is enough to fault the whole range in
+  const size_t page_size = 4096;
+  volatile unsigned char sink = 0;
+  const unsigned char* end = data + entry.compressed_size;
+  for(const unsigned char* p = data; p < end; p += page_size)
+    sink ^= *p;
+  if(entry.compressed_size)
+    sink ^= end[-1];
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// matches the pattern against the folded names, folded the same way, so
+// it finds the same entries Find() would
+//////////////////////////////////////////////////////////////////////////////
+int ZipFile::FindMatching(const WildcardPattern& pattern, std::vector<int>& out_files) const
+{
+  WildcardPattern folded(pattern);
+  folded.NormalizePath();
+
+  int matched = 0;
+  size_t min_length = folded.MinLength();
+  for(size_t i = 0; i < _entries.size(); ++i)
+  {
+    const Entry& entry = _entries[i];
+    if(entry.name_length >= min_length && folded.Match(_folded_names.c_str() + entry.folded_name, entry.name_length))
+    {
+      out_files.push_back((int)i);
+      ++matched;
+    }
+  }
+  return matched;
+}
+
+#pragma endregion
+
+#pragma region ResourceZipFile
+
+ResourceZipFile::ResourceZipFile(const std::wstring& resource_file_name)
+{
+  _zip_file = NULL;
+  _resource_file_name = resource_file_name;
+}
+
+ResourceZipFile::~ResourceZipFile()
+{
+  delete _zip_file;
+}
+
+bool ResourceZipFile::Open()
+{
+  if(!_zip_file)
+    _zip_file = SOL_NEW ZipFile;
+  if(!_zip_file->Open(_resource_file_name))
+  {
+    SOL_ERROR("Could not open resource file " + ws2s(_resource_file_name));
+    return false;
+  }
+  return true;
+}
+
+int ResourceZipFile::RawResourceSize(const Resource& r)
+{
+  if(!_zip_file)
+    return -1;
+  int num = _zip_file->Find(r.Name());
+  if(num == -1)
+    return -1;
+  return _zip_file->FileSize(num);
+}
+
+int ResourceZipFile::RawResource(const Resource& r, char* buffer)
+{
+  if(!_zip_file)
+    return -1;
+  int num = _zip_file->Find(r.Name());
+  if(num == -1 || !_zip_file->ReadFile(num, buffer))
+    return -1;
+  return _zip_file->FileSize(num);
+}
+
+const char* ResourceZipFile::MappedResource(const Resource& r, int& out_size)
+{
+  out_size = 0;
+  if(!_zip_file)
+    return 0;
+  int num = _zip_file->Find(r.Name());
+  if(num == -1)
+    return 0;
+  const char* data = _zip_file->MappedData(num);
+  if(data)
+    out_size = _zip_file->FileSize(num);
+  return data;
+}
+
+bool ResourceZipFile::PrefetchResource(const Resource& r)
+{
+  if(!_zip_file)
+    return false;
+  int num = _zip_file->Find(r.Name());
+  if(num == -1)
+    return false;
+  return _zip_file->Prefetch(num);
+}
+
+int ResourceZipFile::NumResources() const
+{
+  return _zip_file ? _zip_file->NumFiles() : 0;
+}
+
+std::string ResourceZipFile::ResourceName(int num) const
+{
+  if(!_zip_file || num < 0 || num >= _zip_file->NumFiles())
+    return std::string();
+  return _zip_file->FileName(num);
+}
+
+int ResourceZipFile::MatchResources(const WildcardPattern& pattern, std::vector<int>& out_nums) const
+{
+  if(!_zip_file)
+    return 0;
+  return _zip_file->FindMatching(pattern, out_nums);
+}
+
+#pragma endregion
@@ -0,0 +1,105 @@
+#pragma once
+//========================================================================
+// ZipFile.h : Memory mapped zip archive and the IResourceFile built on it
+//
+// The archive is mapped into memory once and its central directory is
+// parsed into a table of entries plus a hash index on the entry names, so
+// finding a resource never touches the disk.  Stored (uncompressed)
+// entries can be used straight out of the mapping.  Deflated entries are
+// inflated into the caller's buffer.
+//
+// Zip64 archives and encrypted entries aren't supported.  On 32 bit builds
+// the archive also has to fit in the address space.
+//========================================================================
+
+class ZipFile : public SOL_noncopyable
+{
+public:
+  enum CompressionMethod
+  {
+    ZIP_STORED = 0,
+    ZIP_DEFLATED = 8
+  };
+
+  //one file in the central directory.  name points into the mapped archive and isnt null terminated.
+  struct Entry
+  {
+    const char* name;
+    unsigned int name_length;
+    unsigned int hash;
+    unsigned int folded_name;       //offset of the lowercased name with / separators in _folded_names
+    unsigned int compressed_size;
+    unsigned int uncompressed_size;
+    unsigned int local_header_offset;
+    unsigned short method;
+    unsigned short flags;
+  };
+
+private:
+  typedef std::vector<Entry> Entries;
+
+  HANDLE _file;
+  HANDLE _mapping;
+  const unsigned char* _view;
+  size_t _view_size;
+
+  Entries _entries;
+  std::string _folded_names;  //every entry's name folded the way Find() compares them, for FindMatching()
+  std::vector<int> _index;  //open addressed hash of entry numbers, -1 is an empty slot
+  unsigned int _index_mask;
+
+public:
+  ZipFile();
+  ~ZipFile();
+
+  bool Open(const std::wstring& file_name);
+  void Close();
+
+  int NumFiles() const { return (int)_entries.size(); }
+  const Entry& FileEntry(int i) const { return _entries[i]; }
+  std::string FileName(int i) const;
+  int FileSize(int i) const { return (int)_entries[i].uncompressed_size; }
+
+  //returns the entry number for name, or -1.  Case insensitive and / and \ are the same.
+  int Find(const char* name, size_t length) const;
+  int Find(const std::string& name) const { return Find(name.c_str(), name.size()); }
+
+  //the entry's bytes inside the mapping if it is stored uncompressed, otherwise NULL
+  const char* MappedData(int i) const;
+  //copies or inflates the entry into buffer, which must hold FileSize(i) bytes
+  bool ReadFile(int i, void* buffer) const;
+  //touches every page of the entry's stored bytes so a later ReadFile doesnt wait on the disk
+  bool Prefetch(int i) const;
+
+  //appends the number of every entry whose name matches pattern, returns how many were added.  Folded like Find().
+  int FindMatching(const WildcardPattern& pattern, std::vector<int>& out_files) const;
+
+  static unsigned int HashName(const char* name, size_t length);
+
+private:
+  bool ReadCentralDirectory();
+  void BuildIndex();
+  const unsigned char* EntryData(const Entry& entry) const;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// ResourceZipFile - IResourceFile over a ZipFile
+//////////////////////////////////////////////////////////////////////////////
+class ResourceZipFile : public IResourceFile
+{
+  ZipFile* _zip_file;
+  std::wstring _resource_file_name;
+
+public:
+  ResourceZipFile(const std::wstring& resource_file_name);
+  virtual ~ResourceZipFile();
+
+  virtual bool Open();
+  virtual int RawResourceSize(const Resource& r);
+  virtual int RawResource(const Resource& r, char* buffer);
+  virtual const char* MappedResource(const Resource& r, int& out_size);
+  virtual bool PrefetchResource(const Resource& r);
+  virtual int NumResources() const;
+  virtual std::string ResourceName(int num) const;
+  virtual int MatchResources(const WildcardPattern& pattern, std::vector<int>& out_nums) const;
+};
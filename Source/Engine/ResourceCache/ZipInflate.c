@@ -0,0 +1,83 @@
+/*
+  ZipInflate.c : raw deflate decompression built from FreeType's zlib
+
+  This file pulls the zlib sources into one translation unit the same way
+  freetype's src/gzip/ftgzip.c does, so every zlib function stays static
+  and cant clash with FreeType or a system zlib at link time.  It is plain C
+  and doesnt use the engine's precompiled header.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+/* the zlib sources expect a few of FreeType's macros */
+#define ft_memcpy memcpy
+#define ft_memcmp memcmp
+#define ft_memset memset
+#define FT_UNUSED(arg) ((arg) = (arg))
+
+#define NO_DUMMY_DECL
+#define MY_ZCALLOC /* zcalloc() & zcfree() are defined below */
+
+#include "../3rdParty/freetype-2.4.10/src/gzip/zlib.h"
+
+#undef  SLOW
+#define SLOW  1
+
+#define NO_INFLATE_MASK
+#include "../3rdParty/freetype-2.4.10/src/gzip/zutil.h"
+#include "../3rdParty/freetype-2.4.10/src/gzip/inftrees.h"
+#include "../3rdParty/freetype-2.4.10/src/gzip/infblock.h"
+#include "../3rdParty/freetype-2.4.10/src/gzip/infcodes.h"
+#include "../3rdParty/freetype-2.4.10/src/gzip/infutil.h"
+#undef  NO_INFLATE_MASK
+
+/* infutil.c must be included before infcodes.c */
+#include "../3rdParty/freetype-2.4.10/src/gzip/zutil.c"
+#include "../3rdParty/freetype-2.4.10/src/gzip/inftrees.c"
+#include "../3rdParty/freetype-2.4.10/src/gzip/infutil.c"
+#include "../3rdParty/freetype-2.4.10/src/gzip/infcodes.c"
+#include "../3rdParty/freetype-2.4.10/src/gzip/infblock.c"
+#include "../3rdParty/freetype-2.4.10/src/gzip/inflate.c"
+#include "../3rdParty/freetype-2.4.10/src/gzip/adler32.c"
+
+#include "ZipInflate.h"
+
+local voidpf zcalloc(voidpf opaque, unsigned items, unsigned size)
+{
+  (void)opaque;
+  return calloc(items, size);
+}
+
+local void zcfree(voidpf opaque, voidpf ptr)
+{
+  (void)opaque;
+  free(ptr);
+}
+
+int ZipInflate(const void* src, unsigned int src_size, void* dest, unsigned int dest_size)
+{
+  z_stream stream;
+  int err;
+  int written;
+
+  memset(&stream, 0, sizeof(stream));
+  stream.next_in = (Bytef*)src;
+  /* raw mode needs to see one dummy byte after the data */
+  stream.avail_in = src_size + 1;
+  stream.next_out = (Bytef*)dest;
+  stream.avail_out = dest_size;
+
+  /* a negative window size selects raw deflate with no header or check value */
+  err = inflateInit2(&stream, -MAX_WBITS);
+  if(err != Z_OK)
+    return -1;
+
+  err = inflate(&stream, Z_FINISH);
+  written = (int)stream.total_out;
+  inflateEnd(&stream);
+
+  if(err != Z_STREAM_END)
+    return -1;
+  return written;
+}
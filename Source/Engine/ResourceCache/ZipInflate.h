@@ -0,0 +1,21 @@
+#pragma once
+//========================================================================
+// ZipInflate.h : raw deflate decompression for zip archive entries
+//
+// Built from the copy of zlib that ships inside FreeType (src/gzip) so the
+// engine doesnt need a second zlib.  Only decompression is available.
+//========================================================================
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//inflates src_size bytes of raw deflate data (no zlib or gzip header) into dest, which must hold the whole
+//uncompressed entry.  zlib's raw mode may read one byte past src_size, so src must have at least one readable byte
+//after it; inside a zip there is always a header or the central directory there.  Returns the number of bytes
+//written or -1 on corrupt data.
+int ZipInflate(const void* src, unsigned int src_size, void* dest, unsigned int dest_size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+//========================================================================
+// Aabb.h : Axis aligned bounding box
+//========================================================================
+
+#include "3rdParty/glm-0.9.3.4/glm/glm.hpp"
+
+struct Aabb
+{
+  glm::vec3 min;
+  glm::vec3 max;
+
+  Aabb() : min(0.0f), max(0.0f) {}
+  Aabb(const glm::vec3& min_corner, const glm::vec3& max_corner) : min(min_corner), max(max_corner) {}
+
+  glm::vec3 Center() const { return (min + max) * 0.5f; }
+  glm::vec3 Extent() const { return (max - min) * 0.5f; }
+  float SurfaceArea() const
+  {
+    glm::vec3 size = max - min;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+  }
+
+  bool Overlaps(const Aabb& other) const
+  {
+    return min.x <= other.max.x && other.min.x <= max.x &&
+           min.y <= other.max.y && other.min.y <= max.y &&
+           min.z <= other.max.z && other.min.z <= max.z;
+  }
+  bool Contains(const Aabb& other) const
+  {
+    return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+           other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+  }
+
+  static Aabb Union(const Aabb& a, const Aabb& b) { return Aabb(glm::min(a.min, b.min), glm::max(a.max, b.max)); }
+};
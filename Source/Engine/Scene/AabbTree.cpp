@@ -0,0 +1,683 @@
+#include "EngineStd.h"
+#include "AabbTree.h"
+#include "Frustum.h"
+#include "../Debugging/Logger.h"
+#include <emmintrin.h>
+
+const unsigned int NULL_NODE = UINT_MAX;
+
+//the query stacks hold at most the tree's height plus one.  The tree is kept
+//balanced, so even a few billion proxies are nowhere near this, but past it
+//the stack goes on in a vector rather than dropping part of the tree.
+const unsigned int MAX_QUERY_STACK = 128;
+
+//queries taken down the tree together by the batched queries, one bit each
+const unsigned int QUERIES_PER_BATCH = 32;
+
+#pragma region Query Tests
+
+struct SphereTest
+{
+  glm::vec3 center;
+  float radius_squared;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// A direction component too small to invert, zero included, makes the ray
+// parallel to that axis's slab.  The slab test would multiply 0 by an
+// infinite inverse there and get NaN, so those axes get an inverse of 0
+// and are tested by whether the origin is inside the slab instead.
+//////////////////////////////////////////////////////////////////////////////
+struct RayTest
+{
+  glm::vec3 origin;
+  glm::vec3 inverse_direction;
+  float max_t;
+  bool parallel[3];
+};
+
+static inline RayTest MakeRayTest(const AabbTreeRay& ray)
+{
+  RayTest test;
+  test.origin = ray.origin;
+  test.max_t = ray.max_t;
+  for(int axis = 0; axis < 3; ++axis)
+  {
+    float inverse = 1.0f / ray.direction[axis];
+    test.parallel[axis] = !(fabsf(inverse) <= FLT_MAX);
+    test.inverse_direction[axis] = test.parallel[axis] ? 0.0f : inverse;
+  }
+  return test;
+}
+
+static inline bool Hits(const Aabb& query, const Aabb& box)
+{
+  return query.Overlaps(box);
+}
+
+static inline bool Hits(const SphereTest& query, const Aabb& box)
+{
+  glm::vec3 offset = query.center - glm::clamp(query.center, box.min, box.max);
+  return glm::dot(offset, offset) <= query.radius_squared;
+}
+
+//the slab test, the ray hits if it is inside all three slabs at once somewhere along [0, max_t]
+static inline bool Hits(const RayTest& query, const Aabb& box)
+{
+  float enter = 0.0f;
+  float exit = query.max_t;
+  for(int axis = 0; axis < 3; ++axis)
+  {
+    if(query.parallel[axis])
+    {
+      if(query.origin[axis] < box.min[axis] || query.origin[axis] > box.max[axis])
+        return false;
+      continue;
+    }
+    float t0 = (box.min[axis] - query.origin[axis]) * query.inverse_direction[axis];
+    float t1 = (box.max[axis] - query.origin[axis]) * query.inverse_direction[axis];
+    enter = std::max(enter, std::min(t0, t1));
+    exit = std::min(exit, std::max(t0, t1));
+  }
+  return enter <= exit;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The batched queries keep a run of queries one array per component, so a
+// node can be tested against four of them at once.  Hits() returns which
+// of the queries in mask hit the node.  Lanes past the end of the run are
+// never in the mask.
+//////////////////////////////////////////////////////////////////////////////
+const unsigned int PACKET_GROUPS = QUERIES_PER_BATCH / 4;
+
+//the mask bits of group g
+static inline unsigned int GroupMask(unsigned int mask, unsigned int g)
+{
+  return (mask >> (g * 4)) & 0xf;
+}
+
+struct BoxPacket
+{
+  __m128 min_x[PACKET_GROUPS], min_y[PACKET_GROUPS], min_z[PACKET_GROUPS];
+  __m128 max_x[PACKET_GROUPS], max_y[PACKET_GROUPS], max_z[PACKET_GROUPS];
+
+  void Load(const Aabb* boxes, unsigned int count)
+  {
+    float* lanes[6] = { (float*)min_x, (float*)min_y, (float*)min_z, (float*)max_x, (float*)max_y, (float*)max_z };
+    for(unsigned int q = 0; q < QUERIES_PER_BATCH; ++q)
+    {
+      Aabb box = q < count ? boxes[q] : Aabb();
+      lanes[0][q] = box.min.x;
+      lanes[1][q] = box.min.y;
+      lanes[2][q] = box.min.z;
+      lanes[3][q] = box.max.x;
+      lanes[4][q] = box.max.y;
+      lanes[5][q] = box.max.z;
+    }
+  }
+
+  unsigned int Hits(const Aabb& box, unsigned int mask) const
+  {
+    __m128 node_min_x = _mm_set1_ps(box.min.x), node_min_y = _mm_set1_ps(box.min.y), node_min_z = _mm_set1_ps(box.min.z);
+    __m128 node_max_x = _mm_set1_ps(box.max.x), node_max_y = _mm_set1_ps(box.max.y), node_max_z = _mm_set1_ps(box.max.z);
+    unsigned int hits = 0;
+    for(unsigned int g = 0; g < PACKET_GROUPS; ++g)
+    {
+      if(GroupMask(mask, g) == 0)
+        continue;
+      __m128 x = _mm_and_ps(_mm_cmple_ps(min_x[g], node_max_x), _mm_cmple_ps(node_min_x, max_x[g]));
+      __m128 y = _mm_and_ps(_mm_cmple_ps(min_y[g], node_max_y), _mm_cmple_ps(node_min_y, max_y[g]));
+      __m128 z = _mm_and_ps(_mm_cmple_ps(min_z[g], node_max_z), _mm_cmple_ps(node_min_z, max_z[g]));
+      hits |= (unsigned int)_mm_movemask_ps(_mm_and_ps(_mm_and_ps(x, y), z)) << (g * 4);
+    }
+    return hits & mask;
+  }
+};
+
+//one axis of the slab test for four rays.  Rays parallel to the slab have an inverse of 0, so t0 and t1
+//are 0 and are replaced, and the ones whose origin is outside it are added to missed.
+static inline void Slab(__m128 node_min, __m128 node_max, __m128 origin, __m128 inverse, __m128 parallel,
+                        __m128& enter, __m128& exit, __m128& missed)
+{
+  __m128 t0 = _mm_mul_ps(_mm_sub_ps(node_min, origin), inverse);
+  __m128 t1 = _mm_mul_ps(_mm_sub_ps(node_max, origin), inverse);
+  __m128 near_t = _mm_andnot_ps(parallel, _mm_min_ps(t0, t1));
+  __m128 far_t = _mm_or_ps(_mm_andnot_ps(parallel, _mm_max_ps(t0, t1)), _mm_and_ps(parallel, _mm_set1_ps(FLT_MAX)));
+  enter = _mm_max_ps(enter, near_t);
+  exit = _mm_min_ps(exit, far_t);
+  __m128 inside = _mm_and_ps(_mm_cmple_ps(node_min, origin), _mm_cmple_ps(origin, node_max));
+  missed = _mm_or_ps(missed, _mm_andnot_ps(inside, parallel));
+}
+
+struct RayPacket
+{
+  __m128 origin_x[PACKET_GROUPS], origin_y[PACKET_GROUPS], origin_z[PACKET_GROUPS];
+  __m128 inverse_x[PACKET_GROUPS], inverse_y[PACKET_GROUPS], inverse_z[PACKET_GROUPS];
+  __m128 parallel_x[PACKET_GROUPS], parallel_y[PACKET_GROUPS], parallel_z[PACKET_GROUPS];   //all bits set when parallel
+  __m128 max_t[PACKET_GROUPS];
+
+  void Load(const AabbTreeRay* rays, unsigned int count)
+  {
+    float* lanes[7] = { (float*)origin_x, (float*)origin_y, (float*)origin_z, (float*)inverse_x, (float*)inverse_y, (float*)inverse_z, (float*)max_t };
+    unsigned int* parallel[3] = { (unsigned int*)parallel_x, (unsigned int*)parallel_y, (unsigned int*)parallel_z };
+    for(unsigned int q = 0; q < QUERIES_PER_BATCH; ++q)
+    {
+      RayTest test = { glm::vec3(0.0f), glm::vec3(0.0f), 0.0f, { false, false, false } };
+      if(q < count)
+        test = MakeRayTest(rays[q]);
+      lanes[0][q] = test.origin.x;
+      lanes[1][q] = test.origin.y;
+      lanes[2][q] = test.origin.z;
+      lanes[3][q] = test.inverse_direction.x;
+      lanes[4][q] = test.inverse_direction.y;
+      lanes[5][q] = test.inverse_direction.z;
+      lanes[6][q] = test.max_t;
+      for(int axis = 0; axis < 3; ++axis)
+        parallel[axis][q] = test.parallel[axis] ? 0xffffffff : 0;
+    }
+  }
+
+  unsigned int Hits(const Aabb& box, unsigned int mask) const
+  {
+    __m128 node_min_x = _mm_set1_ps(box.min.x), node_min_y = _mm_set1_ps(box.min.y), node_min_z = _mm_set1_ps(box.min.z);
+    __m128 node_max_x = _mm_set1_ps(box.max.x), node_max_y = _mm_set1_ps(box.max.y), node_max_z = _mm_set1_ps(box.max.z);
+    unsigned int hits = 0;
+    for(unsigned int g = 0; g < PACKET_GROUPS; ++g)
+    {
+      if(GroupMask(mask, g) == 0)
+        continue;
+      __m128 enter = _mm_setzero_ps();
+      __m128 exit = max_t[g];
+      __m128 missed = _mm_setzero_ps();
+      Slab(node_min_x, node_max_x, origin_x[g], inverse_x[g], parallel_x[g], enter, exit, missed);
+      Slab(node_min_y, node_max_y, origin_y[g], inverse_y[g], parallel_y[g], enter, exit, missed);
+      Slab(node_min_z, node_max_z, origin_z[g], inverse_z[g], parallel_z[g], enter, exit, missed);
+      hits |= (unsigned int)_mm_movemask_ps(_mm_andnot_ps(missed, _mm_cmple_ps(enter, exit))) << (g * 4);
+    }
+    return hits & mask;
+  }
+};
+
+enum FrustumOverlap
+{
+  FRUSTUM_OUTSIDE,
+  FRUSTUM_INTERSECTS,
+  FRUSTUM_INSIDE
+};
+
+static FrustumOverlap ClassifyBox(const Frustum& frustum, const Aabb& box)
+{
+  glm::vec3 center = box.Center();
+  glm::vec3 extent = box.Extent();
+  FrustumOverlap overlap = FRUSTUM_INSIDE;
+  for(int i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+  {
+    const glm::vec4& plane = frustum.Plane((FrustumPlane)i);
+    glm::vec3 normal(plane);
+    float distance = glm::dot(normal, center) + plane.w;
+    float reach = glm::dot(glm::abs(normal), extent);
+    if(distance + reach <= 0.0f)
+      return FRUSTUM_OUTSIDE;
+    if(distance - reach < 0.0f)
+      overlap = FRUSTUM_INTERSECTS;
+  }
+  return overlap;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The stack a query walks the tree with.  It lives in the query's frame
+// and only goes on into a vector if the tree is deeper than it should
+// ever get.
+//////////////////////////////////////////////////////////////////////////////
+template<class Entry> class QueryStack
+{
+  Entry _entries[MAX_QUERY_STACK];
+  std::vector<Entry> _overflow;
+  unsigned int _size;
+
+public:
+  QueryStack() : _size(0) {}
+
+  bool Empty() const { return _size == 0; }
+  void Clear()
+  {
+    _size = 0;
+    _overflow.clear();
+  }
+  void Push(const Entry& entry)
+  {
+    if(_size < MAX_QUERY_STACK)
+      _entries[_size] = entry;
+    else
+      _overflow.push_back(entry);
+    ++_size;
+  }
+  Entry Pop()
+  {
+    --_size;
+    if(_size < MAX_QUERY_STACK)
+      return _entries[_size];
+    Entry entry = _overflow.back();
+    _overflow.pop_back();
+    return entry;
+  }
+};
+
+//what the batched queries and the frustum query keep for each node on the stack
+struct MaskedNode
+{
+  unsigned int node;
+  unsigned int mask;
+};
+
+struct FrustumNode
+{
+  unsigned int node;
+  bool inside;
+};
+
+#pragma endregion
+
+AabbTree* AabbTree::_global = 0;
+
+AabbTree::AabbTree(float margin, bool set_as_global)
+{
+  _root = NULL_NODE;
+  _free = NULL_NODE;
+  _num_proxies = 0;
+  _margin = margin;
+
+  if(set_as_global)
+  {
+    if(_global)
+      SOL_ERROR("Attempting to create two global AABB trees! Actors will use the new one.");
+    _global = this;
+  }
+}
+
+AabbTree::~AabbTree()
+{
+  if(_global == this)
+    _global = 0;
+}
+
+ProxyId AabbTree::Insert(const Aabb& box, ActorId actor)
+{
+  unsigned int leaf = AllocateNode();
+  Node& node = _nodes[leaf];
+  node.box = Aabb(box.min - glm::vec3(_margin), box.max + glm::vec3(_margin));
+  node.actor = actor;
+  node.height = 0;
+  InsertLeaf(leaf);
+  ++_num_proxies;
+  return leaf;
+}
+
+void AabbTree::Remove(ProxyId proxy)
+{
+  SOL_ASSERT(proxy < _nodes.size() && _nodes[proxy].IsLeaf() && _nodes[proxy].height == 0);
+  RemoveLeaf(proxy);
+  FreeNode(proxy);
+  --_num_proxies;
+}
+
+bool AabbTree::Move(ProxyId proxy, const Aabb& box)
+{
+  SOL_ASSERT(proxy < _nodes.size() && _nodes[proxy].IsLeaf() && _nodes[proxy].height == 0);
+  if(_nodes[proxy].box.Contains(box))
+    return false;
+
+  RemoveLeaf(proxy);
+  _nodes[proxy].box = Aabb(box.min - glm::vec3(_margin), box.max + glm::vec3(_margin));
+  InsertLeaf(proxy);
+  return true;
+}
+
+float AabbTree::AreaRatio() const
+{
+  if(_root == NULL_NODE || _nodes[_root].IsLeaf())
+    return 0.0f;
+
+  float total = 0.0f;
+  for(unsigned int i = 0; i < _nodes.size(); ++i)
+  {
+    if(_nodes[i].height > 0)
+      total += _nodes[i].box.SurfaceArea();
+  }
+  return total / _nodes[_root].box.SurfaceArea();
+}
+
+unsigned int AabbTree::AllocateNode()
+{
+  unsigned int node;
+  if(_free != NULL_NODE)
+  {
+    node = _free;
+    _free = _nodes[node].parent;
+  }
+  else
+  {
+    node = (unsigned int)_nodes.size();
+    _nodes.push_back(Node());
+  }
+  _nodes[node].parent = NULL_NODE;
+  _nodes[node].child[0] = NULL_NODE;
+  _nodes[node].child[1] = NULL_NODE;
+  _nodes[node].height = 0;
+  _nodes[node].actor = INVALID_ACTOR_ID;
+  return node;
+}
+
+void AabbTree::FreeNode(unsigned int node)
+{
+  _nodes[node].parent = _free;
+  _nodes[node].height = -1;
+  _free = node;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Walks down from the root towards the cheapest sibling for the new leaf.
+// Going down a node costs the area it grows by, which every node below it
+// also pays, so the walk stops as soon as pairing with the current node is
+// cheaper than going into either child.
+//////////////////////////////////////////////////////////////////////////////
+void AabbTree::InsertLeaf(unsigned int leaf)
+{
+  if(_root == NULL_NODE)
+  {
+    _root = leaf;
+    _nodes[leaf].parent = NULL_NODE;
+    return;
+  }
+
+  Aabb box = _nodes[leaf].box;
+  unsigned int sibling = _root;
+  while(!_nodes[sibling].IsLeaf())
+  {
+    const Node& node = _nodes[sibling];
+    float area = node.box.SurfaceArea();
+    float combined_area = Aabb::Union(node.box, box).SurfaceArea();
+
+    //pairing with this node makes a new parent with the combined area
+    float cost = 2.0f * combined_area;
+    //the least going down has to pay
+    float inherited = 2.0f * (combined_area - area);
+
+    float child_cost[2];
+    for(int c = 0; c < 2; ++c)
+    {
+      const Node& child = _nodes[node.child[c]];
+      float grown = Aabb::Union(child.box, box).SurfaceArea();
+      child_cost[c] = (child.IsLeaf() ? grown : grown - child.box.SurfaceArea()) + inherited;
+    }
+
+    if(cost < child_cost[0] && cost < child_cost[1])
+      break;
+    sibling = child_cost[0] < child_cost[1] ? node.child[0] : node.child[1];
+  }
+
+  //the new parent takes the sibling's place
+  unsigned int old_parent = _nodes[sibling].parent;
+  unsigned int new_parent = AllocateNode();
+  Node& parent = _nodes[new_parent];
+  parent.parent = old_parent;
+  parent.box = Aabb::Union(box, _nodes[sibling].box);
+  parent.height = _nodes[sibling].height + 1;
+  parent.child[0] = sibling;
+  parent.child[1] = leaf;
+  _nodes[sibling].parent = new_parent;
+  _nodes[leaf].parent = new_parent;
+
+  if(old_parent == NULL_NODE)
+    _root = new_parent;
+  else if(_nodes[old_parent].child[0] == sibling)
+    _nodes[old_parent].child[0] = new_parent;
+  else
+    _nodes[old_parent].child[1] = new_parent;
+
+  Refit(old_parent);
+}
+
+//the leaf's sibling takes their parent's place
+void AabbTree::RemoveLeaf(unsigned int leaf)
+{
+  if(leaf == _root)
+  {
+    _root = NULL_NODE;
+    return;
+  }
+
+  unsigned int parent = _nodes[leaf].parent;
+  unsigned int grandparent = _nodes[parent].parent;
+  unsigned int sibling = _nodes[parent].child[0] == leaf ? _nodes[parent].child[1] : _nodes[parent].child[0];
+
+  _nodes[sibling].parent = grandparent;
+  if(grandparent == NULL_NODE)
+    _root = sibling;
+  else if(_nodes[grandparent].child[0] == parent)
+    _nodes[grandparent].child[0] = sibling;
+  else
+    _nodes[grandparent].child[1] = sibling;
+  FreeNode(parent);
+
+  Refit(grandparent);
+}
+
+//balances and refits node and everything above it
+void AabbTree::Refit(unsigned int node)
+{
+  while(node != NULL_NODE)
+  {
+    node = Balance(node);
+
+    Node& n = _nodes[node];
+    const Node& a = _nodes[n.child[0]];
+    const Node& b = _nodes[n.child[1]];
+    n.height = 1 + std::max(a.height, b.height);
+    n.box = Aabb::Union(a.box, b.box);
+    node = n.parent;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// If one of node's children is more than one level taller than the other,
+// the taller child is rotated up into node's place.  node takes the
+// shorter of the taller child's children, and the child keeps the other.
+// Returns the node now in node's place.
+//////////////////////////////////////////////////////////////////////////////
+unsigned int AabbTree::Balance(unsigned int node)
+{
+  Node& a = _nodes[node];
+  if(a.IsLeaf() || a.height < 2)
+    return node;
+
+  int balance = _nodes[a.child[1]].height - _nodes[a.child[0]].height;
+  if(balance >= -1 && balance <= 1)
+    return node;
+
+  //the side that is too tall, and the other
+  int tall = balance > 1 ? 1 : 0;
+  unsigned int up = a.child[tall];
+  unsigned int other = a.child[1 - tall];
+  Node& b = _nodes[up];
+
+  //b goes up into a's place and a becomes b's first child
+  b.parent = a.parent;
+  a.parent = up;
+  if(b.parent == NULL_NODE)
+    _root = up;
+  else if(_nodes[b.parent].child[0] == node)
+    _nodes[b.parent].child[0] = up;
+  else
+    _nodes[b.parent].child[1] = up;
+
+  unsigned int keep = b.child[0];
+  unsigned int give = b.child[1];
+  if(_nodes[give].height > _nodes[keep].height)
+    std::swap(keep, give);
+
+  b.child[0] = node;
+  b.child[1] = keep;
+  a.child[tall] = give;
+  _nodes[give].parent = node;
+
+  a.box = Aabb::Union(_nodes[other].box, _nodes[give].box);
+  a.height = 1 + std::max(_nodes[other].height, _nodes[give].height);
+  b.box = Aabb::Union(a.box, _nodes[keep].box);
+  b.height = 1 + std::max(a.height, _nodes[keep].height);
+  return up;
+}
+
+#pragma region Queries
+
+template<class Test> void AabbTree::Query(const Test& test, std::vector<ActorId>& results) const
+{
+  if(_root == NULL_NODE)
+    return;
+
+  QueryStack<unsigned int> stack;
+  stack.Push(_root);
+  while(!stack.Empty())
+  {
+    const Node& node = _nodes[stack.Pop()];
+    if(!Hits(test, node.box))
+      continue;
+
+    if(node.IsLeaf())
+    {
+      results.push_back(node.actor);
+    }
+    else
+    {
+      stack.Push(node.child[1]);
+      stack.Push(node.child[0]);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Each stack entry carries a mask of the queries still going down that
+// part of the tree.  A node is tested against the queries in its mask and
+// its children get the mask of the ones that hit it.
+//////////////////////////////////////////////////////////////////////////////
+template<class Packet, class Input> void AabbTree::BatchQuery(const Input* queries, unsigned int count, std::vector<AabbTreeHit>& hits) const
+{
+  if(_root == NULL_NODE)
+    return;
+
+  Packet packet;
+  QueryStack<MaskedNode> stack;
+  for(unsigned int first = 0; first < count; first += QUERIES_PER_BATCH)
+  {
+    unsigned int batch = std::min(QUERIES_PER_BATCH, count - first);
+    packet.Load(queries + first, batch);
+
+    MaskedNode entry;
+    entry.node = _root;
+    entry.mask = batch == 32 ? 0xffffffff : (1u << batch) - 1;
+    stack.Clear();
+    stack.Push(entry);
+    while(!stack.Empty())
+    {
+      entry = stack.Pop();
+      const Node& node = _nodes[entry.node];
+      unsigned int hit_mask = packet.Hits(node.box, entry.mask);
+      if(hit_mask == 0)
+        continue;
+
+      if(node.IsLeaf())
+      {
+        for(unsigned int q = 0; q < batch; ++q)
+        {
+          if(hit_mask & (1u << q))
+          {
+            AabbTreeHit hit;
+            hit.query = first + q;
+            hit.actor = node.actor;
+            hits.push_back(hit);
+          }
+        }
+      }
+      else
+      {
+        entry.mask = hit_mask;
+        entry.node = node.child[1];
+        stack.Push(entry);
+        entry.node = node.child[0];
+        stack.Push(entry);
+      }
+    }
+  }
+}
+
+void AabbTree::QueryBox(const Aabb& box, std::vector<ActorId>& results) const
+{
+  Query(box, results);
+}
+
+void AabbTree::QuerySphere(const glm::vec3& center, float radius, std::vector<ActorId>& results) const
+{
+  SphereTest test;
+  test.center = center;
+  test.radius_squared = radius * radius;
+  Query(test, results);
+}
+
+void AabbTree::QueryRay(const AabbTreeRay& ray, std::vector<ActorId>& results) const
+{
+  Query(MakeRayTest(ray), results);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Once a node is wholly inside the frustum so is everything below it, so
+// its leaves are added without testing them.
+//////////////////////////////////////////////////////////////////////////////
+void AabbTree::QueryFrustum(const Frustum& frustum, std::vector<ActorId>& results) const
+{
+  if(_root == NULL_NODE)
+    return;
+
+  QueryStack<FrustumNode> stack;
+  FrustumNode entry;
+  entry.node = _root;
+  entry.inside = false;
+  stack.Push(entry);
+  while(!stack.Empty())
+  {
+    entry = stack.Pop();
+    const Node& node = _nodes[entry.node];
+    bool node_inside = entry.inside;
+    if(!node_inside)
+    {
+      FrustumOverlap overlap = ClassifyBox(frustum, node.box);
+      if(overlap == FRUSTUM_OUTSIDE)
+        continue;
+      node_inside = overlap == FRUSTUM_INSIDE;
+    }
+
+    if(node.IsLeaf())
+    {
+      results.push_back(node.actor);
+    }
+    else
+    {
+      entry.inside = node_inside;
+      entry.node = node.child[1];
+      stack.Push(entry);
+      entry.node = node.child[0];
+      stack.Push(entry);
+    }
+  }
+}
+
+void AabbTree::QueryBoxes(const Aabb* boxes, unsigned int count, std::vector<AabbTreeHit>& hits) const
+{
+  BatchQuery<BoxPacket>(boxes, count, hits);
+}
+
+void AabbTree::QueryRays(const AabbTreeRay* rays, unsigned int count, std::vector<AabbTreeHit>& hits) const
+{
+  BatchQuery<RayPacket>(rays, count, hits);
+}
+
+#pragma endregion
@@ -0,0 +1,111 @@
+#pragma once
+//========================================================================
+// AabbTree.h : A dynamic bounding volume hierarchy of actors
+//
+// Each actor registers a box and gets back a proxy.  The tree stores a
+// slightly larger "fat" box for it, so an actor moving a little inside
+// its fat box costs nothing.  Once it moves out, its leaf is removed and
+// inserted again.
+//
+// A new leaf goes next to the sibling that adds the least surface area to
+// the tree.  Every box on the way back up to the root is refit, and any
+// node whose children's heights differ by more than one is rotated, so
+// the tree stays balanced however the actors are added and moved.
+//
+// The queries walk the tree with a small stack and return every actor
+// whose fat box passes the test, in no particular order.  The batched
+// queries take up to 32 queries down the tree together, so each node is
+// loaded once for all of them and tested against four at a time with SSE.
+// Batches go furthest when queries near each other are next to each other.
+//
+// The queries are const and can be run from several threads at once, as
+// long as nothing changes the tree meanwhile.
+//
+// Actors register themselves in the global tree with Actor::SetBounds(),
+// and take themselves out when they are destroyed.
+//========================================================================
+
+#include "Aabb.h"
+
+class Frustum;
+
+typedef unsigned int ProxyId;
+const ProxyId INVALID_PROXY_ID = UINT_MAX;
+
+struct AabbTreeRay
+{
+  glm::vec3 origin;
+  glm::vec3 direction;    //doesnt need to be normalised, the ray is origin + direction * t.  Components may be 0.
+  float max_t;
+};
+
+//an actor found by one of a batch of queries
+struct AabbTreeHit
+{
+  unsigned int query;     //index into the batch
+  ActorId actor;
+};
+
+class AabbTree : public SOL_noncopyable
+{
+  struct Node
+  {
+    Aabb box;
+    unsigned int parent;    //the next free node when on the free list
+    unsigned int child[2];  //UINT_MAX for a leaf
+    int height;             //0 for a leaf, -1 when free
+    ActorId actor;
+
+    bool IsLeaf() const { return child[0] == UINT_MAX; }
+  };
+
+  std::vector<Node> _nodes;
+  unsigned int _root;
+  unsigned int _free;
+  unsigned int _num_proxies;
+  float _margin;
+
+  static AabbTree* _global;
+
+public:
+  //margin is how far the fat boxes reach past the real ones on every side.  Actors
+  //register in the global tree.
+  explicit AabbTree(float margin = 0.1f, bool set_as_global = false);
+  ~AabbTree();
+
+  static AabbTree* Get() { return _global; }
+
+  ProxyId Insert(const Aabb& box, ActorId actor);
+  void Remove(ProxyId proxy);
+  //returns true if the box left its fat box and the proxy was reinserted
+  bool Move(ProxyId proxy, const Aabb& box);
+
+  ActorId Actor(ProxyId proxy) const { return _nodes[proxy].actor; }
+  const Aabb& FatBox(ProxyId proxy) const { return _nodes[proxy].box; }
+
+  //results are appended
+  void QueryBox(const Aabb& box, std::vector<ActorId>& results) const;
+  void QuerySphere(const glm::vec3& center, float radius, std::vector<ActorId>& results) const;
+  void QueryRay(const AabbTreeRay& ray, std::vector<ActorId>& results) const;
+  void QueryFrustum(const Frustum& frustum, std::vector<ActorId>& results) const;
+
+  //hits are appended, grouped by runs of 32 queries
+  void QueryBoxes(const Aabb* boxes, unsigned int count, std::vector<AabbTreeHit>& hits) const;
+  void QueryRays(const AabbTreeRay* rays, unsigned int count, std::vector<AabbTreeHit>& hits) const;
+
+  unsigned int NumProxies() const { return _num_proxies; }
+  int Height() const { return _root == UINT_MAX ? 0 : _nodes[_root].height; }
+  //sum of every internal node's surface area over the root's, lower is better
+  float AreaRatio() const;
+
+private:
+  unsigned int AllocateNode();
+  void FreeNode(unsigned int node);
+  void InsertLeaf(unsigned int leaf);
+  void RemoveLeaf(unsigned int leaf);
+  void Refit(unsigned int node);
+  unsigned int Balance(unsigned int node);
+
+  template<class Test> void Query(const Test& test, std::vector<ActorId>& results) const;
+  template<class Packet, class Input> void BatchQuery(const Input* queries, unsigned int count, std::vector<AabbTreeHit>& hits) const;
+};
@@ -0,0 +1,77 @@
+#include "EngineStd.h"
+#include "Frustum.h"
+
+Frustum::Frustum()
+{
+  for(int i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+    _planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+Frustum::Frustum(const glm::mat4& view_projection)
+{
+  Set(view_projection);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// A point is inside when -w <= x, y, z <= w after the projection, so each
+// plane is the matrix's last row plus or minus one of the others.
+//////////////////////////////////////////////////////////////////////////////
+void Frustum::Set(const glm::mat4& view_projection)
+{
+  //glm is column major, so row r is the r'th element of each column
+  glm::vec4 rows[4];
+  for(int r = 0; r < 4; ++r)
+    rows[r] = glm::vec4(view_projection[0][r], view_projection[1][r], view_projection[2][r], view_projection[3][r]);
+
+  _planes[FRUSTUM_LEFT] = rows[3] + rows[0];
+  _planes[FRUSTUM_RIGHT] = rows[3] - rows[0];
+  _planes[FRUSTUM_BOTTOM] = rows[3] + rows[1];
+  _planes[FRUSTUM_TOP] = rows[3] - rows[1];
+  _planes[FRUSTUM_NEAR] = rows[3] + rows[2];
+  _planes[FRUSTUM_FAR] = rows[3] - rows[2];
+
+  for(int i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+  {
+    float length = glm::length(glm::vec3(_planes[i]));
+    if(length > 0.0f)
+      _planes[i] /= length;
+  }
+}
+
+bool Frustum::TestPoint(const glm::vec3& point) const
+{
+  for(int i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+  {
+    if(glm::dot(glm::vec3(_planes[i]), point) + _planes[i].w < 0.0f)
+      return false;
+  }
+  return true;
+}
+
+bool Frustum::TestSphere(const glm::vec3& center, float radius) const
+{
+  for(int i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+  {
+    if(glm::dot(glm::vec3(_planes[i]), center) + _planes[i].w <= -radius)
+      return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The box is outside a plane if the corner furthest along its normal is.
+// That corner's distance is the center's plus the extent projected onto
+// the normal's absolute value.
+//////////////////////////////////////////////////////////////////////////////
+bool Frustum::TestBox(const glm::vec3& min, const glm::vec3& max) const
+{
+  glm::vec3 center = (min + max) * 0.5f;
+  glm::vec3 extent = (max - min) * 0.5f;
+  for(int i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+  {
+    glm::vec3 normal(_planes[i]);
+    if(glm::dot(normal, center) + _planes[i].w + glm::dot(glm::abs(normal), extent) <= 0.0f)
+      return false;
+  }
+  return true;
+}
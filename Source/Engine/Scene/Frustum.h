@@ -0,0 +1,42 @@
+#pragma once
+//========================================================================
+// Frustum.h : The six planes of a view frustum
+//
+// The planes are pulled straight out of a projection * view matrix, so
+// they are in world space, and normalised so a plane's w plus its dot
+// product with a point is the point's distance from it.  Normals point
+// into the frustum.  The matrix is taken to use GL's -1 to 1 depth range.
+//
+// The tests are conservative.  A box near a corner can be outside the
+// frustum but inside every plane, and it counts as visible.
+//========================================================================
+
+#include "3rdParty/glm-0.9.3.4/glm/glm.hpp"
+
+enum FrustumPlane
+{
+  FRUSTUM_LEFT,
+  FRUSTUM_RIGHT,
+  FRUSTUM_BOTTOM,
+  FRUSTUM_TOP,
+  FRUSTUM_NEAR,
+  FRUSTUM_FAR,
+  NUM_FRUSTUM_PLANES
+};
+
+class Frustum
+{
+  glm::vec4 _planes[NUM_FRUSTUM_PLANES];
+
+public:
+  //contains everything
+  Frustum();
+  explicit Frustum(const glm::mat4& view_projection);
+
+  void Set(const glm::mat4& view_projection);
+  const glm::vec4& Plane(FrustumPlane plane) const { return _planes[plane]; }
+
+  bool TestPoint(const glm::vec3& point) const;
+  bool TestSphere(const glm::vec3& center, float radius) const;
+  bool TestBox(const glm::vec3& min, const glm::vec3& max) const;
+};
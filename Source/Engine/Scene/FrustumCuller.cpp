@@ -0,0 +1,403 @@
+#include "EngineStd.h"
+#include "FrustumCuller.h"
+#include "../Math/BatchMath.h"
+#include "../Multicore/JobSystem.h"
+#include <immintrin.h>
+
+//volumes per job.  Fewer than this are culled on the calling thread.
+const unsigned int VOLUMES_PER_JOB = 16384;
+
+#pragma region Bounding Volumes
+
+unsigned int BoundingSpheres::Add(const glm::vec3& center, float radius)
+{
+  _x.push_back(center.x);
+  _y.push_back(center.y);
+  _z.push_back(center.z);
+  _radius.push_back(radius);
+  return Count() - 1;
+}
+
+void BoundingSpheres::Set(unsigned int index, const glm::vec3& center, float radius)
+{
+  _x[index] = center.x;
+  _y[index] = center.y;
+  _z[index] = center.z;
+  _radius[index] = radius;
+}
+
+void BoundingSpheres::Remove(unsigned int index)
+{
+  unsigned int last = Count() - 1;
+  Set(index, Center(last), Radius(last));
+  _x.pop_back();
+  _y.pop_back();
+  _z.pop_back();
+  _radius.pop_back();
+}
+
+void BoundingSpheres::Clear()
+{
+  _x.clear();
+  _y.clear();
+  _z.clear();
+  _radius.clear();
+}
+
+unsigned int BoundingBoxes::Add(const glm::vec3& min, const glm::vec3& max)
+{
+  _center_x.push_back(0.0f);
+  _center_y.push_back(0.0f);
+  _center_z.push_back(0.0f);
+  _extent_x.push_back(0.0f);
+  _extent_y.push_back(0.0f);
+  _extent_z.push_back(0.0f);
+  Set(Count() - 1, min, max);
+  return Count() - 1;
+}
+
+void BoundingBoxes::Set(unsigned int index, const glm::vec3& min, const glm::vec3& max)
+{
+  glm::vec3 center = (min + max) * 0.5f;
+  glm::vec3 extent = (max - min) * 0.5f;
+  _center_x[index] = center.x;
+  _center_y[index] = center.y;
+  _center_z[index] = center.z;
+  _extent_x[index] = extent.x;
+  _extent_y[index] = extent.y;
+  _extent_z[index] = extent.z;
+}
+
+void BoundingBoxes::Remove(unsigned int index)
+{
+  unsigned int last = Count() - 1;
+  _center_x[index] = _center_x[last];
+  _center_y[index] = _center_y[last];
+  _center_z[index] = _center_z[last];
+  _extent_x[index] = _extent_x[last];
+  _extent_y[index] = _extent_y[last];
+  _extent_z[index] = _extent_z[last];
+  _center_x.pop_back();
+  _center_y.pop_back();
+  _center_z.pop_back();
+  _extent_x.pop_back();
+  _extent_y.pop_back();
+  _extent_z.pop_back();
+}
+
+void BoundingBoxes::Clear()
+{
+  _center_x.clear();
+  _center_y.clear();
+  _center_z.clear();
+  _extent_x.clear();
+  _extent_y.clear();
+  _extent_z.clear();
+}
+
+#pragma endregion
+
+#pragma region Kernels
+
+//////////////////////////////////////////////////////////////////////////////
+// Every kernel tests [begin, end) and writes the visible indices to
+// visible[0], visible[1] and so on, returning how many it wrote.  The SIMD
+// ones do the sums in the same order as the scalar ones, so all of them
+// give the same answer for the same volume.
+//////////////////////////////////////////////////////////////////////////////
+
+//the culler's arrays for one Cull()
+struct CullArrays
+{
+  const float* x;
+  const float* y;
+  const float* z;
+  const float* radius;    //spheres only
+  const float* extent_x;  //boxes only
+  const float* extent_y;
+  const float* extent_z;
+};
+
+//writes base plus the index of each set bit of mask, without branching on the bits
+static inline unsigned int Append(unsigned int* visible, unsigned int count, unsigned int base, int mask, int width)
+{
+  for(int k = 0; k < width; ++k)
+  {
+    visible[count] = base + k;
+    count += (mask >> k) & 1;
+  }
+  return count;
+}
+
+static unsigned int CullSpheresScalar(const Frustum& frustum, const CullArrays& a, unsigned int begin, unsigned int end, unsigned int* visible)
+{
+  unsigned int count = 0;
+  for(unsigned int i = begin; i < end; ++i)
+  {
+    bool inside = true;
+    for(int p = 0; p < NUM_FRUSTUM_PLANES && inside; ++p)
+    {
+      const glm::vec4& plane = frustum.Plane((FrustumPlane)p);
+      float d = ((plane.x * a.x[i] + plane.y * a.y[i]) + plane.z * a.z[i]) + plane.w;
+      inside = d > -a.radius[i];
+    }
+    if(inside)
+      visible[count++] = i;
+  }
+  return count;
+}
+
+static unsigned int CullBoxesScalar(const Frustum& frustum, const CullArrays& a, unsigned int begin, unsigned int end, unsigned int* visible)
+{
+  unsigned int count = 0;
+  for(unsigned int i = begin; i < end; ++i)
+  {
+    bool inside = true;
+    for(int p = 0; p < NUM_FRUSTUM_PLANES && inside; ++p)
+    {
+      const glm::vec4& plane = frustum.Plane((FrustumPlane)p);
+      float d = ((plane.x * a.x[i] + plane.y * a.y[i]) + plane.z * a.z[i]) + plane.w;
+      float r = (fabsf(plane.x) * a.extent_x[i] + fabsf(plane.y) * a.extent_y[i]) + fabsf(plane.z) * a.extent_z[i];
+      inside = d + r > 0.0f;
+    }
+    if(inside)
+      visible[count++] = i;
+  }
+  return count;
+}
+
+static unsigned int CullSpheresSSE(const Frustum& frustum, const CullArrays& a, unsigned int begin, unsigned int end, unsigned int* visible)
+{
+  __m128 nx[NUM_FRUSTUM_PLANES], ny[NUM_FRUSTUM_PLANES], nz[NUM_FRUSTUM_PLANES], nw[NUM_FRUSTUM_PLANES];
+  for(int p = 0; p < NUM_FRUSTUM_PLANES; ++p)
+  {
+    const glm::vec4& plane = frustum.Plane((FrustumPlane)p);
+    nx[p] = _mm_set1_ps(plane.x);
+    ny[p] = _mm_set1_ps(plane.y);
+    nz[p] = _mm_set1_ps(plane.z);
+    nw[p] = _mm_set1_ps(plane.w);
+  }
+
+  unsigned int count = 0;
+  unsigned int i = begin;
+  for(; i + 4 <= end; i += 4)
+  {
+    __m128 x = _mm_loadu_ps(a.x + i), y = _mm_loadu_ps(a.y + i), z = _mm_loadu_ps(a.z + i);
+    __m128 neg_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(a.radius + i));
+    __m128 inside = _mm_cmpeq_ps(x, x);
+    for(int p = 0; p < NUM_FRUSTUM_PLANES; ++p)
+    {
+      __m128 d = _mm_add_ps(_mm_mul_ps(nx[p], x), _mm_mul_ps(ny[p], y));
+      d = _mm_add_ps(_mm_add_ps(d, _mm_mul_ps(nz[p], z)), nw[p]);
+      inside = _mm_and_ps(inside, _mm_cmpgt_ps(d, neg_radius));
+    }
+    count = Append(visible, count, i, _mm_movemask_ps(inside), 4);
+  }
+  return count + CullSpheresScalar(frustum, a, i, end, visible + count);
+}
+
+static unsigned int CullBoxesSSE(const Frustum& frustum, const CullArrays& a, unsigned int begin, unsigned int end, unsigned int* visible)
+{
+  __m128 nx[NUM_FRUSTUM_PLANES], ny[NUM_FRUSTUM_PLANES], nz[NUM_FRUSTUM_PLANES], nw[NUM_FRUSTUM_PLANES];
+  __m128 ax[NUM_FRUSTUM_PLANES], ay[NUM_FRUSTUM_PLANES], az[NUM_FRUSTUM_PLANES];
+  for(int p = 0; p < NUM_FRUSTUM_PLANES; ++p)
+  {
+    const glm::vec4& plane = frustum.Plane((FrustumPlane)p);
+    nx[p] = _mm_set1_ps(plane.x);
+    ny[p] = _mm_set1_ps(plane.y);
+    nz[p] = _mm_set1_ps(plane.z);
+    nw[p] = _mm_set1_ps(plane.w);
+    ax[p] = _mm_set1_ps(fabs(plane.x));
+    ay[p] = _mm_set1_ps(fabs(plane.y));
+    az[p] = _mm_set1_ps(fabs(plane.z));
+  }
+
+  const __m128 zero = _mm_setzero_ps();
+  unsigned int count = 0;
+  unsigned int i = begin;
+  for(; i + 4 <= end; i += 4)
+  {
+    __m128 x = _mm_loadu_ps(a.x + i), y = _mm_loadu_ps(a.y + i), z = _mm_loadu_ps(a.z + i);
+    __m128 ex = _mm_loadu_ps(a.extent_x + i), ey = _mm_loadu_ps(a.extent_y + i), ez = _mm_loadu_ps(a.extent_z + i);
+    __m128 inside = _mm_cmpeq_ps(x, x);
+    for(int p = 0; p < NUM_FRUSTUM_PLANES; ++p)
+    {
+      __m128 d = _mm_add_ps(_mm_mul_ps(nx[p], x), _mm_mul_ps(ny[p], y));
+      d = _mm_add_ps(_mm_add_ps(d, _mm_mul_ps(nz[p], z)), nw[p]);
+      __m128 r = _mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey));
+      r = _mm_add_ps(r, _mm_mul_ps(az[p], ez));
+      inside = _mm_and_ps(inside, _mm_cmpgt_ps(_mm_add_ps(d, r), zero));
+    }
+    count = Append(visible, count, i, _mm_movemask_ps(inside), 4);
+  }
+  return count + CullBoxesScalar(frustum, a, i, end, visible + count);
+}
+
+static unsigned int CullSpheresAVX(const Frustum& frustum, const CullArrays& a, unsigned int begin, unsigned int end, unsigned int* visible)
+{
+  __m256 nx[NUM_FRUSTUM_PLANES], ny[NUM_FRUSTUM_PLANES], nz[NUM_FRUSTUM_PLANES], nw[NUM_FRUSTUM_PLANES];
+  for(int p = 0; p < NUM_FRUSTUM_PLANES; ++p)
+  {
+    const glm::vec4& plane = frustum.Plane((FrustumPlane)p);
+    nx[p] = _mm256_set1_ps(plane.x);
+    ny[p] = _mm256_set1_ps(plane.y);
+    nz[p] = _mm256_set1_ps(plane.z);
+    nw[p] = _mm256_set1_ps(plane.w);
+  }
+
+  unsigned int count = 0;
+  unsigned int i = begin;
+  for(; i + 8 <= end; i += 8)
+  {
+    __m256 x = _mm256_loadu_ps(a.x + i), y = _mm256_loadu_ps(a.y + i), z = _mm256_loadu_ps(a.z + i);
+    __m256 neg_radius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(a.radius + i));
+    __m256 inside = _mm256_cmp_ps(x, x, _CMP_EQ_OQ);
+    for(int p = 0; p < NUM_FRUSTUM_PLANES; ++p)
+    {
+      __m256 d = _mm256_add_ps(_mm256_mul_ps(nx[p], x), _mm256_mul_ps(ny[p], y));
+      d = _mm256_add_ps(_mm256_add_ps(d, _mm256_mul_ps(nz[p], z)), nw[p]);
+      inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, neg_radius, _CMP_GT_OQ));
+    }
+    count = Append(visible, count, i, _mm256_movemask_ps(inside), 8);
+  }
+  _mm256_zeroupper();
+  return count + CullSpheresScalar(frustum, a, i, end, visible + count);
+}
+
+static unsigned int CullBoxesAVX(const Frustum& frustum, const CullArrays& a, unsigned int begin, unsigned int end, unsigned int* visible)
+{
+  __m256 nx[NUM_FRUSTUM_PLANES], ny[NUM_FRUSTUM_PLANES], nz[NUM_FRUSTUM_PLANES], nw[NUM_FRUSTUM_PLANES];
+  __m256 ax[NUM_FRUSTUM_PLANES], ay[NUM_FRUSTUM_PLANES], az[NUM_FRUSTUM_PLANES];
+  for(int p = 0; p < NUM_FRUSTUM_PLANES; ++p)
+  {
+    const glm::vec4& plane = frustum.Plane((FrustumPlane)p);
+    nx[p] = _mm256_set1_ps(plane.x);
+    ny[p] = _mm256_set1_ps(plane.y);
+    nz[p] = _mm256_set1_ps(plane.z);
+    nw[p] = _mm256_set1_ps(plane.w);
+    ax[p] = _mm256_set1_ps(fabs(plane.x));
+    ay[p] = _mm256_set1_ps(fabs(plane.y));
+    az[p] = _mm256_set1_ps(fabs(plane.z));
+  }
+
+  const __m256 zero = _mm256_setzero_ps();
+  unsigned int count = 0;
+  unsigned int i = begin;
+  for(; i + 8 <= end; i += 8)
+  {
+    __m256 x = _mm256_loadu_ps(a.x + i), y = _mm256_loadu_ps(a.y + i), z = _mm256_loadu_ps(a.z + i);
+    __m256 ex = _mm256_loadu_ps(a.extent_x + i), ey = _mm256_loadu_ps(a.extent_y + i), ez = _mm256_loadu_ps(a.extent_z + i);
+    __m256 inside = _mm256_cmp_ps(x, x, _CMP_EQ_OQ);
+    for(int p = 0; p < NUM_FRUSTUM_PLANES; ++p)
+    {
+      __m256 d = _mm256_add_ps(_mm256_mul_ps(nx[p], x), _mm256_mul_ps(ny[p], y));
+      d = _mm256_add_ps(_mm256_add_ps(d, _mm256_mul_ps(nz[p], z)), nw[p]);
+      __m256 r = _mm256_add_ps(_mm256_mul_ps(ax[p], ex), _mm256_mul_ps(ay[p], ey));
+      r = _mm256_add_ps(r, _mm256_mul_ps(az[p], ez));
+      inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_GT_OQ));
+    }
+    count = Append(visible, count, i, _mm256_movemask_ps(inside), 8);
+  }
+  _mm256_zeroupper();
+  return count + CullBoxesScalar(frustum, a, i, end, visible + count);
+}
+
+#pragma endregion
+
+FrustumCuller::FrustumCuller(JobSystem* jobs)
+{
+  _jobs = jobs;
+  _num_visible = 0;
+  _frustum = 0;
+  _spheres = 0;
+  _boxes = 0;
+  _path = BATCH_MATH_SCALAR;
+}
+
+unsigned int FrustumCuller::Cull(const Frustum& frustum, const BoundingSpheres& spheres)
+{
+  _frustum = &frustum;
+  _spheres = &spheres;
+  _boxes = 0;
+  return Run(spheres.Count());
+}
+
+unsigned int FrustumCuller::Cull(const Frustum& frustum, const BoundingBoxes& boxes)
+{
+  _frustum = &frustum;
+  _spheres = 0;
+  _boxes = &boxes;
+  return Run(boxes.Count());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Job n writes its indices from _visible[n * VOLUMES_PER_JOB] on, so once
+// they have all finished each job's run is moved down against the last.
+//////////////////////////////////////////////////////////////////////////////
+unsigned int FrustumCuller::Run(unsigned int count)
+{
+  _num_visible = 0;
+  if(count == 0)
+    return 0;
+
+  if(_visible.size() < count)
+    _visible.resize(count);
+  _path = GetBatchMathPath();
+  _chunk_visible.assign((count + VOLUMES_PER_JOB - 1) / VOLUMES_PER_JOB, 0);
+
+  if(_jobs)
+    _jobs->ParallelFor(CullRange, this, count, VOLUMES_PER_JOB);
+  else
+    CullRange(this, 0, count);
+
+  for(unsigned int chunk = 0; chunk < _chunk_visible.size(); ++chunk)
+  {
+    unsigned int begin = chunk * VOLUMES_PER_JOB;
+    if(_num_visible != begin && _chunk_visible[chunk] > 0)
+      memmove(&_visible[_num_visible], &_visible[begin], _chunk_visible[chunk] * sizeof(unsigned int));
+    _num_visible += _chunk_visible[chunk];
+  }
+  return _num_visible;
+}
+
+void FrustumCuller::CullRange(void* data, unsigned int begin, unsigned int end)
+{
+  FrustumCuller* culler = (FrustumCuller*)data;
+  CullArrays a;
+  memset(&a, 0, sizeof(a));
+  if(culler->_spheres)
+  {
+    const BoundingSpheres& spheres = *culler->_spheres;
+    a.x = &spheres._x[0];
+    a.y = &spheres._y[0];
+    a.z = &spheres._z[0];
+    a.radius = &spheres._radius[0];
+  }
+  else
+  {
+    const BoundingBoxes& boxes = *culler->_boxes;
+    a.x = &boxes._center_x[0];
+    a.y = &boxes._center_y[0];
+    a.z = &boxes._center_z[0];
+    a.extent_x = &boxes._extent_x[0];
+    a.extent_y = &boxes._extent_y[0];
+    a.extent_z = &boxes._extent_z[0];
+  }
+
+  const Frustum& frustum = *culler->_frustum;
+  unsigned int* visible = &culler->_visible[begin];
+  unsigned int count;
+  switch(culler->_path)
+  {
+  case BATCH_MATH_AVX:
+    count = culler->_spheres ? CullSpheresAVX(frustum, a, begin, end, visible) : CullBoxesAVX(frustum, a, begin, end, visible);
+    break;
+  case BATCH_MATH_SSE:
+    count = culler->_spheres ? CullSpheresSSE(frustum, a, begin, end, visible) : CullBoxesSSE(frustum, a, begin, end, visible);
+    break;
+  default:
+    count = culler->_spheres ? CullSpheresScalar(frustum, a, begin, end, visible) : CullBoxesScalar(frustum, a, begin, end, visible);
+    break;
+  }
+  culler->_chunk_visible[begin / VOLUMES_PER_JOB] = count;
+}
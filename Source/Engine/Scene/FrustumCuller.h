@@ -0,0 +1,101 @@
+#pragma once
+//========================================================================
+// FrustumCuller.h : Tests whole arrays of bounding volumes against a frustum
+//
+// Spheres and boxes are stored one array per component, so the culler can
+// load four of them into SSE registers, or eight with AVX, and test them
+// against each plane at once.  The path is the one BatchMath picked, so
+// forcing BATCH_MATH_SCALAR gives the plain version to check the others
+// against.  Boxes are kept as a center and a half extent, which is what
+// the plane test wants.
+//
+// Cull() writes the indices of the volumes that are at least partly inside
+// into one list, in increasing order.  Large arrays are split across the
+// job system.  Each job writes into its own part of the list and the parts
+// are closed up afterwards, so the jobs never share anything.
+//
+// The scalar kernels add in the same order as the SIMD ones, so where the
+// compiler uses SSE for float maths, x64 or /arch:SSE2, every path gives
+// exactly the same list.  A Win32 build without /arch:SSE2 does the scalar
+// sums on the x87, which keeps more precision, so a volume that touches a
+// plane to within a float rounding can come out differently there.  That
+// is a volume whose distance plus radius is within 1e-6 of the sum of the
+// terms' sizes, which is what the frustum bench allows.
+//========================================================================
+
+#include "Frustum.h"
+
+class JobSystem;
+
+class BoundingSpheres
+{
+  friend class FrustumCuller;
+
+  std::vector<float> _x;
+  std::vector<float> _y;
+  std::vector<float> _z;
+  std::vector<float> _radius;
+
+public:
+  unsigned int Add(const glm::vec3& center, float radius);
+  void Set(unsigned int index, const glm::vec3& center, float radius);
+  //moves the last sphere into index
+  void Remove(unsigned int index);
+  void Clear();
+
+  glm::vec3 Center(unsigned int index) const { return glm::vec3(_x[index], _y[index], _z[index]); }
+  float Radius(unsigned int index) const { return _radius[index]; }
+  unsigned int Count() const { return (unsigned int)_x.size(); }
+};
+
+class BoundingBoxes
+{
+  friend class FrustumCuller;
+
+  std::vector<float> _center_x;
+  std::vector<float> _center_y;
+  std::vector<float> _center_z;
+  std::vector<float> _extent_x;
+  std::vector<float> _extent_y;
+  std::vector<float> _extent_z;
+
+public:
+  unsigned int Add(const glm::vec3& min, const glm::vec3& max);
+  void Set(unsigned int index, const glm::vec3& min, const glm::vec3& max);
+  //moves the last box into index
+  void Remove(unsigned int index);
+  void Clear();
+
+  glm::vec3 Center(unsigned int index) const { return glm::vec3(_center_x[index], _center_y[index], _center_z[index]); }
+  glm::vec3 Extent(unsigned int index) const { return glm::vec3(_extent_x[index], _extent_y[index], _extent_z[index]); }
+  unsigned int Count() const { return (unsigned int)_center_x.size(); }
+};
+
+class FrustumCuller : public SOL_noncopyable
+{
+  JobSystem* _jobs;
+  std::vector<unsigned int> _visible;         //only grows, so culling doesnt allocate
+  unsigned int _num_visible;
+
+  //the Cull() in progress
+  const Frustum* _frustum;
+  const BoundingSpheres* _spheres;
+  const BoundingBoxes* _boxes;
+  int _path;
+  std::vector<unsigned int> _chunk_visible;   //how many each job found
+
+public:
+  explicit FrustumCuller(JobSystem* jobs = 0);
+
+  //both return how many are visible
+  unsigned int Cull(const Frustum& frustum, const BoundingSpheres& spheres);
+  unsigned int Cull(const Frustum& frustum, const BoundingBoxes& boxes);
+
+  //indices of the volumes the last Cull() found, in increasing order.  Valid until the next Cull().
+  const unsigned int* Visible() const { return _visible.empty() ? 0 : &_visible[0]; }
+  unsigned int NumVisible() const { return _num_visible; }
+
+private:
+  unsigned int Run(unsigned int count);
+  static void CullRange(void* data, unsigned int begin, unsigned int end);
+};
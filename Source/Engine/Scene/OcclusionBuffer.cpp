@@ -0,0 +1,289 @@
+#include "EngineStd.h"
+#include "OcclusionBuffer.h"
+#include "../Multicore/JobSystem.h"
+#include "../Debugging/Logger.h"
+#include <emmintrin.h>
+
+//tiles are a multiple of 4 wide, so a run of 4 pixels never crosses into the next tile
+const unsigned int TILE_WIDTH = 64;
+const unsigned int TILE_HEIGHT = 32;
+
+//work per job.  Fewer than this are done on the calling thread.
+const unsigned int TRIANGLES_PER_JOB = 512;
+const unsigned int BOXES_PER_JOB = 1024;
+
+//a box is tested against the level where it covers at most this many texels across
+const int MAX_TEST_TEXELS = 4;
+
+OcclusionBuffer::OcclusionBuffer(unsigned int width, unsigned int height, JobSystem* jobs)
+{
+  _width = std::max(4u, (width + 3) & ~3u);
+  _height = std::max(1u, height);
+  _tiles_x = (_width + TILE_WIDTH - 1) / TILE_WIDTH;
+  _tiles_y = (_height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+  _jobs = jobs;
+  _num_bin_jobs = 0;
+  _test_boxes = 0;
+  _test_visible = 0;
+
+  unsigned int w = _width, h = _height;
+  for(;;)
+  {
+    _levels.push_back(std::vector<float>(w * h, 1.0f));
+    if(w == 1 && h == 1)
+      break;
+    w = (w + 1) / 2;
+    h = (h + 1) / 2;
+  }
+}
+
+void OcclusionBuffer::Begin(const glm::mat4& view_projection)
+{
+  _view_projection = view_projection;
+  _triangles.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Projects each triangle to pixels and works out its edge equations, its
+// depth plane and the pixels whose centers it could cover.  Back facing
+// and degenerate triangles are dropped.
+//////////////////////////////////////////////////////////////////////////////
+void OcclusionBuffer::AddOccluder(const glm::mat4& world, const glm::vec3* vertices, const unsigned int* indices, unsigned int num_indices)
+{
+  glm::mat4 transform = _view_projection * world;
+  for(unsigned int i = 0; i + 3 <= num_indices; i += 3)
+  {
+    float x[3], y[3], z[3];
+    bool behind = false;
+    for(int k = 0; k < 3; ++k)
+    {
+      glm::vec4 clip = transform * glm::vec4(vertices[indices[i + k]], 1.0f);
+      if(clip.w <= 0.0f || clip.z < -clip.w)
+      {
+        behind = true;
+        break;
+      }
+      float inverse_w = 1.0f / clip.w;
+      x[k] = (clip.x * inverse_w * 0.5f + 0.5f) * _width;
+      y[k] = (clip.y * inverse_w * 0.5f + 0.5f) * _height;
+      z[k] = clip.z * inverse_w * 0.5f + 0.5f;
+    }
+    if(behind)
+      continue;
+
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if(area <= 0.0f)
+      continue;
+
+    //pixel i's center is at i + 0.5
+    Triangle t;
+    t.min_x = std::max(0, (int)ceil(std::min(x[0], std::min(x[1], x[2])) - 0.5f));
+    t.max_x = std::min((int)_width - 1, (int)floor(std::max(x[0], std::max(x[1], x[2])) - 0.5f));
+    t.min_y = std::max(0, (int)ceil(std::min(y[0], std::min(y[1], y[2])) - 0.5f));
+    t.max_y = std::min((int)_height - 1, (int)floor(std::max(y[0], std::max(y[1], y[2])) - 0.5f));
+    if(t.min_x > t.max_x || t.min_y > t.max_y)
+      continue;
+
+    for(int k = 0; k < 3; ++k)
+    {
+      int next = (k + 1) % 3;
+      t.edge[k][0] = y[k] - y[next];
+      t.edge[k][1] = x[next] - x[k];
+      t.edge[k][2] = x[k] * y[next] - y[k] * x[next];
+    }
+
+    float depth_dx = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+    float depth_dy = ((x[1] - x[0]) * (z[2] - z[0]) - (x[2] - x[0]) * (z[1] - z[0])) / area;
+    t.depth[0] = z[0] - depth_dx * x[0] - depth_dy * y[0];
+    t.depth[1] = depth_dx;
+    t.depth[2] = depth_dy;
+    _triangles.push_back(t);
+  }
+}
+
+void OcclusionBuffer::Render()
+{
+  unsigned int num_tiles = _tiles_x * _tiles_y;
+  unsigned int num_triangles = (unsigned int)_triangles.size();
+  _num_bin_jobs = (num_triangles + TRIANGLES_PER_JOB - 1) / TRIANGLES_PER_JOB;
+  if(_bins.size() < _num_bin_jobs * num_tiles)
+    _bins.resize(_num_bin_jobs * num_tiles);
+
+  JobSystem::Run(_jobs, BinRange, this, num_triangles, TRIANGLES_PER_JOB);
+  JobSystem::Run(_jobs, DrawTiles, this, num_tiles, 1);
+  BuildLevels();
+}
+
+//each job keeps its own bin for every tile, so the jobs never share one
+void OcclusionBuffer::BinRange(void* data, unsigned int begin, unsigned int end)
+{
+  OcclusionBuffer* buffer = (OcclusionBuffer*)data;
+  unsigned int num_tiles = buffer->_tiles_x * buffer->_tiles_y;
+  std::vector<unsigned int>* bins = &buffer->_bins[(begin / TRIANGLES_PER_JOB) * num_tiles];
+  for(unsigned int tile = 0; tile < num_tiles; ++tile)
+    bins[tile].clear();
+
+  for(unsigned int i = begin; i < end; ++i)
+  {
+    const Triangle& t = buffer->_triangles[i];
+    for(int ty = t.min_y / TILE_HEIGHT; ty <= t.max_y / (int)TILE_HEIGHT; ++ty)
+    {
+      for(int tx = t.min_x / TILE_WIDTH; tx <= t.max_x / (int)TILE_WIDTH; ++tx)
+        bins[ty * buffer->_tiles_x + tx].push_back(i);
+    }
+  }
+}
+
+void OcclusionBuffer::DrawTiles(void* data, unsigned int begin, unsigned int end)
+{
+  OcclusionBuffer* buffer = (OcclusionBuffer*)data;
+  for(unsigned int tile = begin; tile < end; ++tile)
+    buffer->DrawTile(tile);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Steps the edge equations and depth plane across each row of the part of
+// a triangle's bounds in the tile, four pixels at a time, and keeps the
+// nearer depth wherever all three edges pass.
+//////////////////////////////////////////////////////////////////////////////
+void OcclusionBuffer::DrawTile(unsigned int tile)
+{
+  int tile_x0 = (tile % _tiles_x) * TILE_WIDTH;
+  int tile_y0 = (tile / _tiles_x) * TILE_HEIGHT;
+  int tile_x1 = std::min(tile_x0 + (int)TILE_WIDTH, (int)_width) - 1;
+  int tile_y1 = std::min(tile_y0 + (int)TILE_HEIGHT, (int)_height) - 1;
+  float* depth = &_levels[0][0];
+  for(int y = tile_y0; y <= tile_y1; ++y)
+    std::fill(depth + y * _width + tile_x0, depth + y * _width + tile_x1 + 1, 1.0f);
+
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 centers = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+  unsigned int num_tiles = _tiles_x * _tiles_y;
+  for(unsigned int job = 0; job < _num_bin_jobs; ++job)
+  {
+    const std::vector<unsigned int>& bin = _bins[job * num_tiles + tile];
+    for(unsigned int b = 0; b < bin.size(); ++b)
+    {
+      const Triangle& t = _triangles[bin[b]];
+      int x0 = std::max(t.min_x, tile_x0) & ~3;
+      int x1 = std::min(t.max_x, tile_x1);
+      int y0 = std::max(t.min_y, tile_y0);
+      int y1 = std::min(t.max_y, tile_y1);
+
+      __m128 a[3], step[3];
+      for(int k = 0; k < 3; ++k)
+      {
+        a[k] = _mm_set1_ps(t.edge[k][0]);
+        step[k] = _mm_set1_ps(t.edge[k][0] * 4.0f);
+      }
+      __m128 depth_dx = _mm_set1_ps(t.depth[1]);
+      __m128 depth_step = _mm_set1_ps(t.depth[1] * 4.0f);
+      __m128 px = _mm_add_ps(_mm_set1_ps((float)x0), centers);
+
+      for(int y = y0; y <= y1; ++y)
+      {
+        float py = y + 0.5f;
+        __m128 e0 = _mm_add_ps(_mm_mul_ps(a[0], px), _mm_set1_ps(t.edge[0][1] * py + t.edge[0][2]));
+        __m128 e1 = _mm_add_ps(_mm_mul_ps(a[1], px), _mm_set1_ps(t.edge[1][1] * py + t.edge[1][2]));
+        __m128 e2 = _mm_add_ps(_mm_mul_ps(a[2], px), _mm_set1_ps(t.edge[2][1] * py + t.edge[2][2]));
+        __m128 z = _mm_add_ps(_mm_mul_ps(depth_dx, px), _mm_set1_ps(t.depth[2] * py + t.depth[0]));
+        float* row = depth + y * _width;
+        for(int x = x0; x <= x1; x += 4)
+        {
+          __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+          if(_mm_movemask_ps(inside))
+          {
+            __m128 old_depth = _mm_loadu_ps(row + x);
+            __m128 new_depth = _mm_min_ps(old_depth, z);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, new_depth), _mm_andnot_ps(inside, old_depth)));
+          }
+          e0 = _mm_add_ps(e0, step[0]);
+          e1 = _mm_add_ps(e1, step[1]);
+          e2 = _mm_add_ps(e2, step[2]);
+          z = _mm_add_ps(z, depth_step);
+        }
+      }
+    }
+  }
+}
+
+//each texel is the farthest of the 2x2 below it, the odd row or column at an edge is taken on its own
+void OcclusionBuffer::BuildLevels()
+{
+  unsigned int w = _width, h = _height;
+  for(unsigned int level = 1; level < _levels.size(); ++level)
+  {
+    const float* src = &_levels[level - 1][0];
+    float* dst = &_levels[level][0];
+    unsigned int dst_w = (w + 1) / 2, dst_h = (h + 1) / 2;
+    for(unsigned int y = 0; y < dst_h; ++y)
+    {
+      unsigned int y0 = y * 2, y1 = std::min(y0 + 1, h - 1);
+      for(unsigned int x = 0; x < dst_w; ++x)
+      {
+        unsigned int x0 = x * 2, x1 = std::min(x0 + 1, w - 1);
+        dst[y * dst_w + x] = std::max(std::max(src[y0 * w + x0], src[y0 * w + x1]), std::max(src[y1 * w + x0], src[y1 * w + x1]));
+      }
+    }
+    w = dst_w;
+    h = dst_h;
+  }
+}
+
+bool OcclusionBuffer::IsVisible(const Aabb& box) const
+{
+  float min_x = FLT_MAX, min_y = FLT_MAX, min_z = FLT_MAX;
+  float max_x = -FLT_MAX, max_y = -FLT_MAX;
+  for(int corner = 0; corner < 8; ++corner)
+  {
+    glm::vec3 p((corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y, (corner & 4) ? box.max.z : box.min.z);
+    glm::vec4 clip = _view_projection * glm::vec4(p, 1.0f);
+    if(clip.w <= 0.0f || clip.z < -clip.w)
+      return true;
+    float inverse_w = 1.0f / clip.w;
+    float x = (clip.x * inverse_w * 0.5f + 0.5f) * _width;
+    float y = (clip.y * inverse_w * 0.5f + 0.5f) * _height;
+    min_x = std::min(min_x, x);
+    max_x = std::max(max_x, x);
+    min_y = std::min(min_y, y);
+    max_y = std::max(max_y, y);
+    min_z = std::min(min_z, clip.z * inverse_w * 0.5f + 0.5f);
+  }
+  if(max_x < 0.0f || max_y < 0.0f || min_x >= _width || min_y >= _height)
+    return true;
+
+  int x0 = std::max(0, (int)min_x);
+  int y0 = std::max(0, (int)min_y);
+  int x1 = std::min((int)_width - 1, (int)max_x);
+  int y1 = std::min((int)_height - 1, (int)max_y);
+
+  unsigned int level = 0;
+  while(level + 1 < _levels.size() && std::max((x1 >> level) - (x0 >> level), (y1 >> level) - (y0 >> level)) >= MAX_TEST_TEXELS)
+    ++level;
+
+  const float* texels = &_levels[level][0];
+  unsigned int level_width = ((_width - 1) >> level) + 1;
+  for(int y = y0 >> level; y <= (y1 >> level); ++y)
+  {
+    for(int x = x0 >> level; x <= (x1 >> level); ++x)
+    {
+      if(texels[y * level_width + x] >= min_z)
+        return true;
+    }
+  }
+  return false;
+}
+
+void OcclusionBuffer::TestBoxes(const Aabb* boxes, unsigned int count, unsigned char* visible)
+{
+  _test_boxes = boxes;
+  _test_visible = visible;
+  JobSystem::Run(_jobs, TestRange, this, count, BOXES_PER_JOB);
+}
+
+void OcclusionBuffer::TestRange(void* data, unsigned int begin, unsigned int end)
+{
+  OcclusionBuffer* buffer = (OcclusionBuffer*)data;
+  for(unsigned int i = begin; i < end; ++i)
+    buffer->_test_visible[i] = buffer->IsVisible(buffer->_test_boxes[i]) ? 1 : 0;
+}
@@ -0,0 +1,80 @@
+#pragma once
+//========================================================================
+// OcclusionBuffer.h : A small software depth buffer for occlusion culling
+//
+// A handful of big, simple occluder meshes (walls, buildings, terrain
+// chunks) are drawn into a low resolution depth buffer on the CPU, then
+// the bounding boxes of everything else are tested against it.  Nothing
+// here touches the GPU, so the answer is ready the same frame without
+// waiting on occlusion queries.
+//
+// Render() bins the occluders' triangles into screen tiles and then draws
+// each tile as its own job, four pixels at a time with SSE.  Afterwards it
+// builds a hierarchy of the buffer where each texel is the farthest depth
+// of the four below it.  A box is tested against the level where its
+// screen rectangle covers only a few texels, and is hidden only if its
+// nearest point is behind the farthest occluder everywhere it covers.
+//
+// Occluder triangles that reach behind the near plane are dropped rather
+// than clipped, which only ever lets more through.  Boxes reaching behind
+// the near plane, or off the screen, count as visible, frustum culling is
+// left to the FrustumCuller.
+//========================================================================
+
+#include "Aabb.h"
+
+class JobSystem;
+
+class OcclusionBuffer : public SOL_noncopyable
+{
+  //an occluder triangle set up for drawing, in pixels
+  struct Triangle
+  {
+    float edge[3][3];     //a, b, c of each edge, a pixel is inside when a*x + b*y + c >= 0 for all three
+    float depth[3];       //the depth at x, y is depth[0] + depth[1]*x + depth[2]*y
+    int min_x, min_y, max_x, max_y;
+  };
+
+  unsigned int _width;
+  unsigned int _height;
+  unsigned int _tiles_x;
+  unsigned int _tiles_y;
+  JobSystem* _jobs;
+
+  glm::mat4 _view_projection;
+  std::vector<Triangle> _triangles;
+  std::vector<std::vector<unsigned int> > _bins;  //each binning job's triangles for each tile
+  unsigned int _num_bin_jobs;
+  std::vector<std::vector<float> > _levels;       //0 is the full buffer, each level after is the farthest of 2x2 of the last
+
+  //the TestBoxes() in progress
+  const Aabb* _test_boxes;
+  unsigned char* _test_visible;
+
+public:
+  //the width is rounded up to a multiple of 4
+  OcclusionBuffer(unsigned int width = 256, unsigned int height = 128, JobSystem* jobs = 0);
+
+  //clears the occluders, the buffer itself is cleared by Render()
+  void Begin(const glm::mat4& view_projection);
+  //indices are three per triangle, counter-clockwise triangles face the camera
+  void AddOccluder(const glm::mat4& world, const glm::vec3* vertices, const unsigned int* indices, unsigned int num_indices);
+  void Render();
+
+  bool IsVisible(const Aabb& box) const;
+  //visible[i] is set to 1 or 0 for each box
+  void TestBoxes(const Aabb* boxes, unsigned int count, unsigned char* visible);
+
+  unsigned int Width() const { return _width; }
+  unsigned int Height() const { return _height; }
+  unsigned int NumTriangles() const { return (unsigned int)_triangles.size(); }
+  //after Render(), 0 is the near plane and 1 the far plane.  Row 0 is the bottom of the screen.
+  const float* Depth() const { return &_levels[0][0]; }
+
+private:
+  static void BinRange(void* data, unsigned int begin, unsigned int end);
+  static void DrawTiles(void* data, unsigned int begin, unsigned int end);
+  static void TestRange(void* data, unsigned int begin, unsigned int end);
+  void DrawTile(unsigned int tile);
+  void BuildLevels();
+};
@@ -0,0 +1,232 @@
+#include "EngineStd.h"
+#include "SpatialHashGrid.h"
+#include "../Debugging/Logger.h"
+
+//points per job.  Fewer than this are done on the calling thread.
+const unsigned int POINTS_PER_JOB = 16384;
+
+SpatialHashGrid::SpatialHashGrid(float cell_size, unsigned int table_bits, JobSystem* jobs) : _sort(POINTS_PER_JOB)
+{
+  SOL_ASSERT(cell_size > 0.0f);
+  _cell_size = cell_size;
+  _inverse_cell_size = 1.0f / cell_size;
+  _table_bits = std::max(1u, std::min(table_bits, 24u));
+  _jobs = jobs;
+  _positions = 0;
+  _actors = 0;
+  _bucket_start.assign((1 << _table_bits) + 1, 0);
+  _low_cell = glm::ivec3(0);
+  _high_cell = glm::ivec3(0);
+}
+
+glm::ivec3 SpatialHashGrid::Cell(const glm::vec3& position) const
+{
+  return glm::ivec3(glm::floor(position * _inverse_cell_size));
+}
+
+//spreads the cell over the table with a multiplicative hash, keeping its top bits
+unsigned int SpatialHashGrid::Bucket(const glm::ivec3& cell) const
+{
+  unsigned int hash = ((unsigned int)cell.x * 73856093u) ^ ((unsigned int)cell.y * 19349663u) ^ ((unsigned int)cell.z * 83492791u);
+  return (hash * 2654435761u) >> (32 - _table_bits);
+}
+
+#pragma region Rebuild
+
+//////////////////////////////////////////////////////////////////////////////
+// Finds each point's bucket and the occupied cells, sorts the points by
+// bucket, then copies them into bucket order and finds where each bucket
+// starts.
+//////////////////////////////////////////////////////////////////////////////
+void SpatialHashGrid::Rebuild(const glm::vec3* positions, const ActorId* actors, unsigned int count)
+{
+  _positions = positions;
+  _actors = actors;
+  _x.resize(count);
+  _y.resize(count);
+  _z.resize(count);
+  _actor.resize(count);
+
+  unsigned int num_buckets = 1 << _table_bits;
+  if(count == 0)
+  {
+    _bucket_start.assign(num_buckets + 1, 0);
+    return;
+  }
+
+  unsigned int num_chunks = (count + POINTS_PER_JOB - 1) / POINTS_PER_JOB;
+  _chunk_low.resize(num_chunks);
+  _chunk_high.resize(num_chunks);
+  _sort.Reserve(count);
+  JobSystem::Run(_jobs, KeyRange, this, count, POINTS_PER_JOB);
+  _low_cell = _chunk_low[0];
+  _high_cell = _chunk_high[0];
+  for(unsigned int chunk = 1; chunk < num_chunks; ++chunk)
+  {
+    _low_cell = glm::min(_low_cell, _chunk_low[chunk]);
+    _high_cell = glm::max(_high_cell, _chunk_high[chunk]);
+  }
+
+  _sort.Sort(_jobs, count, _table_bits);
+  JobSystem::Run(_jobs, GatherRange, this, count, POINTS_PER_JOB);
+
+  const unsigned int* keys = _sort.SortedKeys();
+  unsigned int bucket = 0;
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    while(bucket <= keys[i])
+      _bucket_start[bucket++] = i;
+  }
+  while(bucket <= num_buckets)
+    _bucket_start[bucket++] = count;
+}
+
+void SpatialHashGrid::KeyRange(void* data, unsigned int begin, unsigned int end)
+{
+  SpatialHashGrid* grid = (SpatialHashGrid*)data;
+  unsigned int* keys = grid->_sort.Keys();
+  unsigned int* order = grid->_sort.Order();
+  glm::ivec3 low(INT_MAX), high(INT_MIN);
+  for(unsigned int i = begin; i < end; ++i)
+  {
+    glm::ivec3 cell = grid->Cell(grid->_positions[i]);
+    low = glm::min(low, cell);
+    high = glm::max(high, cell);
+    keys[i] = grid->Bucket(cell);
+    order[i] = i;
+  }
+  grid->_chunk_low[begin / POINTS_PER_JOB] = low;
+  grid->_chunk_high[begin / POINTS_PER_JOB] = high;
+}
+
+void SpatialHashGrid::GatherRange(void* data, unsigned int begin, unsigned int end)
+{
+  SpatialHashGrid* grid = (SpatialHashGrid*)data;
+  const unsigned int* order = grid->_sort.SortedOrder();
+  for(unsigned int i = begin; i < end; ++i)
+  {
+    const glm::vec3& position = grid->_positions[order[i]];
+    grid->_x[i] = position.x;
+    grid->_y[i] = position.y;
+    grid->_z[i] = position.z;
+    grid->_actor[i] = grid->_actors ? grid->_actors[order[i]] : order[i];
+  }
+}
+
+#pragma endregion
+
+#pragma region Queries
+
+//////////////////////////////////////////////////////////////////////////////
+// Visits each cell the sphere's bounds cover and the run of points in its
+// bucket.  A point is passed to the visitor only from its own cell, which
+// skips the points of other cells sharing the bucket and stops a point
+// being found twice when two of the cells share a bucket.
+//
+// The cells are clamped to the occupied ones while still floats, so a
+// huge radius cant overflow them.  If there are still more cells than
+// points, every point is checked once instead.
+//////////////////////////////////////////////////////////////////////////////
+template<class Visitor> void SpatialHashGrid::VisitRadius(const glm::vec3& center, float radius, Visitor& visitor) const
+{
+  if(_actor.empty())
+    return;
+
+  glm::vec3 low_cell = glm::max(glm::floor((center - glm::vec3(radius)) * _inverse_cell_size), glm::vec3(_low_cell));
+  glm::vec3 high_cell = glm::min(glm::floor((center + glm::vec3(radius)) * _inverse_cell_size), glm::vec3(_high_cell));
+  if(low_cell.x > high_cell.x || low_cell.y > high_cell.y || low_cell.z > high_cell.z)
+    return;
+
+  float radius_squared = radius * radius;
+  glm::vec3 size = high_cell - low_cell + glm::vec3(1.0f);
+  if((double)size.x * size.y * size.z > (double)_actor.size())
+  {
+    for(unsigned int i = 0; i < _actor.size(); ++i)
+    {
+      float dx = _x[i] - center.x;
+      float dy = _y[i] - center.y;
+      float dz = _z[i] - center.z;
+      float distance_squared = dx * dx + dy * dy + dz * dz;
+      if(distance_squared <= radius_squared)
+        visitor.Visit(i, distance_squared);
+    }
+    return;
+  }
+
+  glm::ivec3 low(low_cell);
+  glm::ivec3 high(high_cell);
+  for(int z = low.z; z <= high.z; ++z)
+  {
+    for(int y = low.y; y <= high.y; ++y)
+    {
+      for(int x = low.x; x <= high.x; ++x)
+      {
+        glm::ivec3 cell(x, y, z);
+        unsigned int bucket = Bucket(cell);
+        for(unsigned int i = _bucket_start[bucket]; i < _bucket_start[bucket + 1]; ++i)
+        {
+          float dx = _x[i] - center.x;
+          float dy = _y[i] - center.y;
+          float dz = _z[i] - center.z;
+          float distance_squared = dx * dx + dy * dy + dz * dz;
+          if(distance_squared <= radius_squared && Cell(Position(i)) == cell)
+            visitor.Visit(i, distance_squared);
+        }
+      }
+    }
+  }
+}
+
+struct RadiusVisitor
+{
+  std::vector<unsigned int>* results;
+
+  void Visit(unsigned int index, float) { results->push_back(index); }
+};
+
+//keeps the closest points found so far in order, closest first
+struct NeighbourVisitor
+{
+  unsigned int max_neighbours;
+  unsigned int count;
+  unsigned int index[SpatialHashGrid::MAX_NEIGHBOURS];
+  float distance_squared[SpatialHashGrid::MAX_NEIGHBOURS];
+
+  void Visit(unsigned int i, float d)
+  {
+    if(count == max_neighbours && d >= distance_squared[count - 1])
+      return;
+
+    unsigned int slot = count < max_neighbours ? count++ : count - 1;
+    while(slot > 0 && distance_squared[slot - 1] > d)
+    {
+      index[slot] = index[slot - 1];
+      distance_squared[slot] = distance_squared[slot - 1];
+      --slot;
+    }
+    index[slot] = i;
+    distance_squared[slot] = d;
+  }
+};
+
+void SpatialHashGrid::QueryRadius(const glm::vec3& center, float radius, std::vector<unsigned int>& results) const
+{
+  RadiusVisitor visitor;
+  visitor.results = &results;
+  VisitRadius(center, radius, visitor);
+}
+
+void SpatialHashGrid::QueryNeighbours(const glm::vec3& center, float radius, unsigned int max_neighbours, std::vector<unsigned int>& results) const
+{
+  SOL_ASSERT(max_neighbours <= MAX_NEIGHBOURS);
+  NeighbourVisitor visitor;
+  visitor.max_neighbours = std::min(max_neighbours, (unsigned int)MAX_NEIGHBOURS);
+  visitor.count = 0;
+  if(visitor.max_neighbours == 0)
+    return;
+
+  VisitRadius(center, radius, visitor);
+  results.insert(results.end(), visitor.index, visitor.index + visitor.count);
+}
+
+#pragma endregion
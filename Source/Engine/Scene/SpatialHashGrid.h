@@ -0,0 +1,75 @@
+#pragma once
+//========================================================================
+// SpatialHashGrid.h : Points bucketed by grid cell, rebuilt every frame
+//
+// Meant for large crowds where everything moves every frame.  Rather than
+// updating a tree, Rebuild() throws the last frame's grid away and sorts
+// every point by the hash of the cell it is in, with a ParallelRadixSort
+// split across the job system.  Afterwards the points in a hash bucket
+// are one contiguous run of the sorted arrays, and positions and actors
+// are stored one array per component in that order.
+//
+// Cells hash into a fixed size table, so cells far apart can share a
+// bucket.  The queries check each point's distance, and its cell, so they
+// only return points that really are in range, each once.  They only visit
+// the cells between the lowest and highest occupied ones, and a query that
+// would still visit more cells than there are points checks every point
+// instead, so a huge radius costs no more than a linear scan.
+//
+// The queries are const and can be run from several threads at once
+// between rebuilds.
+//========================================================================
+
+#include "3rdParty/glm-0.9.3.4/glm/glm.hpp"
+#include "../Multicore/ParallelRadixSort.h"
+
+class SpatialHashGrid : public SOL_noncopyable
+{
+  float _cell_size;
+  float _inverse_cell_size;
+  unsigned int _table_bits;
+  JobSystem* _jobs;
+
+  //sorted by bucket
+  std::vector<float> _x;
+  std::vector<float> _y;
+  std::vector<float> _z;
+  std::vector<ActorId> _actor;
+  std::vector<unsigned int> _bucket_start;    //first point in each bucket, and one past the last
+  glm::ivec3 _low_cell;                       //the corners of the occupied cells
+  glm::ivec3 _high_cell;
+
+  //the Rebuild() in progress
+  const glm::vec3* _positions;
+  const ActorId* _actors;
+  ParallelRadixSort<unsigned int> _sort;      //each point's bucket
+  std::vector<glm::ivec3> _chunk_low;         //each job's occupied cells
+  std::vector<glm::ivec3> _chunk_high;
+
+public:
+  //the table has 2^table_bits buckets
+  explicit SpatialHashGrid(float cell_size, unsigned int table_bits = 16, JobSystem* jobs = 0);
+
+  //actors can be NULL, Actor() then gives the index into positions
+  void Rebuild(const glm::vec3* positions, const ActorId* actors, unsigned int count);
+
+  //results are appended.  Both give indices into the sorted points.
+  void QueryRadius(const glm::vec3& center, float radius, std::vector<unsigned int>& results) const;
+  //the closest max_neighbours points within radius, closest first.  max_neighbours can be at most MAX_NEIGHBOURS.
+  void QueryNeighbours(const glm::vec3& center, float radius, unsigned int max_neighbours, std::vector<unsigned int>& results) const;
+  enum { MAX_NEIGHBOURS = 32 };
+
+  unsigned int Count() const { return (unsigned int)_actor.size(); }
+  glm::vec3 Position(unsigned int index) const { return glm::vec3(_x[index], _y[index], _z[index]); }
+  ActorId Actor(unsigned int index) const { return _actor[index]; }
+  float CellSize() const { return _cell_size; }
+
+private:
+  glm::ivec3 Cell(const glm::vec3& position) const;
+  unsigned int Bucket(const glm::ivec3& cell) const;
+
+  template<class Visitor> void VisitRadius(const glm::vec3& center, float radius, Visitor& visitor) const;
+
+  static void KeyRange(void* data, unsigned int begin, unsigned int end);
+  static void GatherRange(void* data, unsigned int begin, unsigned int end);
+};
@@ -0,0 +1,367 @@
+#include "EngineStd.h"
+#include "TransformHierarchy.h"
+#include "../Multicore/JobSystem.h"
+#include "../Math/BatchMath.h"
+#include "../Debugging/Logger.h"
+
+//transforms per job.  Levels smaller than this are updated on the calling thread.
+const unsigned int TRANSFORMS_PER_JOB = 4096;
+//transforms UpdateRange() works on at a time
+const unsigned int TRANSFORMS_PER_BLOCK = 64;
+
+//generations wrap at this
+const unsigned int TRANSFORM_GENERATION_MASK = UINT_MAX >> TRANSFORM_SLOT_BITS;
+
+//Depth() markers
+const unsigned int DEPTH_UNKNOWN = UINT_MAX - 1;
+const unsigned int DEPTH_DEAD = UINT_MAX;
+
+TransformHierarchy::TransformHierarchy(JobSystem* jobs)
+{
+  _jobs = jobs;
+  _order_dirty = false;
+  _update_base = 0;
+  _identity = glm::mat4(1.0f);
+}
+
+TransformId TransformHierarchy::Create(TransformId parent)
+{
+  SOL_ASSERT(parent == INVALID_TRANSFORM_ID || IsValid(parent));
+  unsigned int parent_index = parent == INVALID_TRANSFORM_ID ? UINT_MAX : Index(parent);
+
+  unsigned int slot;
+  if(!_free_slots.empty())
+  {
+    slot = _free_slots.back();
+    _free_slots.pop_back();
+  }
+  else
+  {
+    //the last slot is never used, so no id can be INVALID_TRANSFORM_ID
+    if(_index.size() >= TRANSFORM_SLOT_MASK)
+    {
+      SOL_ERROR("Out of transform slots");
+      return INVALID_TRANSFORM_ID;
+    }
+    slot = (unsigned int)_index.size();
+    _index.push_back(UINT_MAX);
+    _generation.push_back(0);
+  }
+  TransformId id = slot | (_generation[slot] << TRANSFORM_SLOT_BITS);
+
+  //goes on the end for now, Sort() moves it to its level
+  _index[slot] = (unsigned int)_id.size();
+  _local_position.push_back(glm::vec3(0.0f));
+  _local_rotation.push_back(glm::quat());
+  _local_scale.push_back(glm::vec3(1.0f));
+  _world.push_back(glm::mat4(1.0f));
+  _parent.push_back(parent_index);
+  _dirty.push_back(1);
+  _changed.push_back(0);
+  _alive.push_back(1);
+  _id.push_back(id);
+  _order_dirty = true;
+  return id;
+}
+
+void TransformHierarchy::Destroy(TransformId id)
+{
+  unsigned int index = Index(id);
+  if(index == UINT_MAX)
+    return;
+  _alive[index] = 0;
+  _order_dirty = true;
+}
+
+bool TransformHierarchy::SetParent(TransformId id, TransformId parent)
+{
+  //a stale id or parent does nothing, the same as the setters
+  unsigned int index = Index(id);
+  if(index == UINT_MAX)
+    return false;
+  unsigned int parent_index = UINT_MAX;
+  if(parent != INVALID_TRANSFORM_ID)
+  {
+    parent_index = Index(parent);
+    if(parent_index == UINT_MAX)
+      return false;
+    for(unsigned int i = parent_index; i != UINT_MAX; i = _parent[i])
+    {
+      if(i == index)
+      {
+        SOL_ERROR("Can't parent a transform to itself or one of its children");
+        return false;
+      }
+    }
+  }
+
+  if(_parent[index] != parent_index)
+  {
+    _parent[index] = parent_index;
+    _dirty[index] = 1;
+    _order_dirty = true;
+  }
+  return true;
+}
+
+TransformId TransformHierarchy::Parent(TransformId id) const
+{
+  unsigned int index = Index(id);
+  unsigned int parent = index == UINT_MAX ? UINT_MAX : _parent[index];
+  return parent == UINT_MAX ? INVALID_TRANSFORM_ID : _id[parent];
+}
+
+void TransformHierarchy::SetLocal(TransformId id, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+  unsigned int index = Index(id);
+  if(index == UINT_MAX)
+    return;
+  _local_position[index] = position;
+  _local_rotation[index] = rotation;
+  _local_scale[index] = scale;
+  _dirty[index] = 1;
+}
+
+void TransformHierarchy::SetLocalPosition(TransformId id, const glm::vec3& position)
+{
+  unsigned int index = Index(id);
+  if(index == UINT_MAX)
+    return;
+  _local_position[index] = position;
+  _dirty[index] = 1;
+}
+
+void TransformHierarchy::SetLocalRotation(TransformId id, const glm::quat& rotation)
+{
+  unsigned int index = Index(id);
+  if(index == UINT_MAX)
+    return;
+  _local_rotation[index] = rotation;
+  _dirty[index] = 1;
+}
+
+void TransformHierarchy::SetLocalScale(TransformId id, const glm::vec3& scale)
+{
+  unsigned int index = Index(id);
+  if(index == UINT_MAX)
+    return;
+  _local_scale[index] = scale;
+  _dirty[index] = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Levels run in order since each one reads the world matrices of the one
+// before.
+//////////////////////////////////////////////////////////////////////////////
+void TransformHierarchy::Update()
+{
+  if(_order_dirty)
+    Sort();
+
+  for(size_t level = 0; level + 1 < _level_start.size(); ++level)
+  {
+    _update_base = _level_start[level];
+    unsigned int count = _level_start[level + 1] - _update_base;
+    if(_jobs)
+      _jobs->ParallelFor(UpdateRange, this, count, TRANSFORMS_PER_JOB);
+    else
+      UpdateRange(this, 0, count);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Drops the destroyed transforms, and their children, and lays the rest
+// out level by level.
+//////////////////////////////////////////////////////////////////////////////
+void TransformHierarchy::Sort()
+{
+  unsigned int count = (unsigned int)_id.size();
+  std::vector<unsigned int> depths(count, DEPTH_UNKNOWN);
+  std::vector<unsigned int> chain;
+  unsigned int num_levels = 0;
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    unsigned int depth = Depth(i, depths, chain);
+    if(depth != DEPTH_DEAD)
+      num_levels = std::max(num_levels, depth + 1);
+  }
+
+  //children of each transform, as ranges into one array
+  std::vector<unsigned int> first_child(count + 1, 0);
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    if(depths[i] != DEPTH_DEAD && _parent[i] != UINT_MAX)
+      ++first_child[_parent[i] + 1];
+  }
+  for(unsigned int i = 0; i < count; ++i)
+    first_child[i + 1] += first_child[i];
+  std::vector<unsigned int> children(first_child[count]);
+  std::vector<unsigned int> next(first_child.begin(), first_child.end() - 1);
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    if(depths[i] != DEPTH_DEAD && _parent[i] != UINT_MAX)
+      children[next[_parent[i]]++] = i;
+  }
+
+  //breadth first from the roots, so each level is in its parents' order and
+  //the parents are read front to back when it is updated
+  std::vector<unsigned int> order;
+  order.reserve(count);
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    if(depths[i] == 0)
+      order.push_back(i);
+  }
+  _level_start.assign(1, 0);
+  for(unsigned int level_begin = 0; level_begin < order.size(); )
+  {
+    unsigned int level_end = (unsigned int)order.size();
+    _level_start.push_back(level_end);
+    for(unsigned int o = level_begin; o < level_end; ++o)
+    {
+      unsigned int i = order[o];
+      order.insert(order.end(), children.begin() + first_child[i], children.begin() + first_child[i + 1]);
+    }
+    level_begin = level_end;
+  }
+  SOL_ASSERT(_level_start.size() == num_levels + 1);
+
+  std::vector<unsigned int> moved_to(count, UINT_MAX);
+  for(unsigned int o = 0; o < order.size(); ++o)
+    moved_to[order[o]] = o;
+
+  unsigned int num_alive = (unsigned int)order.size();
+  std::vector<glm::vec3> local_position(num_alive);
+  std::vector<glm::quat> local_rotation(num_alive);
+  std::vector<glm::vec3> local_scale(num_alive);
+  std::vector<glm::mat4> world(num_alive);
+  std::vector<unsigned int> parent(num_alive);
+  std::vector<unsigned char> dirty(num_alive);
+  std::vector<unsigned char> changed(num_alive);
+  std::vector<TransformId> id(num_alive);
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    unsigned int to = moved_to[i];
+    unsigned int slot = _id[i] & TRANSFORM_SLOT_MASK;
+    if(to == UINT_MAX)
+    {
+      _index[slot] = UINT_MAX;
+      _generation[slot] = (_generation[slot] + 1) & TRANSFORM_GENERATION_MASK;
+      _free_slots.push_back(slot);
+      continue;
+    }
+
+    local_position[to] = _local_position[i];
+    local_rotation[to] = _local_rotation[i];
+    local_scale[to] = _local_scale[i];
+    world[to] = _world[i];
+    parent[to] = _parent[i] == UINT_MAX ? UINT_MAX : moved_to[_parent[i]];
+    dirty[to] = _dirty[i];
+    changed[to] = _changed[i];
+    id[to] = _id[i];
+    _index[slot] = to;
+  }
+
+  _local_position.swap(local_position);
+  _local_rotation.swap(local_rotation);
+  _local_scale.swap(local_scale);
+  _world.swap(world);
+  _parent.swap(parent);
+  _dirty.swap(dirty);
+  _changed.swap(changed);
+  _id.swap(id);
+  _alive.assign(num_alive, 1);
+  _order_dirty = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Walks up to the first transform whose depth is known, then fills in the
+// depths on the way back down.  A transform is dead if it or any of its
+// parents was destroyed.
+//////////////////////////////////////////////////////////////////////////////
+unsigned int TransformHierarchy::Depth(unsigned int index, std::vector<unsigned int>& depths, std::vector<unsigned int>& chain)
+{
+  unsigned int i = index;
+  while(depths[i] == DEPTH_UNKNOWN)
+  {
+    if(!_alive[i])
+    {
+      depths[i] = DEPTH_DEAD;
+      break;
+    }
+    chain.push_back(i);
+    if(_parent[i] == UINT_MAX)
+      break;
+    i = _parent[i];
+  }
+
+  //the walk stopped at a live root, which is the last one in the chain, or at a
+  //transform that is dead or whose depth is already known
+  unsigned int depth = depths[i];
+  if(depth == DEPTH_UNKNOWN)
+  {
+    chain.pop_back();
+    depths[i] = depth = 0;
+  }
+
+  while(!chain.empty())
+  {
+    unsigned int link = chain.back();
+    chain.pop_back();
+    if(depth != DEPTH_DEAD)
+      ++depth;
+    depths[link] = depth;
+  }
+  return depths[index];
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Works through the range a block at a time.  If anything in a block needs
+// updating, the whole block is rebuilt with the batch kernels, which is
+// cheaper than picking out the ones that need it.  Rebuilding one that
+// didnt need it gives the matrix it already had.  A level is either all
+// roots or has no roots, so the first transform says which kernel to use.
+//////////////////////////////////////////////////////////////////////////////
+void TransformHierarchy::UpdateRange(void* data, unsigned int begin, unsigned int end)
+{
+  TransformHierarchy* hierarchy = (TransformHierarchy*)data;
+  unsigned int base = hierarchy->_update_base;
+  const unsigned int* parents = &hierarchy->_parent[0];
+  unsigned char* dirty = &hierarchy->_dirty[0];
+  unsigned char* changed = &hierarchy->_changed[0];
+  glm::mat4* world = &hierarchy->_world[0];
+
+  unsigned char needs[TRANSFORMS_PER_BLOCK];
+  for(unsigned int first = base + begin; first < base + end; first += TRANSFORMS_PER_BLOCK)
+  {
+    unsigned int count = std::min(TRANSFORMS_PER_BLOCK, base + end - first);
+    bool any = false;
+    for(unsigned int b = 0; b < count; ++b)
+    {
+      unsigned int parent = parents[first + b];
+      //parents are on earlier levels, so the block never writes a world matrix it reads
+      SOL_ASSERT(parent == UINT_MAX || parent < first);
+      needs[b] = dirty[first + b] || (parent != UINT_MAX && changed[parent]);
+      any |= needs[b] != 0;
+    }
+    if(!any)
+    {
+      memset(&changed[first], 0, count);
+      continue;
+    }
+
+    const glm::vec3* position = &hierarchy->_local_position[first];
+    const glm::quat* rotation = &hierarchy->_local_rotation[first];
+    const glm::vec3* scale = &hierarchy->_local_scale[first];
+    if(parents[first] == UINT_MAX)
+      BatchComposeTRS(position, rotation, scale, &world[first], count);
+    else
+      BatchComposeTRS(world, &parents[first], position, rotation, scale, &world[first], count);
+
+    for(unsigned int b = 0; b < count; ++b)
+    {
+      dirty[first + b] = 0;
+      changed[first + b] = needs[b];
+    }
+  }
+}
@@ -0,0 +1,117 @@
+#pragma once
+//========================================================================
+// TransformHierarchy.h : Parented transforms stored as arrays
+//
+// Every transform's local position, rotation and scale, its parent and
+// its world matrix live in parallel arrays, one entry per transform.  The
+// arrays are kept sorted by depth in the hierarchy, so each level is one
+// contiguous range and parents always come before their children.
+//
+// Update() walks the levels in order.  A transform's world matrix is only
+// recomputed when its local transform was set or its parent's world matrix
+// changed, so a still part of the scene costs a flag test per transform.
+// Each level is split across the job system, since nothing in a level
+// depends on anything else in it.
+//
+// Transforms are referred to by a TransformId, which stays the same when
+// the arrays are re-sorted.  Creating, destroying or reparenting a
+// transform re-sorts the arrays on the next Update().  World matrices are
+// as of the last Update().
+//
+// An id is a slot plus the slot's generation, which goes up each time the
+// slot is freed, so an id kept after its transform is destroyed doesnt
+// find whatever took the slot next.  Such an id gets the identity from
+// World() and is ignored by the setters.  The generation wraps after 1024
+// reuses of one slot.
+//========================================================================
+
+#include "3rdParty/glm-0.9.3.4/glm/glm.hpp"
+#include "3rdParty/glm-0.9.3.4/glm/gtc/quaternion.hpp"
+
+class JobSystem;
+
+typedef unsigned int TransformId;
+const TransformId INVALID_TRANSFORM_ID = UINT_MAX;
+
+//the low bits of a TransformId are its slot, the rest the slot's generation
+const unsigned int TRANSFORM_SLOT_BITS = 22;
+const unsigned int TRANSFORM_SLOT_MASK = (1 << TRANSFORM_SLOT_BITS) - 1;
+
+class TransformHierarchy : public SOL_noncopyable
+{
+  //sorted by depth
+  std::vector<glm::vec3> _local_position;
+  std::vector<glm::quat> _local_rotation;
+  std::vector<glm::vec3> _local_scale;
+  std::vector<glm::mat4> _world;
+  std::vector<unsigned int> _parent;        //index of the parent, UINT_MAX for a root
+  std::vector<unsigned char> _dirty;        //local transform set since the last Update()
+  std::vector<unsigned char> _changed;      //world matrix changed by the last Update()
+  std::vector<unsigned char> _alive;
+  std::vector<TransformId> _id;
+  std::vector<unsigned int> _level_start;   //first index of each level, and one past the last
+
+  std::vector<unsigned int> _index;         //by slot, UINT_MAX when free
+  std::vector<unsigned int> _generation;    //by slot
+  std::vector<unsigned int> _free_slots;
+  bool _order_dirty;
+  glm::mat4 _identity;                      //what World() gives a stale id
+
+  JobSystem* _jobs;
+  unsigned int _update_base;                //first index of the level being updated
+
+public:
+  explicit TransformHierarchy(JobSystem* jobs = 0);
+
+  //the new transform is the identity
+  TransformId Create(TransformId parent = INVALID_TRANSFORM_ID);
+  //its children are destroyed with it on the next Update()
+  void Destroy(TransformId id);
+  //fails and returns false if parent is id or one of its children
+  bool SetParent(TransformId id, TransformId parent);
+  TransformId Parent(TransformId id) const;
+
+  void SetLocal(TransformId id, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+  void SetLocalPosition(TransformId id, const glm::vec3& position);
+  void SetLocalRotation(TransformId id, const glm::quat& rotation);
+  void SetLocalScale(TransformId id, const glm::vec3& scale);
+  const glm::vec3& LocalPosition(TransformId id) const { return _local_position[ValidIndex(id)]; }
+  const glm::quat& LocalRotation(TransformId id) const { return _local_rotation[ValidIndex(id)]; }
+  const glm::vec3& LocalScale(TransformId id) const { return _local_scale[ValidIndex(id)]; }
+
+  const glm::mat4& World(TransformId id) const
+  {
+    unsigned int index = Index(id);
+    return index == UINT_MAX ? _identity : _world[index];
+  }
+  //whether the last Update() changed its world matrix
+  bool WorldChanged(TransformId id) const
+  {
+    unsigned int index = Index(id);
+    return index != UINT_MAX && _changed[index] != 0;
+  }
+
+  void Update();
+
+  //false once the transform has been destroyed, even before the next Update()
+  bool IsValid(TransformId id) const { return Index(id) != UINT_MAX; }
+  unsigned int Count() const { return (unsigned int)(_index.size() - _free_slots.size()); }
+  unsigned int NumLevels() const { return _level_start.empty() ? 0 : (unsigned int)_level_start.size() - 1; }
+
+private:
+  //where id is in the arrays, UINT_MAX if it is stale or was never handed out
+  unsigned int Index(TransformId id) const
+  {
+    unsigned int slot = id & TRANSFORM_SLOT_MASK;
+    if(slot >= _index.size() || _generation[slot] != id >> TRANSFORM_SLOT_BITS)
+      return UINT_MAX;
+    unsigned int index = _index[slot];
+    return index != UINT_MAX && _alive[index] ? index : UINT_MAX;
+  }
+  //for the accessors that return a reference, id has to be valid
+  unsigned int ValidIndex(TransformId id) const { return _index[id & TRANSFORM_SLOT_MASK]; }
+
+  void Sort();
+  unsigned int Depth(unsigned int index, std::vector<unsigned int>& depths, std::vector<unsigned int>& chain);
+  static void UpdateRange(void* data, unsigned int begin, unsigned int end);
+};
@@ -0,0 +1,200 @@
+#include "EngineStd.h"
+#include "BakedFont.h"
+#include "FontCache.h"
+#include "../Debugging/Logger.h"
+
+//record to record, the Debug lower_bound checks the table's order with the same comparison
+static bool CharacterLess(const BakedCharacter& a, const BakedCharacter& b)
+{
+  return a.character < b.character;
+}
+
+static bool GlyphLess(const BakedGlyph& a, const BakedGlyph& b)
+{
+  return a.glyph_index < b.glyph_index;
+}
+
+static bool PairLess(const BakedKerningPair& a, const BakedKerningPair& b)
+{
+  return a.left < b.left || (a.left == b.left && a.right < b.right);
+}
+
+//a table of count items of size bytes at offset has to lie inside the file and be aligned
+static bool TableFits(unsigned int offset, unsigned int count, size_t size, size_t file_size)
+{
+  return offset % 4 == 0 && offset <= file_size && count <= (file_size - offset) / size;
+}
+
+BakedFont::BakedFont()
+{
+  _file = INVALID_HANDLE_VALUE;
+  _mapping = NULL;
+  _view = 0;
+  _view_size = 0;
+  _header = 0;
+  _characters = 0;
+  _glyphs = 0;
+  _kerning = 0;
+  _pixels = 0;
+}
+
+BakedFont::~BakedFont()
+{
+  Close();
+}
+
+bool BakedFont::Open(const std::wstring& file_name)
+{
+  Close();
+
+  _file = CreateFileW(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+  if(_file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size;
+  if(!GetFileSizeEx(_file, &size) || size.QuadPart < (LONGLONG)sizeof(BakedFontHeader) ||
+     (unsigned long long)size.QuadPart > (size_t)-1)
+  {
+    Close();
+    return false;
+  }
+  _view_size = (size_t)size.QuadPart;
+
+  _mapping = CreateFileMappingW(_file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if(!_mapping)
+  {
+    Close();
+    return false;
+  }
+  _view = (const unsigned char*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+  if(!_view || !Read())
+  {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+bool BakedFont::Open(const void* data, size_t size)
+{
+  Close();
+  if(!data || ((size_t)data & 3) != 0 || size < sizeof(BakedFontHeader))
+    return false;
+  _view = (const unsigned char*)data;
+  _view_size = size;
+  if(!Read())
+  {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void BakedFont::Close()
+{
+  _header = 0;
+  _characters = 0;
+  _glyphs = 0;
+  _kerning = 0;
+  _pixels = 0;
+
+  //a view of memory someone else owns has no mapping behind it
+  if(_view && _mapping)
+    UnmapViewOfFile(_view);
+  _view = 0;
+  _view_size = 0;
+  if(_mapping)
+    CloseHandle(_mapping);
+  _mapping = NULL;
+  if(_file != INVALID_HANDLE_VALUE)
+    CloseHandle(_file);
+  _file = INVALID_HANDLE_VALUE;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Only checks that every table lies inside the file, the contents are
+// trusted to be what the FontTool wrote.  Glyphs that point outside the
+// atlas are caught when they are looked up.
+//////////////////////////////////////////////////////////////////////////////
+bool BakedFont::Read()
+{
+  const BakedFontHeader* header = (const BakedFontHeader*)_view;
+  if(header->magic != BAKED_FONT_MAGIC || header->version != BAKED_FONT_VERSION)
+  {
+    SOL_ERROR("Not a baked font, or baked by a different version of the FontTool");
+    return false;
+  }
+  if(!TableFits(header->characters_offset, header->num_characters, sizeof(BakedCharacter), _view_size) ||
+     !TableFits(header->glyphs_offset, header->num_glyphs, sizeof(BakedGlyph), _view_size) ||
+     !TableFits(header->kerning_offset, header->num_kerning_pairs, sizeof(BakedKerningPair), _view_size) ||
+     header->atlas_width == 0 ||
+     !TableFits(header->atlas_offset, header->atlas_height, header->atlas_width, _view_size))
+  {
+    SOL_ERROR("Baked font is truncated");
+    return false;
+  }
+
+  _header = header;
+  _characters = (const BakedCharacter*)(_view + header->characters_offset);
+  _glyphs = (const BakedGlyph*)(_view + header->glyphs_offset);
+  _kerning = (const BakedKerningPair*)(_view + header->kerning_offset);
+  _pixels = _view + header->atlas_offset;
+  return true;
+}
+
+void BakedFont::Metrics(FontMetrics& out) const
+{
+  out.ascender = _header->ascender;
+  out.descender = _header->descender;
+  out.line_height = _header->line_height;
+}
+
+unsigned int BakedFont::GlyphIndex(unsigned int character) const
+{
+  BakedCharacter key;
+  key.character = character;
+  const BakedCharacter* end = _characters + _header->num_characters;
+  const BakedCharacter* found = std::lower_bound(_characters, end, key, CharacterLess);
+  return found != end && found->character == character ? found->glyph_index : 0;
+}
+
+const BakedGlyph* BakedFont::FindGlyph(unsigned int glyph_index) const
+{
+  BakedGlyph key;
+  key.glyph_index = glyph_index;
+  const BakedGlyph* end = _glyphs + _header->num_glyphs;
+  const BakedGlyph* found = std::lower_bound(_glyphs, end, key, GlyphLess);
+  return found != end && found->glyph_index == glyph_index ? found : 0;
+}
+
+bool BakedFont::Glyph(unsigned int glyph_index, GlyphBitmap& out) const
+{
+  const BakedGlyph* glyph = FindGlyph(glyph_index);
+  if(!glyph)
+    return false;
+
+  bool blank = glyph->width == 0 || glyph->height == 0;
+  if(!blank && ((unsigned int)glyph->x + glyph->width > _header->atlas_width ||
+                (unsigned int)glyph->y + glyph->height > _header->atlas_height))
+    return false;
+  out.glyph_index = glyph_index;
+  out.width = blank ? 0 : glyph->width;
+  out.height = blank ? 0 : glyph->height;
+  out.left = glyph->left;
+  out.top = glyph->top;
+  out.advance = glyph->advance;
+  out.pitch = (int)_header->atlas_width;
+  out.pixels = blank ? 0 : _pixels + glyph->y * _header->atlas_width + glyph->x;
+  return true;
+}
+
+int BakedFont::Kerning(unsigned int left_glyph, unsigned int right_glyph) const
+{
+  BakedKerningPair pair;
+  pair.left = left_glyph;
+  pair.right = right_glyph;
+  const BakedKerningPair* end = _kerning + _header->num_kerning_pairs;
+  const BakedKerningPair* found = std::lower_bound(_kerning, end, pair, PairLess);
+  return found != end && found->left == left_glyph && found->right == right_glyph ? found->amount : 0;
+}
@@ -0,0 +1,131 @@
+#pragma once
+//========================================================================
+// BakedFont.h : A font's glyphs rendered ahead of time, used straight
+//               from a memory mapped file
+//
+// Opening a font, running its hinting setup and rendering the glyphs for
+// the first screen of text is most of a cold start on a slow machine.
+// The FontTool does all of that offline for a font, a size and a set of
+// characters, and writes the results out as one file: the metrics, the
+// character map, every glyph's place in an atlas bitmap, the kerning
+// pairs between the glyphs and the atlas bitmap itself.
+//
+// Everything in the file is laid out the way it is used, little endian
+// with every table 4 byte aligned and sorted for a binary search, so the
+// file is mapped and read in place without parsing or copying anything.
+// Only the pages that are looked at get read from the disk.
+//
+// A BakedFont is handed to FontCache::AddBakedFont(), which then asks it
+// before going to FreeType, so FreeType only opens the font for glyphs
+// and sizes that werent baked.  The glyph bitmaps point into the baked
+// atlas, whose pixels can also be uploaded as a texture of their own.
+//========================================================================
+
+#include "Glyph.h"
+
+struct FontMetrics;
+
+//"BFNT"
+const unsigned int BAKED_FONT_MAGIC = 0x544e4642;
+const unsigned int BAKED_FONT_VERSION = 1;
+
+enum BakedFontFlags
+{
+  BAKED_FONT_DISTANCE_FIELD = 1   //the glyphs are distance fields made at pixel_size with spread around them
+};
+
+struct BakedFontHeader
+{
+  unsigned int magic;
+  unsigned int version;
+  unsigned int flags;
+  unsigned int pixel_size;
+  unsigned int spread;
+  int ascender;
+  int descender;
+  int line_height;
+  unsigned int num_characters;
+  unsigned int characters_offset;   //from the start of the file
+  unsigned int num_glyphs;
+  unsigned int glyphs_offset;
+  unsigned int num_kerning_pairs;
+  unsigned int kerning_offset;
+  unsigned int atlas_width;
+  unsigned int atlas_height;
+  unsigned int atlas_offset;        //one byte per pixel, rows atlas_width apart
+};
+
+//sorted by character
+struct BakedCharacter
+{
+  unsigned int character;
+  unsigned int glyph_index;
+};
+
+//sorted by glyph_index.  x and y are the top left of the bitmap in the atlas.
+struct BakedGlyph
+{
+  unsigned int glyph_index;
+  unsigned short x;
+  unsigned short y;
+  unsigned short width;
+  unsigned short height;
+  short left;
+  short top;
+  float advance;
+};
+
+//sorted by left, then right.  Only pairs that arent 0 are kept.
+struct BakedKerningPair
+{
+  unsigned int left;
+  unsigned int right;
+  int amount;
+};
+
+class BakedFont : public SOL_noncopyable
+{
+  HANDLE _file;
+  HANDLE _mapping;
+  const unsigned char* _view;
+  size_t _view_size;
+
+  const BakedFontHeader* _header;
+  const BakedCharacter* _characters;
+  const BakedGlyph* _glyphs;
+  const BakedKerningPair* _kerning;
+  const unsigned char* _pixels;
+
+public:
+  BakedFont();
+  ~BakedFont();
+
+  //maps the file
+  bool Open(const std::wstring& file_name);
+  //uses a file already in memory, like a resource.  data has to be 4 byte aligned and stay valid until Close().
+  bool Open(const void* data, size_t size);
+  void Close();
+  bool IsOpen() const { return _header != 0; }
+
+  unsigned int PixelSize() const { return _header->pixel_size; }
+  bool IsDistanceField() const { return (_header->flags & BAKED_FONT_DISTANCE_FIELD) != 0; }
+  unsigned int Spread() const { return _header->spread; }
+  void Metrics(FontMetrics& out) const;
+
+  //0 if the character wasnt baked
+  unsigned int GlyphIndex(unsigned int character) const;
+  //false if the glyph wasnt baked.  The pixels are in the atlas, pitch is its width.
+  bool Glyph(unsigned int glyph_index, GlyphBitmap& out) const;
+  bool HasGlyph(unsigned int glyph_index) const { return FindGlyph(glyph_index) != 0; }
+  int Kerning(unsigned int left_glyph, unsigned int right_glyph) const;
+
+  unsigned int NumCharacters() const { return _header->num_characters; }
+  unsigned int NumGlyphs() const { return _header->num_glyphs; }
+  unsigned int AtlasWidth() const { return _header->atlas_width; }
+  unsigned int AtlasHeight() const { return _header->atlas_height; }
+  const unsigned char* AtlasPixels() const { return _pixels; }
+
+private:
+  bool Read();
+  const BakedGlyph* FindGlyph(unsigned int glyph_index) const;
+};
@@ -0,0 +1,350 @@
+#include "EngineStd.h"
+#include "BakedFontBuilder.h"
+#include "BakedFont.h"
+#include "DistanceField.h"
+#include "GlyphAtlas.h"
+#include "../Utility/String.h"
+#include "../Utility/Utf8.h"
+#include "../Debugging/Logger.h"
+
+#include FT_TRUETYPE_TABLES_H
+#include FT_TRUETYPE_TAGS_H
+
+//the atlas starts this big and doubles until everything fits
+const unsigned int FIRST_ATLAS_SIZE = 256;
+const unsigned int MAX_ATLAS_SIZE = 8192;
+
+//orders glyph numbers so the tallest bitmaps come first
+struct TallerFirst
+{
+  const std::vector<GlyphBitmap>* bitmaps;
+  bool operator()(unsigned int a, unsigned int b) const { return (*bitmaps)[a].height > (*bitmaps)[b].height; }
+};
+
+typedef std::pair<unsigned int, unsigned int> GlyphPair;
+
+static unsigned int ReadUShort(const FT_Byte* p)
+{
+  return (p[0] << 8) | p[1];
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The pairs listed in a Windows kern table, walked the same way FreeType
+// does, so these are exactly the pairs FT_Get_Kerning can give an amount
+// for.  False if the font has no table like that.
+//////////////////////////////////////////////////////////////////////////////
+static bool ReadKernTable(FT_Face face, std::vector<GlyphPair>& pairs)
+{
+  FT_ULong length = 0;
+  if(!FT_IS_SFNT(face) || FT_Load_Sfnt_Table(face, TTAG_kern, 0, 0, &length) != 0 || length < 4)
+    return false;
+  std::vector<FT_Byte> table(length);
+  if(FT_Load_Sfnt_Table(face, TTAG_kern, 0, &table[0], &length) != 0 || ReadUShort(&table[0]) != 0)
+    return false;
+
+  unsigned int num_tables = ReadUShort(&table[2]);
+  size_t offset = 4;
+  for(unsigned int t = 0; t < num_tables && offset + 6 <= length; ++t)
+  {
+    const FT_Byte* subtable = &table[offset];
+    size_t subtable_length = ReadUShort(subtable + 2);
+    unsigned int coverage = ReadUShort(subtable + 4);
+    if(subtable_length <= 14)
+      break;
+    size_t end = std::min(offset + subtable_length, (size_t)length);
+    //horizontal format 0 only, the same as FreeType
+    if((coverage & ~8u) == 1 && offset + 14 <= end)
+    {
+      size_t num_pairs = std::min((size_t)ReadUShort(subtable + 6), (end - offset - 14) / 6);
+      for(size_t i = 0; i < num_pairs; ++i)
+      {
+        const FT_Byte* pair = subtable + 14 + i * 6;
+        pairs.push_back(GlyphPair(ReadUShort(pair), ReadUShort(pair + 2)));
+      }
+    }
+    offset = end;
+  }
+  return true;
+}
+
+static void AddKerning(FT_Face face, unsigned int left, unsigned int right, std::vector<BakedKerningPair>& kerning)
+{
+  FT_Vector delta;
+  if(FT_Get_Kerning(face, left, right, FT_KERNING_DEFAULT, &delta) != 0)
+    return;
+  BakedKerningPair pair;
+  pair.left = left;
+  pair.right = right;
+  pair.amount = (int)((delta.x + 32) >> 6);
+  if(pair.amount != 0)
+    kerning.push_back(pair);
+}
+
+static bool WriteAll(HANDLE file, const void* data, size_t size)
+{
+  DWORD written = 0;
+  return size == 0 || (WriteFile(file, data, (DWORD)size, &written, NULL) && written == size);
+}
+
+BakedFontBuilder::BakedFontBuilder()
+{
+  _font = INVALID_FONT_ID;
+  _pixel_size = 0;
+  _spread = 0;
+  _upscale = 4;
+  _padding = 1;
+}
+
+bool BakedFontBuilder::SetFont(const std::wstring& file_name, unsigned int pixel_size, int face_index)
+{
+  _font = _fonts.AddFont(ws2s(file_name), face_index);
+  _pixel_size = pixel_size;
+  FontMetrics metrics;
+  if(pixel_size == 0 || !_fonts.Metrics(_font, pixel_size, metrics))
+  {
+    SOL_ERROR("Could not open font " + ws2s(file_name));
+    _font = INVALID_FONT_ID;
+    return false;
+  }
+  return true;
+}
+
+void BakedFontBuilder::SetDistanceField(unsigned int spread, unsigned int upscale)
+{
+  _spread = spread;
+  _upscale = std::max(1u, upscale);
+}
+
+void BakedFontBuilder::AddCharacters(const char* text, size_t length)
+{
+  if(length == 0)
+    return;
+  std::vector<unsigned int> characters(length);
+  size_t num_characters = 0;
+  Utf8ToUtf32(text, length, &characters[0], characters.size(), num_characters, true);
+  for(size_t i = 0; i < num_characters; ++i)
+  {
+    //line breaks and the byte order mark in a character file arent characters to draw
+    if(characters[i] >= 0x20 && characters[i] != 0xfeff)
+      _characters.push_back(characters[i]);
+  }
+}
+
+bool BakedFontBuilder::AddCharacterFile(const std::wstring& file_name)
+{
+  HANDLE file = CreateFileW(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if(file == INVALID_HANDLE_VALUE)
+  {
+    SOL_ERROR("Could not read character set " + ws2s(file_name));
+    return false;
+  }
+
+  std::vector<char> text;
+  LARGE_INTEGER size;
+  bool success = GetFileSizeEx(file, &size) && size.QuadPart < 0xffffffff;
+  if(success && size.QuadPart > 0)
+  {
+    text.resize((size_t)size.QuadPart);
+    DWORD read = 0;
+    success = ReadFile(file, &text[0], (DWORD)text.size(), &read, NULL) && read == text.size();
+  }
+  CloseHandle(file);
+  if(!success)
+  {
+    SOL_ERROR("Could not read character set " + ws2s(file_name));
+    return false;
+  }
+  if(!text.empty())
+    AddCharacters(&text[0], text.size());
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Every glyph is rendered once and copied, since the bitmaps only last
+// until the next one, and then the copies are packed as many times as it
+// takes to find an atlas they fit in.
+//////////////////////////////////////////////////////////////////////////////
+bool BakedFontBuilder::Build(const std::wstring& file_name)
+{
+  _stats = BakedFontBuilderStats();
+  if(_font == INVALID_FONT_ID)
+  {
+    SOL_ERROR("No font to bake");
+    return false;
+  }
+
+  std::sort(_characters.begin(), _characters.end());
+  _characters.erase(std::unique(_characters.begin(), _characters.end()), _characters.end());
+  std::vector<BakedCharacter> characters;
+  std::vector<unsigned int> glyph_indices;
+  for(unsigned int i = 0; i < _characters.size(); ++i)
+  {
+    BakedCharacter character;
+    character.character = _characters[i];
+    character.glyph_index = _fonts.GlyphIndex(_font, _characters[i]);
+    if(character.glyph_index == 0)
+    {
+      ++_stats.missing;
+      continue;
+    }
+    characters.push_back(character);
+    glyph_indices.push_back(character.glyph_index);
+  }
+  std::sort(glyph_indices.begin(), glyph_indices.end());
+  glyph_indices.erase(std::unique(glyph_indices.begin(), glyph_indices.end()), glyph_indices.end());
+  unsigned int num_glyphs = (unsigned int)glyph_indices.size();
+  _stats.characters = (unsigned int)characters.size();
+  _stats.glyphs = num_glyphs;
+
+  DistanceFieldGlyphs distance_fields(_fonts, _pixel_size, std::max(1u, _spread), _upscale);
+  std::vector<GlyphBitmap> bitmaps(num_glyphs);
+  std::vector<size_t> offsets(num_glyphs);
+  std::vector<unsigned char> glyph_pixels;
+  for(unsigned int i = 0; i < num_glyphs; ++i)
+  {
+    GlyphBitmap& bitmap = bitmaps[i];
+    bool rendered = _spread ? distance_fields.Glyph(_font, glyph_indices[i], bitmap) :
+                              _fonts.Glyph(_font, _pixel_size, glyph_indices[i], bitmap);
+    if(!rendered || bitmap.width > 0xffff || bitmap.height > 0xffff)
+    {
+      char number[16];
+      ToStr(glyph_indices[i], number, sizeof(number));
+      SOL_ERROR(std::string("Could not render glyph ") + number);
+      return false;
+    }
+    offsets[i] = glyph_pixels.size();
+    if(!bitmap.pixels)
+      bitmap.width = bitmap.height = 0;
+    glyph_pixels.resize(offsets[i] + bitmap.width * bitmap.height);
+    for(int row = 0; row < bitmap.height; ++row)
+      memcpy(&glyph_pixels[offsets[i] + row * bitmap.width], bitmap.pixels + row * bitmap.pitch, bitmap.width);
+    bitmap.pitch = bitmap.width;
+  }
+  for(unsigned int i = 0; i < num_glyphs; ++i)
+    bitmaps[i].pixels = bitmaps[i].width > 0 ? &glyph_pixels[offsets[i]] : 0;
+
+  std::vector<unsigned int> order(num_glyphs);
+  for(unsigned int i = 0; i < num_glyphs; ++i)
+    order[i] = i;
+  TallerFirst taller;
+  taller.bitmaps = &bitmaps;
+  std::stable_sort(order.begin(), order.end(), taller);
+
+  std::vector<BakedGlyph> glyphs(num_glyphs);
+  std::vector<unsigned char> atlas_pixels;
+  unsigned int atlas_width = FIRST_ATLAS_SIZE, atlas_height = FIRST_ATLAS_SIZE;
+  for(;;)
+  {
+    //glyphs are all inserted in the same frame, so none of them can be evicted
+    GlyphAtlas atlas(atlas_width, atlas_height, _padding);
+    bool fits = true;
+    std::vector<GlyphAtlas::Handle> handles(num_glyphs);
+    for(unsigned int i = 0; i < num_glyphs && fits; ++i)
+    {
+      handles[order[i]] = atlas.Insert(MakeGlyphKey(0, 0, glyph_indices[order[i]]), bitmaps[order[i]]);
+      fits = handles[order[i]] != GlyphAtlas::INVALID_HANDLE;
+    }
+
+    if(fits)
+    {
+      unsigned int used_height = 1;
+      for(unsigned int i = 0; i < num_glyphs; ++i)
+      {
+        const AtlasGlyph& placed = atlas.Glyph(handles[i]);
+        BakedGlyph& glyph = glyphs[i];
+        glyph.glyph_index = glyph_indices[i];
+        glyph.x = (unsigned short)placed.x;
+        glyph.y = (unsigned short)placed.y;
+        glyph.width = (unsigned short)placed.width;
+        glyph.height = (unsigned short)placed.height;
+        glyph.left = (short)placed.left;
+        glyph.top = (short)placed.top;
+        glyph.advance = placed.advance;
+        if(placed.height > 0)
+          used_height = std::max(used_height, std::min((unsigned int)(placed.y + placed.height) + _padding, atlas_height));
+      }
+      atlas_height = used_height;
+      atlas_pixels.assign(atlas.Pixels(), atlas.Pixels() + atlas_width * atlas_height);
+      break;
+    }
+
+    if(atlas_width >= MAX_ATLAS_SIZE && atlas_height >= MAX_ATLAS_SIZE)
+    {
+      SOL_ERROR("The glyphs dont fit in the largest atlas");
+      return false;
+    }
+    if(atlas_width <= atlas_height)
+      atlas_width *= 2;
+    else
+      atlas_height *= 2;
+  }
+  _stats.atlas_width = atlas_width;
+  _stats.atlas_height = atlas_height;
+
+  //the table's pairs are sorted here, the others come out sorted because glyph_indices is
+  std::vector<BakedKerningPair> kerning;
+  std::vector<GlyphPair> pairs;
+  FT_Face face = _fonts.Face(_font, _pixel_size);
+  if(face && FT_HAS_KERNING(face) && ReadKernTable(face, pairs))
+  {
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    for(size_t i = 0; i < pairs.size(); ++i)
+    {
+      if(std::binary_search(glyph_indices.begin(), glyph_indices.end(), pairs[i].first) &&
+         std::binary_search(glyph_indices.begin(), glyph_indices.end(), pairs[i].second))
+        AddKerning(face, pairs[i].first, pairs[i].second, kerning);
+    }
+  }
+  else if(face && FT_HAS_KERNING(face))
+  {
+    //kerning from somewhere else, like a Type 1 font's AFM file, can only be asked about pair by pair
+    for(unsigned int left = 0; left < num_glyphs; ++left)
+    {
+      for(unsigned int right = 0; right < num_glyphs; ++right)
+        AddKerning(face, glyph_indices[left], glyph_indices[right], kerning);
+    }
+  }
+  _stats.kerning_pairs = (unsigned int)kerning.size();
+
+  FontMetrics metrics;
+  _fonts.Metrics(_font, _pixel_size, metrics);
+  BakedFontHeader header;
+  header.magic = BAKED_FONT_MAGIC;
+  header.version = BAKED_FONT_VERSION;
+  header.flags = _spread ? BAKED_FONT_DISTANCE_FIELD : 0;
+  header.pixel_size = _pixel_size;
+  header.spread = _spread;
+  header.ascender = metrics.ascender;
+  header.descender = metrics.descender;
+  header.line_height = metrics.line_height;
+  header.num_characters = (unsigned int)characters.size();
+  header.characters_offset = sizeof(header);
+  header.num_glyphs = num_glyphs;
+  header.glyphs_offset = header.characters_offset + header.num_characters * sizeof(BakedCharacter);
+  header.num_kerning_pairs = (unsigned int)kerning.size();
+  header.kerning_offset = header.glyphs_offset + header.num_glyphs * sizeof(BakedGlyph);
+  header.atlas_width = atlas_width;
+  header.atlas_height = atlas_height;
+  header.atlas_offset = header.kerning_offset + header.num_kerning_pairs * sizeof(BakedKerningPair);
+
+  HANDLE file = CreateFileW(file_name.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if(file == INVALID_HANDLE_VALUE)
+  {
+    SOL_ERROR("Could not create " + ws2s(file_name));
+    return false;
+  }
+  bool success = WriteAll(file, &header, sizeof(header)) &&
+                 (characters.empty() || WriteAll(file, &characters[0], characters.size() * sizeof(BakedCharacter))) &&
+                 (glyphs.empty() || WriteAll(file, &glyphs[0], glyphs.size() * sizeof(BakedGlyph))) &&
+                 (kerning.empty() || WriteAll(file, &kerning[0], kerning.size() * sizeof(BakedKerningPair))) &&
+                 WriteAll(file, &atlas_pixels[0], atlas_pixels.size());
+  CloseHandle(file);
+  if(!success)
+  {
+    SOL_ERROR("Could not write " + ws2s(file_name));
+    return false;
+  }
+  _stats.bytes = header.atlas_offset + atlas_pixels.size();
+  return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+//========================================================================
+// BakedFontBuilder.h : Writes the files BakedFont maps, for the FontTool
+//
+// Renders every character of a character set with the same code the game
+// uses, the FontCache for plain glyphs and DistanceFieldGlyphs for
+// distance fields, so a baked glyph is exactly the glyph the game would
+// have rendered itself.  Characters that map to the same glyph share it.
+//
+// The glyphs are packed tallest first into a GlyphAtlas, which starts
+// small and doubles until they all fit, and the atlas is cut off below
+// the last glyph.  Kerning is looked up for the pairs in the font's kern
+// table that are between baked glyphs, so a big CJK set costs no more
+// than the table.  Only a font that kerns some other way, like a Type 1
+// font with an AFM file, has every pair of glyphs looked up.
+//========================================================================
+
+#include "FontCache.h"
+
+struct BakedFontBuilderStats
+{
+  unsigned int characters;
+  unsigned int missing;           //characters the font has no glyph for, left out
+  unsigned int glyphs;
+  unsigned int kerning_pairs;
+  unsigned int atlas_width;
+  unsigned int atlas_height;
+  unsigned long long bytes;       //of the whole file
+
+  BakedFontBuilderStats() : characters(0), missing(0), glyphs(0), kerning_pairs(0), atlas_width(0), atlas_height(0), bytes(0) {}
+};
+
+class BakedFontBuilder : public SOL_noncopyable
+{
+  FontCache _fonts;
+  FontId _font;
+  unsigned int _pixel_size;
+  unsigned int _spread;           //0 for plain glyphs
+  unsigned int _upscale;
+  unsigned int _padding;
+  std::vector<unsigned int> _characters;
+  BakedFontBuilderStats _stats;
+
+public:
+  BakedFontBuilder();
+
+  bool SetFont(const std::wstring& file_name, unsigned int pixel_size, int face_index = 0);
+  //bakes distance field glyphs with pixel_size as their base size.  They are only used by
+  //DistanceFieldGlyphs with the same base size and spread.
+  void SetDistanceField(unsigned int spread, unsigned int upscale = 4);
+  //pixels left empty around each glyph in the atlas
+  void SetPadding(unsigned int padding) { _padding = padding; }
+
+  //UTF-8, repeats are ignored
+  void AddCharacters(const char* text, size_t length);
+  bool AddCharacterFile(const std::wstring& file_name);
+
+  bool Build(const std::wstring& file_name);
+  const BakedFontBuilderStats& Stats() const { return _stats; }
+};
@@ -0,0 +1,249 @@
+#include "EngineStd.h"
+#include "DistanceField.h"
+#include "BakedFont.h"
+#include "../Math/BatchMath.h"
+#include <emmintrin.h>
+
+//the offset given to pixels with nothing found yet, far enough that anything real is nearer
+const float FAR_AWAY = 10000.0f;
+
+static int FloorDiv(int a, int b)
+{
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static int RoundUp(int a, int b)
+{
+  return (a + b - 1) / b * b;
+}
+
+#pragma region DistanceTransform
+
+DistanceTransform::DistanceTransform()
+{
+  _width = 0;
+  _height = 0;
+}
+
+//takes q's offset, moved by q - p, if it is nearer than what p has
+static inline void Compare(float* dx, float* dy, int p, int q, float ox, float oy)
+{
+  float x = dx[q] + ox;
+  float y = dy[q] + oy;
+  if(x * x + y * y < dx[p] * dx[p] + dy[p] * dy[p])
+  {
+    dx[p] = x;
+    dy[p] = y;
+  }
+}
+
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Compares every pixel in a row with the three touching it in the row
+// above or below, which is already finished, so the pixels in the row
+// dont depend on each other and can be done four at a time.  The order of
+// the compares is the same either way, so SSE gives exactly the same
+// offsets as the plain loop.
+//////////////////////////////////////////////////////////////////////////////
+static void CompareRow(float* dx, float* dy, int row, int other, float oy, int width, bool sse)
+{
+  int x = 1;
+  if(sse)
+  {
+    const __m128 offset_y = _mm_set1_ps(oy);
+    for(; x + 4 <= width - 1; x += 4)
+    {
+      __m128 px = _mm_loadu_ps(dx + row + x);
+      __m128 py = _mm_loadu_ps(dy + row + x);
+      __m128 distance = _mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py));
+      for(int k = -1; k <= 1; ++k)
+      {
+        __m128 qx = _mm_add_ps(_mm_loadu_ps(dx + other + x + k), _mm_set1_ps((float)k));
+        __m128 qy = _mm_add_ps(_mm_loadu_ps(dy + other + x + k), offset_y);
+        __m128 q_distance = _mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy));
+        __m128 nearer = _mm_cmplt_ps(q_distance, distance);
+        px = Select(nearer, qx, px);
+        py = Select(nearer, qy, py);
+        distance = Select(nearer, q_distance, distance);
+      }
+      _mm_storeu_ps(dx + row + x, px);
+      _mm_storeu_ps(dy + row + x, py);
+    }
+  }
+  for(; x < width - 1; ++x)
+  {
+    for(int k = -1; k <= 1; ++k)
+      Compare(dx, dy, row + x, other + x + k, (float)k, oy);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The two passes of 8SSEDT.  Going down, each row takes what it can from
+// the row above and then from its left and right neighbours, going up the
+// same from the row below.  The border of the grid is never written.
+//////////////////////////////////////////////////////////////////////////////
+void DistanceTransform::Sweep(float* dx, float* dy, bool sse)
+{
+  for(int y = 1; y < _height - 1; ++y)
+  {
+    int row = y * _width;
+    CompareRow(dx, dy, row, row - _width, -1.0f, _width, sse);
+    for(int x = 1; x < _width - 1; ++x)
+      Compare(dx, dy, row + x, row + x - 1, -1.0f, 0.0f);
+    for(int x = _width - 2; x >= 1; --x)
+      Compare(dx, dy, row + x, row + x + 1, 1.0f, 0.0f);
+  }
+  for(int y = _height - 2; y >= 1; --y)
+  {
+    int row = y * _width;
+    CompareRow(dx, dy, row, row + _width, 1.0f, _width, sse);
+    for(int x = _width - 2; x >= 1; --x)
+      Compare(dx, dy, row + x, row + x + 1, 1.0f, 0.0f);
+    for(int x = 1; x < _width - 1; ++x)
+      Compare(dx, dy, row + x, row + x - 1, -1.0f, 0.0f);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Works out the distance from each pixel to the nearest inside pixel and
+// to the nearest outside one.  Pixel centers are half a pixel from the
+// edge between them, so inside the distance is the distance to outside
+// less a half, outside it is the distance to inside less a half, negated.
+// Each out pixel averages the pixels at the middle of its block.
+//////////////////////////////////////////////////////////////////////////////
+void DistanceTransform::Build(const unsigned char* coverage, int width, int height, int pitch, int scale, float spread, unsigned char* out)
+{
+  _width = width + 2;
+  _height = height + 2;
+  for(int i = 0; i < 2; ++i)
+  {
+    _dx[i].assign(_width * _height, FAR_AWAY);
+    _dy[i].assign(_width * _height, FAR_AWAY);
+  }
+
+  //the border is outside
+  for(int y = 0; y < _height; ++y)
+  {
+    for(int x = 0; x < _width; ++x)
+    {
+      bool border = x == 0 || y == 0 || x == _width - 1 || y == _height - 1;
+      bool inside = !border && coverage[(y - 1) * pitch + x - 1] >= 128;
+      int seed = inside ? 0 : 1;
+      _dx[seed][y * _width + x] = 0.0f;
+      _dy[seed][y * _width + x] = 0.0f;
+    }
+  }
+
+  bool sse = GetBatchMathPath() != BATCH_MATH_SCALAR;
+  for(int i = 0; i < 2; ++i)
+    Sweep(&_dx[i][0], &_dy[i][0], sse);
+
+  const float* inside_x = &_dx[0][0];
+  const float* inside_y = &_dy[0][0];
+  const float* outside_x = &_dx[1][0];
+  const float* outside_y = &_dy[1][0];
+  float to_value = 127.0f / (spread * scale);
+  int out_width = width / scale, out_height = height / scale;
+  for(int j = 0; j < out_height; ++j)
+  {
+    for(int i = 0; i < out_width; ++i)
+    {
+      float sum = 0.0f;
+      for(int sy = (scale - 1) / 2; sy <= scale / 2; ++sy)
+      {
+        for(int sx = (scale - 1) / 2; sx <= scale / 2; ++sx)
+        {
+          int p = (j * scale + sy + 1) * _width + i * scale + sx + 1;
+          if(inside_x[p] == 0.0f && inside_y[p] == 0.0f)
+            sum += sqrtf(outside_x[p] * outside_x[p] + outside_y[p] * outside_y[p]) - 0.5f;
+          else
+            sum -= sqrtf(inside_x[p] * inside_x[p] + inside_y[p] * inside_y[p]) - 0.5f;
+        }
+      }
+      int samples = (scale % 2) ? 1 : 4;
+      float value = 128.0f + sum / samples * to_value;
+      out[j * out_width + i] = (unsigned char)std::max(0.0f, std::min(value + 0.5f, 255.0f));
+    }
+  }
+}
+
+#pragma endregion
+
+#pragma region DistanceFieldGlyphs
+
+DistanceFieldGlyphs::DistanceFieldGlyphs(FontCache& fonts, unsigned int base_size, unsigned int spread, unsigned int upscale)
+{
+  _fonts = &fonts;
+  _base_size = std::max(1u, base_size);
+  _spread = std::max(1u, spread);
+  _upscale = std::max(1u, upscale);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The big bitmap is put in a grid lined up on whole out pixels, so the
+// glyph's left and top come out in whole base size pixels, with the
+// spread around it so the distances can fall away to nothing.
+//////////////////////////////////////////////////////////////////////////////
+bool DistanceFieldGlyphs::Glyph(FT_Face face, unsigned int glyph_index, DistanceFieldScratch& scratch, GlyphBitmap& out) const
+{
+  int scale = (int)_upscale;
+  if(FT_Load_Glyph(face, glyph_index, FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP) != 0 ||
+     FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL) != 0)
+    return false;
+
+  FT_GlyphSlot slot = face->glyph;
+  const FT_Bitmap& bitmap = slot->bitmap;
+  out.glyph_index = glyph_index;
+  out.advance = slot->advance.x / 64.0f / scale;
+  if(bitmap.width <= 0 || bitmap.rows <= 0)
+  {
+    out.width = out.height = 0;
+    out.left = out.top = 0;
+    out.pitch = 0;
+    out.pixels = 0;
+    return true;
+  }
+
+  int padding = (int)_spread * scale;
+  int grid_left = FloorDiv(slot->bitmap_left, scale) * scale - padding;
+  int grid_top = -FloorDiv(-slot->bitmap_top, scale) * scale + padding;
+  int grid_width = RoundUp(slot->bitmap_left + bitmap.width - grid_left + padding, scale);
+  int grid_height = RoundUp(grid_top - (slot->bitmap_top - bitmap.rows) + padding, scale);
+
+  scratch.coverage.assign(grid_width * grid_height, 0);
+  int offset_x = slot->bitmap_left - grid_left;
+  int offset_y = grid_top - slot->bitmap_top;
+  for(int row = 0; row < bitmap.rows; ++row)
+    memcpy(&scratch.coverage[(offset_y + row) * grid_width + offset_x], bitmap.buffer + row * bitmap.pitch, bitmap.width);
+
+  out.width = grid_width / scale;
+  out.height = grid_height / scale;
+  out.left = grid_left / scale;
+  out.top = grid_top / scale;
+  out.pitch = out.width;
+  scratch.pixels.resize(out.width * out.height);
+  scratch.transform.Build(&scratch.coverage[0], grid_width, grid_height, grid_width, scale, (float)_spread, &scratch.pixels[0]);
+  out.pixels = &scratch.pixels[0];
+  return true;
+}
+
+const BakedFont* DistanceFieldGlyphs::Baked(FontId font) const
+{
+  const BakedFont* baked = _fonts->Baked(font, _base_size, true);
+  return baked && baked->Spread() == _spread ? baked : 0;
+}
+
+bool DistanceFieldGlyphs::Glyph(FontId font, unsigned int glyph_index, GlyphBitmap& out)
+{
+  const BakedFont* baked = Baked(font);
+  if(baked && baked->Glyph(glyph_index, out))
+    return true;
+  FT_Face face = _fonts->Face(font, RenderSize());
+  return face && Glyph(face, glyph_index, _scratch, out);
+}
+
+#pragma endregion
@@ -0,0 +1,83 @@
+#pragma once
+//========================================================================
+// DistanceField.h : Signed distance field glyphs, one size for all sizes
+//
+// Instead of how much of each pixel a glyph covers, a distance field
+// glyph stores how far each pixel is from the glyph's edge, 128 on the
+// edge and more inside.  Filtered and thresholded in the shader it gives
+// sharp edges at any scale, so one page of glyphs made at a single base
+// size serves every size the HUD uses and nothing has to be rendered
+// again when the resolution changes.
+//
+// Glyphs are rendered by FreeType a few times larger than the base size
+// and the distances worked out on that bitmap with 8SSEDT, which passes
+// over the image twice carrying the offset to the nearest edge pixel
+// along.  Each pass first compares a whole row against the finished row
+// before it, four pixels at a time with SSE, and then sweeps along the
+// row each way, which has to be done a pixel at a time.  The big bitmap
+// is then sampled once per output pixel.
+//
+// The DistanceFieldGlyphs hand back GlyphBitmaps for the GlyphAtlas like
+// the FontCache does, with their metrics at the base size and the spread
+// added around every side.  The same code runs offline to bake them, and
+// baked glyphs that match are used instead of making them again.
+//========================================================================
+
+#include "FontCache.h"
+
+//8SSEDT over an 8 bit coverage bitmap.  Keeps its working memory between calls, use one per thread.
+class DistanceTransform : public SOL_noncopyable
+{
+  int _width;     //of the grid, which has a border of one pixel around the image
+  int _height;
+  std::vector<float> _dx[2];    //offset to the nearest inside pixel, and to the nearest outside one
+  std::vector<float> _dy[2];
+
+public:
+  DistanceTransform();
+
+  //a pixel is inside where coverage is 128 or more.  width and height have to be multiples of scale, out
+  //gets width / scale by height / scale pixels.  spread is in out pixels.
+  void Build(const unsigned char* coverage, int width, int height, int pitch, int scale, float spread, unsigned char* out);
+
+private:
+  void Sweep(float* dx, float* dy, bool sse);
+};
+
+//what making a distance field glyph needs on each thread
+struct DistanceFieldScratch
+{
+  DistanceTransform transform;
+  std::vector<unsigned char> coverage;
+  std::vector<unsigned char> pixels;
+};
+
+class DistanceFieldGlyphs : public SOL_noncopyable
+{
+  FontCache* _fonts;
+  unsigned int _base_size;
+  unsigned int _spread;
+  unsigned int _upscale;
+  DistanceFieldScratch _scratch;
+
+public:
+  //glyphs are made at base_size pixels, rendered upscale times bigger, with spread pixels of distance around them
+  DistanceFieldGlyphs(FontCache& fonts, unsigned int base_size = 32, unsigned int spread = 4, unsigned int upscale = 4);
+
+  //the bitmap is only good until the next call.  Baked glyphs come from the BakedFont.
+  bool Glyph(FontId font, unsigned int glyph_index, GlyphBitmap& out);
+  //the same from a face of the caller's own, already set to RenderSize().  Doesnt touch the FontCache,
+  //so threads with their own FT_Library can call it at once.  The bitmap is in scratch.
+  bool Glyph(FT_Face face, unsigned int glyph_index, DistanceFieldScratch& scratch, GlyphBitmap& out) const;
+
+  //the font's distance field bake made with this base size and spread, or NULL
+  const BakedFont* Baked(FontId font) const;
+
+  //the atlas key of a distance field glyph, it never matches a plain glyph's
+  GlyphKey Key(FontId font, unsigned int glyph_index) const { return MakeGlyphKey(font, DISTANCE_FIELD_SIZE | _base_size, glyph_index); }
+  enum { DISTANCE_FIELD_SIZE = 0x8000 };
+
+  unsigned int BaseSize() const { return _base_size; }
+  unsigned int Spread() const { return _spread; }
+  unsigned int RenderSize() const { return _base_size * _upscale; }
+};
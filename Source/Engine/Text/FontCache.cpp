@@ -0,0 +1,249 @@
+#include "EngineStd.h"
+#include "FontCache.h"
+#include "BakedFont.h"
+#include "../Debugging/Logger.h"
+
+//the cmap cache picks the unicode charmap for this
+const FT_Int UNICODE_CHARMAP = -1;
+
+//the face id the FTC_Manager knows a font by, it cant be NULL
+static FTC_FaceID FaceId(FontId font)
+{
+  return (FTC_FaceID)(size_t)(font + 1);
+}
+
+FontCache::FontCache(unsigned int max_faces, unsigned int max_bytes)
+{
+  _library = 0;
+  _manager = 0;
+  _cmap_cache = 0;
+  _sbit_cache = 0;
+  _image_cache = 0;
+  _large_glyph = 0;
+
+  if(FT_Init_FreeType(&_library) != 0)
+  {
+    SOL_ERROR("FreeType failed to initialize");
+    _library = 0;
+    return;
+  }
+  if(FTC_Manager_New(_library, max_faces, 0, max_bytes, RequestFace, this, &_manager) != 0 ||
+     FTC_CMapCache_New(_manager, &_cmap_cache) != 0 ||
+     FTC_SBitCache_New(_manager, &_sbit_cache) != 0 ||
+     FTC_ImageCache_New(_manager, &_image_cache) != 0)
+  {
+    SOL_ERROR("FreeType's cache manager failed to initialize");
+    if(_manager)
+      FTC_Manager_Done(_manager);
+    _manager = 0;
+  }
+}
+
+FontCache::~FontCache()
+{
+  if(_large_glyph)
+    FT_Done_Glyph(_large_glyph);
+  //the manager frees its caches and faces
+  if(_manager)
+    FTC_Manager_Done(_manager);
+  if(_library)
+    FT_Done_FreeType(_library);
+}
+
+FT_Error FontCache::RequestFace(FTC_FaceID face_id, FT_Library library, FT_Pointer data, FT_Face* face)
+{
+  FontCache* cache = (FontCache*)data;
+  FontId font = (FontId)((size_t)face_id - 1);
+  FT_Error error = cache->OpenFace(font, library, face);
+  if(error != 0)
+    SOL_ERROR("Couldnt open font " + cache->FontName(font));
+  return error;
+}
+
+FT_Error FontCache::OpenFace(FontId font, FT_Library library, FT_Face* face) const
+{
+  if(font >= _fonts.size())
+    return FT_Err_Invalid_Argument;
+  const FontSource& source = _fonts[font];
+  FT_Error error;
+  if(source.data)
+    error = FT_New_Memory_Face(library, (const FT_Byte*)source.data, source.size, source.face_index, face);
+  else
+    error = FT_New_Face(library, source.file_name.c_str(), source.face_index, face);
+  return error;
+}
+
+std::string FontCache::FontName(FontId font) const
+{
+  if(font >= _fonts.size())
+    return "with a bad FontId";
+  return _fonts[font].data ? std::string("from memory") : _fonts[font].file_name;
+}
+
+FontId FontCache::AddFont(const std::string& file_name, int face_index)
+{
+  FontSource source;
+  source.file_name = file_name;
+  source.data = 0;
+  source.size = 0;
+  source.face_index = face_index;
+  _fonts.push_back(source);
+  return (FontId)_fonts.size() - 1;
+}
+
+FontId FontCache::AddFont(const char* data, unsigned int size, int face_index)
+{
+  FontSource source;
+  source.data = data;
+  source.size = size;
+  source.face_index = face_index;
+  _fonts.push_back(source);
+  return (FontId)_fonts.size() - 1;
+}
+
+void FontCache::AddBakedFont(FontId font, const BakedFont& baked)
+{
+  if(font < _fonts.size() && baked.IsOpen())
+    _fonts[font].baked.push_back(&baked);
+}
+
+const BakedFont* FontCache::Baked(FontId font, unsigned int pixel_size, bool distance_field) const
+{
+  if(font >= _fonts.size())
+    return 0;
+  const std::vector<const BakedFont*>& baked = _fonts[font].baked;
+  for(unsigned int i = 0; i < baked.size(); ++i)
+  {
+    if(baked[i]->PixelSize() == pixel_size && baked[i]->IsDistanceField() == distance_field)
+      return baked[i];
+  }
+  return 0;
+}
+
+void FontCache::Scaler(FontId font, unsigned int pixel_size, FTC_ScalerRec& scaler) const
+{
+  scaler.face_id = FaceId(font);
+  scaler.width = pixel_size;
+  scaler.height = pixel_size;
+  scaler.pixel = 1;
+  scaler.x_res = 0;
+  scaler.y_res = 0;
+}
+
+//the glyph indices are the font's own, so any size that has the character will do
+unsigned int FontCache::GlyphIndex(FontId font, unsigned int character)
+{
+  if(font >= _fonts.size())
+    return 0;
+  const std::vector<const BakedFont*>& baked = _fonts[font].baked;
+  for(unsigned int i = 0; i < baked.size(); ++i)
+  {
+    unsigned int glyph_index = baked[i]->GlyphIndex(character);
+    if(glyph_index)
+      return glyph_index;
+  }
+  if(!_manager)
+    return 0;
+  return FTC_CMapCache_Lookup(_cmap_cache, FaceId(font), UNICODE_CHARMAP, character);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The small bitmap cache marks a glyph it couldnt hold by leaving its
+// buffer NULL and setting its width to 255, those are rendered from the
+// outline in the image cache instead.  A blank glyph also has no buffer,
+// but a width of 0.
+//////////////////////////////////////////////////////////////////////////////
+bool FontCache::Glyph(FontId font, unsigned int pixel_size, unsigned int glyph_index, GlyphBitmap& out)
+{
+  const BakedFont* baked = Baked(font, pixel_size, false);
+  if(baked && baked->Glyph(glyph_index, out))
+    return true;
+  if(!_manager || font >= _fonts.size())
+    return false;
+
+  FTC_ScalerRec scaler;
+  Scaler(font, pixel_size, scaler);
+  FTC_SBit sbit;
+  if(FTC_SBitCache_LookupScaler(_sbit_cache, &scaler, FT_LOAD_DEFAULT | FT_LOAD_RENDER, glyph_index, &sbit, 0) != 0)
+    return false;
+
+  out.glyph_index = glyph_index;
+  if(sbit->buffer || sbit->width != 255)
+  {
+    out.width = sbit->width;
+    out.height = sbit->height;
+    out.left = sbit->left;
+    out.top = sbit->top;
+    out.advance = (float)sbit->xadvance;
+    out.pitch = sbit->pitch;
+    out.pixels = sbit->buffer;
+    if(!out.pixels)
+      out.width = out.height = 0;
+    return true;
+  }
+
+  FT_Glyph glyph;
+  if(FTC_ImageCache_LookupScaler(_image_cache, &scaler, FT_LOAD_DEFAULT, glyph_index, &glyph, 0) != 0)
+    return false;
+  if(_large_glyph)
+    FT_Done_Glyph(_large_glyph);
+  _large_glyph = 0;
+  if(FT_Glyph_Copy(glyph, &_large_glyph) != 0 || FT_Glyph_To_Bitmap(&_large_glyph, FT_RENDER_MODE_NORMAL, 0, 1) != 0)
+    return false;
+
+  FT_BitmapGlyph bitmap = (FT_BitmapGlyph)_large_glyph;
+  out.width = bitmap->bitmap.width;
+  out.height = bitmap->bitmap.rows;
+  out.left = bitmap->left;
+  out.top = bitmap->top;
+  out.advance = (float)((glyph->advance.x + 0x8000) >> 16);
+  out.pitch = bitmap->bitmap.pitch;
+  out.pixels = bitmap->bitmap.buffer;
+  return true;
+}
+
+int FontCache::Kerning(FontId font, unsigned int pixel_size, unsigned int left_glyph, unsigned int right_glyph)
+{
+  //every pair between baked glyphs was baked, the ones that arent there are 0
+  const BakedFont* baked = Baked(font, pixel_size, false);
+  if(baked && baked->HasGlyph(left_glyph) && baked->HasGlyph(right_glyph))
+    return baked->Kerning(left_glyph, right_glyph);
+
+  FT_Face face = Face(font, pixel_size);
+  if(!face || !FT_HAS_KERNING(face))
+    return 0;
+  FT_Vector delta;
+  if(FT_Get_Kerning(face, left_glyph, right_glyph, FT_KERNING_DEFAULT, &delta) != 0)
+    return 0;
+  return (int)((delta.x + 32) >> 6);
+}
+
+bool FontCache::Metrics(FontId font, unsigned int pixel_size, FontMetrics& out)
+{
+  const BakedFont* baked = Baked(font, pixel_size, false);
+  if(baked)
+  {
+    baked->Metrics(out);
+    return true;
+  }
+  FT_Face face = Face(font, pixel_size);
+  if(!face)
+    return false;
+  const FT_Size_Metrics& metrics = face->size->metrics;
+  out.ascender = (int)((metrics.ascender + 63) >> 6);
+  out.descender = (int)(metrics.descender >> 6);
+  out.line_height = (int)((metrics.height + 63) >> 6);
+  return true;
+}
+
+FT_Face FontCache::Face(FontId font, unsigned int pixel_size)
+{
+  if(!_manager || font >= _fonts.size())
+    return 0;
+  FTC_ScalerRec scaler;
+  Scaler(font, pixel_size, scaler);
+  FT_Size size;
+  if(FTC_Manager_LookupSize(_manager, &scaler, &size) != 0)
+    return 0;
+  return size->face;
+}
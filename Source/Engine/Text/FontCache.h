@@ -0,0 +1,97 @@
+#pragma once
+//========================================================================
+// FontCache.h : Fonts and rendered glyphs through FreeType's cache manager
+//
+// Fonts are added by file name or from bytes already in memory, like a
+// resource from the ResourceCache, and are referred to by a FontId.  The
+// faces themselves are opened by the FTC_Manager only when a glyph needs
+// them, and it closes the least used ones again once there are more than
+// a handful open.
+//
+// Glyph() turns a character into an 8 bit coverage bitmap.  Small glyphs,
+// which is nearly all text, come from FreeType's small bitmap cache, so
+// asking again for one that was already rendered is a hash lookup.  The
+// small bitmap cache can only hold glyphs up to 255 pixels with advances
+// under 128, anything bigger is rendered from the outline cache instead.
+//
+// The bitmaps belong to FreeType's caches and are only good until the next
+// call into the FontCache, copy them into the GlyphAtlas straight away.
+// FreeType isnt thread safe, so neither is this.
+//
+// A font can have BakedFonts added to it, which are asked first.  A baked
+// character never needs the font opened, and neither do the glyphs,
+// kerning and metrics at a baked size.
+//========================================================================
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_CACHE_H
+#include FT_GLYPH_H
+
+#include "Glyph.h"
+
+class BakedFont;
+
+struct FontMetrics
+{
+  int ascender;
+  int descender;      //negative, below the baseline
+  int line_height;
+};
+
+class FontCache : public SOL_noncopyable
+{
+  struct FontSource
+  {
+    std::string file_name;
+    const char* data;     //used instead of the file when it isnt NULL
+    unsigned int size;
+    int face_index;
+    std::vector<const BakedFont*> baked;
+  };
+
+  FT_Library _library;
+  FTC_Manager _manager;
+  FTC_CMapCache _cmap_cache;
+  FTC_SBitCache _sbit_cache;
+  FTC_ImageCache _image_cache;
+  std::vector<FontSource> _fonts;
+  FT_Glyph _large_glyph;  //the last glyph too big for the small bitmap cache
+
+public:
+  //max_bytes is how much the FTC_Manager can keep of rendered glyphs
+  explicit FontCache(unsigned int max_faces = 4, unsigned int max_bytes = 1024 * 1024);
+  ~FontCache();
+
+  //false if FreeType failed to start, nothing else will work
+  bool IsValid() const { return _manager != 0; }
+
+  //the file isnt opened until a glyph is needed from it
+  FontId AddFont(const std::string& file_name, int face_index = 0);
+  //data has to stay valid for as long as the FontCache
+  FontId AddFont(const char* data, unsigned int size, int face_index = 0);
+  unsigned int NumFonts() const { return (unsigned int)_fonts.size(); }
+  //baked has to stay open for as long as the FontCache
+  void AddBakedFont(FontId font, const BakedFont& baked);
+  //NULL if the font wasnt baked at that size, or that way
+  const BakedFont* Baked(FontId font, unsigned int pixel_size, bool distance_field) const;
+  //opens a font in another FT_Library, for threads that render glyphs on their own.  The caller closes it.
+  //It doesnt log, so it can be called from any thread, failures are left to the caller to report.
+  FT_Error OpenFace(FontId font, FT_Library library, FT_Face* face) const;
+  //the file name, for messages
+  std::string FontName(FontId font) const;
+
+  //0 if the font has no glyph for the character
+  unsigned int GlyphIndex(FontId font, unsigned int character);
+  bool Glyph(FontId font, unsigned int pixel_size, unsigned int glyph_index, GlyphBitmap& out);
+  //the extra space between two glyphs, usually 0 or negative
+  int Kerning(FontId font, unsigned int pixel_size, unsigned int left_glyph, unsigned int right_glyph);
+  bool Metrics(FontId font, unsigned int pixel_size, FontMetrics& out);
+
+  //the face at a size, for reading outlines.  Only good until the next call into the FontCache.
+  FT_Face Face(FontId font, unsigned int pixel_size);
+
+private:
+  void Scaler(FontId font, unsigned int pixel_size, FTC_ScalerRec& scaler) const;
+  static FT_Error RequestFace(FTC_FaceID face_id, FT_Library library, FT_Pointer data, FT_Face* face);
+};
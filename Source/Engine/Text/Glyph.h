@@ -0,0 +1,28 @@
+#pragma once
+//========================================================================
+// Glyph.h : The types the text classes pass glyphs around with
+//========================================================================
+
+typedef unsigned int FontId;
+const FontId INVALID_FONT_ID = UINT_MAX;
+
+//a font, a pixel size and a glyph index in one, 16 bits of font, 16 of size and 32 of glyph
+typedef unsigned long long GlyphKey;
+
+inline GlyphKey MakeGlyphKey(FontId font, unsigned int pixel_size, unsigned int glyph_index)
+{
+  return ((GlyphKey)(font & 0xffff) << 48) | ((GlyphKey)(pixel_size & 0xffff) << 32) | glyph_index;
+}
+
+//a rendered glyph, in pixels.  y is up, so top is the distance from the baseline up to the first row.
+struct GlyphBitmap
+{
+  unsigned int glyph_index;
+  int width;
+  int height;
+  int left;
+  int top;
+  float advance;                //fractional for distance field glyphs
+  int pitch;                    //bytes from one row to the next
+  const unsigned char* pixels;  //NULL for a blank glyph, like a space
+};
@@ -0,0 +1,457 @@
+#include "EngineStd.h"
+#include "GlyphAtlas.h"
+#include "../Debugging/Logger.h"
+
+//shelf heights are rounded up to this, so glyphs of nearly the same height share shelves
+const int SHELF_ROUNDING = 4;
+
+//the height of the shelf a glyph needs
+static int ShelfHeight(int height, int padding)
+{
+  return (height + padding + SHELF_ROUNDING - 1) / SHELF_ROUNDING * SHELF_ROUNDING;
+}
+
+GlyphAtlas::GlyphAtlas(unsigned int width, unsigned int height, unsigned int padding)
+{
+  _width = (int)std::max(1u, width);
+  _height = (int)std::max(1u, height);
+  _padding = (int)padding;
+  _pixels.resize(_width * _height);
+  _frame = 0;
+  _generation = 0;
+  Clear();
+  ResetStats();
+}
+
+void GlyphAtlas::Clear()
+{
+  if(!_glyphs.empty())
+    ++_generation;
+  memset(&_pixels[0], 0, _pixels.size());
+  _shelves.clear();
+  _shelves_end = 0;
+  _slots.clear();
+  _free_slots.clear();
+  _glyphs.clear();
+  _touches = 0;
+  _dirty_min_x = 0;
+  _dirty_min_y = 0;
+  _dirty_max_x = _width;
+  _dirty_max_y = _height;
+}
+
+void GlyphAtlas::ResetStats()
+{
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+void GlyphAtlas::Touch(Handle handle)
+{
+  _slots[handle].last_used = _frame;
+  _slots[handle].last_touch = ++_touches;
+}
+
+GlyphAtlas::Handle GlyphAtlas::Find(GlyphKey key)
+{
+  GlyphMap::iterator found = _glyphs.find(key);
+  if(found == _glyphs.end())
+  {
+    ++_stats.misses;
+    return INVALID_HANDLE;
+  }
+  ++_stats.hits;
+  Touch(found->second);
+  return found->second;
+}
+
+GlyphAtlas::Handle GlyphAtlas::Insert(GlyphKey key, const GlyphBitmap& bitmap)
+{
+  GlyphMap::iterator found = _glyphs.find(key);
+  if(found != _glyphs.end())
+  {
+    Touch(found->second);
+    return found->second;
+  }
+
+  Handle handle;
+  if(!_free_slots.empty())
+  {
+    handle = _free_slots.back();
+    _free_slots.pop_back();
+  }
+  else
+  {
+    handle = (Handle)_slots.size();
+    _slots.push_back(Slot());
+  }
+
+  Slot& slot = _slots[handle];
+  AtlasGlyph& glyph = slot.glyph;
+  glyph.key = key;
+  glyph.x = 0;
+  glyph.y = 0;
+  glyph.width = bitmap.pixels ? bitmap.width : 0;
+  glyph.height = bitmap.pixels ? bitmap.height : 0;
+  glyph.left = bitmap.left;
+  glyph.top = bitmap.top;
+  glyph.advance = bitmap.advance;
+  slot.shelf = INVALID_HANDLE;
+
+  if(glyph.width > 0 && glyph.height > 0)
+  {
+    bool fits = glyph.width + _padding <= _width && ShelfHeight(glyph.height, _padding) <= _height;
+    if(fits && !Allocate(handle))
+      fits = MakeRoom(handle) && Allocate(handle);
+    if(!fits)
+    {
+      ++_stats.failures;
+      _free_slots.push_back(handle);
+      return INVALID_HANDLE;
+    }
+
+    //clear the padding too, whatever was here before may have left pixels in it
+    int x1 = std::min(glyph.x + glyph.width + _padding, _width);
+    int y1 = std::min(glyph.y + glyph.height + _padding, _height);
+    for(int y = glyph.y; y < y1; ++y)
+      memset(&_pixels[y * _width + glyph.x], 0, x1 - glyph.x);
+    for(int row = 0; row < glyph.height; ++row)
+      memcpy(&_pixels[(glyph.y + row) * _width + glyph.x], bitmap.pixels + row * bitmap.pitch, glyph.width);
+
+    _dirty_min_x = std::min(_dirty_min_x, glyph.x);
+    _dirty_min_y = std::min(_dirty_min_y, glyph.y);
+    _dirty_max_x = std::max(_dirty_max_x, x1);
+    _dirty_max_y = std::max(_dirty_max_y, y1);
+  }
+
+  _glyphs[key] = handle;
+  Touch(handle);
+  return handle;
+}
+
+#pragma region Shelves
+
+//////////////////////////////////////////////////////////////////////////////
+// Looks for room on a shelf whose height is close to the glyph's first,
+// then on an empty shelf, then starts a new shelf below the last one, and
+// only then puts it on a shelf much taller than it needs.  On a shelf the
+// first gap wide enough is taken, or the free space past the end of it.
+// An empty shelf is cut down to the glyph's height and the rest of it
+// stays empty below.
+//////////////////////////////////////////////////////////////////////////////
+bool GlyphAtlas::Allocate(Handle handle)
+{
+  AtlasGlyph& glyph = _slots[handle].glyph;
+  int width = glyph.width + _padding;
+  int height = ShelfHeight(glyph.height, _padding);
+
+  unsigned int best = INVALID_HANDLE, empty = INVALID_HANDLE, tall = INVALID_HANDLE;
+  int best_x = 0, tall_x = 0;
+  for(unsigned int s = 0; s < _shelves.size(); ++s)
+  {
+    const Shelf& shelf = _shelves[s];
+    if(shelf.height < height)
+      continue;
+    if(shelf.spans.empty())
+    {
+      if(empty == INVALID_HANDLE || shelf.height < _shelves[empty].height)
+        empty = s;
+      continue;
+    }
+
+    int x = -1;
+    for(unsigned int i = 0; i < shelf.spans.size() && x < 0; ++i)
+    {
+      if(shelf.spans[i].slot == INVALID_HANDLE && shelf.spans[i].width >= width)
+        x = shelf.spans[i].x;
+    }
+    int end = shelf.End();
+    if(x < 0 && _width - end >= width)
+      x = end;
+    if(x < 0)
+      continue;
+
+    bool close = shelf.height <= height + height / 2;
+    if(close && (best == INVALID_HANDLE || shelf.height < _shelves[best].height))
+    {
+      best = s;
+      best_x = x;
+    }
+    else if(!close && (tall == INVALID_HANDLE || shelf.height < _shelves[tall].height))
+    {
+      tall = s;
+      tall_x = x;
+    }
+  }
+
+  if(best == INVALID_HANDLE && empty != INVALID_HANDLE)
+  {
+    best = empty;
+    best_x = 0;
+    if(_shelves[empty].height > height)
+    {
+      Shelf rest;
+      rest.y = _shelves[empty].y + height;
+      rest.height = _shelves[empty].height - height;
+      _shelves[empty].height = height;
+      _shelves.insert(_shelves.begin() + empty + 1, rest);
+      Renumber(empty + 2);
+    }
+  }
+  if(best == INVALID_HANDLE && _shelves_end + height <= _height)
+  {
+    Shelf shelf;
+    shelf.y = _shelves_end;
+    shelf.height = height;
+    _shelves.push_back(shelf);
+    _shelves_end += height;
+    best = (unsigned int)_shelves.size() - 1;
+    best_x = 0;
+  }
+  if(best == INVALID_HANDLE)
+  {
+    best = tall;
+    best_x = tall_x;
+  }
+  if(best == INVALID_HANDLE)
+    return false;
+
+  Shelf& shelf = _shelves[best];
+  Span span;
+  span.x = best_x;
+  span.width = width;
+  span.slot = handle;
+  unsigned int i = 0;
+  while(i < shelf.spans.size() && shelf.spans[i].x < best_x)
+    ++i;
+  if(i < shelf.spans.size())
+  {
+    //filling a gap, what is left of it stays a gap
+    Span& gap = shelf.spans[i];
+    gap.x += width;
+    gap.width -= width;
+    if(gap.width == 0)
+      gap = span;
+    else
+      shelf.spans.insert(shelf.spans.begin() + i, span);
+  }
+  else
+  {
+    shelf.spans.push_back(span);
+  }
+
+  _slots[handle].shelf = best;
+  glyph.x = best_x;
+  glyph.y = shelf.y;
+  return true;
+}
+
+//the shelves from first on have moved along the list, so their glyphs are told where they are now
+void GlyphAtlas::Renumber(unsigned int first)
+{
+  for(unsigned int s = first; s < _shelves.size(); ++s)
+  {
+    for(unsigned int i = 0; i < _shelves[s].spans.size(); ++i)
+    {
+      if(_shelves[s].spans[i].slot != INVALID_HANDLE)
+        _slots[_shelves[s].spans[i].slot].shelf = s;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Turns the glyph's span into a gap, joining it to the gaps either side.
+// A shelf left empty is joined to empty shelves above and below it, so
+// the space can be cut up again for glyphs taller than any of them, and
+// empty shelves are dropped off the bottom.
+//////////////////////////////////////////////////////////////////////////////
+void GlyphAtlas::Release(Handle handle)
+{
+  unsigned int s = _slots[handle].shelf;
+  if(s == INVALID_HANDLE)
+    return;
+  _slots[handle].shelf = INVALID_HANDLE;
+
+  std::vector<Span>& spans = _shelves[s].spans;
+  unsigned int i = 0;
+  while(spans[i].slot != handle)
+    ++i;
+  spans[i].slot = INVALID_HANDLE;
+  if(i + 1 < spans.size() && spans[i + 1].slot == INVALID_HANDLE)
+  {
+    spans[i].width += spans[i + 1].width;
+    spans.erase(spans.begin() + i + 1);
+  }
+  if(i > 0 && spans[i - 1].slot == INVALID_HANDLE)
+  {
+    spans[i - 1].width += spans[i].width;
+    spans.erase(spans.begin() + i);
+  }
+  if(!spans.empty() && spans.back().slot == INVALID_HANDLE)
+    spans.pop_back();
+
+  if(spans.empty())
+  {
+    unsigned int moved = INVALID_HANDLE;
+    if(s + 1 < _shelves.size() && _shelves[s + 1].spans.empty())
+    {
+      _shelves[s].height += _shelves[s + 1].height;
+      _shelves.erase(_shelves.begin() + s + 1);
+      moved = s + 1;
+    }
+    if(s > 0 && _shelves[s - 1].spans.empty())
+    {
+      _shelves[s - 1].height += _shelves[s].height;
+      _shelves.erase(_shelves.begin() + s);
+      moved = s;
+    }
+    if(moved != INVALID_HANDLE)
+      Renumber(moved);
+  }
+
+  while(!_shelves.empty() && _shelves.back().spans.empty())
+  {
+    _shelves_end = _shelves.back().y;
+    _shelves.pop_back();
+  }
+}
+
+bool GlyphAtlas::Evictable(const Span& span) const
+{
+  return span.slot == INVALID_HANDLE || _slots[span.slot].last_used != _frame;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Looks at every space the glyph would fit in once the glyphs in it were
+// evicted, and evicts the one whose newest glyph is the oldest.  A space
+// is a run of neighbouring spans on a shelf tall enough, counting the free
+// end of the shelf when the run reaches it, or a run of whole shelves
+// tall enough between them, counting the free space below the last shelf
+// when the run reaches it, which Release() joins into one.  Throwing out the
+// least recently used glyph until the new one fits doesnt work on a
+// fragmented atlas, the gaps it leaves can be too short or too narrow and
+// it goes on to empty the whole atlas.  Returns false, having evicted
+// nothing, if every space holds a glyph used this frame.
+//////////////////////////////////////////////////////////////////////////////
+bool GlyphAtlas::MakeRoom(Handle handle)
+{
+  const AtlasGlyph& glyph = _slots[handle].glyph;
+  int width = glyph.width + _padding;
+  int height = ShelfHeight(glyph.height, _padding);
+  const unsigned long long NO_SPACE = ~0ull;
+
+  unsigned long long best_touch = NO_SPACE;
+  unsigned int best_shelf = INVALID_HANDLE, best_first = 0, best_end = 0;
+  for(unsigned int s = 0; s < _shelves.size(); ++s)
+  {
+    const std::vector<Span>& spans = _shelves[s].spans;
+    if(_shelves[s].height < height)
+      continue;
+    for(unsigned int first = 0; first < spans.size(); ++first)
+    {
+      int room = 0;
+      unsigned long long touch = 0;
+      unsigned int end = first;
+      for(; end < spans.size() && room < width && touch < best_touch && Evictable(spans[end]); ++end)
+      {
+        room += spans[end].width;
+        if(spans[end].slot != INVALID_HANDLE)
+          touch = std::max(touch, _slots[spans[end].slot].last_touch);
+      }
+      if(room < width && end == spans.size())
+        room += _width - _shelves[s].End();
+      if(room >= width && touch < best_touch)
+      {
+        best_touch = touch;
+        best_shelf = s;
+        best_first = first;
+        best_end = end;
+      }
+    }
+  }
+
+  //the newest glyph on each shelf, NO_SPACE if it has one that cant be evicted
+  std::vector<unsigned long long> shelf_touch(_shelves.size(), 0);
+  for(unsigned int s = 0; s < _shelves.size(); ++s)
+  {
+    const std::vector<Span>& spans = _shelves[s].spans;
+    for(unsigned int i = 0; i < spans.size() && shelf_touch[s] != NO_SPACE; ++i)
+    {
+      if(!Evictable(spans[i]))
+        shelf_touch[s] = NO_SPACE;
+      else if(spans[i].slot != INVALID_HANDLE)
+        shelf_touch[s] = std::max(shelf_touch[s], _slots[spans[i].slot].last_touch);
+    }
+  }
+  unsigned int best_last = INVALID_HANDLE;
+  for(unsigned int first = 0; first < _shelves.size(); ++first)
+  {
+    unsigned long long touch = 0;
+    for(unsigned int last = first; last < _shelves.size() && shelf_touch[last] < best_touch; ++last)
+    {
+      touch = std::max(touch, shelf_touch[last]);
+      int bottom = last + 1 < _shelves.size() ? _shelves[last].y + _shelves[last].height : _height;
+      if(bottom - _shelves[first].y >= height && touch < best_touch)
+      {
+        best_touch = touch;
+        best_shelf = first;
+        best_last = last;
+        break;
+      }
+    }
+  }
+
+  if(best_touch == NO_SPACE)
+    return false;
+
+  //Evict() changes the spans, so they are listed first.  Gaps are listed as INVALID_HANDLE.
+  std::vector<Handle> victims;
+  if(best_last != INVALID_HANDLE)
+  {
+    for(unsigned int s = best_shelf; s <= best_last; ++s)
+    {
+      for(unsigned int i = 0; i < _shelves[s].spans.size(); ++i)
+        victims.push_back(_shelves[s].spans[i].slot);
+    }
+  }
+  else
+  {
+    for(unsigned int i = best_first; i < best_end; ++i)
+      victims.push_back(_shelves[best_shelf].spans[i].slot);
+  }
+  for(size_t i = 0; i < victims.size(); ++i)
+  {
+    if(victims[i] != INVALID_HANDLE)
+      Evict(victims[i]);
+  }
+  return true;
+}
+
+void GlyphAtlas::Evict(Handle handle)
+{
+  Release(handle);
+  _glyphs.erase(_slots[handle].glyph.key);
+  _free_slots.push_back(handle);
+  ++_generation;
+  ++_stats.evictions;
+}
+
+#pragma endregion
+
+bool GlyphAtlas::DirtyRect(int& min_x, int& min_y, int& max_x, int& max_y) const
+{
+  if(_dirty_min_x >= _dirty_max_x || _dirty_min_y >= _dirty_max_y)
+    return false;
+  min_x = _dirty_min_x;
+  min_y = _dirty_min_y;
+  max_x = _dirty_max_x;
+  max_y = _dirty_max_y;
+  return true;
+}
+
+void GlyphAtlas::ClearDirty()
+{
+  _dirty_min_x = _width;
+  _dirty_min_y = _height;
+  _dirty_max_x = 0;
+  _dirty_max_y = 0;
+}
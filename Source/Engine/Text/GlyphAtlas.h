@@ -0,0 +1,139 @@
+#pragma once
+//========================================================================
+// GlyphAtlas.h : One 8 bit texture holding many glyphs, packed in shelves
+//
+// The atlas is cut into horizontal shelves, each as tall as the first
+// glyph put on it rounded up a little.  A glyph goes on the shortest shelf
+// it fits, so a shelf only ever holds glyphs of about the same height, and
+// along the shelf into the first gap wide enough.  Glyphs have a few
+// blank pixels on their right and bottom so filtering doesnt pick up their
+// neighbours.
+//
+// When the atlas is full, room is made by evicting the glyphs in the space
+// that was used longest ago and that the new glyph would fit in once
+// emptied.  That is a run of neighbouring glyphs and gaps on a shelf tall
+// enough, or a run of whole shelves.  Evicting a glyph joins its gap up
+// with any gaps beside it, an empty shelf joins the empty shelves above
+// and below it, and the next glyph put on an empty shelf cuts it back down
+// to its own height.  Glyphs that have been used since BeginFrame() are
+// never evicted.  If no space is left without them, Insert() fails
+// without evicting anything.  Each eviction bumps Generation(), so
+// anything holding on to where glyphs were can tell it has to look again.
+//
+// The pixels are kept here and the part changed since the last
+// ClearDirty() is tracked, so the renderer only uploads that.
+//========================================================================
+
+#include "Glyph.h"
+
+//where a glyph is in the atlas
+struct AtlasGlyph
+{
+  GlyphKey key;
+  int x;              //top left of the bitmap, in pixels with y down
+  int y;
+  int width;
+  int height;
+  int left;
+  int top;
+  float advance;
+};
+
+struct GlyphAtlasStats
+{
+  unsigned int hits;
+  unsigned int misses;
+  unsigned int evictions;
+  unsigned int failures;    //inserts that didnt fit even after evicting
+};
+
+class GlyphAtlas : public SOL_noncopyable
+{
+public:
+  typedef unsigned int Handle;
+  enum { INVALID_HANDLE = 0xffffffff };
+
+private:
+  struct Slot
+  {
+    AtlasGlyph glyph;
+    unsigned int shelf;     //INVALID_HANDLE for a blank glyph, which takes no space
+    unsigned int last_used;   //the frame
+    unsigned long long last_touch;    //_touches when it was last used, to find the oldest
+  };
+
+  //part of a shelf, in order along it.  They cover the shelf up to its end, the rest of the row is free.
+  struct Span
+  {
+    int x;
+    int width;
+    Handle slot;            //INVALID_HANDLE when it is a gap
+  };
+
+  struct Shelf
+  {
+    int y;
+    int height;
+    std::vector<Span> spans;
+
+    int End() const { return spans.empty() ? 0 : spans.back().x + spans.back().width; }
+  };
+
+  typedef std::tr1::unordered_map<GlyphKey, Handle> GlyphMap;
+
+  int _width;
+  int _height;
+  int _padding;
+  std::vector<unsigned char> _pixels;
+  std::vector<Shelf> _shelves;
+  int _shelves_end;         //the top of the free space below the last shelf
+
+  std::vector<Slot> _slots;
+  std::vector<Handle> _free_slots;
+  GlyphMap _glyphs;
+  unsigned long long _touches;
+  unsigned int _frame;
+  unsigned int _generation;
+
+  int _dirty_min_x, _dirty_min_y, _dirty_max_x, _dirty_max_y;
+  GlyphAtlasStats _stats;
+
+public:
+  GlyphAtlas(unsigned int width = 1024, unsigned int height = 1024, unsigned int padding = 1);
+
+  //glyphs used before the next BeginFrame() are safe from eviction
+  void BeginFrame() { ++_frame; }
+
+  //INVALID_HANDLE if the glyph isnt in the atlas.  Finding a glyph counts as using it.
+  Handle Find(GlyphKey key);
+  //looks without counting a hit or a miss or touching the glyph
+  bool Contains(GlyphKey key) const { return _glyphs.find(key) != _glyphs.end(); }
+  //copies the bitmap in, evicting as needed.  INVALID_HANDLE if it cant be made to fit.
+  Handle Insert(GlyphKey key, const GlyphBitmap& bitmap);
+  //marks a glyph as used without looking it up, for text laid out earlier
+  void Touch(Handle handle);
+  //handles are only good until Generation() changes
+  const AtlasGlyph& Glyph(Handle handle) const { return _slots[handle].glyph; }
+  unsigned int Generation() const { return _generation; }
+
+  //throws every glyph out
+  void Clear();
+
+  int Width() const { return _width; }
+  int Height() const { return _height; }
+  const unsigned char* Pixels() const { return &_pixels[0]; }
+  //false if nothing has changed.  max is one past the last pixel.
+  bool DirtyRect(int& min_x, int& min_y, int& max_x, int& max_y) const;
+  void ClearDirty();
+
+  const GlyphAtlasStats& Stats() const { return _stats; }
+  void ResetStats();
+
+private:
+  bool Allocate(Handle handle);
+  bool MakeRoom(Handle handle);
+  bool Evictable(const Span& span) const;
+  void Renumber(unsigned int first);
+  void Release(Handle handle);
+  void Evict(Handle handle);
+};
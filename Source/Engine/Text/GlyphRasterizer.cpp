@@ -0,0 +1,267 @@
+#include "EngineStd.h"
+#include "GlyphRasterizer.h"
+#include "BakedFont.h"
+#include "../Multicore/JobSystem.h"
+#include "../Utility/Utf8.h"
+#include "../Debugging/Logger.h"
+
+//glyphs per job.  A glyph is a fraction of a millisecond, so a job is still worth handing out.
+const unsigned int GLYPHS_PER_JOB = 16;
+
+GlyphRasterizer::GlyphRasterizer(FontCache& fonts, GlyphAtlas& atlas, JobSystem* jobs)
+{
+  _fonts = &fonts;
+  _atlas = &atlas;
+  _jobs = jobs;
+  _distance_fields = 0;
+  ResetStats();
+}
+
+GlyphRasterizer::~GlyphRasterizer()
+{
+  //FT_Done_FreeType closes the worker's faces too
+  for(unsigned int i = 0; i < _workers.size(); ++i)
+  {
+    FT_Done_FreeType(_workers[i]->library);
+    delete _workers[i];
+  }
+}
+
+void GlyphRasterizer::SetDistanceFields(DistanceFieldGlyphs* distance_fields)
+{
+  _distance_fields = distance_fields;
+  _requests.clear();
+  _queued.clear();
+}
+
+void GlyphRasterizer::ResetStats()
+{
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Looks the glyphs up the same way the TextLayoutCache does, including
+// glyph 0 for characters the font doesnt have, so the keys match.
+//////////////////////////////////////////////////////////////////////////////
+void GlyphRasterizer::Add(FontId font, unsigned int pixel_size, const char* text, size_t length)
+{
+  if(font >= _fonts->NumFonts() || length == 0)
+    return;
+
+  _characters.resize(length + 1);
+  size_t num_characters = 0;
+  Utf8ToUtf32(text, length, &_characters[0], _characters.size(), num_characters, true);
+  for(size_t i = 0; i < num_characters; ++i)
+  {
+    if(_characters[i] == '\n')
+      continue;
+    unsigned int glyph_index = _fonts->GlyphIndex(font, _characters[i]);
+    GlyphKey key = _distance_fields ? _distance_fields->Key(font, glyph_index) : MakeGlyphKey(font, pixel_size, glyph_index);
+    //finding it marks it used this frame, so making room for the rest cant evict it
+    if(_atlas->Find(key) != GlyphAtlas::INVALID_HANDLE || _queued.find(key) != _queued.end())
+      continue;
+
+    //baked glyphs are only a copy, there is nothing to gain from a job
+    const BakedFont* baked = _distance_fields ? _distance_fields->Baked(font) : _fonts->Baked(font, pixel_size, false);
+    GlyphBitmap bitmap;
+    if(baked && baked->Glyph(glyph_index, bitmap))
+    {
+      if(_atlas->Insert(key, bitmap) != GlyphAtlas::INVALID_HANDLE)
+        ++_stats.inserted;
+      else
+        ++_stats.failures;
+      continue;
+    }
+
+    _queued[key] = (unsigned int)_requests.size();
+
+    Request request;
+    request.key = key;
+    request.font = font;
+    request.pixel_size = pixel_size;
+    request.glyph_index = glyph_index;
+    request.result = NOT_RENDERED;
+    request.offset = 0;
+    _requests.push_back(request);
+    ++_stats.queued;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The job buffers can still grow while later jobs are running, so the
+// bitmaps only get their pointers once every job is done.  Jobs that
+// couldnt get FreeType going or open a font are logged here, once a
+// Flush() for each font, rather than for every glyph.
+//////////////////////////////////////////////////////////////////////////////
+unsigned int GlyphRasterizer::Flush()
+{
+  unsigned int count = (unsigned int)_requests.size();
+  if(count == 0)
+    return 0;
+
+  unsigned int num_jobs = (count + GLYPHS_PER_JOB - 1) / GLYPHS_PER_JOB;
+  if(_job_pixels.size() < num_jobs)
+    _job_pixels.resize(num_jobs);
+  JobSystem::Run(_jobs, RenderRange, this, count, GLYPHS_PER_JOB);
+
+  unsigned int inserted = 0;
+  bool logged_freetype = false;
+  std::vector<bool> logged_fonts(_fonts->NumFonts(), false);
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    Request& request = _requests[i];
+    if(request.result == NO_FREETYPE && !logged_freetype)
+    {
+      SOL_ERROR("FreeType failed to initialize for a glyph rasterizer job");
+      logged_freetype = true;
+    }
+    else if(request.result == NO_FACE && !logged_fonts[request.font])
+    {
+      SOL_ERROR("Couldnt open font " + _fonts->FontName(request.font) + " for a glyph rasterizer job");
+      logged_fonts[request.font] = true;
+    }
+    if(request.result != RENDERED)
+    {
+      ++_stats.failures;
+      continue;
+    }
+    ++_stats.rendered;
+    GlyphBitmap& bitmap = request.bitmap;
+    if(bitmap.width > 0 && bitmap.height > 0)
+      bitmap.pixels = &_job_pixels[i / GLYPHS_PER_JOB][request.offset];
+    if(_atlas->Insert(request.key, bitmap) != GlyphAtlas::INVALID_HANDLE)
+      ++inserted;
+    else
+      ++_stats.failures;
+  }
+
+  _requests.clear();
+  _queued.clear();
+  _stats.inserted += inserted;
+  return inserted;
+}
+
+void GlyphRasterizer::RenderRange(void* data, unsigned int begin, unsigned int end)
+{
+  GlyphRasterizer* rasterizer = (GlyphRasterizer*)data;
+  std::vector<unsigned char>& pixels = rasterizer->_job_pixels[begin / GLYPHS_PER_JOB];
+  pixels.clear();
+
+  Worker* worker = rasterizer->BorrowWorker();
+  for(unsigned int i = begin; i < end; ++i)
+  {
+    Request& request = rasterizer->_requests[i];
+    request.result = worker ? rasterizer->Render(*worker, request, pixels) : NO_FREETYPE;
+  }
+  if(worker)
+    rasterizer->ReturnWorker(worker);
+}
+
+#pragma region Workers
+
+GlyphRasterizer::Worker* GlyphRasterizer::BorrowWorker()
+{
+  ScopedCriticalSection lock(_workers_cs);
+  if(!_idle_workers.empty())
+  {
+    Worker* worker = _idle_workers.back();
+    _idle_workers.pop_back();
+    return worker;
+  }
+
+  Worker* worker = new Worker;
+  //called from the jobs, so Flush() logs this
+  if(FT_Init_FreeType(&worker->library) != 0)
+  {
+    delete worker;
+    return 0;
+  }
+  _workers.push_back(worker);
+  return worker;
+}
+
+void GlyphRasterizer::ReturnWorker(Worker* worker)
+{
+  ScopedCriticalSection lock(_workers_cs);
+  _idle_workers.push_back(worker);
+}
+
+//only the job holding the worker gets here, so its faces need no lock
+FT_Face GlyphRasterizer::Face(Worker& worker, FontId font, unsigned int pixel_size)
+{
+  if(worker.faces.size() <= font)
+  {
+    worker.faces.resize(font + 1, 0);
+    worker.sizes.resize(font + 1, 0);
+  }
+  FT_Face& face = worker.faces[font];
+  if(!face && _fonts->OpenFace(font, worker.library, &face) != 0)
+  {
+    face = 0;
+    return 0;
+  }
+  if(worker.sizes[font] != pixel_size)
+  {
+    if(FT_Set_Pixel_Sizes(face, pixel_size, pixel_size) != 0)
+    {
+      worker.sizes[font] = 0;
+      return 0;
+    }
+    worker.sizes[font] = pixel_size;
+  }
+  return face;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Loads with the same flags the FontCache's small bitmap cache uses, so
+// the glyphs are hinted and rounded the same way.  Bitmap fonts that only
+// have one bit glyphs arent handled, the same as there.
+//////////////////////////////////////////////////////////////////////////////
+GlyphRasterizer::Result GlyphRasterizer::Render(Worker& worker, Request& request, std::vector<unsigned char>& pixels)
+{
+  unsigned int size = _distance_fields ? _distance_fields->RenderSize() : request.pixel_size;
+  FT_Face face = Face(worker, request.font, size);
+  if(!face)
+    return NO_FACE;
+
+  GlyphBitmap& bitmap = request.bitmap;
+  if(_distance_fields)
+  {
+    if(!_distance_fields->Glyph(face, request.glyph_index, worker.scratch, bitmap))
+      return NO_GLYPH;
+  }
+  else
+  {
+    if(FT_Load_Glyph(face, request.glyph_index, FT_LOAD_DEFAULT | FT_LOAD_RENDER) != 0)
+      return NO_GLYPH;
+    FT_GlyphSlot slot = face->glyph;
+    if(slot->bitmap.width > 0 && slot->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
+      return NO_GLYPH;
+    bitmap.glyph_index = request.glyph_index;
+    bitmap.width = slot->bitmap.width;
+    bitmap.height = slot->bitmap.rows;
+    bitmap.left = slot->bitmap_left;
+    bitmap.top = slot->bitmap_top;
+    bitmap.advance = (float)((slot->advance.x + 32) >> 6);
+    bitmap.pitch = slot->bitmap.pitch;
+    bitmap.pixels = slot->bitmap.buffer;
+  }
+
+  //rows packed tight into the job's buffer
+  request.offset = pixels.size();
+  if(bitmap.pixels && bitmap.width > 0 && bitmap.height > 0)
+  {
+    pixels.resize(request.offset + bitmap.width * bitmap.height);
+    for(int row = 0; row < bitmap.height; ++row)
+      memcpy(&pixels[request.offset + row * bitmap.width], bitmap.pixels + row * bitmap.pitch, bitmap.width);
+  }
+  else
+  {
+    bitmap.width = bitmap.height = 0;
+  }
+  bitmap.pitch = bitmap.width;
+  bitmap.pixels = 0;
+  return RENDERED;
+}
+
+#pragma endregion
@@ -0,0 +1,122 @@
+#pragma once
+//========================================================================
+// GlyphRasterizer.h : Renders a batch of new glyphs on all the cores
+//
+// FreeType isnt thread safe, the FontCache and its faces can only be used
+// from one thread, so a scene change that brings in thousands of new
+// glyphs, like a CJK localization does, would render them all one after
+// another on the main thread.  Instead the strings the scene is going to
+// draw are handed to Add(), which queues every glyph in them that the
+// atlas doesnt have yet, and Flush() renders the queue across the job
+// system and copies the results into the GlyphAtlas.
+//
+// Each job borrows a worker with its own FT_Library and its own faces,
+// opened from the FontCache's fonts the first time a worker needs them.
+// A worker is only ever used by one job at a time and goes back to be
+// borrowed again when the job is done, so there are never more of them
+// than jobs that have run at once and they are kept for the next Flush().
+// The jobs write into bitmaps of their own, the atlas is only touched
+// once they have all finished, so it doesnt need a lock.  The jobs dont
+// log either, the Logger isnt safe from other threads.  Each request
+// keeps what went wrong with it and Flush() reports that.
+//
+// The glyphs come out the same as the TextLayoutCache's would, under the
+// same keys, so laying out the strings afterwards finds them all in the
+// atlas.  If the layouts use distance fields the rasterizer has to be
+// given the same DistanceFieldGlyphs.  Glyphs in a BakedFont are copied
+// into the atlas by Add() and never queued.
+//========================================================================
+
+#include "../Multicore/CriticalSection.h"
+#include "DistanceField.h"
+#include "GlyphAtlas.h"
+
+class JobSystem;
+
+struct GlyphRasterizerStats
+{
+  unsigned int queued;
+  unsigned int rendered;
+  unsigned int inserted;
+  unsigned int failures;      //FreeType couldnt render them or they didnt fit in the atlas
+};
+
+class GlyphRasterizer : public SOL_noncopyable
+{
+  //a FreeType for one job at a time
+  struct Worker
+  {
+    FT_Library library;
+    std::vector<FT_Face> faces;     //by FontId, NULL until first needed
+    std::vector<unsigned int> sizes;  //each face is set to, setting it again runs the font's hinting setup
+    DistanceFieldScratch scratch;
+  };
+
+  //what the job made of a request
+  enum Result
+  {
+    NOT_RENDERED,
+    RENDERED,
+    NO_FREETYPE,          //the job couldnt get a worker
+    NO_FACE,              //the font couldnt be opened or set to the size
+    NO_GLYPH              //FreeType couldnt render it
+  };
+
+  struct Request
+  {
+    GlyphKey key;
+    FontId font;
+    unsigned int pixel_size;
+    unsigned int glyph_index;
+    Result result;
+    GlyphBitmap bitmap;             //pixels stays NULL until every job is done
+    size_t offset;                  //of the pixels in the job's buffer
+  };
+
+  typedef std::tr1::unordered_map<GlyphKey, unsigned int> RequestMap;
+
+  FontCache* _fonts;
+  GlyphAtlas* _atlas;
+  JobSystem* _jobs;
+  DistanceFieldGlyphs* _distance_fields;
+
+  std::vector<Request> _requests;
+  RequestMap _queued;              //to the request's index
+  std::vector<std::vector<unsigned char> > _job_pixels;   //one per job
+  std::vector<unsigned int> _characters;
+
+  CriticalSection _workers_cs;
+  std::vector<Worker*> _workers;
+  std::vector<Worker*> _idle_workers;
+
+  GlyphRasterizerStats _stats;
+
+public:
+  GlyphRasterizer(FontCache& fonts, GlyphAtlas& atlas, JobSystem* jobs = 0);
+  ~GlyphRasterizer();
+
+  //has to match the TextLayoutCache's.  Drops anything queued.
+  void SetDistanceFields(DistanceFieldGlyphs* distance_fields);
+
+  //queues the glyphs of the text that arent in the atlas or queued already.  The ones in the
+  //atlas count as used this frame.
+  void Add(FontId font, unsigned int pixel_size, const char* text, size_t length);
+  void Add(FontId font, unsigned int pixel_size, const std::string& text) { Add(font, pixel_size, text.c_str(), text.size()); }
+  unsigned int NumQueued() const { return (unsigned int)_requests.size(); }
+
+  //renders everything queued and puts it in the atlas, returns how many went in.  They count as used
+  //this frame, so they dont evict each other, and what doesnt fit is left out.
+  unsigned int Flush();
+
+  unsigned int NumWorkers() const { return (unsigned int)_workers.size(); }
+
+  const GlyphRasterizerStats& Stats() const { return _stats; }
+  void ResetStats();
+
+private:
+  Worker* BorrowWorker();
+  void ReturnWorker(Worker* worker);
+  FT_Face Face(Worker& worker, FontId font, unsigned int pixel_size);
+  Result Render(Worker& worker, Request& request, std::vector<unsigned char>& pixels);
+  static void RenderRange(void* data, unsigned int begin, unsigned int end);
+};
@@ -0,0 +1,179 @@
+#include "EngineStd.h"
+#include "TextLayoutCache.h"
+#include "FontCache.h"
+#include "DistanceField.h"
+#include "../Utility/Utf8.h"
+
+//64 bit FNV-1a of the font, size and text
+static unsigned long long LayoutHash(FontId font, unsigned int pixel_size, const char* text, size_t length)
+{
+  unsigned long long hash = 14695981039346656037ULL;
+  hash = (hash ^ font) * 1099511628211ULL;
+  hash = (hash ^ pixel_size) * 1099511628211ULL;
+  for(size_t i = 0; i < length; ++i)
+    hash = (hash ^ (unsigned char)text[i]) * 1099511628211ULL;
+  return hash;
+}
+
+TextLayoutCache::TextLayoutCache(FontCache& fonts, GlyphAtlas& atlas, unsigned int max_layouts)
+{
+  _fonts = &fonts;
+  _atlas = &atlas;
+  _distance_fields = 0;
+  _max_layouts = std::max(1u, max_layouts);
+  ResetStats();
+}
+
+void TextLayoutCache::Clear()
+{
+  _layouts.clear();
+  _lookup.clear();
+}
+
+void TextLayoutCache::SetDistanceFields(DistanceFieldGlyphs* distance_fields)
+{
+  _distance_fields = distance_fields;
+  Clear();
+}
+
+void TextLayoutCache::ResetStats()
+{
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Two strings whose hashes collide would keep replacing each other, but
+// the text is compared so neither is ever drawn as the other.
+//////////////////////////////////////////////////////////////////////////////
+const TextLayout* TextLayoutCache::Layout(FontId font, unsigned int pixel_size, const char* text, size_t length)
+{
+  if(font >= _fonts->NumFonts())
+    return 0;
+
+  unsigned long long hash = LayoutHash(font, pixel_size, text, length);
+  LayoutMap::iterator found = _lookup.find(hash);
+  if(found != _lookup.end())
+  {
+    TextLayout& layout = *found->second;
+    if(layout.font == font && layout.pixel_size == pixel_size && layout.text.compare(0, std::string::npos, text, length) == 0)
+    {
+      _layouts.splice(_layouts.begin(), _layouts, found->second);
+      if(layout.generation == _atlas->Generation())
+      {
+        ++_stats.hits;
+        for(unsigned int i = 0; i < layout.glyphs.size(); ++i)
+          _atlas->Touch(layout.glyphs[i]);
+        return &layout;
+      }
+      ++_stats.misses;
+      Build(layout);
+      return &layout;
+    }
+    _layouts.erase(found->second);
+    _lookup.erase(found);
+  }
+
+  ++_stats.misses;
+  if(_layouts.size() >= _max_layouts)
+  {
+    _lookup.erase(LayoutHash(_layouts.back().font, _layouts.back().pixel_size, _layouts.back().text.c_str(), _layouts.back().text.size()));
+    _layouts.pop_back();
+  }
+
+  _layouts.push_front(TextLayout());
+  TextLayout& layout = _layouts.front();
+  layout.font = font;
+  layout.pixel_size = pixel_size;
+  layout.text.assign(text, length);
+  _lookup[hash] = _layouts.begin();
+  Build(layout);
+  return &layout;
+}
+
+GlyphAtlas::Handle TextLayoutCache::Glyph(FontId font, unsigned int pixel_size, unsigned int glyph_index)
+{
+  GlyphKey key = _distance_fields ? _distance_fields->Key(font, glyph_index) : MakeGlyphKey(font, pixel_size, glyph_index);
+  GlyphAtlas::Handle handle = _atlas->Find(key);
+  if(handle != GlyphAtlas::INVALID_HANDLE)
+    return handle;
+
+  GlyphBitmap bitmap;
+  bool rendered = _distance_fields ? _distance_fields->Glyph(font, glyph_index, bitmap) : _fonts->Glyph(font, pixel_size, glyph_index, bitmap);
+  if(!rendered)
+    return GlyphAtlas::INVALID_HANDLE;
+  ++_stats.glyphs_rendered;
+  return _atlas->Insert(key, bitmap);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Adding a glyph to the atlas can evict others, including ones already
+// placed in this layout, so if the generation changes part way through
+// the layout starts over.  Glyphs used this frame are never evicted, so
+// the second time round only glyphs that dont fit at all can cause it.
+// Distance field glyphs are scaled from their base size, kerning and line
+// spacing still come from the font at the size asked for.
+//////////////////////////////////////////////////////////////////////////////
+bool TextLayoutCache::Build(TextLayout& layout)
+{
+  _characters.resize(layout.text.size() + 1);
+  size_t num_characters = 0;
+  if(!layout.text.empty())
+    Utf8ToUtf32(layout.text.c_str(), layout.text.size(), &_characters[0], _characters.size(), num_characters, true);
+
+  FontMetrics metrics;
+  if(!_fonts->Metrics(layout.font, layout.pixel_size, metrics))
+    memset(&metrics, 0, sizeof(metrics));
+  float scale = _distance_fields ? (float)layout.pixel_size / _distance_fields->BaseSize() : 1.0f;
+
+  for(int attempt = 0; attempt < 2; ++attempt)
+  {
+    layout.vertices.clear();
+    layout.glyphs.clear();
+    layout.width = 0.0f;
+    layout.height = (float)metrics.line_height;
+    layout.generation = _atlas->Generation();
+
+    float inverse_width = 1.0f / _atlas->Width();
+    float inverse_height = 1.0f / _atlas->Height();
+    float pen_x = 0.0f, pen_y = 0.0f;
+    unsigned int previous = 0;
+    for(size_t i = 0; i < num_characters; ++i)
+    {
+      if(_characters[i] == '\n')
+      {
+        pen_x = 0.0f;
+        pen_y += metrics.line_height;
+        layout.height += metrics.line_height;
+        previous = 0;
+        continue;
+      }
+
+      unsigned int glyph_index = _fonts->GlyphIndex(layout.font, _characters[i]);
+      if(previous && glyph_index)
+        pen_x += _fonts->Kerning(layout.font, layout.pixel_size, previous, glyph_index);
+      previous = glyph_index;
+
+      GlyphAtlas::Handle handle = Glyph(layout.font, layout.pixel_size, glyph_index);
+      if(handle == GlyphAtlas::INVALID_HANDLE)
+        continue;
+      ++_stats.glyphs_laid_out;
+      layout.glyphs.push_back(handle);
+      const AtlasGlyph& glyph = _atlas->Glyph(handle);
+      if(glyph.width > 0)
+      {
+        float x0 = pen_x + glyph.left * scale, x1 = x0 + glyph.width * scale;
+        float y0 = pen_y - glyph.top * scale, y1 = y0 + glyph.height * scale;
+        float u0 = glyph.x * inverse_width, u1 = (glyph.x + glyph.width) * inverse_width;
+        float v0 = glyph.y * inverse_height, v1 = (glyph.y + glyph.height) * inverse_height;
+        TextVertex quad[4] = {{x0, y0, u0, v0}, {x1, y0, u1, v0}, {x1, y1, u1, v1}, {x0, y1, u0, v1}};
+        layout.vertices.insert(layout.vertices.end(), quad, quad + 4);
+      }
+      pen_x += glyph.advance * scale;
+      layout.width = std::max(layout.width, pen_x);
+    }
+
+    if(layout.generation == _atlas->Generation())
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,97 @@
+#pragma once
+//========================================================================
+// TextLayoutCache.h : Laid out strings kept as ready made vertex buffers
+//
+// Layout() turns a UTF-8 string into one textured quad per glyph, looking
+// each glyph up in the GlyphAtlas and only going to FreeType for the ones
+// it doesnt have.  The result is kept, keyed by the font, the size and a
+// hash of the text, so a string that is drawn every frame, which is most
+// of the UI, is laid out once and afterwards costs a hash lookup and a
+// touch of each of its glyphs to keep them in the atlas.
+//
+// A layout remembers the atlas Generation() it was made in.  If the atlas
+// has evicted anything since, the layout's glyphs may have moved, so it is
+// laid out again the next time it is asked for.  Layouts beyond max_layouts
+// are dropped, least recently used first.
+//
+// Quads are in pixels with y down and the pen starting at 0, 0 on the
+// baseline of the first line.  Each is four vertices, top left, top
+// right, bottom right, bottom left, so every layout shares the same index
+// buffer.  '\n' starts a new line.
+//
+// With SetDistanceFields() glyphs come from the DistanceFieldGlyphs at
+// their one base size instead, and the quads are scaled up or down to the
+// size asked for, so the atlas holds one copy of each glyph for all sizes.
+// Drawing them needs the distance field shader.
+//========================================================================
+
+#include "Glyph.h"
+#include "GlyphAtlas.h"
+
+class FontCache;
+class DistanceFieldGlyphs;
+
+struct TextVertex
+{
+  float x;
+  float y;
+  float u;
+  float v;
+};
+
+struct TextLayout
+{
+  FontId font;
+  unsigned int pixel_size;
+  std::string text;
+  std::vector<TextVertex> vertices;
+  std::vector<GlyphAtlas::Handle> glyphs;   //touched each time the layout is used
+  float width;                              //of the widest line
+  float height;                             //of all the lines
+  unsigned int generation;
+};
+
+struct TextLayoutStats
+{
+  unsigned int hits;
+  unsigned int misses;
+  unsigned int glyphs_laid_out;
+  unsigned int glyphs_rendered;             //had to come from FreeType
+};
+
+class TextLayoutCache : public SOL_noncopyable
+{
+  typedef std::list<TextLayout> LayoutList;
+  typedef std::tr1::unordered_map<unsigned long long, LayoutList::iterator> LayoutMap;
+
+  FontCache* _fonts;
+  GlyphAtlas* _atlas;
+  DistanceFieldGlyphs* _distance_fields;
+  unsigned int _max_layouts;
+  LayoutList _layouts;          //most recently used first
+  LayoutMap _lookup;
+  std::vector<unsigned int> _characters;
+  TextLayoutStats _stats;
+
+public:
+  TextLayoutCache(FontCache& fonts, GlyphAtlas& atlas, unsigned int max_layouts = 1024);
+
+  //NULL if the font doesnt exist.  Glyphs that didnt fit in the atlas are left out.
+  const TextLayout* Layout(FontId font, unsigned int pixel_size, const char* text, size_t length);
+  const TextLayout* Layout(FontId font, unsigned int pixel_size, const std::string& text) { return Layout(font, pixel_size, text.c_str(), text.size()); }
+
+  //NULL goes back to plain glyphs.  Drops every layout, the ones there are were made the other way.
+  void SetDistanceFields(DistanceFieldGlyphs* distance_fields);
+  bool UsesDistanceFields() const { return _distance_fields != 0; }
+
+  //drops every layout, for after the atlas has been cleared or fonts changed
+  void Clear();
+  unsigned int NumLayouts() const { return (unsigned int)_layouts.size(); }
+
+  const TextLayoutStats& Stats() const { return _stats; }
+  void ResetStats();
+
+private:
+  bool Build(TextLayout& layout);
+  GlyphAtlas::Handle Glyph(FontId font, unsigned int pixel_size, unsigned int glyph_index);
+};
@@ -0,0 +1,73 @@
+#pragma once
+//========================================================================
+// Delegate.h : Callable reference to a function or a member function
+//
+// A delegate is an object pointer plus a pointer to a small stub function
+// that the compiler generates for each target, so making one never
+// allocates and calling one is a single indirect call.  Two delegates are
+// equal when they call the same function on the same object, which is
+// what listener removal needs.
+//
+// The target is a template argument, so it has to be known at compile
+// time:
+//   Delegate<int> d = Delegate<int>::FromMethod<Foo, &Foo::Bar>(&foo);
+//   d(42);
+//
+// A delegate doesnt keep its object alive.
+//========================================================================
+
+template<class Arg>
+class Delegate
+{
+  typedef void (*Stub)(void* object, Arg arg);
+
+  void* _object;
+  Stub _stub;
+
+  template<class T, void (T::*Method)(Arg)>
+  static void MethodStub(void* object, Arg arg)
+  {
+    (static_cast<T*>(object)->*Method)(arg);
+  }
+
+  template<class T, void (T::*Method)(Arg) const>
+  static void ConstMethodStub(void* object, Arg arg)
+  {
+    (static_cast<const T*>(object)->*Method)(arg);
+  }
+
+  template<void (*Function)(Arg)>
+  static void FunctionStub(void*, Arg arg)
+  {
+    Function(arg);
+  }
+
+  Delegate(void* object, Stub stub) : _object(object), _stub(stub) {}
+
+public:
+  Delegate() : _object(0), _stub(0) {}
+
+  template<class T, void (T::*Method)(Arg)>
+  static Delegate FromMethod(T* object)
+  {
+    return Delegate(object, &MethodStub<T, Method>);
+  }
+
+  template<class T, void (T::*Method)(Arg) const>
+  static Delegate FromConstMethod(const T* object)
+  {
+    return Delegate(const_cast<T*>(object), &ConstMethodStub<T, Method>);
+  }
+
+  template<void (*Function)(Arg)>
+  static Delegate FromFunction()
+  {
+    return Delegate(0, &FunctionStub<Function>);
+  }
+
+  void operator()(Arg arg) const { _stub(_object, arg); }
+
+  bool Empty() const { return _stub == 0; }
+  bool operator==(const Delegate& rhs) const { return _object == rhs._object && _stub == rhs._stub; }
+  bool operator!=(const Delegate& rhs) const { return !(*this == rhs); }
+};
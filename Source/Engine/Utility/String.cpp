@@ -0,0 +1,688 @@
+#include "EngineStd.h"
+#include "String.h"
+#include "Utf8.h"
+
+#include <float.h>
+#include <math.h>
+
+#pragma region Constants
+
+//every two digit number, used to write decimal numbers two digits at a time
+static const char DIGIT_PAIRS[201] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+//large enough for the digits of any unsigned long plus a sign
+static const size_t MAX_DIGITS_IN_LONG = 24;
+
+//max significant digits needed for any float or double to survive a round trip
+static const int FLOAT_ROUND_TRIP_DIGITS = 9;
+static const int DOUBLE_ROUND_TRIP_DIGITS = 17;
+
+//bits in the mantissa counting the hidden one, and the exponent of the lowest bit of a denormal
+static const int FLOAT_MANTISSA_BITS = 24;
+static const int FLOAT_MIN_EXPONENT = -149;
+static const int DOUBLE_MANTISSA_BITS = 53;
+static const int DOUBLE_MIN_EXPONENT = -1074;
+
+//words in a BigNumber.  The biggest number the digit search makes is the smallest denormal double scaled
+//by 10^324, a bit under 2^1130, times 10.
+static const int BIG_NUMBER_WORDS = 40;
+
+#pragma endregion
+
+#pragma region Helpers
+
+//////////////////////////////////////////////////////////////////////////////
+// writes the decimal digits of num backwards ending just before end, returns
+// a pointer to the first digit
+//////////////////////////////////////////////////////////////////////////////
+static char* WriteDigitsBackwards(unsigned long num, char* end)
+{
+  while(num >= 100)
+  {
+    unsigned long pair = (num % 100) * 2;
+    num /= 100;
+    *--end = DIGIT_PAIRS[pair + 1];
+    *--end = DIGIT_PAIRS[pair];
+  }
+  if(num >= 10)
+  {
+    *--end = DIGIT_PAIRS[num * 2 + 1];
+    *--end = DIGIT_PAIRS[num * 2];
+  }
+  else
+  {
+    *--end = (char)('0' + num);
+  }
+  return end;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// copies [first, last) into buffer with a '\0', returns 0 if it doesnt fit
+//////////////////////////////////////////////////////////////////////////////
+static size_t CopyToBuffer(const char* first, const char* last, char* buffer, size_t buffer_size)
+{
+  size_t length = last - first;
+  if(length + 1 > buffer_size)
+  {
+    if(buffer_size > 0)
+      buffer[0] = '\0';
+    return 0;
+  }
+  memcpy(buffer, first, length);
+  buffer[length] = '\0';
+  return length;
+}
+
+static size_t FormatUnsigned(unsigned long num, bool negative, char* buffer, size_t buffer_size)
+{
+  char temp[MAX_DIGITS_IN_LONG];
+  char* end = temp + MAX_DIGITS_IN_LONG;
+  char* first = WriteDigitsBackwards(num, end);
+  if(negative)
+    *--first = '-';
+  return CopyToBuffer(first, end, buffer, buffer_size);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// handles nan and infinity so the CRT's 1.#QNAN style output never leaks out,
+// returns true if num was one of them
+//////////////////////////////////////////////////////////////////////////////
+static bool FormatNonFinite(double num, char* buffer, size_t buffer_size, size_t& out_length)
+{
+  const char* str = 0;
+  if(num != num)
+    str = "nan";
+  else if(num > DBL_MAX)
+    str = "inf";
+  else if(num < -DBL_MAX)
+    str = "-inf";
+  else
+    return false;
+  out_length = CopyToBuffer(str, str + strlen(str), buffer, buffer_size);
+  return true;
+}
+
+#pragma endregion
+
+#pragma region Shortest Digits
+
+//////////////////////////////////////////////////////////////////////////////
+// A fixed size unsigned integer with only what the digit search needs.
+// The words are lowest first, and only the first _count are used, so the
+// small numbers most floats turn into stay cheap.
+//////////////////////////////////////////////////////////////////////////////
+class BigNumber
+{
+  unsigned int _words[BIG_NUMBER_WORDS];
+  int _count;
+
+public:
+  explicit BigNumber(unsigned long long num = 0) { Set(num); }
+
+  void Set(unsigned long long num)
+  {
+    _count = 0;
+    for(; num; num >>= 32)
+      _words[_count++] = (unsigned int)num;
+  }
+
+  void Multiply(unsigned int factor)
+  {
+    unsigned long long carry = 0;
+    for(int i = 0; i < _count; ++i)
+    {
+      carry += (unsigned long long)_words[i] * factor;
+      _words[i] = (unsigned int)carry;
+      carry >>= 32;
+    }
+    if(carry)
+      _words[_count++] = (unsigned int)carry;
+  }
+
+  void MultiplyPow10(int power)
+  {
+    static const unsigned int POWERS_OF_TEN[9] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+    for(; power >= 9; power -= 9)
+      Multiply(1000000000);
+    if(power > 0)
+      Multiply(POWERS_OF_TEN[power]);
+  }
+
+  void ShiftLeft(int bits)
+  {
+    if(_count == 0)
+      return;
+    int words = bits / 32;
+    bits %= 32;
+    if(bits)
+    {
+      unsigned int carry = 0;
+      for(int i = 0; i < _count; ++i)
+      {
+        unsigned int word = _words[i];
+        _words[i] = (word << bits) | carry;
+        carry = word >> (32 - bits);
+      }
+      if(carry)
+        _words[_count++] = carry;
+    }
+    if(words)
+    {
+      for(int i = _count - 1; i >= 0; --i)
+        _words[i + words] = _words[i];
+      for(int i = 0; i < words; ++i)
+        _words[i] = 0;
+      _count += words;
+    }
+  }
+
+  void Add(const BigNumber& other)
+  {
+    unsigned long long carry = 0;
+    int count = std::max(_count, other._count);
+    for(int i = 0; i < count; ++i)
+    {
+      carry += (unsigned long long)(i < _count ? _words[i] : 0) + (i < other._count ? other._words[i] : 0);
+      _words[i] = (unsigned int)carry;
+      carry >>= 32;
+    }
+    _count = count;
+    if(carry)
+      _words[_count++] = (unsigned int)carry;
+  }
+
+  //other cant be bigger
+  void Subtract(const BigNumber& other)
+  {
+    unsigned long long borrow = 0;
+    for(int i = 0; i < _count; ++i)
+    {
+      unsigned long long difference = (unsigned long long)_words[i] - (i < other._count ? other._words[i] : 0) - borrow;
+      _words[i] = (unsigned int)difference;
+      borrow = difference >> 63;
+    }
+    while(_count > 0 && _words[_count - 1] == 0)
+      --_count;
+  }
+
+  //less than, equal or greater than 0 like strcmp
+  static int Compare(const BigNumber& a, const BigNumber& b)
+  {
+    if(a._count != b._count)
+      return a._count < b._count ? -1 : 1;
+    for(int i = a._count - 1; i >= 0; --i)
+    {
+      if(a._words[i] != b._words[i])
+        return a._words[i] < b._words[i] ? -1 : 1;
+    }
+    return 0;
+  }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Steele and White's free format algorithm, set up the way Burger and
+// Dybvig do it.  num is mantissa * 2^exponent, and every decimal between
+// halfway to the next float down and halfway to the next one up reads
+// back as num, the halfway points too if the mantissa is even since ties
+// round to even.  r / s is num scaled so the first digit is the leading
+// one, and m_minus and m_plus are the distances to the halfway points at
+// the same scale.  Each digit comes off the front of r, and the search
+// stops at the first one that leaves r inside the bounds, so there can be
+// no shorter decimal.  Everything is exact, the CRT's strtod and printf
+// arent involved, so the digits are the same on every compiler.
+//
+// Returns the number of digits, with point set to where the decimal point
+// goes, num = 0.digits * 10^point.
+//////////////////////////////////////////////////////////////////////////////
+static int ShortestDigits(unsigned long long mantissa, int exponent, int mantissa_bits, int min_exponent, char* digits, int& point)
+{
+  //the float below a power of two is closer than the one above
+  int unequal = (mantissa == 1ull << (mantissa_bits - 1) && exponent > min_exponent) ? 1 : 0;
+  bool even = (mantissa & 1) == 0;
+
+  BigNumber r(mantissa), s, m_plus, m_minus(1);
+  if(exponent >= 0)
+  {
+    r.ShiftLeft(exponent + 1 + unequal);
+    s.Set(2u << unequal);
+    m_plus.Set(1);
+    m_plus.ShiftLeft(exponent + unequal);
+    m_minus.ShiftLeft(exponent);
+  }
+  else
+  {
+    r.ShiftLeft(1 + unequal);
+    s.Set(1);
+    s.ShiftLeft(1 - exponent + unequal);
+    m_plus.Set(1u << unequal);
+  }
+
+  //log10(2) times the exponent of the top bit undershoots the power of ten by at most one, the loop below fixes it
+  int top_bit = exponent;
+  for(unsigned long long m = mantissa; m > 1; m >>= 1)
+    ++top_bit;
+  int k = (int)ceil(top_bit * 0.30102999566398114 - 1e-10);
+  if(k >= 0)
+    s.MultiplyPow10(k);
+  else
+  {
+    r.MultiplyPow10(-k);
+    m_plus.MultiplyPow10(-k);
+    m_minus.MultiplyPow10(-k);
+  }
+
+  for(;;)
+  {
+    BigNumber high(r);
+    high.Add(m_plus);
+    int compare = BigNumber::Compare(high, s);
+    if(even ? compare < 0 : compare <= 0)
+      break;
+    s.Multiply(10);
+    ++k;
+  }
+
+  int count = 0;
+  for(;;)
+  {
+    r.Multiply(10);
+    m_plus.Multiply(10);
+    m_minus.Multiply(10);
+    int digit = 0;
+    while(BigNumber::Compare(r, s) >= 0)
+    {
+      r.Subtract(s);
+      ++digit;
+    }
+
+    BigNumber high(r);
+    high.Add(m_plus);
+    int low_compare = BigNumber::Compare(r, m_minus);
+    int high_compare = BigNumber::Compare(high, s);
+    bool low_done = even ? low_compare <= 0 : low_compare < 0;
+    bool high_done = even ? high_compare >= 0 : high_compare > 0;
+    if(low_done && high_done)
+    {
+      //either digit reads back, take the nearer one
+      r.ShiftLeft(1);
+      if(BigNumber::Compare(r, s) >= 0)
+        ++digit;
+    }
+    else if(high_done)
+    {
+      ++digit;
+    }
+    digits[count++] = (char)('0' + digit);
+    if(low_done || high_done)
+      break;
+  }
+  point = k;
+  return count;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Lays the digits out the way %g does, with an exponent when the number is
+// under 0.0001 or has more digits before the point than it has digits, but
+// never before fixed_digits, so 100 is written 100 and not 1e+02.  No
+// digits means zero.
+//////////////////////////////////////////////////////////////////////////////
+static size_t FormatDigits(bool negative, const char* digits, int count, int point, int fixed_digits, char* buffer, size_t buffer_size)
+{
+  char temp[MAX_CHARS_IN_DOUBLE + 8];
+  char* out = temp;
+  if(negative)
+    *out++ = '-';
+  if(count == 0)
+  {
+    *out++ = '0';
+    return CopyToBuffer(temp, out, buffer, buffer_size);
+  }
+
+  int exponent = point - 1;
+  if(exponent < -4 || exponent >= std::max(count, fixed_digits))
+  {
+    *out++ = digits[0];
+    if(count > 1)
+    {
+      *out++ = '.';
+      memcpy(out, digits + 1, count - 1);
+      out += count - 1;
+    }
+    *out++ = 'e';
+    *out++ = exponent < 0 ? '-' : '+';
+    unsigned long magnitude = exponent < 0 ? -exponent : exponent;
+    if(magnitude < 10)
+      *out++ = '0';
+    char exponent_digits[MAX_DIGITS_IN_LONG];
+    char* end = exponent_digits + MAX_DIGITS_IN_LONG;
+    char* first = WriteDigitsBackwards(magnitude, end);
+    memcpy(out, first, end - first);
+    out += end - first;
+  }
+  else if(point <= 0)
+  {
+    *out++ = '0';
+    *out++ = '.';
+    for(int i = 0; i < -point; ++i)
+      *out++ = '0';
+    memcpy(out, digits, count);
+    out += count;
+  }
+  else if(point >= count)
+  {
+    memcpy(out, digits, count);
+    out += count;
+    for(int i = count; i < point; ++i)
+      *out++ = '0';
+  }
+  else
+  {
+    memcpy(out, digits, point);
+    out += point;
+    *out++ = '.';
+    memcpy(out, digits + point, count - point);
+    out += count - point;
+  }
+  return CopyToBuffer(temp, out, buffer, buffer_size);
+}
+
+#pragma endregion
+
+#pragma region Tokenizing
+
+StringTokenizer::StringTokenizer(StringRef str, char delimiter)
+{
+  _cur = str.Begin();
+  _end = str.End();
+  _delimiter = delimiter;
+}
+
+bool StringTokenizer::Next(StringRef& token)
+{
+  if(_cur >= _end)
+    return false;
+
+  const char* found = (const char*)memchr(_cur, _delimiter, _end - _cur);
+  if(!found)
+    found = _end;
+  token = StringRef(_cur, found - _cur);
+  _cur = found + 1;
+  return true;
+}
+
+void Split(StringRef str, StringRefVec& vec, char delimiter)
+{
+  vec.clear();
+  StringTokenizer tok(str, delimiter);
+  StringRef token;
+  while(tok.Next(token))
+    vec.push_back(token);
+}
+
+#pragma endregion
+
+#pragma region Pattern Matching
+
+//////////////////////////////////////////////////////////////////////////////
+// Classic backtracking match.  On a mismatch after a * the segment is retried
+// one character further along the string.
+//////////////////////////////////////////////////////////////////////////////
+BOOL WildcardMatch(const char* pat, const char* str)
+{
+  const char* star_pat = 0;
+  const char* star_str = 0;
+
+  while(*str)
+  {
+    if(*pat == '*')
+    {
+      while(*pat == '*')
+        ++pat;
+      if(!*pat)
+        return TRUE;
+      star_pat = pat;
+      star_str = str;
+    }
+    else if(*pat == *str || (*pat == '?' && *str != '.'))
+    {
+      ++pat;
+      ++str;
+    }
+    else if(star_pat)
+    {
+      pat = star_pat;
+      str = ++star_str;
+    }
+    else
+    {
+      return FALSE;
+    }
+  }
+  while(*pat == '*')
+    ++pat;
+  return *pat == '\0';
+}
+
+#pragma endregion
+
+#pragma region Number Formatting
+
+size_t ToStr(int num, char* buffer, size_t buffer_size)
+{
+  //negate as unsigned so INT_MIN doesnt overflow
+  if(num < 0)
+    return FormatUnsigned(0u - (unsigned int)num, true, buffer, buffer_size);
+  return FormatUnsigned((unsigned long)num, false, buffer, buffer_size);
+}
+
+size_t ToStr(unsigned int num, char* buffer, size_t buffer_size)
+{
+  return FormatUnsigned(num, false, buffer, buffer_size);
+}
+
+size_t ToStr(unsigned long num, char* buffer, size_t buffer_size)
+{
+  return FormatUnsigned(num, false, buffer, buffer_size);
+}
+
+size_t ToStr(bool val, char* buffer, size_t buffer_size)
+{
+  const char* str = val ? "true" : "false";
+  return CopyToBuffer(str, str + strlen(str), buffer, buffer_size);
+}
+
+size_t ToStr(float num, char* buffer, size_t buffer_size)
+{
+  size_t length = 0;
+  if(FormatNonFinite(num, buffer, buffer_size, length))
+    return length;
+
+  unsigned int bits;
+  memcpy(&bits, &num, sizeof(bits));
+  unsigned int mantissa = bits & 0x7fffff;
+  int exponent = (bits >> 23) & 0xff;
+  if(exponent == 0)
+    exponent = FLOAT_MIN_EXPONENT;
+  else
+  {
+    mantissa |= 0x800000;
+    exponent += FLOAT_MIN_EXPONENT - 1;
+  }
+
+  char digits[FLOAT_ROUND_TRIP_DIGITS + 1];
+  int point = 1;
+  int count = mantissa ? ShortestDigits(mantissa, exponent, FLOAT_MANTISSA_BITS, FLOAT_MIN_EXPONENT, digits, point) : 0;
+  return FormatDigits((bits >> 31) != 0, digits, count, point, FLT_DIG, buffer, buffer_size);
+}
+
+size_t ToStr(double num, char* buffer, size_t buffer_size)
+{
+  size_t length = 0;
+  if(FormatNonFinite(num, buffer, buffer_size, length))
+    return length;
+
+  unsigned long long bits;
+  memcpy(&bits, &num, sizeof(bits));
+  unsigned long long mantissa = bits & 0xfffffffffffffull;
+  int exponent = (int)((bits >> 52) & 0x7ff);
+  if(exponent == 0)
+    exponent = DOUBLE_MIN_EXPONENT;
+  else
+  {
+    mantissa |= 0x10000000000000ull;
+    exponent += DOUBLE_MIN_EXPONENT - 1;
+  }
+
+  char digits[DOUBLE_ROUND_TRIP_DIGITS + 1];
+  int point = 1;
+  int count = mantissa ? ShortestDigits(mantissa, exponent, DOUBLE_MANTISSA_BITS, DOUBLE_MIN_EXPONENT, digits, point) : 0;
+  return FormatDigits((bits >> 63) != 0, digits, count, point, DBL_DIG, buffer, buffer_size);
+}
+
+#pragma endregion
+
+#pragma region Wide Conversion
+
+//////////////////////////////////////////////////////////////////////////////
+// All narrow strings are UTF-8.  The std::string versions never fail, any
+// malformed input comes out as U+FFFD, while the buffer versions report it.
+//////////////////////////////////////////////////////////////////////////////
+
+std::string ws2s(const std::wstring& s)
+{
+  std::string result;
+  size_t length = 0;
+  WideToUtf8(s.c_str(), s.size(), 0, 0, length, true);
+  result.resize(length + 1);
+  WideToUtf8(s.c_str(), s.size(), &result[0], length + 1, length, true);
+  result.resize(length);
+  return result;
+}
+
+std::wstring s2ws(const std::string& s)
+{
+  std::wstring result;
+  size_t length = 0;
+  Utf8ToWide(s.c_str(), s.size(), 0, 0, length, true);
+  result.resize(length + 1);
+  Utf8ToWide(s.c_str(), s.size(), &result[0], length + 1, length, true);
+  result.resize(length);
+  return result;
+}
+
+void StringToWideString(const std::string& source, std::wstring& out)
+{
+  size_t length = 0;
+  Utf8ToWide(source.c_str(), source.size(), 0, 0, length, true);
+  out.resize(length + 1);
+  Utf8ToWide(source.c_str(), source.size(), &out[0], length + 1, length, true);
+  out.resize(length);
+}
+
+size_t ws2s(const wchar_t* src, size_t src_len, char* dest, size_t dest_size)
+{
+  size_t length = 0;
+  if(WideToUtf8(src, src_len, dest, dest_size, length) != UTF_OK)
+  {
+    if(dest_size > 0)
+      dest[0] = '\0';
+    return 0;
+  }
+  return length;
+}
+
+size_t s2ws(const char* src, size_t src_len, wchar_t* dest, size_t dest_size)
+{
+  size_t length = 0;
+  if(Utf8ToWide(src, src_len, dest, dest_size, length) != UTF_OK)
+  {
+    if(dest_size > 0)
+      dest[0] = L'\0';
+    return 0;
+  }
+  return length;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// count is the size of dest in characters.  Like the originals these fail if
+// the result would not fit, but they also fail on malformed input.
+//////////////////////////////////////////////////////////////////////////////
+HRESULT AnsiToWideCch(WCHAR* dest, const CHAR* src, int count)
+{
+  if(!dest || !src || count <= 0)
+    return E_INVALIDARG;
+  size_t length = 0;
+  if(Utf8ToWide(src, strlen(src), dest, count, length) != UTF_OK)
+    return E_FAIL;
+  return S_OK;
+}
+
+HRESULT WideToAnsiCch(CHAR* dest, const WCHAR* src, int count)
+{
+  if(!dest || !src || count <= 0)
+    return E_INVALIDARG;
+  size_t length = 0;
+  if(WideToUtf8(src, wcslen(src), dest, count, length) != UTF_OK)
+    return E_FAIL;
+  return S_OK;
+}
+
+HRESULT GenericToAnsiCch(CHAR* dest, const TCHAR* src, int count)
+{
+#ifdef UNICODE
+  return WideToAnsiCch(dest, src, count);
+#else
+  if(!dest || !src || count <= 0)
+    return E_INVALIDARG;
+  strncpy_s(dest, count, src, _TRUNCATE);
+  return S_OK;
+#endif
+}
+
+HRESULT GenericToWideCch(WCHAR* dest, const TCHAR* src, int count)
+{
+#ifdef UNICODE
+  if(!dest || !src || count <= 0)
+    return E_INVALIDARG;
+  wcsncpy_s(dest, count, src, _TRUNCATE);
+  return S_OK;
+#else
+  return AnsiToWideCch(dest, src, count);
+#endif
+}
+
+HRESULT AnsiToGenericCch(TCHAR* dest, const CHAR* src, int count)
+{
+#ifdef UNICODE
+  return AnsiToWideCch(dest, src, count);
+#else
+  if(!dest || !src || count <= 0)
+    return E_INVALIDARG;
+  strncpy_s(dest, count, src, _TRUNCATE);
+  return S_OK;
+#endif
+}
+
+HRESULT WideToGenericCch(TCHAR* dest, const WCHAR* src, int count)
+{
+#ifdef UNICODE
+  if(!dest || !src || count <= 0)
+    return E_INVALIDARG;
+  wcsncpy_s(dest, count, src, _TRUNCATE);
+  return S_OK;
+#else
+  return WideToAnsiCch(dest, src, count);
+#endif
+}
+
+#pragma endregion
@@ -38,8 +38,12 @@
 //========================================================================
 
 #define MAX_DIGITS_IN_INT 12  //max num of digits in an int (-2147483647 = 11 digits, +1 for the '\0')
+#define MAX_CHARS_IN_FLOAT 16 //max chars for a round-trip float (-1.17549435e-38 = 15 chars, +1 for the '\0')
+#define MAX_CHARS_IN_DOUBLE 25  //max chars for a round-trip double (-2.2250738585072014e-308 = 24 chars, +1 for the '\0')
 typedef std::vector<std::string> StringVec;
 
+class Vec3;
+
 //removes characters up to the first \n
 extern void RemoveFirstLine(std::wstring& src, std::wstring& result);
 
@@ -49,10 +53,11 @@ extern void TrimLeft(std::wstring& s);
 //counts the number of lines in a block of text
 extern int CountLines(const std::wstring& s);
 
-//does a classic * & ? pattern match on a file name - case sensitive
+//does a classic * & ? pattern match on a file name - case sensitive, ? doesnt match '.'
+//use WildcardPattern when the same pattern is matched against many names
 extern BOOL WildcardMatch(const char* pat, const char* str);
 
-//converts a regular string to a wide string
+//converts a regular string to a wide string.  Narrow strings are always UTF-8, see Utf8.h
 extern void StringToWideString(const std::string& source, std::wstring& out);
 
 extern HRESULT AnsiToWideCch(WCHAR* dest, const CHAR* src, int count);
@@ -80,3 +85,75 @@ extern std::wstring s2ws(const std::string& s);
 // outVec will have the following values:
 // "one", "two", "three"
 void Split(const std::string& str, StringVec& vec, char delimiter);
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Allocation free versions
+//
+// These do the same work as the functions above but never create a temporary std::string.  Results are written into
+// caller supplied buffers or returned as StringRefs that point back into the source string.
+//////////////////////////////////////////////////////////////////////////////
+
+// A non-owning view of a run of characters, the engine's stand-in for string_view.  It is not null terminated and the
+// memory it points at must outlive it.
+struct StringRef
+{
+  const char* str;
+  size_t length;
+
+  StringRef() : str(0), length(0) {}
+  StringRef(const char* s, size_t len) : str(s), length(len) {}
+  StringRef(const char* s) : str(s), length(s ? strlen(s) : 0) {}
+  StringRef(const std::string& s) : str(s.c_str()), length(s.size()) {}
+
+  bool Empty() const { return length == 0; }
+  const char* Begin() const { return str; }
+  const char* End() const { return str + length; }
+  std::string ToString() const { return std::string(str, length); }
+
+  bool operator==(const StringRef& rhs) const
+  {
+    return length == rhs.length && (length == 0 || memcmp(str, rhs.str, length) == 0);
+  }
+  bool operator!=(const StringRef& rhs) const { return !(*this == rhs); }
+};
+typedef std::vector<StringRef> StringRefVec;
+
+// Walks the tokens of a string one at a time without allocating.  Tokens follow the same rules as Split(): empty
+// tokens between two delimiters are returned, a trailing delimiter does not produce an empty token.
+//
+// StringTokenizer tok(attribute_value, ',');
+// StringRef token;
+// while(tok.Next(token))
+//   ...
+class StringTokenizer
+{
+  const char* _cur;
+  const char* _end;
+  char _delimiter;
+
+public:
+  StringTokenizer(StringRef str, char delimiter);
+  bool Next(StringRef& token);
+};
+
+// Same as Split() above but fills vec with StringRefs into str.  vec is cleared but keeps its capacity, so a vector
+// that is reused across calls stops allocating once it has grown to fit.
+void Split(StringRef str, StringRefVec& vec, char delimiter);
+
+// Decimal formatting into a caller buffer.  Each returns the number of characters written, not counting the '\0' that
+// is always appended, or 0 if the buffer is too small.  MAX_DIGITS_IN_INT, MAX_CHARS_IN_FLOAT and MAX_CHARS_IN_DOUBLE
+// are always big enough.
+extern size_t ToStr(int num, char* buffer, size_t buffer_size);
+extern size_t ToStr(unsigned int num, char* buffer, size_t buffer_size);
+extern size_t ToStr(unsigned long num, char* buffer, size_t buffer_size);
+extern size_t ToStr(bool val, char* buffer, size_t buffer_size);
+// floats and doubles are written with the fewest significant digits that read back to exactly the same value
+extern size_t ToStr(float num, char* buffer, size_t buffer_size);
+extern size_t ToStr(double num, char* buffer, size_t buffer_size);
+
+// ws2s() and s2ws() into a caller buffer.  src_len is in characters.  The result is always null terminated and the
+// return value is the number of characters written, not counting the '\0', or 0 if it did not fit or src was not
+// valid UTF-8 (UTF-16).
+extern size_t ws2s(const wchar_t* src, size_t src_len, char* dest, size_t dest_size);
+extern size_t s2ws(const char* src, size_t src_len, wchar_t* dest, size_t dest_size);
@@ -0,0 +1,501 @@
+#include "EngineStd.h"
+#include "Utf8.h"
+
+//the vector paths are picked at compile time, there is no runtime dispatch
+#if defined(__AVX2__)
+#define SOL_UTF_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define SOL_UTF_SSE2
+#include <emmintrin.h>
+#endif
+
+#pragma region ASCII Runs
+
+//////////////////////////////////////////////////////////////////////////////
+// Each of these handles the leading run of ASCII in src and returns how many
+// code units it consumed.  They stop at the first unit that isnt ASCII and
+// leave it, and everything after it, to the scalar code.
+//////////////////////////////////////////////////////////////////////////////
+
+static size_t AsciiPrefixLength(const unsigned char* src, size_t len)
+{
+  size_t i = 0;
+#ifdef SOL_UTF_SSE2
+  for(; i + 16 <= len; i += 16)
+  {
+    if(_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(src + i))))
+      break;
+  }
+#endif
+  while(i < len && src[i] < 0x80)
+    ++i;
+  return i;
+}
+
+static size_t WidenAsciiTo16(const unsigned char* src, size_t len, Utf16Char* dest)
+{
+  size_t i = 0;
+#ifdef SOL_UTF_AVX2
+  for(; i + 32 <= len; i += 32)
+  {
+    __m256i bytes = _mm256_loadu_si256((const __m256i*)(src + i));
+    if(_mm256_movemask_epi8(bytes))
+      break;
+    _mm256_storeu_si256((__m256i*)(dest + i), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes)));
+    _mm256_storeu_si256((__m256i*)(dest + i + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1)));
+  }
+#endif
+#ifdef SOL_UTF_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  for(; i + 16 <= len; i += 16)
+  {
+    __m128i bytes = _mm_loadu_si128((const __m128i*)(src + i));
+    if(_mm_movemask_epi8(bytes))
+      break;
+    _mm_storeu_si128((__m128i*)(dest + i), _mm_unpacklo_epi8(bytes, zero));
+    _mm_storeu_si128((__m128i*)(dest + i + 8), _mm_unpackhi_epi8(bytes, zero));
+  }
+#endif
+  for(; i < len && src[i] < 0x80; ++i)
+    dest[i] = src[i];
+  return i;
+}
+
+static size_t WidenAsciiTo32(const unsigned char* src, size_t len, Utf32Char* dest)
+{
+  size_t i = 0;
+#ifdef SOL_UTF_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  for(; i + 16 <= len; i += 16)
+  {
+    __m128i bytes = _mm_loadu_si128((const __m128i*)(src + i));
+    if(_mm_movemask_epi8(bytes))
+      break;
+    __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+    _mm_storeu_si128((__m128i*)(dest + i), _mm_unpacklo_epi16(lo, zero));
+    _mm_storeu_si128((__m128i*)(dest + i + 4), _mm_unpackhi_epi16(lo, zero));
+    _mm_storeu_si128((__m128i*)(dest + i + 8), _mm_unpacklo_epi16(hi, zero));
+    _mm_storeu_si128((__m128i*)(dest + i + 12), _mm_unpackhi_epi16(hi, zero));
+  }
+#endif
+  for(; i < len && src[i] < 0x80; ++i)
+    dest[i] = src[i];
+  return i;
+}
+
+static size_t NarrowAsciiFrom16(const Utf16Char* src, size_t len, char* dest)
+{
+  size_t i = 0;
+#ifdef SOL_UTF_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i non_ascii = _mm_set1_epi16((short)0xff80);
+  for(; i + 16 <= len; i += 16)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i*)(src + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(src + i + 8));
+    __m128i high_bits = _mm_and_si128(_mm_or_si128(a, b), non_ascii);
+    if(_mm_movemask_epi8(_mm_cmpeq_epi16(high_bits, zero)) != 0xffff)
+      break;
+    _mm_storeu_si128((__m128i*)(dest + i), _mm_packus_epi16(a, b));
+  }
+#endif
+  for(; i < len && src[i] < 0x80; ++i)
+    dest[i] = (char)src[i];
+  return i;
+}
+
+static size_t NarrowAsciiFrom32(const Utf32Char* src, size_t len, char* dest)
+{
+  size_t i = 0;
+#ifdef SOL_UTF_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i non_ascii = _mm_set1_epi32((int)0xffffff80);
+  for(; i + 16 <= len; i += 16)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i*)(src + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(src + i + 4));
+    __m128i c = _mm_loadu_si128((const __m128i*)(src + i + 8));
+    __m128i d = _mm_loadu_si128((const __m128i*)(src + i + 12));
+    __m128i high_bits = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), non_ascii);
+    if(_mm_movemask_epi8(_mm_cmpeq_epi32(high_bits, zero)) != 0xffff)
+      break;
+    //every value is below 0x80 so the saturating packs are exact
+    _mm_storeu_si128((__m128i*)(dest + i), _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+  }
+#endif
+  for(; i < len && src[i] < 0x80; ++i)
+    dest[i] = (char)src[i];
+  return i;
+}
+
+#pragma endregion
+
+#pragma region Scalar Coding
+
+static bool IsContinuation(unsigned char c)
+{
+  return (c & 0xc0) == 0x80;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// decodes the (non ASCII) sequence at src into code_point and returns its
+// length, or 0 if it is malformed, overlong, a surrogate or past U+10FFFF
+//////////////////////////////////////////////////////////////////////////////
+static size_t DecodeUtf8(const unsigned char* src, size_t remaining, Utf32Char& code_point)
+{
+  unsigned char lead = src[0];
+  if(lead < 0x80)
+  {
+    code_point = lead;
+    return 1;
+  }
+  if(lead < 0xc2)
+    return 0;   //stray continuation byte or overlong 2 byte form
+  if(lead < 0xe0)
+  {
+    if(remaining < 2 || !IsContinuation(src[1]))
+      return 0;
+    code_point = ((lead & 0x1f) << 6) | (src[1] & 0x3f);
+    return 2;
+  }
+  if(lead < 0xf0)
+  {
+    if(remaining < 3 || !IsContinuation(src[1]) || !IsContinuation(src[2]))
+      return 0;
+    code_point = ((lead & 0x0f) << 12) | ((src[1] & 0x3f) << 6) | (src[2] & 0x3f);
+    if(code_point < 0x800 || (code_point >= 0xd800 && code_point <= 0xdfff))
+      return 0;
+    return 3;
+  }
+  if(lead < 0xf5)
+  {
+    if(remaining < 4 || !IsContinuation(src[1]) || !IsContinuation(src[2]) || !IsContinuation(src[3]))
+      return 0;
+    code_point = ((lead & 0x07) << 18) | ((src[1] & 0x3f) << 12) | ((src[2] & 0x3f) << 6) | (src[3] & 0x3f);
+    if(code_point < 0x10000 || code_point > 0x10ffff)
+      return 0;
+    return 4;
+  }
+  return 0;
+}
+
+static size_t EncodedUtf8Length(Utf32Char code_point)
+{
+  if(code_point < 0x80)
+    return 1;
+  if(code_point < 0x800)
+    return 2;
+  if(code_point < 0x10000)
+    return 3;
+  return 4;
+}
+
+static void EncodeUtf8(Utf32Char code_point, char* dest)
+{
+  if(code_point < 0x80)
+  {
+    dest[0] = (char)code_point;
+  }
+  else if(code_point < 0x800)
+  {
+    dest[0] = (char)(0xc0 | (code_point >> 6));
+    dest[1] = (char)(0x80 | (code_point & 0x3f));
+  }
+  else if(code_point < 0x10000)
+  {
+    dest[0] = (char)(0xe0 | (code_point >> 12));
+    dest[1] = (char)(0x80 | ((code_point >> 6) & 0x3f));
+    dest[2] = (char)(0x80 | (code_point & 0x3f));
+  }
+  else
+  {
+    dest[0] = (char)(0xf0 | (code_point >> 18));
+    dest[1] = (char)(0x80 | ((code_point >> 12) & 0x3f));
+    dest[2] = (char)(0x80 | ((code_point >> 6) & 0x3f));
+    dest[3] = (char)(0x80 | (code_point & 0x3f));
+  }
+}
+
+//room left in dest, not counting the '\0'.  Counting only runs have no limit.
+static size_t Capacity(const void* dest, size_t dest_size)
+{
+  if(!dest)
+    return (size_t)-1;
+  return dest_size - 1;
+}
+
+#pragma endregion
+
+#pragma region Converters
+
+UtfResult Utf8ToUtf16(const char* src, size_t src_len, Utf16Char* dest, size_t dest_size, size_t& out_length,
+                      bool replace_invalid)
+{
+  out_length = 0;
+  if(dest && dest_size == 0)
+    return UTF_BUFFER_TOO_SMALL;
+
+  const unsigned char* in = (const unsigned char*)src;
+  const unsigned char* in_end = in + src_len;
+  size_t capacity = Capacity(dest, dest_size);
+  size_t written = 0;
+  UtfResult result = UTF_OK;
+
+  while(in < in_end)
+  {
+    if(*in < 0x80)
+    {
+      size_t run = std::min((size_t)(in_end - in), capacity - written);
+      if(run == 0)
+      {
+        result = UTF_BUFFER_TOO_SMALL;
+        break;
+      }
+      run = dest ? WidenAsciiTo16(in, run, dest + written) : AsciiPrefixLength(in, run);
+      in += run;
+      written += run;
+      continue;
+    }
+
+    Utf32Char code_point;
+    size_t consumed = DecodeUtf8(in, in_end - in, code_point);
+    if(consumed == 0)
+    {
+      if(!replace_invalid)
+      {
+        result = UTF_INVALID_SEQUENCE;
+        break;
+      }
+      code_point = UTF_REPLACEMENT_CHAR;
+      consumed = 1;
+    }
+    size_t units = code_point >= 0x10000 ? 2 : 1;
+    if(capacity - written < units)
+    {
+      result = UTF_BUFFER_TOO_SMALL;
+      break;
+    }
+    if(dest)
+    {
+      if(units == 2)
+      {
+        code_point -= 0x10000;
+        dest[written] = (Utf16Char)(0xd800 | (code_point >> 10));
+        dest[written + 1] = (Utf16Char)(0xdc00 | (code_point & 0x3ff));
+      }
+      else
+      {
+        dest[written] = (Utf16Char)code_point;
+      }
+    }
+    in += consumed;
+    written += units;
+  }
+
+  if(dest)
+    dest[written] = 0;
+  out_length = written;
+  return result;
+}
+
+UtfResult Utf16ToUtf8(const Utf16Char* src, size_t src_len, char* dest, size_t dest_size, size_t& out_length,
+                      bool replace_invalid)
+{
+  out_length = 0;
+  if(dest && dest_size == 0)
+    return UTF_BUFFER_TOO_SMALL;
+
+  const Utf16Char* in = src;
+  const Utf16Char* in_end = src + src_len;
+  size_t capacity = Capacity(dest, dest_size);
+  size_t written = 0;
+  UtfResult result = UTF_OK;
+
+  while(in < in_end)
+  {
+    if(dest && *in < 0x80)
+    {
+      size_t run = std::min((size_t)(in_end - in), capacity - written);
+      if(run == 0)
+      {
+        result = UTF_BUFFER_TOO_SMALL;
+        break;
+      }
+      run = NarrowAsciiFrom16(in, run, dest + written);
+      in += run;
+      written += run;
+      continue;
+    }
+
+    Utf32Char code_point = *in;
+    size_t consumed = 1;
+    if(code_point >= 0xd800 && code_point <= 0xdfff)
+    {
+      bool paired = code_point <= 0xdbff && in + 1 < in_end && in[1] >= 0xdc00 && in[1] <= 0xdfff;
+      if(paired)
+      {
+        code_point = 0x10000 + ((code_point - 0xd800) << 10) + (in[1] - 0xdc00);
+        consumed = 2;
+      }
+      else if(replace_invalid)
+      {
+        code_point = UTF_REPLACEMENT_CHAR;
+      }
+      else
+      {
+        result = UTF_INVALID_SEQUENCE;
+        break;
+      }
+    }
+
+    size_t bytes = EncodedUtf8Length(code_point);
+    if(capacity - written < bytes)
+    {
+      result = UTF_BUFFER_TOO_SMALL;
+      break;
+    }
+    if(dest)
+      EncodeUtf8(code_point, dest + written);
+    in += consumed;
+    written += bytes;
+  }
+
+  if(dest)
+    dest[written] = '\0';
+  out_length = written;
+  return result;
+}
+
+UtfResult Utf8ToUtf32(const char* src, size_t src_len, Utf32Char* dest, size_t dest_size, size_t& out_length,
+                      bool replace_invalid)
+{
+  out_length = 0;
+  if(dest && dest_size == 0)
+    return UTF_BUFFER_TOO_SMALL;
+
+  const unsigned char* in = (const unsigned char*)src;
+  const unsigned char* in_end = in + src_len;
+  size_t capacity = Capacity(dest, dest_size);
+  size_t written = 0;
+  UtfResult result = UTF_OK;
+
+  while(in < in_end)
+  {
+    if(written == capacity)
+    {
+      result = UTF_BUFFER_TOO_SMALL;
+      break;
+    }
+    if(*in < 0x80)
+    {
+      size_t run = std::min((size_t)(in_end - in), capacity - written);
+      run = dest ? WidenAsciiTo32(in, run, dest + written) : AsciiPrefixLength(in, run);
+      in += run;
+      written += run;
+      continue;
+    }
+
+    Utf32Char code_point;
+    size_t consumed = DecodeUtf8(in, in_end - in, code_point);
+    if(consumed == 0)
+    {
+      if(!replace_invalid)
+      {
+        result = UTF_INVALID_SEQUENCE;
+        break;
+      }
+      code_point = UTF_REPLACEMENT_CHAR;
+      consumed = 1;
+    }
+    if(dest)
+      dest[written] = code_point;
+    in += consumed;
+    ++written;
+  }
+
+  if(dest)
+    dest[written] = 0;
+  out_length = written;
+  return result;
+}
+
+UtfResult Utf32ToUtf8(const Utf32Char* src, size_t src_len, char* dest, size_t dest_size, size_t& out_length,
+                      bool replace_invalid)
+{
+  out_length = 0;
+  if(dest && dest_size == 0)
+    return UTF_BUFFER_TOO_SMALL;
+
+  const Utf32Char* in = src;
+  const Utf32Char* in_end = src + src_len;
+  size_t capacity = Capacity(dest, dest_size);
+  size_t written = 0;
+  UtfResult result = UTF_OK;
+
+  while(in < in_end)
+  {
+    if(dest && *in < 0x80)
+    {
+      size_t run = std::min((size_t)(in_end - in), capacity - written);
+      if(run == 0)
+      {
+        result = UTF_BUFFER_TOO_SMALL;
+        break;
+      }
+      run = NarrowAsciiFrom32(in, run, dest + written);
+      in += run;
+      written += run;
+      continue;
+    }
+
+    Utf32Char code_point = *in;
+    if(code_point > 0x10ffff || (code_point >= 0xd800 && code_point <= 0xdfff))
+    {
+      if(!replace_invalid)
+      {
+        result = UTF_INVALID_SEQUENCE;
+        break;
+      }
+      code_point = UTF_REPLACEMENT_CHAR;
+    }
+    size_t bytes = EncodedUtf8Length(code_point);
+    if(capacity - written < bytes)
+    {
+      result = UTF_BUFFER_TOO_SMALL;
+      break;
+    }
+    if(dest)
+      EncodeUtf8(code_point, dest + written);
+    ++in;
+    written += bytes;
+  }
+
+  if(dest)
+    dest[written] = '\0';
+  out_length = written;
+  return result;
+}
+
+bool IsValidUtf8(const char* src, size_t src_len)
+{
+  const unsigned char* in = (const unsigned char*)src;
+  const unsigned char* in_end = in + src_len;
+  while(in < in_end)
+  {
+    in += AsciiPrefixLength(in, in_end - in);
+    if(in == in_end)
+      break;
+    Utf32Char code_point;
+    size_t consumed = DecodeUtf8(in, in_end - in, code_point);
+    if(consumed == 0)
+      return false;
+    in += consumed;
+  }
+  return true;
+}
+
+#pragma endregion
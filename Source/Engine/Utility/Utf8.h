@@ -0,0 +1,60 @@
+#pragma once
+//========================================================================
+// Utf8.h : Validating UTF-8 <-> UTF-16/UTF-32 conversion
+//
+// All text that crosses into the engine (xml, file paths, localized
+// strings) is UTF-8.  These converters replace the code page based Win32
+// and CRT calls so that results are the same on every machine.  Runs of
+// ASCII, which is almost everything we convert, are handled 16 or 32
+// characters at a time with SSE2/AVX2 when the compiler targets them and
+// with plain loops otherwise.
+//
+// Every function takes a source length in code units, so the source does
+// not have to be null terminated.  If dest is NULL nothing is written and
+// out_length is set to the number of code units the result needs.  When
+// dest is not NULL the result is always null terminated and out_length
+// does not count the '\0'.  Malformed input stops the conversion unless
+// replace_invalid is set, in which case each bad unit becomes U+FFFD.
+//========================================================================
+
+typedef unsigned short Utf16Char;
+typedef unsigned int Utf32Char;
+
+enum UtfResult
+{
+  UTF_OK,
+  UTF_INVALID_SEQUENCE, //malformed input, out_length holds the units written before it
+  UTF_BUFFER_TOO_SMALL  //dest was too small, out_length holds the units written
+};
+
+//written in place of malformed input when replace_invalid is set
+const Utf32Char UTF_REPLACEMENT_CHAR = 0xfffd;
+
+extern UtfResult Utf8ToUtf16(const char* src, size_t src_len, Utf16Char* dest, size_t dest_size, size_t& out_length,
+                           bool replace_invalid = false);
+extern UtfResult Utf16ToUtf8(const Utf16Char* src, size_t src_len, char* dest, size_t dest_size, size_t& out_length,
+                           bool replace_invalid = false);
+extern UtfResult Utf8ToUtf32(const char* src, size_t src_len, Utf32Char* dest, size_t dest_size, size_t& out_length,
+                           bool replace_invalid = false);
+extern UtfResult Utf32ToUtf8(const Utf32Char* src, size_t src_len, char* dest, size_t dest_size, size_t& out_length,
+                           bool replace_invalid = false);
+
+//returns true if src is well formed UTF-8 (no overlongs, surrogates or code points past U+10FFFF)
+extern bool IsValidUtf8(const char* src, size_t src_len);
+
+//wchar_t is UTF-16 on Windows and UTF-32 everywhere else, these pick the right one
+inline UtfResult Utf8ToWide(const char* src, size_t src_len, wchar_t* dest, size_t dest_size, size_t& out_length,
+                            bool replace_invalid = false)
+{
+  if(sizeof(wchar_t) == sizeof(Utf16Char))
+    return Utf8ToUtf16(src, src_len, (Utf16Char*)dest, dest_size, out_length, replace_invalid);
+  return Utf8ToUtf32(src, src_len, (Utf32Char*)dest, dest_size, out_length, replace_invalid);
+}
+
+inline UtfResult WideToUtf8(const wchar_t* src, size_t src_len, char* dest, size_t dest_size, size_t& out_length,
+                            bool replace_invalid = false)
+{
+  if(sizeof(wchar_t) == sizeof(Utf16Char))
+    return Utf16ToUtf8((const Utf16Char*)src, src_len, dest, dest_size, out_length, replace_invalid);
+  return Utf32ToUtf8((const Utf32Char*)src, src_len, dest, dest_size, out_length, replace_invalid);
+}
@@ -0,0 +1,185 @@
+#include "EngineStd.h"
+#include "String.h"
+#include "WildcardPattern.h"
+
+WildcardPattern::WildcardPattern()
+{
+  Compile("*");
+}
+
+WildcardPattern::WildcardPattern(const char* pattern)
+{
+  Compile(pattern);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// splits the pattern into the literal segments between its *s.  Repeated *s
+// collapse into one, they match exactly the same thing.
+//////////////////////////////////////////////////////////////////////////////
+void WildcardPattern::Compile(const char* pattern)
+{
+  _chars.clear();
+  _segments.clear();
+  _min_length = 0;
+  _has_star = false;
+
+  size_t length = strlen(pattern);
+  _anchored_start = length == 0 || pattern[0] != '*';
+  _anchored_end = length == 0 || pattern[length - 1] != '*';
+
+  Segment current;
+  current.offset = 0;
+  current.length = 0;
+  current.has_any = false;
+  for(size_t i = 0; i <= length; ++i)
+  {
+    char c = pattern[i];
+    if(c == '*' || c == '\0')
+    {
+      if(c == '*')
+        _has_star = true;
+      if(current.length > 0)
+      {
+        _segments.push_back(current);
+        _min_length += current.length;
+      }
+      current.offset = _chars.size();
+      current.length = 0;
+      current.has_any = false;
+      continue;
+    }
+    if(c == '?')
+      current.has_any = true;
+    _chars.push_back(c);
+    ++current.length;
+  }
+}
+
+//the segments stay where they are, no character changes length or becomes a *
+void WildcardPattern::NormalizePath()
+{
+  for(size_t i = 0; i < _chars.size(); ++i)
+  {
+    char c = _chars[i];
+    if(c == '\\')
+      _chars[i] = '/';
+    else if(c >= 'A' && c <= 'Z')
+      _chars[i] = c - 'A' + 'a';
+  }
+}
+
+bool WildcardPattern::SegmentMatchesAt(const Segment& segment, const char* str) const
+{
+  const char* pat = _chars.c_str() + segment.offset;
+  if(!segment.has_any)
+    return memcmp(pat, str, segment.length) == 0;
+
+  for(size_t i = 0; i < segment.length; ++i)
+  {
+    if(pat[i] == '?' ? str[i] == '.' : pat[i] != str[i])
+      return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// returns the leftmost place in [first, last) where segment matches, or NULL
+//////////////////////////////////////////////////////////////////////////////
+const char* WildcardPattern::FindSegment(const Segment& segment, const char* first, const char* last) const
+{
+  if((size_t)(last - first) < segment.length)
+    return 0;
+  const char* final_start = last - segment.length;
+  char lead = _chars[segment.offset];
+
+  if(lead == '?')
+  {
+    for(const char* cur = first; cur <= final_start; ++cur)
+    {
+      if(SegmentMatchesAt(segment, cur))
+        return cur;
+    }
+    return 0;
+  }
+
+  //skip to each occurrence of the segment's first character
+  const char* cur = first;
+  while(cur <= final_start)
+  {
+    cur = (const char*)memchr(cur, lead, final_start - cur + 1);
+    if(!cur)
+      return 0;
+    if(SegmentMatchesAt(segment, cur))
+      return cur;
+    ++cur;
+  }
+  return 0;
+}
+
+bool WildcardPattern::Match(const char* str, size_t length) const
+{
+  if(length < _min_length)
+    return false;
+  if(!_has_star)
+    return length == _min_length && (_segments.empty() || SegmentMatchesAt(_segments[0], str));
+
+  size_t first = 0;
+  size_t last = _segments.size();
+  const char* cur = str;
+  const char* end = str + length;
+
+  //fixed prefix and suffix first, they reject most names
+  if(_anchored_start && first < last)
+  {
+    if(!SegmentMatchesAt(_segments[first], cur))
+      return false;
+    cur += _segments[first].length;
+    ++first;
+  }
+  if(_anchored_end && first < last)
+  {
+    const Segment& suffix = _segments[last - 1];
+    if((size_t)(end - cur) < suffix.length || !SegmentMatchesAt(suffix, end - suffix.length))
+      return false;
+    end -= suffix.length;
+    --last;
+  }
+
+  //taking the leftmost match of each middle segment leaves the most room for the ones after it
+  for(size_t i = first; i < last; ++i)
+  {
+    const char* found = FindSegment(_segments[i], cur, end);
+    if(!found)
+      return false;
+    cur = found + _segments[i].length;
+  }
+  return true;
+}
+
+size_t WildcardPattern::MatchAll(const char* const* names, size_t count, std::vector<size_t>& out_matches) const
+{
+  size_t matched = 0;
+  for(size_t i = 0; i < count; ++i)
+  {
+    if(Match(names[i]))
+    {
+      out_matches.push_back(i);
+      ++matched;
+    }
+  }
+  return matched;
+}
+
+size_t WildcardPattern::MatchAll(const StringVec& names, std::vector<size_t>& out_matches) const
+{
+  size_t matched = 0;
+  for(size_t i = 0; i < names.size(); ++i)
+  {
+    if(Match(names[i].c_str(), names[i].size()))
+    {
+      out_matches.push_back(i);
+      ++matched;
+    }
+  }
+  return matched;
+}
@@ -0,0 +1,58 @@
+#pragma once
+//========================================================================
+// WildcardPattern.h : A * and ? file name pattern compiled once and
+// matched many times
+//
+// WildcardMatch() in String.h walks the pattern again for every name it
+// is given.  WildcardPattern splits the pattern up front into the literal
+// segments between its *s, so a match is a length check, a compare of the
+// fixed prefix and suffix, and then a left to right search for each middle
+// segment.  Most names in a big directory fail one of the first three
+// checks without looking at the rest of the name.
+//
+// Matching is case sensitive and gives the same results as WildcardMatch(),
+// including ? not matching a '.', so "*.???" wont match "a.b.c".
+//========================================================================
+
+#include "String.h"
+
+class WildcardPattern
+{
+  //a run of the pattern between two *s, ? matches any one character but '.'
+  struct Segment
+  {
+    size_t offset;  //into _chars
+    size_t length;
+    bool has_any;   //contains a ?, so it cant be compared with memcmp
+  };
+  typedef std::vector<Segment> Segments;
+
+  std::string _chars;   //the pattern with the *s removed
+  Segments _segments;
+  bool _anchored_start; //pattern doesnt start with a *
+  bool _anchored_end;   //pattern doesnt end with a *
+  bool _has_star;
+  size_t _min_length;   //sum of all segment lengths, shorter names can never match
+
+public:
+  WildcardPattern();
+  explicit WildcardPattern(const char* pattern);
+
+  void Compile(const char* pattern);
+
+  bool Match(const char* str) const { return Match(str, strlen(str)); }
+  bool Match(const char* str, size_t length) const;
+
+  //batch matching, appends the index of every matching name to out_matches and returns how many were added
+  size_t MatchAll(const char* const* names, size_t count, std::vector<size_t>& out_matches) const;
+  size_t MatchAll(const StringVec& names, std::vector<size_t>& out_matches) const;
+
+  size_t MinLength() const { return _min_length; }
+
+  //lowercases the pattern and turns \ into /, to match names that have been folded the same way
+  void NormalizePath();
+
+private:
+  bool SegmentMatchesAt(const Segment& segment, const char* str) const;
+  const char* FindSegment(const Segment& segment, const char* first, const char* last) const;
+};
@@ -0,0 +1,41 @@
+#include "FontToolStd.h"
+#include "../../Engine/Text/BakedFontBuilder.h"
+#include "../../Engine/Debugging/Logger.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// FontTool <font> <pixel size> <character set> <baked font> [distance field spread]
+//
+// Bakes every character in the character set, a UTF-8 text file, into the
+// file BakedFont maps.  With a spread the glyphs are distance fields with
+// the pixel size as their base size.
+//////////////////////////////////////////////////////////////////////////////
+int wmain(int argc, wchar_t* argv[])
+{
+  if(argc < 5 || argc > 6)
+  {
+    wprintf(L"usage: FontTool <font> <pixel size> <character set> <baked font> [distance field spread]\n");
+    return 1;
+  }
+
+  Logger::Init("logging.xml");
+
+  BakedFontBuilder builder;
+  bool success = builder.SetFont(argv[1], (unsigned int)_wtoi(argv[2]));
+  if(success && argc == 6)
+    builder.SetDistanceField((unsigned int)_wtoi(argv[5]));
+  if(success)
+    success = builder.AddCharacterFile(argv[3]);
+  if(success)
+    success = builder.Build(argv[4]);
+
+  if(success)
+  {
+    const BakedFontBuilderStats& stats = builder.Stats();
+    wprintf(L"%u characters, %u missing from the font, %u glyphs, %u kerning pairs\n",
+            stats.characters, stats.missing, stats.glyphs, stats.kerning_pairs);
+    wprintf(L"%ux%u atlas, %llu bytes\n", stats.atlas_width, stats.atlas_height, stats.bytes);
+  }
+
+  Logger::Destroy();
+  return success ? 0 : 1;
+}
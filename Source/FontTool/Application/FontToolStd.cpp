@@ -0,0 +1 @@
+#include "FontToolStd.h"
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "PackToolStd.h"
+#include "../../Engine/ResourceCache/PackBuilder.h"
+#include "../../Engine/Debugging/Logger.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// PackTool <asset directory> <archive> [load order file]
+//
+// Packs everything under the asset directory into the archive the game
+// loads.  The load order file comes from ResourceCache::SaveLoadOrder().
+//////////////////////////////////////////////////////////////////////////////
+int wmain(int argc, wchar_t* argv[])
+{
+  if(argc < 3 || argc > 4)
+  {
+    wprintf(L"usage: PackTool <asset directory> <archive> [load order file]\n");
+    return 1;
+  }
+
+  Logger::Init("logging.xml");
+
+  PackBuilder builder;
+  bool success = builder.AddDirectory(argv[1]);
+  if(success && argc == 4)
+    success = builder.LoadOrder(argv[3]);
+  if(success)
+    success = builder.Build(argv[2]);
+
+  if(success)
+  {
+    const PackBuilderStats& stats = builder.Stats();
+    wprintf(L"%u files, %u duplicates, %u deflated, %u stored, %u placed by load order\n",
+            stats.files, stats.duplicates, stats.deflated, stats.stored, stats.in_load_order);
+    wprintf(L"%llu bytes packed into %llu\n", stats.raw_bytes, stats.packed_bytes);
+  }
+
+  Logger::Destroy();
+  return success ? 0 : 1;
+}
@@ -0,0 +1 @@
+#include "PackToolStd.h"
\ No newline at end of file